@@ -22,6 +22,15 @@
 #include <fty/messagebus/Message.h>
 #include <fty/messagebus/MessageBus.h>
 #include <fty/messagebus/utils.h>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+
+#include <map>
+#include <memory>
+
+namespace fty::messagebus::utils
+{
+  class PoolWorker;
+}
 
 namespace fty::messagebus::amqp
 {
@@ -37,20 +46,26 @@ namespace fty::messagebus::amqp
   class MessageBusAmqp final : public fty::messagebus::MessageBus
   {
   public:
+    /// @param executor pool of workers running the listeners (the process-wide shared pool when empty)
     MessageBusAmqp(const ClientName& clientName = utils::getClientId("MessageBusAmqp"),
-                   const Endpoint& endpoint = DEFAULT_ENDPOINT);
+                   const Endpoint& endpoint = DEFAULT_ENDPOINT,
+                   std::shared_ptr<utils::PoolWorker> executor = {});
 
     ~MessageBusAmqp() = default;
 
     [[nodiscard]] fty::Expected<void> connect() noexcept override;
     [[nodiscard]] fty::Expected<void> send(const Message& msg) noexcept override;
-    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {}) noexcept override;
+    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {},
+                                              DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {}) noexcept override;
     [[nodiscard]] fty::Expected<void> unreceive(const Address& address) noexcept override;
     [[nodiscard]] fty::Expected<Message> request(const Message& msg, int timeOut) noexcept override;
 
     [[nodiscard]] const ClientName& clientName() const noexcept override;
     [[nodiscard]] const Identity& identity() const noexcept override;
 
+    /// @brief Execution time (ns) of the listener of each address, see the executor for queueing and pool metrics
+    std::map<std::string, utils::HistogramSnapshot> listenerMetrics() const;
+
   private:
     std::shared_ptr<MsgBusAmqp> m_busAmqp;
   };
@@ -19,6 +19,9 @@
 
 #include "AmqpClient.h"
 
+#include <fty/messagebus/Metrics.h>
+#include <fty/messagebus/utils/MsgBusTrace.hpp>
+
 #include <proton/connection_options.hpp>
 #include <proton/reconnect_options.hpp>
 #include <proton/tracker.hpp>
@@ -52,10 +55,14 @@ namespace fty::messagebus::amqp
 
   static auto constexpr TIMEOUT = std::chrono::seconds(5);
 
-  AmqpClient::AmqpClient(const Endpoint& url)
+  AmqpClient::AmqpClient(const Endpoint& url, PoolWorkerPointer poolWorkers)
     : m_url(url)
   {
     m_connectFuture = m_connectPromise.get_future();
+    if (poolWorkers)
+    {
+      m_strands = std::make_shared<utils::Strands>(poolWorkers);
+    }
   }
 
   AmqpClient::~AmqpClient()
@@ -65,6 +72,8 @@ namespace fty::messagebus::amqp
 
   void AmqpClient::on_container_start(proton::container& container)
   {
+    // Called on the thread running the container.
+    utils::adoptThread(utils::ThreadRole::IO);
     try
     {
       container.connect(m_url, connectOpts().reconnect(reconnectOpts()));
@@ -83,6 +92,7 @@ namespace fty::messagebus::amqp
     if (connection.reconnected())
     {
       logDebug("Reconnected on url: {}", m_url);
+      metrics::sharedRegistry()->connectionState(ComState::COM_STATE_OK);
       resetPromise();
     }
     else
@@ -95,6 +105,10 @@ namespace fty::messagebus::amqp
   void AmqpClient::on_sender_open(proton::sender& sender)
   {
     logDebug("Sending message ...");
+    if (m_message.properties().exists(latency::STAMP_SEND))
+    {
+      m_message.properties().put(latency::STAMP_WIRE, std::to_string(latency::now()));
+    }
     sender.send(m_message);
     sender.connection().close();
     m_promiseSender.set_value();
@@ -118,6 +132,7 @@ namespace fty::messagebus::amqp
   {
     logError("Transport error: {}", transport.error().what());
     m_communicationState = ComState::COM_STATE_LOST;
+    metrics::sharedRegistry()->connectionState(ComState::COM_STATE_LOST);
   }
 
   void AmqpClient::resetPromise()
@@ -175,7 +190,8 @@ namespace fty::messagebus::amqp
     return deliveryState;
   }
 
-  DeliveryState AmqpClient::receive(const Address& address, const std::string& filter, MessageListener messageListener)
+  DeliveryState AmqpClient::receive(const Address& address, const std::string& filter, MessageListener messageListener,
+                                    DispatchMode mode, const std::string& orderingKey)
   {
     auto deliveryState = DeliveryState::DELIVERY_STATE_REJECTED;
     if (connected() == ComState::COM_STATE_OK)
@@ -184,7 +200,7 @@ namespace fty::messagebus::amqp
       m_promiseReceiver = std::promise<void>();
 
       auto futureReceiver = m_promiseReceiver.get_future();
-      (!filter.empty()) ? setSubscriptions(filter, messageListener) : setSubscriptions(address, messageListener);
+      (!filter.empty()) ? setSubscriptions(filter, {messageListener, mode, orderingKey}) : setSubscriptions(address, {messageListener, mode, orderingKey});
 
       m_connection.work_queue().add([=]() {
         m_connection.open_receiver(address, {});
@@ -224,10 +240,16 @@ namespace fty::messagebus::amqp
 
   void AmqpClient::on_message(proton::delivery& delivery, proton::message& msg)
   {
+    auto receivedAt = latency::now();
     std::lock_guard<std::mutex> lock(m_lock);
     logDebug("Message arrived: {}", proton::to_string(msg));
     delivery.accept();
     Message amqpMsg(getMetaData(msg), msg.body().empty() ? std::string{} : proton::to_string(msg.body()));
+    latency::stampReceive(amqpMsg.metaData(), receivedAt);
+    if (FTY_TRACE_ENABLED(receive))
+    {
+      FTY_TRACE(receive, msg.address().c_str(), amqpMsg.userData().size(), utils::traceHash(amqpMsg.correlationId()));
+    }
 
     if (m_connection)
     {
@@ -237,7 +259,7 @@ namespace fty::messagebus::amqp
         {
           // Asynchronous reply
           logDebug("Asynchronous mode");
-          m_connection.work_queue().add(proton::make_work(it->second, amqpMsg));
+          dispatch(it->first, it->second, amqpMsg, receivedAt);
         }
         else
         {
@@ -251,7 +273,7 @@ namespace fty::messagebus::amqp
         if (auto it{m_subscriptions.find(msg.address())}; it != m_subscriptions.end())
         {
           // Any subscription
-          m_connection.work_queue().add(proton::make_work(it->second, amqpMsg));
+          dispatch(it->first, it->second, amqpMsg, receivedAt);
         }
         else
         {
@@ -266,13 +288,59 @@ namespace fty::messagebus::amqp
     }
   }
 
-  void AmqpClient::setSubscriptions(const Address& address, MessageListener messageListener)
+  void AmqpClient::dispatch(const Address& address, const Subscription& subscription, const Message& message, int64_t receivedAt)
+  {
+    auto listener = [listener = subscription.listener, listenerTime = subscription.listenerTime, receivedAt](const Message& msg) {
+      auto started = std::chrono::steady_clock::now();
+      auto queued = FTY_TRACE_ENABLED(listener_done) ? latency::now() - receivedAt : 0;
+      latency::invoke(listener, msg);
+      auto duration = std::chrono::steady_clock::now() - started;
+      listenerTime->record(duration);
+      if (FTY_TRACE_ENABLED(listener_done))
+      {
+        FTY_TRACE(listener_done, msg.to().c_str(), utils::traceHash(msg.correlationId()), queued, std::chrono::nanoseconds(duration).count());
+      }
+    };
+
+    if (!m_strands)
+    {
+      m_connection.work_queue().add(proton::make_work(listener, message));
+    }
+    else if (subscription.mode == DISPATCH_ORDERED)
+    {
+      auto key = address;
+      if (!subscription.orderingKey.empty())
+      {
+        auto value = message.metaData().find(subscription.orderingKey);
+        key += ":" + (value != message.metaData().end() ? value->second : std::string{});
+      }
+      m_strands->offload(key, listener, message);
+    }
+    else
+    {
+      m_strands->offloadUnordered(listener, message);
+    }
+  }
+
+  std::map<Address, utils::HistogramSnapshot> AmqpClient::listenerMetrics()
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    std::map<Address, utils::HistogramSnapshot> metrics;
+    for (const auto& [address, subscription] : m_subscriptions)
+    {
+      metrics.emplace(address, subscription.listenerTime->snapshot());
+    }
+    return metrics;
+  }
+
+  void AmqpClient::setSubscriptions(const Address& address, const Subscription& subscription)
   {
-    if (messageListener)
+    if (subscription.listener)
     {
       if (auto it{m_subscriptions.find(address)}; it == m_subscriptions.end())
       {
-        auto ret = m_subscriptions.emplace(address, messageListener);
+        auto ret = m_subscriptions.emplace(address, subscription);
+        ret.first->second.listenerTime = std::make_shared<utils::LazyHistogram>();
         logTrace("Subscriptions emplaced: {} {}", address, ret.second ? "true" : "false");
       }
       else
@@ -22,6 +22,10 @@
 #include "MsgBusAmqpUtils.h"
 #include <fty/messagebus/MessageBus.h>
 #include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+#include <fty/messagebus/utils/MsgBusStrand.hpp>
+#include <fty/messagebus/utils/MsgBusThread.hpp>
 
 #include <proton/connection.hpp>
 #include <proton/container.hpp>
@@ -40,13 +44,26 @@
 namespace fty::messagebus::amqp
 {
   using MessageListener = fty::messagebus::MessageListener;
-  using SubScriptionListener = std::map<Address, MessageListener>;
+
+  struct Subscription
+  {
+    MessageListener listener;
+    DispatchMode mode = DISPATCH_UNORDERED;
+    std::string orderingKey;
+    // Execution time of the listener, set once subscribed
+    std::shared_ptr<utils::LazyHistogram> listenerTime;
+  };
+
+  using SubScriptionListener = std::map<Address, Subscription>;
+
+  using PoolWorkerPointer = std::shared_ptr<utils::PoolWorker>;
+  using StrandsPointer = std::shared_ptr<utils::Strands>;
 
   class AmqpClient : public proton::messaging_handler
   {
   public:
 
-    AmqpClient(const Endpoint& url);
+    AmqpClient(const Endpoint& url, PoolWorkerPointer poolWorkers = {});
     ~AmqpClient();
 
     void on_container_start(proton::container& container) override;
@@ -58,11 +75,13 @@ namespace fty::messagebus::amqp
     void on_transport_error(proton::transport &t) override;
 
     fty::messagebus::ComState connected();
-    fty::messagebus::DeliveryState receive(const Address& address, const std::string& filter = {}, MessageListener messageListener = {});
+    fty::messagebus::DeliveryState receive(const Address& address, const std::string& filter = {}, MessageListener messageListener = {},
+                                           DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {});
     fty::messagebus::DeliveryState unreceive();
     fty::messagebus::DeliveryState send(const proton::message& msg);
     bool tryConsumeMessageFor(std::shared_ptr<proton::message> resp, int timeoutInSeconds);
     void close();
+    std::map<Address, utils::HistogramSnapshot> listenerMetrics();
 
   private:
     Endpoint m_url;
@@ -82,8 +101,11 @@ namespace fty::messagebus::amqp
     std::promise<void> m_promiseSender;
     std::promise<void> m_promiseReceiver;
     std::promise<proton::message> m_promiseSyncRequest;
+    // Listeners dispatching, on the container thread when not set
+    StrandsPointer m_strands;
 
-    void setSubscriptions(const Address& address, MessageListener messageListener);
+    void setSubscriptions(const Address& address, const Subscription& subscription);
+    void dispatch(const Address& address, const Subscription& subscription, const Message& message, int64_t receivedAt);
     void resetPromise();
   };
 
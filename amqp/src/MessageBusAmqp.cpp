@@ -29,10 +29,11 @@
 namespace fty::messagebus::amqp
 {
   MessageBusAmqp::MessageBusAmqp(const ClientName& clientName,
-                                 const Endpoint& endpoint)
+                                 const Endpoint& endpoint,
+                                 std::shared_ptr<utils::PoolWorker> executor)
     : MessageBus()
   {
-    m_busAmqp = std::make_shared<MsgBusAmqp>(clientName, endpoint);
+    m_busAmqp = std::make_shared<MsgBusAmqp>(clientName, endpoint, executor ? executor : utils::sharedPoolWorker());
   }
 
   fty::Expected<void> MessageBusAmqp::connect() noexcept
@@ -49,9 +50,10 @@ namespace fty::messagebus::amqp
     return m_busAmqp->send(msg);
   }
 
-  fty::Expected<void> MessageBusAmqp::receive(const Address& address, MessageListener&& func, const std::string& filter) noexcept
+  fty::Expected<void> MessageBusAmqp::receive(const Address& address, MessageListener&& func, const std::string& filter,
+                                              DispatchMode mode, const std::string& orderingKey) noexcept
   {
-    return m_busAmqp->receive(address, func, filter);
+    return m_busAmqp->receive(address, func, filter, mode, orderingKey);
   }
 
   fty::Expected<void> MessageBusAmqp::unreceive(const Address& address) noexcept
@@ -80,6 +82,11 @@ namespace fty::messagebus::amqp
     return m_busAmqp->clientName();
   }
 
+  std::map<std::string, utils::HistogramSnapshot> MessageBusAmqp::listenerMetrics() const
+  {
+    return m_busAmqp->listenerMetrics();
+  }
+
   static const std::string g_identity(BUS_IDENTITY);
 
   const std::string& MessageBusAmqp::identity() const noexcept
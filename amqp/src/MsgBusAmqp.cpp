@@ -22,6 +22,7 @@
 
 #include <fty/messagebus/MessageBusStatus.h>
 #include <fty/messagebus/utils.h>
+#include <fty/messagebus/utils/MsgBusTrace.hpp>
 #include <fty_log.h>
 
 namespace fty::messagebus::amqp
@@ -37,6 +38,7 @@ namespace fty::messagebus::amqp
     {
       logDebug("Cleaning Amqp ressources for: {}", m_clientName);
 
+      std::lock_guard<std::mutex> lock(m_subScriptionsMutex);
       for (const auto& [key, receiver] : m_subScriptions)
       {
         logDebug("Cleaning: {}...", key);
@@ -75,7 +77,19 @@ namespace fty::messagebus::amqp
     return (m_amqpClient && (m_amqpClient->connected() == ComState::COM_STATE_OK));
   }
 
-  fty::Expected<void> MsgBusAmqp::receive(const Address& address, MessageListener messageListener, const std::string& filter)
+  std::map<std::string, utils::HistogramSnapshot> MsgBusAmqp::listenerMetrics()
+  {
+    std::map<std::string, utils::HistogramSnapshot> metrics;
+    std::lock_guard<std::mutex> lock(m_subScriptionsMutex);
+    for (const auto& [key, receiver] : m_subScriptions)
+    {
+      metrics.merge(receiver->listenerMetrics());
+    }
+    return metrics;
+  }
+
+  fty::Expected<void> MsgBusAmqp::receive(const Address& address, MessageListener messageListener, const std::string& filter,
+                                          DispatchMode mode, const std::string& orderingKey)
   {
     if (!isServiceAvailable())
     {
@@ -83,12 +97,15 @@ namespace fty::messagebus::amqp
       return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
     }
 
-    auto receiver = std::make_shared<AmqpClient>(m_endpoint);
+    auto receiver = std::make_shared<AmqpClient>(m_endpoint, m_poolWorkers);
     std::thread thrd([=]() {
       proton::container(*receiver).run();
     });
-    auto received = receiver->receive(address, filter, messageListener);
-    m_subScriptions.emplace(address, receiver);
+    auto received = receiver->receive(address, filter, messageListener, mode, orderingKey);
+    {
+      std::lock_guard<std::mutex> lock(m_subScriptionsMutex);
+      m_subScriptions.emplace(address, receiver);
+    }
     thrd.detach();
 
     if (received != DeliveryState::DELIVERY_STATE_ACCEPTED)
@@ -107,10 +124,19 @@ namespace fty::messagebus::amqp
       return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
     }
 
-    if (auto it{m_subScriptions.find(address)}; it != m_subScriptions.end())
+    AmqpClientPointer receiver;
     {
-      m_subScriptions.at(address)->unreceive();
-      m_subScriptions.erase(address);
+      std::lock_guard<std::mutex> lock(m_subScriptionsMutex);
+      if (auto it{m_subScriptions.find(address)}; it != m_subScriptions.end())
+      {
+        receiver = it->second;
+        m_subScriptions.erase(it);
+      }
+    }
+
+    if (receiver)
+    {
+      receiver->unreceive();
       logTrace("Unsubscribed for: '{}'", address);
     }
     else
@@ -129,8 +155,19 @@ namespace fty::messagebus::amqp
       return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
     }
 
+    auto sentAt = latency::enabled() ? latency::now() : 0;
+    auto started = utils::traceStart(FTY_TRACE_ENABLED(send_done));
+    if (FTY_TRACE_ENABLED(send))
+    {
+      FTY_TRACE(send, message.to().c_str(), message.userData().size(), utils::traceHash(message.correlationId()));
+    }
     logDebug("Sending message {}", message.toString());
     proton::message msgToSend = getAmqpMessage(message);
+    if (sentAt)
+    {
+      // Hand-off to proton stamped by the client, on the container thread.
+      msgToSend.properties().put(latency::STAMP_SEND, std::to_string(sentAt));
+    }
 
     auto sender = AmqpClient(m_endpoint);
     std::thread thrd([&]() {
@@ -140,6 +177,11 @@ namespace fty::messagebus::amqp
     sender.close();
     thrd.join();
 
+    if (FTY_TRACE_ENABLED(send_done))
+    {
+      FTY_TRACE(send_done, message.to().c_str(), message.userData().size(), utils::traceHash(message.correlationId()), utils::traceElapsed(started),
+                msgSent == DeliveryState::DELIVERY_STATE_ACCEPTED);
+    }
     if (msgSent != DeliveryState::DELIVERY_STATE_ACCEPTED)
     {
       logError("Message sent (Rejected)");
@@ -160,6 +202,18 @@ namespace fty::messagebus::amqp
         return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
       }
 
+      auto started = utils::traceStart(FTY_TRACE_ENABLED(request_done));
+      if (FTY_TRACE_ENABLED(request))
+      {
+        FTY_TRACE(request, message.to().c_str(), message.userData().size(), utils::traceHash(message.correlationId()), receiveTimeOut);
+      }
+      auto traceDone = [&message, started](bool replied) {
+        if (FTY_TRACE_ENABLED(request_done))
+        {
+          FTY_TRACE(request_done, message.to().c_str(), utils::traceHash(message.correlationId()), utils::traceElapsed(started), replied);
+        }
+      };
+
       proton::message msgToSend = getAmqpMessage(message);
 
       AmqpClient requester(m_endpoint);
@@ -170,6 +224,7 @@ namespace fty::messagebus::amqp
       auto msgSent = send(message);
       if (!msgSent)
       {
+        traceDone(false);
         return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_REJECTED));
       }
 
@@ -178,6 +233,7 @@ namespace fty::messagebus::amqp
 
       requester.close();
       thrd.join();
+      traceDone(messageArrived);
 
       if (!messageArrived)
       {
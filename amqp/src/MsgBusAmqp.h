@@ -27,6 +27,8 @@
 #include <proton/container.hpp>
 #include <proton/listen_handler.hpp>
 
+#include <mutex>
+
 namespace fty::messagebus::amqp
 {
 
@@ -37,9 +39,10 @@ namespace fty::messagebus::amqp
   {
   public:
 
-    MsgBusAmqp(const std::string& clientName, const Endpoint& endpoint)
+    MsgBusAmqp(const std::string& clientName, const Endpoint& endpoint, PoolWorkerPointer poolWorkers = utils::sharedPoolWorker())
       : m_clientName(clientName)
-      , m_endpoint(endpoint){};
+      , m_endpoint(endpoint)
+      , m_poolWorkers(poolWorkers){};
 
     MsgBusAmqp() = delete;
     ~MsgBusAmqp();
@@ -51,7 +54,8 @@ namespace fty::messagebus::amqp
 
     [[nodiscard]] fty::Expected<void> connect();
 
-    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener messageListener, const std::string& filter = {});
+    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener messageListener, const std::string& filter = {},
+                                              DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {});
     [[nodiscard]] fty::Expected<void> unreceive(const Address& address);
     [[nodiscard]] fty::Expected<void> send(const Message& message);
 
@@ -65,11 +69,17 @@ namespace fty::messagebus::amqp
 
     bool isServiceAvailable();
 
+    // Execution time of the listeners per address
+    std::map<std::string, utils::HistogramSnapshot> listenerMetrics();
+
   private:
     std::string m_clientName{};
     Endpoint m_endpoint{};
+    // Pool of workers running the listeners
+    PoolWorkerPointer m_poolWorkers;
 
     // To handle all receivers and theirs message listener
+    std::mutex m_subScriptionsMutex;
     std::map<std::string, AmqpClientPointer> m_subScriptions;
     // To handle connection, etc.
     AmqpClientPointer m_amqpClient;
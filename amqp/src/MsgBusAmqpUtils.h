@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "fty/messagebus/Latency.h"
 #include "fty/messagebus/Message.h"
 
 #include <proton/message.hpp>
@@ -0,0 +1,55 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace bench
+{
+  /// Allocations made by the process since its start, counted by the replaced operator new
+  uint64_t allocations();
+
+  /// Bytes allocated by the process since its start
+  uint64_t allocatedBytes();
+
+  /// Allocations made in the measured loop of a benchmark, reported per iteration
+  class AllocationCounter
+  {
+  public:
+    AllocationCounter()
+      : m_allocations(allocations())
+      , m_bytes(allocatedBytes())
+    {
+    }
+
+    void report(benchmark::State& state) const
+    {
+      state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations() - m_allocations), benchmark::Counter::kAvgIterations);
+      state.counters["alloc_bytes"] = benchmark::Counter(static_cast<double>(allocatedBytes() - m_bytes), benchmark::Counter::kAvgIterations);
+    }
+
+  private:
+    uint64_t m_allocations;
+    uint64_t m_bytes;
+  };
+
+} // namespace bench
@@ -0,0 +1,273 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <LoopbackBus.h>
+#include <fty/messagebus/MessageBus.h>
+#include <fty/messagebus/utils.h>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+
+#ifdef FTY_BENCH_MQTT
+#include <FakeBroker.h>
+#include <fty/messagebus/mqtt/MessageBusMqtt.h>
+#endif
+#ifdef FTY_BENCH_AMQP
+#include <fty/messagebus/amqp/MessageBusAmqp.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace bench
+{
+  using namespace fty::messagebus;
+
+  //----------------------------------------------------------------------
+  // Bus counting the user data bytes handed to the backend
+  //----------------------------------------------------------------------
+  class CountingBus : public MessageBus
+  {
+  public:
+    CountingBus(std::shared_ptr<MessageBus> bus)
+      : m_bus(std::move(bus))
+    {
+    }
+
+    fty::Expected<void> connect() noexcept override
+    {
+      return m_bus->connect();
+    }
+
+    fty::Expected<void> send(const Message& msg) noexcept override
+    {
+      m_bytes += msg.userData().size();
+      return m_bus->send(msg);
+    }
+
+    fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {}, DispatchMode mode = DISPATCH_UNORDERED,
+                                const std::string& orderingKey = {}) noexcept override
+    {
+      return m_bus->receive(address, std::move(func), filter, mode, orderingKey);
+    }
+
+    fty::Expected<void> unreceive(const Address& address) noexcept override
+    {
+      return m_bus->unreceive(address);
+    }
+
+    fty::Expected<Message> request(const Message& msg, int timeOut) noexcept override
+    {
+      m_bytes += msg.userData().size();
+      return m_bus->request(msg, timeOut);
+    }
+
+    const ClientName& clientName() const noexcept override
+    {
+      return m_bus->clientName();
+    }
+
+    const Identity& identity() const noexcept override
+    {
+      return m_bus->identity();
+    }
+
+    uint64_t bytes() const
+    {
+      return m_bytes.load();
+    }
+
+  private:
+    std::shared_ptr<MessageBus> m_bus;
+    std::atomic_uint64_t m_bytes{0};
+  };
+
+  /// Connected sending and receiving buses of a backend (the same one in process)
+  struct Peers
+  {
+    std::shared_ptr<CountingBus> sender;
+    std::shared_ptr<MessageBus> receiver;
+  };
+
+  // Endpoint of a broker, overridden by an environment variable.
+  inline std::string endpoint(const char* variable, const std::string& defaultEndpoint)
+  {
+    auto value = std::getenv(variable);
+    return value ? value : defaultEndpoint;
+  }
+
+  // Connect a bus freshly built.
+  inline fty::Expected<std::shared_ptr<MessageBus>> connected(std::shared_ptr<MessageBus> bus)
+  {
+    auto connected = bus->connect();
+    if (!connected)
+    {
+      return fty::unexpected(connected.error());
+    }
+    return bus;
+  }
+
+  template <typename Backend>
+  fty::Expected<Peers> connectPeers()
+  {
+    auto sender = Backend::bus("bench-sender");
+    if (!sender)
+    {
+      return fty::unexpected(sender.error());
+    }
+    auto receiver = Backend::bus("bench-receiver");
+    if (!receiver)
+    {
+      return fty::unexpected(receiver.error());
+    }
+    return Peers{std::make_shared<CountingBus>(*sender), *receiver};
+  }
+
+  //----------------------------------------------------------------------
+  // Backends under benchmark
+  //----------------------------------------------------------------------
+  struct InProcess
+  {
+    static Address address(const std::string& name)
+    {
+      return "bench." + name;
+    }
+
+    // Loopback bus, listeners run on the sending thread whatever the executor.
+    static fty::Expected<std::shared_ptr<MessageBus>> bus(const std::string&, std::shared_ptr<utils::PoolWorker> = {})
+    {
+      return std::shared_ptr<MessageBus>(std::make_shared<test::LoopbackBus>());
+    }
+
+    static fty::Expected<Peers> peers()
+    {
+      auto bus = std::make_shared<test::LoopbackBus>();
+      return Peers{std::make_shared<CountingBus>(bus), bus};
+    }
+  };
+
+#ifdef FTY_BENCH_MQTT
+  struct Mqtt
+  {
+    static Address address(const std::string& name)
+    {
+      return "/etn/bench/" + name;
+    }
+
+    // In-process fake broker unless FTY_BENCH_MQTT_ENDPOINT is set.
+    static std::string brokerEndpoint()
+    {
+      if (auto value = std::getenv("FTY_BENCH_MQTT_ENDPOINT"))
+      {
+        return value;
+      }
+      auto broker = mqtt::test::FakeBroker::shared();
+      return broker ? broker->endpoint() : mqtt::DEFAULT_ENDPOINT;
+    }
+
+    static fty::Expected<std::shared_ptr<MessageBus>> bus(const std::string& name, std::shared_ptr<utils::PoolWorker> executor = {})
+    {
+      return connected(std::make_shared<mqtt::MessageBusMqtt>(utils::getClientId(name), brokerEndpoint(),
+                                                               Message(), executor));
+    }
+
+    static fty::Expected<Peers> peers()
+    {
+      return connectPeers<Mqtt>();
+    }
+  };
+#endif
+
+#ifdef FTY_BENCH_AMQP
+  struct Amqp
+  {
+    static Address address(const std::string& name)
+    {
+      return "queue://bench." + name;
+    }
+
+    static fty::Expected<std::shared_ptr<MessageBus>> bus(const std::string& name, std::shared_ptr<utils::PoolWorker> executor = {})
+    {
+      return connected(
+        std::make_shared<amqp::MessageBusAmqp>(utils::getClientId(name), endpoint("FTY_BENCH_AMQP_ENDPOINT", amqp::DEFAULT_ENDPOINT), executor));
+    }
+
+    static fty::Expected<Peers> peers()
+    {
+      return connectPeers<Amqp>();
+    }
+  };
+#endif
+
+  //----------------------------------------------------------------------
+  // Count of messages received, waited for by the benchmark thread
+  //----------------------------------------------------------------------
+  class Inbox
+  {
+  public:
+    void add()
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_count++;
+      m_cv.notify_all();
+    }
+
+    /// Wait until count messages were received, false on timeout
+    bool waitFor(uint64_t count, std::chrono::milliseconds timeout = std::chrono::seconds(10))
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      return m_cv.wait_for(lk, timeout, [this, count]() { return m_count >= count; });
+    }
+
+    uint64_t count()
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      return m_count;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    uint64_t m_count = 0;
+  };
+
+} // namespace bench
+
+/// Register a benchmark for every backend built, with the arguments set by an Apply function
+#define BENCHMARK_BACKENDS(func, args)                     \
+  BENCHMARK_TEMPLATE(func, bench::InProcess)->Apply(args); \
+  BENCHMARK_MQTT(func, args);                              \
+  BENCHMARK_AMQP(func, args)
+
+#ifdef FTY_BENCH_MQTT
+#define BENCHMARK_MQTT(func, args) BENCHMARK_TEMPLATE(func, bench::Mqtt)->Apply(args)
+#else
+#define BENCHMARK_MQTT(func, args) static_assert(true, "")
+#endif
+
+#ifdef FTY_BENCH_AMQP
+#define BENCHMARK_AMQP(func, args) BENCHMARK_TEMPLATE(func, bench::Amqp)->Apply(args)
+#else
+#define BENCHMARK_AMQP(func, args) static_assert(true, "")
+#endif
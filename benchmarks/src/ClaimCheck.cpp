@@ -0,0 +1,91 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "Backends.h"
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/ClaimCheckBus.h>
+
+using namespace bench;
+
+namespace
+{
+  // Sizes of firmware images and asset dumps, sent as is or by claim check.
+  void largeArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"payload", "claim"});
+    for (int64_t size : {4 << 20, 16 << 20, 64 << 20})
+    {
+      benchmark->Args({size, 0});
+      benchmark->Args({size, 1});
+    }
+    benchmark->UseRealTime();
+  }
+} // namespace
+
+// Latency of large messages, from send to the listener holding a copy, and bytes through the backend.
+template <typename Backend>
+static void BM_SendLarge(benchmark::State& state)
+{
+  auto peers = Backend::peers();
+  if (!peers)
+  {
+    state.SkipWithError(peers.error().c_str());
+    return;
+  }
+
+  // Files reclaimed on the next send, the payloads are not kept in memory.
+  ClaimCheckBus::Options options;
+  options.ttl = std::chrono::milliseconds(0);
+  if (state.range(1) == 0)
+  {
+    options.threshold = SIZE_MAX;
+  }
+  ClaimCheckBus sender(*peers->sender, options);
+  ClaimCheckBus receiver(*peers->receiver, options);
+
+  auto address = Backend::address("large");
+  Inbox inbox;
+  if (!receiver.receive(address, [&inbox](const Message& msg) {
+        Message copy(msg);
+        benchmark::DoNotOptimize(copy);
+        inbox.add();
+      }))
+  {
+    state.SkipWithError("Receive failed");
+    return;
+  }
+
+  auto msg = Message::buildMessage("bench", address, "LARGE", UserData(static_cast<size_t>(state.range(0)), 'x'));
+  uint64_t sent = 0;
+  for (auto _ : state)
+  {
+    if (!sender.send(msg) || !inbox.waitFor(++sent, std::chrono::seconds(60)))
+    {
+      state.SkipWithError("Message lost");
+      break;
+    }
+  }
+
+  auto unreceived = receiver.unreceive(address);
+  (void)unreceived;
+  state.counters["bus_bytes"] = benchmark::Counter(static_cast<double>(peers->sender->bytes()), benchmark::Counter::kAvgIterations);
+  state.SetBytesProcessed(static_cast<int64_t>(inbox.count() * msg.userData().size()));
+}
+BENCHMARK_BACKENDS(BM_SendLarge, largeArgs);
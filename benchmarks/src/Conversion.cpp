@@ -0,0 +1,192 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "Allocations.h"
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/Message.h>
+
+#ifdef FTY_BENCH_MQTT
+#include <MsgBusMqttUtils.h>
+#endif
+#ifdef FTY_BENCH_AMQP
+#include <MsgBusAmqpUtils.h>
+#endif
+
+using namespace fty::messagebus;
+
+namespace
+{
+  const UserData PAYLOAD(256, 'x');
+
+  // User metadata on top of the request ones.
+  void metaDataArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"user_meta"});
+    benchmark->Arg(0);
+    benchmark->Arg(8);
+  }
+
+  MetaData userMetaData(int64_t count)
+  {
+    MetaData meta;
+    for (int64_t i = 0; i < count; i++)
+    {
+      meta["property." + std::to_string(i)] = "value " + std::to_string(i);
+    }
+    return meta;
+  }
+
+  Message sampleRequest(int64_t userMeta)
+  {
+    auto request = Message::buildRequest("/etn/q/client", "/etn/q/server", "SUBJECT", "/etn/q/reply", PAYLOAD, userMetaData(userMeta));
+    request.id("message-id");
+    return request;
+  }
+} // namespace
+
+//----------------------------------------------------------------------
+// Message builders
+//----------------------------------------------------------------------
+static void BM_BuildMessage(benchmark::State& state)
+{
+  auto meta = userMetaData(state.range(0));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto msg = Message::buildMessage("/etn/q/client", "/etn/q/server", "SUBJECT", PAYLOAD, meta);
+    benchmark::DoNotOptimize(msg);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_BuildMessage)->Apply(metaDataArgs);
+
+static void BM_BuildRequest(benchmark::State& state)
+{
+  auto meta = userMetaData(state.range(0));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto msg = Message::buildRequest("/etn/q/client", "/etn/q/server", "SUBJECT", "/etn/q/reply", PAYLOAD, meta);
+    benchmark::DoNotOptimize(msg);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_BuildRequest)->Apply(metaDataArgs);
+
+static void BM_BuildReply(benchmark::State& state)
+{
+  auto request = sampleRequest(state.range(0));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto reply = request.buildReply(PAYLOAD);
+    benchmark::DoNotOptimize(reply);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_BuildReply)->Apply(metaDataArgs);
+
+static void BM_CopyMessage(benchmark::State& state)
+{
+  auto request = sampleRequest(state.range(0));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    Message copy(request);
+    benchmark::DoNotOptimize(copy);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_CopyMessage)->Apply(metaDataArgs);
+
+//----------------------------------------------------------------------
+// Mqtt conversions
+//----------------------------------------------------------------------
+#ifdef FTY_BENCH_MQTT
+static void BM_MqttProperties(benchmark::State& state)
+{
+  auto request = sampleRequest(state.range(0));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto props = fty::messagebus::mqtt::getMqttProperties(request);
+    benchmark::DoNotOptimize(props);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_MqttProperties)->Apply(metaDataArgs);
+
+static void BM_BuildMessageForMqtt(benchmark::State& state)
+{
+  auto request = sampleRequest(state.range(0));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto msg = fty::messagebus::mqtt::buildMessageForMqtt(request);
+    benchmark::DoNotOptimize(msg);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_BuildMessageForMqtt)->Apply(metaDataArgs);
+
+static void BM_MetaDataFromMqttProperties(benchmark::State& state)
+{
+  auto props = fty::messagebus::mqtt::getMqttProperties(sampleRequest(state.range(0)));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto meta = fty::messagebus::mqtt::getMetaDataFromMqttProperties(props);
+    benchmark::DoNotOptimize(meta);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_MetaDataFromMqttProperties)->Apply(metaDataArgs);
+#endif
+
+//----------------------------------------------------------------------
+// Amqp conversions
+//----------------------------------------------------------------------
+#ifdef FTY_BENCH_AMQP
+static void BM_GetAmqpMessage(benchmark::State& state)
+{
+  auto request = sampleRequest(state.range(0));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto msg = fty::messagebus::amqp::getAmqpMessage(request);
+    benchmark::DoNotOptimize(msg);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_GetAmqpMessage)->Apply(metaDataArgs);
+
+static void BM_GetAmqpMetaData(benchmark::State& state)
+{
+  auto msg = fty::messagebus::amqp::getAmqpMessage(sampleRequest(state.range(0)));
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    auto meta = fty::messagebus::amqp::getMetaData(msg);
+    benchmark::DoNotOptimize(meta);
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_GetAmqpMetaData)->Apply(metaDataArgs);
+#endif
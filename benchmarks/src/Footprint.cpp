@@ -0,0 +1,267 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "Allocations.h"
+#include "Backends.h"
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <malloc.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace bench;
+
+namespace
+{
+  // Memory and threads of the process, the deltas are reported by the benchmarks.
+  struct Footprint
+  {
+    int64_t rss = 0;     // Resident set size (bytes)
+    int64_t heap = 0;    // Heap in use, C libraries included (bytes)
+    int64_t threads = 0; // Threads of the process
+    // Allocations made by operator new, when entering and leaving now() to leave its own out
+    uint64_t allocsIn = 0;
+    uint64_t allocsOut = 0;
+
+    static Footprint now()
+    {
+      // Give freed memory back first, RSS deltas are otherwise hidden by free chunks.
+      malloc_trim(0);
+
+      Footprint footprint;
+      footprint.allocsIn = allocations();
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+      auto info = mallinfo2();
+      footprint.heap = static_cast<int64_t>(info.uordblks + info.hblkhd);
+#else
+      auto info = mallinfo();
+      footprint.heap = static_cast<int64_t>(info.uordblks) + info.hblkhd;
+#endif
+      {
+        std::ifstream statm("/proc/self/statm");
+        int64_t pages = 0;
+        if (statm >> pages >> pages)
+        {
+          footprint.rss = pages * sysconf(_SC_PAGESIZE);
+        }
+      }
+      std::error_code ec;
+      for (auto it = std::filesystem::directory_iterator("/proc/self/task", ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+      {
+        footprint.threads++;
+      }
+      footprint.allocsOut = allocations();
+      return footprint;
+    }
+  };
+
+  // Footprint of units (buses, subscriptions or messages), in total and per unit.
+  void report(benchmark::State& state, const Footprint& before, const Footprint& after, int64_t units)
+  {
+    // Summed over the iterations, averaged by the library.
+    auto add = [&state](const std::string& name, double value) {
+      auto& counter = state.counters[name];
+      counter.value += value;
+      counter.flags = benchmark::Counter::kAvgIterations;
+    };
+    auto addTotal = [&add, units](const std::string& name, double value) {
+      add(name, value);
+      add(name + "_per_unit", value / static_cast<double>(units));
+    };
+    addTotal("rss_bytes", static_cast<double>(after.rss - before.rss));
+    addTotal("heap_bytes", static_cast<double>(after.heap - before.heap));
+    addTotal("threads", static_cast<double>(after.threads - before.threads));
+    addTotal("allocs", static_cast<double>(after.allocsIn - before.allocsOut));
+  }
+
+  void busArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"buses"});
+    for (int64_t buses : {1, 8, 32})
+    {
+      benchmark->Args({buses});
+    }
+    benchmark->Iterations(3)->UseRealTime();
+  }
+
+  void subscriptionArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"subscriptions"});
+    for (int64_t subscriptions : {1, 16, 128})
+    {
+      benchmark->Args({subscriptions});
+    }
+    benchmark->Iterations(3)->UseRealTime();
+  }
+
+  // Brokers only, the loopback bus runs the listeners on the sending thread.
+  [[maybe_unused]] void queuedArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"messages", "payload"});
+    for (int64_t messages : {100, 1000, 10000})
+    {
+      benchmark->Args({messages, 1 << 10});
+    }
+    benchmark->Iterations(3)->UseRealTime();
+  }
+
+  // Shared dispatch pool created ahead, only the cost of each new unit is measured.
+  void warmUp()
+  {
+    utils::sharedPoolWorker();
+  }
+} // namespace
+
+// Footprint of connected bus instances: threads and buffers of the clients.
+template <typename Backend>
+static void BM_FootprintBuses(benchmark::State& state)
+{
+  warmUp();
+  auto count = static_cast<size_t>(state.range(0));
+  for (auto _ : state)
+  {
+    auto before = Footprint::now();
+    std::vector<std::shared_ptr<MessageBus>> buses;
+    for (size_t i = 0; i < count; i++)
+    {
+      auto bus = Backend::bus("bench-footprint");
+      if (!bus)
+      {
+        state.SkipWithError(bus.error().c_str());
+        return;
+      }
+      buses.emplace_back(*bus);
+    }
+    report(state, before, Footprint::now(), state.range(0));
+  }
+}
+BENCHMARK_BACKENDS(BM_FootprintBuses, busArgs);
+
+// Footprint of subscriptions on one bus: listeners, receivers and their threads.
+template <typename Backend>
+static void BM_FootprintSubscriptions(benchmark::State& state)
+{
+  warmUp();
+  auto bus = Backend::bus("bench-footprint");
+  if (!bus)
+  {
+    state.SkipWithError(bus.error().c_str());
+    return;
+  }
+
+  auto count = static_cast<size_t>(state.range(0));
+  for (auto _ : state)
+  {
+    auto before = Footprint::now();
+    for (size_t i = 0; i < count; i++)
+    {
+      if (!(*bus)->receive(Backend::address("footprint" + std::to_string(i)), [](const Message&) {}))
+      {
+        state.SkipWithError("Receive failed");
+        return;
+      }
+    }
+    report(state, before, Footprint::now(), state.range(0));
+
+    for (size_t i = 0; i < count; i++)
+    {
+      auto unreceived = (*bus)->unreceive(Backend::address("footprint" + std::to_string(i)));
+      (void)unreceived;
+    }
+  }
+}
+BENCHMARK_BACKENDS(BM_FootprintSubscriptions, subscriptionArgs);
+
+// Footprint of messages received and queued for dispatch, behind a listener stalled.
+template <typename Backend>
+static void BM_FootprintQueued(benchmark::State& state)
+{
+  warmUp();
+  auto sender = Backend::bus("bench-sender");
+  if (!sender)
+  {
+    state.SkipWithError(sender.error().c_str());
+    return;
+  }
+
+  // Single worker of the receiver, parked on a gate while the messages pile up in its queue.
+  auto executor = std::make_shared<utils::PoolWorker>(1);
+  auto receiver = Backend::bus("bench-footprint", executor);
+  if (!receiver)
+  {
+    state.SkipWithError(receiver.error().c_str());
+    return;
+  }
+
+  auto address = Backend::address("queued");
+  Inbox inbox;
+  if (!(*receiver)->receive(address, [&inbox](const Message&) { inbox.add(); }))
+  {
+    state.SkipWithError("Receive failed");
+    return;
+  }
+
+  auto count = static_cast<size_t>(state.range(0));
+  auto msg = Message::buildMessage("bench", address, "QUEUED", UserData(static_cast<size_t>(state.range(1)), 'x'));
+  uint64_t received = 0;
+  for (auto _ : state)
+  {
+    std::promise<void> gate;
+    auto opened = gate.get_future().share();
+    executor->offload([opened]() { opened.wait(); });
+
+    auto before = Footprint::now();
+    for (size_t i = 0; i < count; i++)
+    {
+      if (!(*sender)->send(msg))
+      {
+        gate.set_value();
+        state.SkipWithError("Send failed");
+        return;
+      }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (executor->jobMetrics().queueDepth < count && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto after = Footprint::now();
+    auto queued = executor->jobMetrics().queueDepth;
+    gate.set_value();
+
+    received += count;
+    if (!inbox.waitFor(received, std::chrono::seconds(30)))
+    {
+      state.SkipWithError("Messages lost");
+      break;
+    }
+    report(state, before, after, state.range(0));
+    state.counters["queued"] = static_cast<double>(queued);
+  }
+
+  auto unreceived = (*receiver)->unreceive(address);
+  (void)unreceived;
+}
+BENCHMARK_MQTT(BM_FootprintQueued, queuedArgs);
+BENCHMARK_AMQP(BM_FootprintQueued, queuedArgs);
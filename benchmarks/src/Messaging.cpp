@@ -0,0 +1,232 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "Backends.h"
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/RpcClient.h>
+#include <fty/messagebus/RpcServer.h>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+
+using namespace bench;
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  // Messages sent per iteration of the throughput benchmarks
+  constexpr size_t BATCH = 256;
+
+  const std::vector<int64_t> PAYLOAD_SIZES = {64, 1 << 10, 16 << 10, 256 << 10};
+
+  // Payload sizes x publishing threads
+  void publishArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"payload", "threads"});
+    for (auto size : PAYLOAD_SIZES)
+    {
+      for (int64_t threads : {1, 4})
+      {
+        benchmark->Args({size, threads});
+      }
+    }
+    benchmark->UseRealTime();
+  }
+
+  void latencyArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"payload"});
+    for (auto size : PAYLOAD_SIZES)
+    {
+      benchmark->Args({size});
+    }
+    benchmark->UseRealTime();
+  }
+
+  // Payload sizes x requests in flight
+  void requestArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    benchmark->ArgNames({"payload", "inflight"});
+    for (auto size : PAYLOAD_SIZES)
+    {
+      for (int64_t inflight : {1, 16, 64})
+      {
+        benchmark->Args({size, inflight});
+      }
+    }
+    benchmark->UseRealTime();
+  }
+
+  void reportPercentiles(benchmark::State& state, const fty::messagebus::utils::Histogram& histogram)
+  {
+    auto snapshot = histogram.snapshot();
+    state.counters["p50_us"] = static_cast<double>(snapshot.percentile(0.5)) / 1000.;
+    state.counters["p99_us"] = static_cast<double>(snapshot.percentile(0.99)) / 1000.;
+    state.counters["p999_us"] = static_cast<double>(snapshot.percentile(0.999)) / 1000.;
+    state.counters["max_us"] = static_cast<double>(snapshot.max) / 1000.;
+  }
+} // namespace
+
+// Publish throughput: batches of messages sent by a number of threads, until all received.
+template <typename Backend>
+static void BM_Publish(benchmark::State& state)
+{
+  auto peers = Backend::peers();
+  if (!peers)
+  {
+    state.SkipWithError(peers.error().c_str());
+    return;
+  }
+
+  auto address = Backend::address("publish");
+  Inbox inbox;
+  if (!peers->receiver->receive(address, [&inbox](const Message&) { inbox.add(); }))
+  {
+    state.SkipWithError("Receive failed");
+    return;
+  }
+
+  auto msg = Message::buildMessage("bench", address, "PUBLISH", UserData(static_cast<size_t>(state.range(0)), 'x'));
+  fty::messagebus::utils::PoolWorker publishers(static_cast<size_t>(state.range(1) - 1));
+  std::atomic_uint64_t failed{0};
+  uint64_t sent = 0;
+  for (auto _ : state)
+  {
+    publishers.parallelFor(0, BATCH, [&](size_t) {
+      if (!peers->sender->send(msg))
+      {
+        failed++;
+      }
+    });
+    sent += BATCH;
+    if (!inbox.waitFor(sent - failed.load()))
+    {
+      state.SkipWithError("Messages lost");
+      break;
+    }
+  }
+
+  auto unreceived = peers->receiver->unreceive(address);
+  (void)unreceived;
+  state.counters["failed"] = static_cast<double>(failed.load());
+  state.SetItemsProcessed(static_cast<int64_t>(inbox.count()));
+  state.SetBytesProcessed(static_cast<int64_t>(inbox.count() * msg.userData().size()));
+}
+BENCHMARK_BACKENDS(BM_Publish, publishArgs);
+
+// End-to-end latency: one message in flight, from send to the listener.
+template <typename Backend>
+static void BM_Latency(benchmark::State& state)
+{
+  auto peers = Backend::peers();
+  if (!peers)
+  {
+    state.SkipWithError(peers.error().c_str());
+    return;
+  }
+
+  auto address = Backend::address("latency");
+  fty::messagebus::utils::Histogram latency;
+  Clock::time_point sentAt;
+  Inbox inbox;
+  if (!peers->receiver->receive(address, [&](const Message&) {
+        latency.record(Clock::now() - sentAt);
+        inbox.add();
+      }))
+  {
+    state.SkipWithError("Receive failed");
+    return;
+  }
+
+  auto msg = Message::buildMessage("bench", address, "LATENCY", UserData(static_cast<size_t>(state.range(0)), 'x'));
+  uint64_t sent = 0;
+  for (auto _ : state)
+  {
+    sentAt = Clock::now();
+    if (!peers->sender->send(msg) || !inbox.waitFor(++sent))
+    {
+      state.SkipWithError("Message lost");
+      break;
+    }
+  }
+
+  auto unreceived = peers->receiver->unreceive(address);
+  (void)unreceived;
+  reportPercentiles(state, latency);
+}
+BENCHMARK_BACKENDS(BM_Latency, latencyArgs);
+
+// Request/reply: batches of concurrent calls through RpcClient and RpcServer.
+template <typename Backend>
+static void BM_RequestReply(benchmark::State& state)
+{
+  auto peers = Backend::peers();
+  if (!peers)
+  {
+    state.SkipWithError(peers.error().c_str());
+    return;
+  }
+
+  auto address = Backend::address("request");
+  RpcServer server(*peers->receiver, address);
+  auto handled = server.handle("ECHO", [](const Message& request) -> fty::Expected<UserData> { return request.userData(); });
+  RpcClient client(*peers->sender, "bench", Backend::address("reply"));
+  if (!handled || !server.start() || !client.start())
+  {
+    state.SkipWithError("Start failed");
+    return;
+  }
+
+  UserData payload(static_cast<size_t>(state.range(0)), 'x');
+  auto inflight = static_cast<size_t>(state.range(1));
+  fty::messagebus::utils::Histogram latency;
+  std::atomic_uint64_t failed{0};
+  Inbox replies;
+  uint64_t calls = 0;
+  for (auto _ : state)
+  {
+    for (size_t i = 0; i < inflight; i++)
+    {
+      auto start = Clock::now();
+      client.callAsync<UserData, UserData>(address, "ECHO", payload, start + std::chrono::seconds(10),
+                                           [&, start](fty::Expected<UserData>&& reply) {
+                                             latency.record(Clock::now() - start);
+                                             if (!reply)
+                                             {
+                                               failed++;
+                                             }
+                                             replies.add();
+                                           });
+    }
+    calls += inflight;
+    if (!replies.waitFor(calls, std::chrono::seconds(20)))
+    {
+      state.SkipWithError("Replies lost");
+      break;
+    }
+  }
+
+  client.stop();
+  server.stop();
+  state.counters["failed"] = static_cast<double>(failed.load());
+  state.SetItemsProcessed(static_cast<int64_t>(replies.count()));
+  reportPercentiles(state, latency);
+}
+BENCHMARK_BACKENDS(BM_RequestReply, requestArgs);
@@ -0,0 +1,76 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "Allocations.h"
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/Metrics.h>
+#include <fty/messagebus/MetricsBus.h>
+
+#include <LoopbackBus.h>
+
+using namespace fty::messagebus;
+
+//----------------------------------------------------------------------
+// Hot path cost of the metrics
+//----------------------------------------------------------------------
+static void BM_MetricsCounter(benchmark::State& state)
+{
+  static metrics::Counter counter;
+  for (auto _ : state)
+  {
+    counter.add();
+  }
+}
+BENCHMARK(BM_MetricsCounter)->ThreadRange(1, 8);
+
+// Lookup of the metrics of an address, same address (cached) or alternating between two.
+static void BM_MetricsAddress(benchmark::State& state)
+{
+  static metrics::Registry registry;
+  const Address addresses[] = {"/etn/q/metrics/0", "/etn/q/metrics/1"};
+  size_t index = 0;
+  bench::AllocationCounter allocations;
+  for (auto _ : state)
+  {
+    registry.address(addresses[index]).sentMessages.add();
+    index = (index + static_cast<size_t>(state.range(0))) & 1;
+  }
+  allocations.report(state);
+}
+BENCHMARK(BM_MetricsAddress)->ArgNames({"alternate"})->Arg(0)->Arg(1)->ThreadRange(1, 8);
+
+// Send and dispatch on the loopback bus, plain or through a metrics bus.
+static void BM_MetricsBusSend(benchmark::State& state)
+{
+  test::LoopbackBus bus;
+  MetricsBus metricsBus(bus, std::make_shared<metrics::Registry>());
+  MessageBus& sender = state.range(0) ? static_cast<MessageBus&>(metricsBus) : bus;
+  if (!sender.receive("/etn/q/metrics", [](const Message&) {}))
+  {
+    state.SkipWithError("receive failed");
+    return;
+  }
+  auto msg = Message::buildMessage("/etn/q/client", "/etn/q/metrics", "SUBJECT", UserData(256, 'x'));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(sender.send(msg));
+  }
+}
+BENCHMARK(BM_MetricsBusSend)->ArgNames({"metrics"})->Arg(0)->Arg(1);
@@ -0,0 +1,154 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/expected.h>
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBus.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+/// Capture of message streams, to replay real traffic offline
+///
+/// A capture file is a header followed by length-prefixed records, in host byte order:
+///   header: "FTYCAPT1", uint32 version, uint32 reserved
+///   record: uint32 length of the rest, uint8 direction, int64 timestamp (wall clock ns),
+///           uint32 metadata count, {uint32 size, key, uint32 size, value}..., uint32 size, user data
+/// The file grows by chunks of zeros: a zero length ends the records.
+namespace fty::messagebus
+{
+  enum class CaptureDirection : uint8_t
+  {
+    SENT = 0,
+    RECEIVED = 1,
+  };
+
+  /// Record of a capture file
+  struct CapturedMessage
+  {
+    CaptureDirection direction = CaptureDirection::SENT;
+    int64_t timestamp = 0;
+    Message message;
+  };
+
+  /// Memory-mapped writer of a capture file, records can be appended from any thread
+  class CaptureWriter
+  {
+  public:
+    /// Create a capture file, replacing an existing one
+    /// @param path path of the file
+    /// @param growth size by which the file is extended when full
+    /// @return Writer or error
+    static fty::Expected<std::shared_ptr<CaptureWriter>> create(const std::string& path, size_t growth = 16 * 1024 * 1024);
+
+    /// Cut the file to its records
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    /// Append a record
+    /// @return Success or error (file system full)
+    fty::Expected<void> append(CaptureDirection direction, int64_t timestamp, const Message& msg);
+
+    uint64_t records() const;
+
+  private:
+    CaptureWriter(int fd, size_t growth);
+
+    fty::Expected<void> reserve(size_t size);
+
+    int m_fd;
+    size_t m_growth;
+    mutable std::mutex m_mutex;
+    char* m_map = nullptr;
+    size_t m_capacity = 0;
+    size_t m_size = 0;
+    uint64_t m_records = 0;
+  };
+
+  /// Memory-mapped reader of a capture file
+  class CaptureReader
+  {
+  public:
+    /// Open a capture file
+    /// @param path path of the file
+    /// @return Reader or error
+    static fty::Expected<std::unique_ptr<CaptureReader>> open(const std::string& path);
+
+    ~CaptureReader();
+
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+
+    /// Next record, nothing at the end of the records
+    std::optional<CapturedMessage> next();
+
+    /// True if the records end on a truncated or invalid one (writer killed)
+    bool truncated() const;
+
+  private:
+    CaptureReader(const char* map, size_t size);
+
+    const char* m_map;
+    size_t m_size;
+    size_t m_offset;
+    bool m_truncated = false;
+  };
+
+  /// Message bus recording the messages sent and received through it in a capture file
+  ///
+  /// Messages are recorded once sent successfully, with the time send() was called. Requests are
+  /// recorded with their reply, as sent and received. A message failing to be recorded is still delivered.
+  class CaptureBus : public MessageBus
+  {
+  public:
+    /// @param bus decorated bus, it must outlive the capture bus
+    /// @param writer capture file, it may be shared between buses
+    CaptureBus(MessageBus& bus, std::shared_ptr<CaptureWriter> writer);
+
+    ~CaptureBus() override = default;
+
+    [[nodiscard]] fty::Expected<void> connect() noexcept override;
+    [[nodiscard]] fty::Expected<void> send(const Message& msg) noexcept override;
+    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {},
+                                              DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {}) noexcept override;
+    [[nodiscard]] fty::Expected<void> unreceive(const Address& address) noexcept override;
+    [[nodiscard]] fty::Expected<Message> request(const Message& msg, int timeOut) noexcept override;
+
+    [[nodiscard]] const ClientName& clientName() const noexcept override;
+    [[nodiscard]] const Identity& identity() const noexcept override;
+
+    /// Number of messages not recorded
+    uint64_t failed() const;
+
+  private:
+    struct State;
+
+    MessageBus& m_bus;
+    std::shared_ptr<State> m_state;
+  };
+
+} // namespace fty::messagebus
@@ -0,0 +1,122 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/expected.h>
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBus.h>
+#include <fty/messagebus/utils/MsgBusTimerWheel.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace fty::messagebus
+{
+  // Metadata of the chunks of a message
+  static constexpr auto CHUNK_ID         = "CHUNK_ID";         // Id shared by the chunks of a message
+  static constexpr auto CHUNK_INDEX      = "CHUNK_INDEX";      // Sequence number of the chunk, from 0
+  static constexpr auto CHUNK_COUNT      = "CHUNK_COUNT";      // Number of chunks of the message
+  static constexpr auto CHUNK_OFFSET     = "CHUNK_OFFSET";     // Offset of the chunk in the user data
+  static constexpr auto CHUNK_TOTAL_SIZE = "CHUNK_TOTAL_SIZE"; // Size of the whole user data
+
+  /// Chunk of a message seen by a streaming listener
+  struct Chunk
+  {
+    // Metadata of the message, user data of the chunk only
+    const Message& message;
+    size_t index;
+    size_t count;
+    size_t offset;
+    size_t totalSize;
+
+    bool last() const
+    {
+      return index + 1 == count;
+    }
+  };
+
+  using ChunkListener = std::function<void(const Chunk&)>;
+
+  /// Message bus splitting large messages in chunks
+  ///
+  /// Messages with a user data over the chunk size are sent as a sequence of smaller messages
+  /// carrying the CHUNK_* metadata, and reassembled on reception before reaching the listener.
+  /// Both sides of an address must go through a ChunkedBus.
+  class ChunkedBus : public MessageBus
+  {
+  public:
+    struct Options
+    {
+      // Maximum user data size of a message on the underlying bus
+      size_t chunkSize = 256 * 1024;
+      // Maximum size of the messages being reassembled at the same time, chunks beyond are dropped
+      size_t maxReassemblyBytes = 64 * 1024 * 1024;
+      // Delay without a new chunk after which a partial message is dropped
+      std::chrono::milliseconds timeout = std::chrono::seconds(30);
+      // Timer wheel dropping the partial messages (the shared one if null)
+      std::shared_ptr<utils::TimerWheel> timers;
+    };
+
+    /// @param bus bus carrying the chunks, it must outlive the chunked bus
+    ChunkedBus(MessageBus& bus);
+
+    /// @param bus bus carrying the chunks, it must outlive the chunked bus
+    /// @param options chunking and reassembly options
+    ChunkedBus(MessageBus& bus, Options options);
+
+    ~ChunkedBus() override = default;
+
+    [[nodiscard]] fty::Expected<void> connect() noexcept override;
+    [[nodiscard]] fty::Expected<void> send(const Message& msg) noexcept override;
+    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {},
+                                              DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {}) noexcept override;
+    [[nodiscard]] fty::Expected<void> unreceive(const Address& address) noexcept override;
+
+    /// Requests are not chunked, a request over the chunk size is not supported
+    [[nodiscard]] fty::Expected<Message> request(const Message& msg, int timeOut) noexcept override;
+
+    [[nodiscard]] const ClientName& clientName() const noexcept override;
+    [[nodiscard]] const Identity& identity() const noexcept override;
+
+    /// Register a listener seeing the chunks as they arrive, without reassembly
+    ///
+    /// Chunks of a message are seen in sequence. A message missing a chunk is cut short: its
+    /// following chunks, including the last one, are dropped. Other messages are seen as one chunk.
+    /// @param address the address to receive
+    /// @param func the function receiving the chunks
+    /// @param filter constraint the receiver with a filter
+    /// @return Success or error
+    [[nodiscard]] fty::Expected<void> receiveStream(const Address& address, ChunkListener&& func, const std::string& filter = {}) noexcept;
+
+    /// Number of chunks dropped: invalid, over the reassembly budget, out of sequence or timed out
+    uint64_t dropped() const;
+
+  private:
+    struct State;
+
+    MessageBus& m_bus;
+    Options m_options;
+    std::shared_ptr<State> m_state;
+  };
+
+} // namespace fty::messagebus
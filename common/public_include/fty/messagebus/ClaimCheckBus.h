@@ -0,0 +1,154 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/expected.h>
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBus.h>
+#include <fty/messagebus/utils/MsgBusTimerWheel.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace fty::messagebus
+{
+  // Metadata of a message sent by claim check
+  static constexpr auto CLAIM_CHECK_PATH = "CLAIM_CHECK_PATH"; // File holding the user data
+  static constexpr auto CLAIM_CHECK_SIZE = "CLAIM_CHECK_SIZE"; // Size of the user data
+
+  /// User data of a message received by claim check, mapped read-only
+  ///
+  /// The mapping is released with the last reference, it stays valid after the file is reclaimed.
+  class ClaimedPayload
+  {
+  public:
+    // Owner of the files: the effective user of the process
+    static constexpr uint32_t OWNER_SELF = UINT32_MAX;
+
+    /// Map the file of a claim check
+    ///
+    /// Symbolic links are not followed, the file must be a regular file of the owner.
+    /// @param path file holding the user data
+    /// @param size size of the user data
+    /// @param owner user id owning the file
+    /// @return Payload or error
+    static fty::Expected<std::shared_ptr<const ClaimedPayload>> map(const std::string& path, size_t size, uint32_t owner = OWNER_SELF);
+
+    /// Copy of a user data received without claim check
+    explicit ClaimedPayload(UserData data);
+
+    ~ClaimedPayload();
+
+    ClaimedPayload(const ClaimedPayload&) = delete;
+    ClaimedPayload& operator=(const ClaimedPayload&) = delete;
+    ClaimedPayload(ClaimedPayload&&) = delete;
+    ClaimedPayload& operator=(ClaimedPayload&&) = delete;
+
+    std::string_view data() const;
+
+  private:
+    ClaimedPayload(void* map, size_t size);
+
+    void* m_map = nullptr;
+    size_t m_size = 0;
+    UserData m_data;
+  };
+
+  using ClaimListener = std::function<void(const Message&, std::shared_ptr<const ClaimedPayload>)>;
+
+  /// Message bus passing large payloads through shared memory between peers of the same host
+  ///
+  /// The user data of messages over the threshold is written to a file of a shared memory
+  /// directory, and only its path is sent in the CLAIM_CHECK_* metadata. Files are reclaimed by
+  /// the sender once their time to live is over, on a timer, including after the destruction of
+  /// the claim check bus. Files of a sender that crashed or exited first are left behind: remove
+  /// the files of the directory starting with fty-messagebus- and older than the time to live, at
+  /// startup or periodically.
+  /// Both sides of an address must go through a ClaimCheckBus, run on the same host and be
+  /// allowed to read the files; receivers only map the files owned by the expected user.
+  class ClaimCheckBus : public MessageBus
+  {
+  public:
+    struct Options
+    {
+      // User data size above which messages are sent by claim check
+      size_t threshold = 1024 * 1024;
+      // Directory of the files, on a memory file system
+      std::string directory = "/dev/shm";
+      // Time for the receivers to map the file of a message
+      std::chrono::milliseconds ttl = std::chrono::seconds(60);
+      // Access permissions of the files
+      uint32_t permissions = 0600;
+      // User id owning the files received (the user of the process by default)
+      uint32_t owner = ClaimedPayload::OWNER_SELF;
+      // Timer wheel reclaiming the files (the shared one if null)
+      std::shared_ptr<utils::TimerWheel> timers;
+    };
+
+    /// @param bus bus carrying the messages, it must outlive the claim check bus
+    ClaimCheckBus(MessageBus& bus);
+
+    /// @param bus bus carrying the messages, it must outlive the claim check bus
+    /// @param options claim check options
+    ClaimCheckBus(MessageBus& bus, Options options);
+
+    /// Leave the files of the messages sent to the timer wheel until their time to live is over
+    ~ClaimCheckBus() override;
+
+    [[nodiscard]] fty::Expected<void> connect() noexcept override;
+    [[nodiscard]] fty::Expected<void> send(const Message& msg) noexcept override;
+    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {},
+                                              DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {}) noexcept override;
+    [[nodiscard]] fty::Expected<void> unreceive(const Address& address) noexcept override;
+
+    /// Requests are not sent by claim check, a request over the threshold is not supported
+    [[nodiscard]] fty::Expected<Message> request(const Message& msg, int timeOut) noexcept override;
+
+    [[nodiscard]] const ClientName& clientName() const noexcept override;
+    [[nodiscard]] const Identity& identity() const noexcept override;
+
+    /// Register a listener reading the user data in place, without copy
+    /// @param address the address to receive
+    /// @param func the function receiving the messages, without user data, and their payload
+    /// @param filter constraint the receiver with a filter
+    /// @param mode dispatch mode of the listener
+    /// @param orderingKey metadata key ordering the messages in DISPATCH_ORDERED mode (the address when empty)
+    /// @return Success or error
+    [[nodiscard]] fty::Expected<void> receiveClaimed(const Address& address, ClaimListener&& func, const std::string& filter = {},
+                                                     DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {}) noexcept;
+
+    /// Number of claim checks received but not mapped (file missing, reclaimed or invalid)
+    uint64_t failed() const;
+
+  private:
+    struct State;
+
+    fty::Expected<std::string> store(const UserData& data);
+
+    MessageBus& m_bus;
+    Options m_options;
+    std::shared_ptr<State> m_state;
+  };
+
+} // namespace fty::messagebus
@@ -0,0 +1,80 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/Message.h>
+
+#include <type_traits>
+#include <utility>
+
+namespace fty::messagebus
+{
+  /// Codec of the payload of a type, resolved at compile time
+  ///
+  /// Specialize it for a type with:
+  ///   static UserData encode(const T& value);
+  ///   static T decode(const UserData& payload);
+  /// decode may throw on a malformed payload.
+  template <typename T, typename Enable = void>
+  struct Codec;
+
+  /// UserData is the payload itself
+  template <>
+  struct Codec<UserData>
+  {
+    static UserData encode(const UserData& value)
+    {
+      return value;
+    }
+
+    static UserData decode(const UserData& payload)
+    {
+      return payload;
+    }
+  };
+
+  /// Types serialized by a member serialize() and deserialized by a constructor from UserData
+  template <typename T>
+  struct Codec<T, std::void_t<decltype(UserData(std::declval<const T&>().serialize())), decltype(T(std::declval<const UserData&>()))>>
+  {
+    static UserData encode(const T& value)
+    {
+      return value.serialize();
+    }
+
+    static T decode(const UserData& payload)
+    {
+      return T(payload);
+    }
+  };
+
+  /// True if a Codec is available for T
+  template <typename T, typename = void>
+  struct HasCodec : std::false_type
+  {
+  };
+
+  template <typename T>
+  struct HasCodec<T, std::void_t<decltype(Codec<T>::encode(std::declval<const T&>())), decltype(Codec<T>::decode(std::declval<const UserData&>()))>>
+    : std::true_type
+  {
+  };
+
+} // namespace fty::messagebus
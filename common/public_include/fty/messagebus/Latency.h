@@ -0,0 +1,125 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBus.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+/// Opt-in latency stamping of the messages, in reserved metadata
+///
+/// A sending process with stamping enabled stamps its messages on send() and when handing them to
+/// the client library (paho, proton). Receivers stamp the messages carrying a send stamp in the
+/// receive callback of the client library and when their listener starts, whatever their own
+/// setting, so the latency splits into our code, the client libraries with the broker and the
+/// dispatch queue. Stamps are wall clock nanoseconds: across hosts, the deltas include the clock skew.
+namespace fty::messagebus::latency
+{
+  // Metadata of the stamps
+  static constexpr auto STAMP_SEND = "STAMP_SEND";         // MessageBus::send called
+  static constexpr auto STAMP_WIRE = "STAMP_WIRE";         // Message handed to the client library
+  static constexpr auto STAMP_RECEIVE = "STAMP_RECEIVE";   // Receive callback of the client library
+  static constexpr auto STAMP_LISTENER = "STAMP_LISTENER"; // Listener started
+
+  /// Stamps of a message, 0 when missing
+  struct Stamps
+  {
+    int64_t send = 0;
+    int64_t wire = 0;
+    int64_t receive = 0;
+    int64_t listenerStart = 0;
+    int64_t listenerEnd = 0; // Only known by the observer
+
+    /// Our code and the conversion to the client library message
+    std::chrono::nanoseconds sendToWire() const
+    {
+      return delta(send, wire);
+    }
+
+    /// Client libraries and broker
+    std::chrono::nanoseconds wireToReceive() const
+    {
+      return delta(wire, receive);
+    }
+
+    /// Conversion from the client library message and dispatch queue
+    std::chrono::nanoseconds receiveToListener() const
+    {
+      return delta(receive, listenerStart);
+    }
+
+    /// Listener execution
+    std::chrono::nanoseconds listener() const
+    {
+      return delta(listenerStart, listenerEnd);
+    }
+
+    /// From send() to the end of the listener
+    std::chrono::nanoseconds total() const
+    {
+      return delta(send, listenerEnd ? listenerEnd : listenerStart);
+    }
+
+  private:
+    static std::chrono::nanoseconds delta(int64_t from, int64_t to)
+    {
+      return std::chrono::nanoseconds(from && to ? to - from : 0);
+    }
+  };
+
+  /// Called after each listener of a stamped message, on the dispatch thread
+  using Observer = std::function<void(const Stamps&)>;
+
+  /// Stamp the messages sent by this process, off unless FTY_MESSAGEBUS_LATENCY_STAMPS=1 is set
+  void enable(bool enabled);
+  bool enabled();
+
+  /// Observe the complete stamps of the messages received by this process (none when empty)
+  void observe(Observer observer);
+
+  /// Wall clock in nanoseconds since epoch
+  int64_t now();
+
+  /// Read the stamps of a message, in its listener
+  Stamps read(const Message& msg);
+
+  //----------------------------------------------------------------------
+  // Hooks of the backends
+  //----------------------------------------------------------------------
+
+  /// True if the metadata carry a send stamp
+  bool stamped(const MetaData& metaData);
+
+  /// Set a stamp
+  void stamp(MetaData& metaData, const char* key, int64_t value);
+
+  /// Stamp the reception of a message sent stamped
+  /// @param receivedAt time of the receive callback
+  void stampReceive(MetaData& metaData, int64_t receivedAt);
+
+  /// Run a listener, stamping a message sent stamped around it for the observer
+  ///
+  /// The listener of a stamped message gets a copy holding the listener stamp.
+  void invoke(const MessageListener& listener, const Message& msg);
+
+} // namespace fty::messagebus::latency
@@ -35,6 +35,13 @@ namespace fty::messagebus
 
   using MessageListener = std::function<void(const Message&)>;
 
+  // Listener dispatch mode
+  enum DispatchMode : uint8_t
+  {
+    DISPATCH_UNORDERED = 0, // Messages are dispatched concurrently, completion order is not guaranteed
+    DISPATCH_ORDERED = 1,   // Messages with the same ordering key are dispatched one at a time, in arrival order
+  };
+
   class MessageBus
   {
   public:
@@ -59,8 +66,11 @@ namespace fty::messagebus
     /// @param address the address to receive
     /// @param func the function to receive
     /// @param filter constraint the receiver with a filter
+    /// @param mode dispatch mode of the listener
+    /// @param orderingKey metadata key ordering the messages in DISPATCH_ORDERED mode (the address when empty)
     /// @return Success or error
-    virtual [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {}) noexcept = 0;
+    virtual [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {},
+                                                      DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {}) noexcept = 0;
 
     /// Unsubscribe from a address
     /// @param address the address to unsubscribe
@@ -0,0 +1,189 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+/// Metrics of the message buses
+///
+/// Counters are split in per-thread slots, incremented without contention and summed on read.
+/// A MetricsBus (see MetricsBus.h) feeds a registry with the traffic of the bus it decorates,
+/// the backends report their connection losses and reconnections to the shared registry.
+namespace fty::messagebus::metrics
+{
+  /// Monotonic counter, a relaxed increment of the slot of the calling thread
+  class Counter
+  {
+  public:
+    static constexpr size_t SLOTS = 16;
+
+    Counter() = default;
+
+    // Counter can't be copied, assigned or moved.
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    void add(uint64_t n = 1) noexcept
+    {
+      m_slots[threadSlot()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    /// Sum of the slots, increments running during the read may be missed
+    uint64_t value() const noexcept
+    {
+      uint64_t sum = 0;
+      for (const auto& slot : m_slots)
+      {
+        sum += slot.value.load(std::memory_order_relaxed);
+      }
+      return sum;
+    }
+
+  private:
+    struct alignas(64) Slot
+    {
+      std::atomic_uint64_t value{0};
+    };
+
+    // Threads get their slot in turn, they only share one beyond SLOTS threads.
+    // Constant initialized, the thread local has no initialization guard to check.
+    static size_t threadSlot() noexcept
+    {
+      static std::atomic_size_t next{0};
+      thread_local size_t slot = SLOTS;
+      if (__builtin_expect(slot == SLOTS, 0))
+      {
+        slot = next.fetch_add(1, std::memory_order_relaxed) % SLOTS;
+      }
+      return slot;
+    }
+
+    std::array<Slot, SLOTS> m_slots;
+  };
+
+  /// Value going up and down
+  class Gauge
+  {
+  public:
+    Gauge() = default;
+
+    // Gauge can't be copied, assigned or moved.
+    Gauge(const Gauge&) = delete;
+    Gauge& operator=(const Gauge&) = delete;
+
+    void add(int64_t n = 1) noexcept
+    {
+      m_value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void sub(int64_t n = 1) noexcept
+    {
+      m_value.fetch_sub(n, std::memory_order_relaxed);
+    }
+
+    int64_t value() const noexcept
+    {
+      return m_value.load(std::memory_order_relaxed);
+    }
+
+  private:
+    alignas(64) std::atomic_int64_t m_value{0};
+  };
+
+  /// Metrics of an address
+  struct AddressMetrics
+  {
+    Counter sentMessages;
+    Counter sentBytes;       // User data only
+    Counter receivedMessages;
+    Counter receivedBytes;   // User data only
+    Gauge inflightRequests;  // Requests waiting for their reply
+    Gauge inflightMessages;  // Listeners running
+    utils::Histogram requestLatency; // Nanoseconds, successful requests only
+  };
+
+  class Registry
+  {
+  public:
+    Registry();
+
+    // Registry can't be copied, assigned or moved.
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    /// Metrics of an address, created on first use and kept for the life of the registry
+    ///
+    /// The last address looked up by a thread is cached, repeated lookups do not lock.
+    AddressMetrics& address(const Address& address);
+
+    /// Count a delivery failure
+    void deliveryFailure(DeliveryState state) noexcept
+    {
+      m_deliveryFailures[index(state, m_deliveryFailures.size())].add();
+    }
+
+    /// Count a connection state change (connected, lost, reconnected, ...)
+    void connectionState(ComState state) noexcept
+    {
+      m_connectionStates[index(state, m_connectionStates.size())].add();
+    }
+
+    uint64_t deliveryFailures(DeliveryState state) const noexcept
+    {
+      return m_deliveryFailures[index(state, m_deliveryFailures.size())].value();
+    }
+
+    uint64_t connectionStates(ComState state) const noexcept
+    {
+      return m_connectionStates[index(state, m_connectionStates.size())].value();
+    }
+
+    /// Dump of the metrics in the Prometheus text exposition format
+    std::string exposition() const;
+
+  private:
+    // Out of range states are counted as undefined (the last one).
+    static size_t index(size_t state, size_t count) noexcept
+    {
+      return state < count ? state : count - 1;
+    }
+
+    const uint64_t m_id;
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<Address, std::unique_ptr<AddressMetrics>> m_addresses;
+    std::array<Counter, DELIVERY_STATE_UNDEFINED + 1> m_deliveryFailures;
+    std::array<Counter, COM_STATE_UNDEFINED + 1> m_connectionStates;
+  };
+
+  /// Registry shared by the buses of the process
+  std::shared_ptr<Registry> sharedRegistry();
+
+} // namespace fty::messagebus::metrics
@@ -0,0 +1,98 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/expected.h>
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBus.h>
+#include <fty/messagebus/Metrics.h>
+#include <fty/messagebus/utils/MsgBusTimerWheel.hpp>
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace fty::messagebus
+{
+  // Subject of the messages published by a MetricsPublisher
+  static constexpr auto METRICS_SUBJECT = "METRICS";
+
+  /// Message bus feeding a metrics registry with the traffic of another bus
+  ///
+  /// Sent and received messages are counted on their destination address, request replies on the
+  /// address of the request. Failures are counted by the delivery state of the error, and the result
+  /// of connect() by its com state. Connection losses and reconnections seen by the backends are
+  /// process-wide: they are counted in the shared registry only, whatever the registry given here.
+  class MetricsBus : public MessageBus
+  {
+  public:
+    /// @param bus decorated bus, it must outlive the metrics bus
+    /// @param registry registry of the metrics
+    MetricsBus(MessageBus& bus, std::shared_ptr<metrics::Registry> registry = metrics::sharedRegistry());
+
+    ~MetricsBus() override = default;
+
+    [[nodiscard]] fty::Expected<void> connect() noexcept override;
+    [[nodiscard]] fty::Expected<void> send(const Message& msg) noexcept override;
+    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& filter = {},
+                                              DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {}) noexcept override;
+    [[nodiscard]] fty::Expected<void> unreceive(const Address& address) noexcept override;
+    [[nodiscard]] fty::Expected<Message> request(const Message& msg, int timeOut) noexcept override;
+
+    [[nodiscard]] const ClientName& clientName() const noexcept override;
+    [[nodiscard]] const Identity& identity() const noexcept override;
+
+    metrics::Registry& registry() const;
+
+  private:
+    MessageBus& m_bus;
+    std::shared_ptr<metrics::Registry> m_registry;
+  };
+
+  /// Periodic publication of the exposition of a registry on a bus, scheduled on a timer wheel
+  class MetricsPublisher
+  {
+  public:
+    /// @param bus bus to publish on, it must outlive the publisher
+    /// @param address address of the publications
+    /// @param period delay between two publications
+    /// @param registry registry to publish
+    /// @param timers timer wheel scheduling the publications (the shared one if null)
+    MetricsPublisher(MessageBus& bus, const Address& address, std::chrono::milliseconds period,
+                     std::shared_ptr<metrics::Registry> registry = metrics::sharedRegistry(),
+                     std::shared_ptr<utils::TimerWheel> timers = nullptr);
+
+    /// Stop the publications, waiting for the one in progress
+    ~MetricsPublisher();
+
+    MetricsPublisher(const MetricsPublisher&) = delete;
+    MetricsPublisher& operator=(const MetricsPublisher&) = delete;
+
+    /// Publish the metrics now
+    /// @return Success or Delivery error
+    fty::Expected<void> publish();
+
+  private:
+    struct State;
+
+    std::shared_ptr<State> m_state;
+  };
+
+} // namespace fty::messagebus
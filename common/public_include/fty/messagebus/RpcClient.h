@@ -0,0 +1,161 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/expected.h>
+#include <fty/messagebus/Codec.h>
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBus.h>
+#include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/utils/MsgBusTimerWheel.hpp>
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+namespace fty::messagebus
+{
+  /// Client of typed requests
+  ///
+  /// Payloads are encoded and decoded by the Codec of the request and reply types. Replies are
+  /// received on a single address for all the calls and matched by correlation id, deadlines
+  /// are tracked on a timer wheel.
+  class RpcClient
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Completion of an asynchronous call, with the reply or the error
+    template <typename Resp>
+    using Completion = std::function<void(fty::Expected<Resp>&& reply)>;
+
+    /// @param bus connected bus, it must outlive the client
+    /// @param from sender of the requests
+    /// @param replyTo address receiving the replies of the client
+    /// @param timers timer wheel tracking the deadlines (the shared one if null)
+    RpcClient(MessageBus& bus, const Address& from, const Address& replyTo, std::shared_ptr<utils::TimerWheel> timers = nullptr);
+
+    /// Stop the client if started
+    ~RpcClient();
+
+    RpcClient(const RpcClient&) = delete;
+    RpcClient& operator=(const RpcClient&) = delete;
+    RpcClient(RpcClient&&) = delete;
+    RpcClient& operator=(RpcClient&&) = delete;
+
+    /// Start receiving the replies
+    /// @return Success or error
+    [[nodiscard]] fty::Expected<void> start();
+
+    /// Stop receiving the replies, calls in progress complete with an ABORTED error
+    void stop();
+
+    /// Call a subject and wait for the reply
+    ///
+    /// Not to be called from a listener running on the executor of the client's bus: with every
+    /// worker waiting, the reply can't be dispatched and the call only ends on its deadline.
+    /// @param address address of the server
+    /// @param subject subject of the request
+    /// @param request request payload
+    /// @param deadline time after which the call fails with a TIMEOUT error
+    /// @return Reply payload or error (the payload of a STATUS_KO reply)
+    template <typename Req, typename Resp>
+    fty::Expected<Resp> call(const Address& address, const std::string& subject, const Req& request, Clock::time_point deadline)
+    {
+      // The promise is shared with the completion, which may still be running when get() returns.
+      auto promise = std::make_shared<std::promise<fty::Expected<Resp>>>();
+      auto future = promise->get_future();
+      auto correlationId = post<Req, Resp>(address, subject, request, deadline, [promise](fty::Expected<Resp>&& reply) {
+        promise->set_value(std::move(reply));
+      });
+
+      // The deadline timer runs on the shared pool, it is late or never runs when the pool is saturated.
+      if (future.wait_until(deadline + DEADLINE_MARGIN) == std::future_status::timeout && cancel(correlationId))
+      {
+        return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_TIMEOUT));
+      }
+      return future.get();
+    }
+
+    /// Call a subject, the completion runs once the reply arrives or the call fails
+    /// @param address address of the server
+    /// @param subject subject of the request
+    /// @param request request payload
+    /// @param deadline time after which the call fails with a TIMEOUT error
+    /// @param completion completion called with the reply payload or error
+    template <typename Req, typename Resp>
+    void callAsync(const Address& address, const std::string& subject, const Req& request, Clock::time_point deadline, Completion<Resp>&& completion)
+    {
+      post<Req, Resp>(address, subject, request, deadline, std::move(completion));
+    }
+
+  private:
+    /// Handler of a reply, reply is null on error
+    using ReplyHandler = std::function<void(const Message* reply, const std::string& error)>;
+
+    struct Calls;
+
+    /// Margin of a synchronous call over its deadline, left to the deadline timer
+    static constexpr auto DEADLINE_MARGIN = std::chrono::milliseconds(100);
+
+    /// Send a call, returns its correlation id
+    template <typename Req, typename Resp>
+    std::string post(const Address& address, const std::string& subject, const Req& request, Clock::time_point deadline, Completion<Resp>&& completion)
+    {
+      static_assert(HasCodec<Req>::value, "No Codec for the request type");
+      static_assert(HasCodec<Resp>::value, "No Codec for the reply type");
+
+      // The payload is encoded in place, and decoded straight from the received message.
+      auto msg = Message::buildRequest(m_from, address, subject, m_replyTo);
+      msg.userData() = Codec<Req>::encode(request);
+      send(msg, deadline, [completion = std::move(completion)](const Message* reply, const std::string& error) {
+        if (!reply)
+        {
+          completion(fty::unexpected(error));
+          return;
+        }
+        fty::Expected<Resp> decoded = fty::unexpected("Invalid reply");
+        try
+        {
+          decoded = Codec<Resp>::decode(reply->userData());
+        }
+        catch (const std::exception& e)
+        {
+          decoded = fty::unexpected(e.what());
+        }
+        completion(std::move(decoded));
+      });
+      return msg.correlationId();
+    }
+
+    void send(const Message& request, Clock::time_point deadline, ReplyHandler&& handler);
+
+    /// Drop a call in progress, false if it is already completed
+    bool cancel(const std::string& correlationId);
+
+    MessageBus& m_bus;
+    Address m_from;
+    Address m_replyTo;
+    std::shared_ptr<Calls> m_calls;
+  };
+
+} // namespace fty::messagebus
@@ -0,0 +1,144 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/expected.h>
+#include <fty/messagebus/Message.h>
+#include <fty/messagebus/MessageBus.h>
+#include <fty/messagebus/utils/MsgBusDispatcher.hpp>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fty::messagebus
+{
+  /// Handler of a request subject
+  /// @return Payload of the reply (sent with STATUS_OK) or error (sent with STATUS_KO)
+  using RpcHandler = std::function<fty::Expected<UserData>(const Message& request)>;
+
+  /// Server of requests routed by subject
+  ///
+  /// Requests received on an address are dispatched to the handler of their subject, on a
+  /// pool with a bounded number of handlers running, and the reply is sent to their REPLY_TO
+  /// address through connected buses.
+  class RpcServer
+  {
+  public:
+    struct Options
+    {
+      // Handlers running at the same time (run on the receiving thread if 0)
+      size_t maxConcurrency = std::max(std::thread::hardware_concurrency(), 1u);
+      // Requests running or waiting for a handler, requests beyond are rejected
+      size_t maxPending = 1024;
+      // Connected buses sending the replies in turn (the receiving bus if empty)
+      std::vector<std::shared_ptr<MessageBus>> replyBuses;
+      // Pool of workers running the handlers (the shared one if null)
+      std::shared_ptr<utils::PoolWorker> executor;
+    };
+
+    /// @param bus connected bus receiving the requests, it must outlive the server
+    /// @param address address of the requests
+    RpcServer(MessageBus& bus, const Address& address);
+
+    /// @param bus connected bus receiving the requests, it must outlive the server
+    /// @param address address of the requests
+    /// @param options concurrency and replies options
+    RpcServer(MessageBus& bus, const Address& address, Options options);
+
+    /// Stop the server if started
+    ~RpcServer();
+
+    RpcServer(const RpcServer&) = delete;
+    RpcServer& operator=(const RpcServer&) = delete;
+    RpcServer(RpcServer&&) = delete;
+    RpcServer& operator=(RpcServer&&) = delete;
+
+    /// Register the handler of a subject, before starting the server
+    /// @param subject subject of the requests
+    /// @param handler handler of the requests
+    /// @return Success or error if the server is started
+    [[nodiscard]] fty::Expected<void> handle(const std::string& subject, RpcHandler handler);
+
+    /// Start receiving the requests
+    /// @return Success or error
+    [[nodiscard]] fty::Expected<void> start();
+
+    /// Stop receiving the requests and wait for the ones in progress
+    void stop();
+
+    /// Latency (ns) between the reception of the requests and the sending of their reply, per subject
+    std::map<std::string, utils::HistogramSnapshot> latency() const;
+
+    /// Number of requests rejected because of maxPending
+    uint64_t rejected() const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    using Handle = std::function<void(const Message&, Clock::time_point)>;
+    using Missing = std::function<void(const std::string&, const Message&, Clock::time_point)>;
+
+    struct Subject
+    {
+      RpcHandler handler;
+      std::unique_ptr<utils::Histogram> latency;
+    };
+
+    struct Request
+    {
+      Message message;
+      Clock::time_point received;
+    };
+
+    void onRequest(const Message& request);
+    void run(Request request);
+    void dispatch(const Request& request);
+    void reply(const Message& request, fty::Expected<UserData>&& result);
+
+    MessageBus& m_bus;
+    Address m_address;
+    Options m_options;
+
+    std::map<std::string, Subject> m_subjects;
+    std::unique_ptr<utils::HashedDispatcher<Handle, Missing>> m_dispatcher;
+    std::shared_ptr<utils::PoolWorker> m_executor;
+    std::atomic_size_t m_nextReplyBus{0};
+    std::atomic_uint64_t m_rejected{0};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_pending = 0;
+    // Handlers running, requests beyond wait in the queue
+    size_t m_running = 0;
+    std::deque<Request> m_queue;
+    bool m_started = false;
+  };
+
+} // namespace fty::messagebus
@@ -0,0 +1,497 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/dto/Fields.h>
+
+#include <cmath>
+#include <cstring>
+
+namespace fty::messagebus::dto
+{
+  class CborWriter
+  {
+  public:
+    explicit CborWriter(UserData& out)
+      : m_out(out)
+    {
+    }
+
+    void beginObject(size_t size)
+    {
+      head(MAP, size);
+    }
+
+    void key(std::string_view name)
+    {
+      value(name);
+    }
+
+    void endObject()
+    {
+    }
+
+    void beginArray(size_t size)
+    {
+      head(ARRAY, size);
+    }
+
+    void endArray()
+    {
+    }
+
+    void value(bool value)
+    {
+      m_out += static_cast<char>(value ? 0xf5 : 0xf4);
+    }
+
+    void value(int64_t value)
+    {
+      if (value >= 0)
+      {
+        head(UNSIGNED, static_cast<uint64_t>(value));
+      }
+      else
+      {
+        head(NEGATIVE, static_cast<uint64_t>(-(value + 1)));
+      }
+    }
+
+    void value(uint64_t value)
+    {
+      head(UNSIGNED, value);
+    }
+
+    void value(float value)
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      big(0xfa, bits);
+    }
+
+    void value(double value)
+    {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      big(0xfb, bits);
+    }
+
+    void value(std::string_view value)
+    {
+      head(TEXT, value.size());
+      m_out.append(value);
+    }
+
+  private:
+    static constexpr uint8_t UNSIGNED = 0;
+    static constexpr uint8_t NEGATIVE = 1;
+    static constexpr uint8_t TEXT = 3;
+    static constexpr uint8_t ARRAY = 4;
+    static constexpr uint8_t MAP = 5;
+
+    // Major type and argument, inline below 24 else in the smallest of 1, 2, 4 or 8 bytes.
+    void head(uint8_t major, uint64_t argument)
+    {
+      auto type = static_cast<uint8_t>(major << 5);
+      if (argument < 24)
+      {
+        m_out += static_cast<char>(type | argument);
+      }
+      else if (argument <= UINT8_MAX)
+      {
+        big(type | 24, static_cast<uint8_t>(argument));
+      }
+      else if (argument <= UINT16_MAX)
+      {
+        big(type | 25, static_cast<uint16_t>(argument));
+      }
+      else if (argument <= UINT32_MAX)
+      {
+        big(type | 26, static_cast<uint32_t>(argument));
+      }
+      else
+      {
+        big(type | 27, argument);
+      }
+    }
+
+    template <typename U>
+    void big(uint8_t marker, U value)
+    {
+      char buffer[1 + sizeof(U)];
+      buffer[0] = static_cast<char>(marker);
+      for (size_t i = 0; i < sizeof(U); i++)
+      {
+        buffer[sizeof(U) - i] = static_cast<char>(value >> (8 * i));
+      }
+      m_out.append(buffer, sizeof(buffer));
+    }
+
+    UserData& m_out;
+  };
+
+  class CborReader
+  {
+  public:
+    /// Members left in an object or array, until a break code if indefinite
+    struct Level
+    {
+      uint64_t remaining = 0;
+      bool indefinite = false;
+    };
+
+    explicit CborReader(std::string_view in)
+      : m_in(in)
+    {
+    }
+
+    Level beginObject()
+    {
+      return level(MAP, "Map expected");
+    }
+
+    bool nextKey(Level& level, std::string_view& key)
+    {
+      if (!next(level))
+      {
+        return false;
+      }
+      key = text();
+      return true;
+    }
+
+    Level beginArray()
+    {
+      return level(ARRAY, "Array expected");
+    }
+
+    bool nextItem(Level& level)
+    {
+      return next(level);
+    }
+
+    size_t sizeHint(const Level& level) const
+    {
+      // Each item takes at least one byte, do not trust a size beyond the payload.
+      return static_cast<size_t>(std::min<uint64_t>(level.remaining, m_in.size() - m_pos));
+    }
+
+    void read(bool& value)
+    {
+      auto initial = byte();
+      if (initial != 0xf4 && initial != 0xf5)
+      {
+        throw DecodeError("Boolean expected");
+      }
+      value = initial == 0xf5;
+    }
+
+    void read(int64_t& value)
+    {
+      bool negative;
+      auto argument = integer(negative);
+      if (argument > uint64_t(INT64_MAX))
+      {
+        throw DecodeError("Integer out of range");
+      }
+      value = negative ? -static_cast<int64_t>(argument) - 1 : static_cast<int64_t>(argument);
+    }
+
+    void read(uint64_t& value)
+    {
+      bool negative;
+      value = integer(negative);
+      if (negative)
+      {
+        throw DecodeError("Integer out of range");
+      }
+    }
+
+    void read(double& value)
+    {
+      switch (peek())
+      {
+        case 0xf9:
+          m_pos++;
+          value = half(big<uint16_t>());
+          break;
+        case 0xfa:
+        {
+          m_pos++;
+          auto bits = big<uint32_t>();
+          float single;
+          std::memcpy(&single, &bits, sizeof(single));
+          value = single;
+          break;
+        }
+        case 0xfb:
+        {
+          m_pos++;
+          auto bits = big<uint64_t>();
+          std::memcpy(&value, &bits, sizeof(value));
+          break;
+        }
+        default:
+        {
+          bool negative;
+          auto argument = integer(negative);
+          value = negative ? -1.0 - static_cast<double>(argument) : static_cast<double>(argument);
+          break;
+        }
+      }
+    }
+
+    void read(std::string& value)
+    {
+      value.assign(text());
+    }
+
+    void skip()
+    {
+      skip(0);
+    }
+
+    void finish()
+    {
+      if (m_pos != m_in.size())
+      {
+        throw DecodeError("Trailing bytes");
+      }
+    }
+
+  private:
+    static constexpr uint8_t UNSIGNED = 0;
+    static constexpr uint8_t NEGATIVE = 1;
+    static constexpr uint8_t BYTES = 2;
+    static constexpr uint8_t TEXT = 3;
+    static constexpr uint8_t ARRAY = 4;
+    static constexpr uint8_t MAP = 5;
+    static constexpr uint8_t TAG = 6;
+    static constexpr uint8_t SIMPLE = 7;
+    static constexpr uint8_t INDEFINITE = 31;
+    static constexpr uint8_t BREAK = 0xff;
+
+    void skip(size_t depth)
+    {
+      if (depth > MAX_SKIP_DEPTH)
+      {
+        throw DecodeError("Nesting too deep");
+      }
+      auto initial = byte();
+      auto major = initial >> 5;
+      auto info = initial & 0x1f;
+      if (info == INDEFINITE)
+      {
+        if (major == UNSIGNED || major == NEGATIVE || major == TAG)
+        {
+          throw DecodeError("Invalid indefinite length");
+        }
+        if (major == SIMPLE)
+        {
+          throw DecodeError("Unexpected break");
+        }
+        // Indefinite strings are chunked, containers end with a break.
+        Level level{0, true};
+        while (next(level))
+        {
+          skip(depth + 1);
+          if (major == MAP)
+          {
+            skip(depth + 1);
+          }
+        }
+        return;
+      }
+
+      auto value = argument(info);
+      switch (major)
+      {
+        case BYTES:
+        case TEXT:
+          bytes(value);
+          break;
+        case ARRAY:
+          for (uint64_t i = 0; i < value; i++)
+          {
+            skip(depth + 1);
+          }
+          break;
+        case MAP:
+          for (uint64_t i = 0; i < value; i++)
+          {
+            skip(depth + 1);
+            skip(depth + 1);
+          }
+          break;
+        case TAG:
+          skip(depth + 1);
+          break;
+        default:
+          break;
+      }
+    }
+
+    uint8_t peek()
+    {
+      if (m_pos >= m_in.size())
+      {
+        throw DecodeError("Unexpected end of payload");
+      }
+      return static_cast<uint8_t>(m_in[m_pos]);
+    }
+
+    uint8_t byte()
+    {
+      auto value = peek();
+      m_pos++;
+      return value;
+    }
+
+    std::string_view bytes(uint64_t size)
+    {
+      if (size > m_in.size() - m_pos)
+      {
+        throw DecodeError("Unexpected end of payload");
+      }
+      auto view = m_in.substr(m_pos, static_cast<size_t>(size));
+      m_pos += static_cast<size_t>(size);
+      return view;
+    }
+
+    template <typename U>
+    U big()
+    {
+      auto view = bytes(sizeof(U));
+      U value = 0;
+      for (auto c : view)
+      {
+        value = static_cast<U>((uint64_t(value) << 8) | static_cast<uint8_t>(c));
+      }
+      return value;
+    }
+
+    uint64_t argument(uint8_t info)
+    {
+      if (info < 24)
+      {
+        return info;
+      }
+      switch (info)
+      {
+        case 24:
+          return big<uint8_t>();
+        case 25:
+          return big<uint16_t>();
+        case 26:
+          return big<uint32_t>();
+        case 27:
+          return big<uint64_t>();
+        default:
+          throw DecodeError("Invalid additional information");
+      }
+    }
+
+    Level level(uint8_t major, const char* error)
+    {
+      auto initial = byte();
+      if ((initial >> 5) != major)
+      {
+        throw DecodeError(error);
+      }
+      if ((initial & 0x1f) == INDEFINITE)
+      {
+        return {0, true};
+      }
+      return {argument(initial & 0x1f), false};
+    }
+
+    bool next(Level& level)
+    {
+      if (level.indefinite)
+      {
+        if (peek() == BREAK)
+        {
+          m_pos++;
+          return false;
+        }
+        return true;
+      }
+      if (level.remaining == 0)
+      {
+        return false;
+      }
+      level.remaining--;
+      return true;
+    }
+
+    uint64_t integer(bool& negative)
+    {
+      auto initial = byte();
+      auto major = initial >> 5;
+      if (major != UNSIGNED && major != NEGATIVE)
+      {
+        throw DecodeError("Integer expected");
+      }
+      negative = major == NEGATIVE;
+      return argument(initial & 0x1f);
+    }
+
+    std::string_view text()
+    {
+      auto initial = byte();
+      if ((initial >> 5) != TEXT || (initial & 0x1f) == INDEFINITE)
+      {
+        throw DecodeError("Definite text string expected");
+      }
+      return bytes(argument(initial & 0x1f));
+    }
+
+    static double half(uint16_t bits)
+    {
+      auto exponent = (bits >> 10) & 0x1f;
+      auto mantissa = bits & 0x3ff;
+      double value;
+      if (exponent == 0)
+      {
+        value = std::ldexp(mantissa, -24);
+      }
+      else if (exponent != 31)
+      {
+        value = std::ldexp(mantissa + 1024, exponent - 25);
+      }
+      else
+      {
+        value = mantissa == 0 ? INFINITY : NAN;
+      }
+      return (bits & 0x8000) ? -value : value;
+    }
+
+    std::string_view m_in;
+    size_t m_pos = 0;
+  };
+
+  /// CBOR format
+  struct Cbor
+  {
+    using Writer = CborWriter;
+    using Reader = CborReader;
+  };
+
+} // namespace fty::messagebus::dto
@@ -0,0 +1,90 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/dto/Json.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace fty::messagebus::dto
+{
+  /// JSON reader on the simdjson on-demand parser
+  ///
+  /// The payload is copied to a padded buffer and parsed by a parser, both reused per thread.
+  /// Values are read in document order, skipped values are passed over by the parser.
+  /// The parser is built in the library: consumers do not depend on simdjson.
+  class SimdJsonReader
+  {
+  public:
+    /// Position in an object or array: index of its iterator in the reader
+    struct Level
+    {
+      size_t depth = 0;
+    };
+
+    explicit SimdJsonReader(std::string_view in);
+    ~SimdJsonReader();
+
+    SimdJsonReader(const SimdJsonReader&) = delete;
+    SimdJsonReader& operator=(const SimdJsonReader&) = delete;
+
+    Level beginObject();
+    bool nextKey(Level& level, std::string_view& key);
+    Level beginArray();
+    bool nextItem(Level& level);
+
+    static size_t sizeHint(const Level&)
+    {
+      return 0;
+    }
+
+    void read(bool& value);
+    void read(int64_t& value);
+    void read(uint64_t& value);
+    void read(double& value);
+    void read(std::string& value);
+
+    void skip()
+    {
+      // The parser skips the values not consumed when moving to the next one.
+    }
+
+    void finish();
+
+  private:
+    struct State;
+
+    std::unique_ptr<State> m_state;
+  };
+
+  /// JSON format parsed by simdjson
+  struct SimdJson
+  {
+    using Writer = JsonWriter;
+    using Reader = SimdJsonReader;
+  };
+
+  /// Fastest JSON format
+  using FastJson = SimdJson;
+
+} // namespace fty::messagebus::dto
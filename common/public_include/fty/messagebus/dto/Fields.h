@@ -0,0 +1,283 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/Message.h>
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace fty::messagebus::dto
+{
+  /// Field of a DTO: name on the wire and member
+  template <typename T, typename M>
+  struct Field
+  {
+    std::string_view name;
+    M T::*member;
+  };
+
+  template <typename T, typename M>
+  constexpr Field<T, M> field(std::string_view name, M T::*member)
+  {
+    return {name, member};
+  }
+
+  /// Nesting limit of the unknown values skipped by the readers
+  static constexpr size_t MAX_SKIP_DEPTH = 128;
+
+  /// Error of a malformed payload
+  class DecodeError : public std::runtime_error
+  {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  /// True if T declares its fields with:
+  ///   static constexpr auto fields() { return std::make_tuple(field("name", &T::name), ...); }
+  template <typename T, typename = void>
+  struct HasFields : std::false_type
+  {
+  };
+
+  template <typename T>
+  struct HasFields<T, std::void_t<decltype(T::fields())>> : std::true_type
+  {
+  };
+
+  template <typename T>
+  struct IsVector : std::false_type
+  {
+  };
+
+  template <typename T, typename A>
+  struct IsVector<std::vector<T, A>> : std::true_type
+  {
+  };
+
+  template <typename T>
+  struct IsStringMap : std::false_type
+  {
+  };
+
+  template <typename T, typename C, typename A>
+  struct IsStringMap<std::map<std::string, T, C, A>> : std::true_type
+  {
+  };
+
+  template <typename T>
+  struct Unsupported : std::false_type
+  {
+  };
+
+  // Generic encoding over the Writer of a format:
+  //   beginObject(size), key(name), endObject(), beginArray(size), endArray()
+  //   value(bool | int64_t | uint64_t | float | double | std::string_view)
+  template <typename Writer, typename V>
+  void write(Writer& writer, const V& value)
+  {
+    if constexpr (std::is_same_v<V, bool>)
+    {
+      writer.value(value);
+    }
+    else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>)
+    {
+      writer.value(static_cast<int64_t>(value));
+    }
+    else if constexpr (std::is_integral_v<V>)
+    {
+      writer.value(static_cast<uint64_t>(value));
+    }
+    else if constexpr (std::is_floating_point_v<V>)
+    {
+      writer.value(value);
+    }
+    else if constexpr (std::is_same_v<V, std::string>)
+    {
+      writer.value(std::string_view(value));
+    }
+    else if constexpr (IsVector<V>::value)
+    {
+      writer.beginArray(value.size());
+      for (const auto& item : value)
+      {
+        write<Writer, typename V::value_type>(writer, item);
+      }
+      writer.endArray();
+    }
+    else if constexpr (IsStringMap<V>::value)
+    {
+      writer.beginObject(value.size());
+      for (const auto& [key, item] : value)
+      {
+        writer.key(key);
+        write(writer, item);
+      }
+      writer.endObject();
+    }
+    else if constexpr (HasFields<V>::value)
+    {
+      constexpr auto fields = V::fields();
+      writer.beginObject(std::tuple_size_v<std::decay_t<decltype(fields)>>);
+      std::apply(
+        [&](const auto&... field) {
+          ((writer.key(field.name), write(writer, value.*(field.member))), ...);
+        },
+        fields);
+      writer.endObject();
+    }
+    else
+    {
+      static_assert(Unsupported<V>::value, "Type not supported by the DTO codec");
+    }
+  }
+
+  // Generic decoding over the Reader of a format, with a Level state per object or array:
+  //   beginObject(), nextKey(level, key), beginArray(), nextItem(level), sizeHint(level)
+  //   read(bool& | int64_t& | uint64_t& | double& | std::string&), skip(), finish()
+  template <typename Reader, typename V>
+  void read(Reader& reader, V& value)
+  {
+    if constexpr (std::is_same_v<V, bool>)
+    {
+      reader.read(value);
+    }
+    else if constexpr (std::is_integral_v<V>)
+    {
+      using Wide = std::conditional_t<std::is_signed_v<V>, int64_t, uint64_t>;
+      Wide wide;
+      reader.read(wide);
+      if (wide < static_cast<Wide>(std::numeric_limits<V>::min()) || wide > static_cast<Wide>(std::numeric_limits<V>::max()))
+      {
+        throw DecodeError("Integer out of range");
+      }
+      value = static_cast<V>(wide);
+    }
+    else if constexpr (std::is_floating_point_v<V>)
+    {
+      double wide;
+      reader.read(wide);
+      value = static_cast<V>(wide);
+    }
+    else if constexpr (std::is_same_v<V, std::string>)
+    {
+      reader.read(value);
+    }
+    else if constexpr (IsVector<V>::value)
+    {
+      value.clear();
+      auto level = reader.beginArray();
+      value.reserve(reader.sizeHint(level));
+      while (reader.nextItem(level))
+      {
+        typename V::value_type item{};
+        read(reader, item);
+        value.push_back(std::move(item));
+      }
+    }
+    else if constexpr (IsStringMap<V>::value)
+    {
+      value.clear();
+      auto level = reader.beginObject();
+      std::string_view key;
+      while (reader.nextKey(level, key))
+      {
+        read(reader, value[std::string(key)]);
+      }
+    }
+    else if constexpr (HasFields<V>::value)
+    {
+      constexpr auto fields = V::fields();
+      auto level = reader.beginObject();
+      std::string_view key;
+      while (reader.nextKey(level, key))
+      {
+        // Missing fields keep their default value, unknown ones are skipped.
+        bool found = std::apply(
+          [&](const auto&... field) {
+            return ((field.name == key ? (read(reader, value.*(field.member)), true) : false) || ...);
+          },
+          fields);
+        if (!found)
+        {
+          reader.skip();
+        }
+      }
+    }
+    else
+    {
+      static_assert(Unsupported<V>::value, "Type not supported by the DTO codec");
+    }
+  }
+
+  /// Encode a value with a format (Json, MsgPack or Cbor)
+  template <typename Format, typename T>
+  UserData encode(const T& value)
+  {
+    // One allocation covers the usual DTOs, larger ones grow geometrically.
+    UserData payload;
+    payload.reserve(256);
+    typename Format::Writer writer(payload);
+    write(writer, value);
+    return payload;
+  }
+
+  /// Decode a value with a format (Json, MsgPack or Cbor)
+  /// @throw DecodeError on a malformed payload
+  template <typename Format, typename T>
+  void decode(std::string_view payload, T& value)
+  {
+    typename Format::Reader reader(payload);
+    read(reader, value);
+    reader.finish();
+  }
+
+  template <typename Format, typename T>
+  T decode(std::string_view payload)
+  {
+    T value{};
+    decode<Format>(payload, value);
+    return value;
+  }
+
+  /// Codec of a DTO with a format, to plug into fty::messagebus::Codec:
+  ///   template <> struct fty::messagebus::Codec<MyDto> : dto::FieldCodec<MyDto, dto::MsgPack> {};
+  template <typename T, typename Format>
+  struct FieldCodec
+  {
+    static UserData encode(const T& value)
+    {
+      return dto::encode<Format>(value);
+    }
+
+    static T decode(const UserData& payload)
+    {
+      return dto::decode<Format, T>(payload);
+    }
+  };
+
+} // namespace fty::messagebus::dto
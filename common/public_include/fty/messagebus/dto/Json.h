@@ -0,0 +1,552 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/dto/Fields.h>
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace fty::messagebus::dto
+{
+  class JsonWriter
+  {
+  public:
+    explicit JsonWriter(UserData& out)
+      : m_out(out)
+    {
+    }
+
+    void beginObject(size_t)
+    {
+      separator();
+      m_out += '{';
+      m_first = true;
+    }
+
+    void key(std::string_view name)
+    {
+      separator();
+      string(name);
+      m_out += ':';
+      m_first = true;
+    }
+
+    void endObject()
+    {
+      m_out += '}';
+      m_first = false;
+    }
+
+    void beginArray(size_t)
+    {
+      separator();
+      m_out += '[';
+      m_first = true;
+    }
+
+    void endArray()
+    {
+      m_out += ']';
+      m_first = false;
+    }
+
+    void value(bool value)
+    {
+      separator();
+      m_out += value ? "true" : "false";
+    }
+
+    void value(int64_t value)
+    {
+      number(value);
+    }
+
+    void value(uint64_t value)
+    {
+      number(value);
+    }
+
+    void value(float value)
+    {
+      number(value);
+    }
+
+    void value(double value)
+    {
+      number(value);
+    }
+
+    void value(std::string_view value)
+    {
+      separator();
+      string(value);
+    }
+
+  private:
+    void separator()
+    {
+      if (!m_first)
+      {
+        m_out += ',';
+      }
+      m_first = false;
+    }
+
+    template <typename N>
+    void number(N value)
+    {
+      separator();
+      if constexpr (std::is_floating_point_v<N>)
+      {
+        if (!std::isfinite(value))
+        {
+          m_out += "null";
+          return;
+        }
+      }
+      char buffer[32];
+      auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+      m_out.append(buffer, result.ptr);
+    }
+
+    void string(std::string_view value)
+    {
+      static constexpr char HEX[] = "0123456789abcdef";
+
+      m_out += '"';
+      size_t start = 0;
+      for (size_t i = 0; i < value.size(); i++)
+      {
+        auto c = static_cast<unsigned char>(value[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+          continue;
+        }
+        m_out.append(value.data() + start, i - start);
+        start = i + 1;
+        switch (c)
+        {
+          case '"':
+            m_out += "\\\"";
+            break;
+          case '\\':
+            m_out += "\\\\";
+            break;
+          case '\n':
+            m_out += "\\n";
+            break;
+          case '\r':
+            m_out += "\\r";
+            break;
+          case '\t':
+            m_out += "\\t";
+            break;
+          default:
+            m_out += "\\u00";
+            m_out += HEX[c >> 4];
+            m_out += HEX[c & 0xf];
+            break;
+        }
+      }
+      m_out.append(value.data() + start, value.size() - start);
+      m_out += '"';
+    }
+
+    UserData& m_out;
+    bool m_first = true;
+  };
+
+  class JsonReader
+  {
+  public:
+    /// Position in an object or array: nothing read yet
+    struct Level
+    {
+      bool first = true;
+    };
+
+    explicit JsonReader(std::string_view in)
+      : m_in(in)
+    {
+    }
+
+    Level beginObject()
+    {
+      expect('{');
+      return {};
+    }
+
+    bool nextKey(Level& level, std::string_view& key)
+    {
+      if (!next(level, '}'))
+      {
+        return false;
+      }
+      key = string(m_key);
+      expect(':');
+      return true;
+    }
+
+    Level beginArray()
+    {
+      expect('[');
+      return {};
+    }
+
+    bool nextItem(Level& level)
+    {
+      return next(level, ']');
+    }
+
+    static size_t sizeHint(const Level&)
+    {
+      return 0;
+    }
+
+    void read(bool& value)
+    {
+      if (literal("true"))
+      {
+        value = true;
+      }
+      else if (literal("false"))
+      {
+        value = false;
+      }
+      else
+      {
+        throw DecodeError("Boolean expected");
+      }
+    }
+
+    void read(int64_t& value)
+    {
+      number(value);
+    }
+
+    void read(uint64_t& value)
+    {
+      number(value);
+    }
+
+    void read(double& value)
+    {
+      if (literal("null"))
+      {
+        value = std::numeric_limits<double>::quiet_NaN();
+        return;
+      }
+      number(value);
+    }
+
+    void read(std::string& value)
+    {
+      auto view = string(value);
+      if (view.data() != value.data())
+      {
+        value.assign(view);
+      }
+    }
+
+    void skip()
+    {
+      skip(0);
+    }
+
+    void finish()
+    {
+      skipSpaces();
+      if (m_pos != m_in.size())
+      {
+        throw DecodeError("Trailing characters");
+      }
+    }
+
+  private:
+    void skip(size_t depth)
+    {
+      if (depth > MAX_SKIP_DEPTH)
+      {
+        throw DecodeError("Nesting too deep");
+      }
+      switch (peek())
+      {
+        case '{':
+        {
+          auto level = beginObject();
+          std::string_view key;
+          while (nextKey(level, key))
+          {
+            skip(depth + 1);
+          }
+          break;
+        }
+        case '[':
+        {
+          auto level = beginArray();
+          while (nextItem(level))
+          {
+            skip(depth + 1);
+          }
+          break;
+        }
+        case '"':
+          string(m_key);
+          break;
+        case 't':
+        case 'f':
+        {
+          bool value;
+          read(value);
+          break;
+        }
+        case 'n':
+          if (!literal("null"))
+          {
+            throw DecodeError("Invalid literal");
+          }
+          break;
+        default:
+        {
+          double value;
+          number(value);
+          break;
+        }
+      }
+    }
+
+    void skipSpaces()
+    {
+      while (m_pos < m_in.size() && (m_in[m_pos] == ' ' || m_in[m_pos] == '\n' || m_in[m_pos] == '\r' || m_in[m_pos] == '\t'))
+      {
+        m_pos++;
+      }
+    }
+
+    char peek()
+    {
+      skipSpaces();
+      if (m_pos >= m_in.size())
+      {
+        throw DecodeError("Unexpected end of payload");
+      }
+      return m_in[m_pos];
+    }
+
+    void expect(char c)
+    {
+      if (peek() != c)
+      {
+        throw DecodeError(std::string("'") + c + "' expected");
+      }
+      m_pos++;
+    }
+
+    bool literal(std::string_view word)
+    {
+      skipSpaces();
+      if (m_in.substr(m_pos, word.size()) != word)
+      {
+        return false;
+      }
+      m_pos += word.size();
+      return true;
+    }
+
+    // Move to the next member of an object or array, false at its end.
+    bool next(Level& level, char end)
+    {
+      if (peek() == end)
+      {
+        m_pos++;
+        return false;
+      }
+      if (!level.first)
+      {
+        expect(',');
+      }
+      level.first = false;
+      return true;
+    }
+
+    template <typename N>
+    void number(N& value)
+    {
+      skipSpaces();
+      auto start = m_pos;
+      while (m_pos < m_in.size() && std::strchr("+-0123456789.eE", m_in[m_pos]) && m_in[m_pos] != '\0')
+      {
+        m_pos++;
+      }
+      auto result = std::from_chars(m_in.data() + start, m_in.data() + m_pos, value);
+      if (start == m_pos || result.ec != std::errc() || result.ptr != m_in.data() + m_pos)
+      {
+        throw DecodeError("Invalid number");
+      }
+    }
+
+    // String view in the payload when it has no escape, else decoded into buffer.
+    std::string_view string(std::string& buffer)
+    {
+      expect('"');
+      auto start = m_pos;
+      while (m_pos < m_in.size() && m_in[m_pos] != '"' && m_in[m_pos] != '\\')
+      {
+        m_pos++;
+      }
+      if (m_pos >= m_in.size())
+      {
+        throw DecodeError("Unterminated string");
+      }
+      if (m_in[m_pos] == '"')
+      {
+        return m_in.substr(start, m_pos++ - start);
+      }
+
+      buffer.assign(m_in.data() + start, m_pos - start);
+      while (true)
+      {
+        if (m_pos >= m_in.size())
+        {
+          throw DecodeError("Unterminated string");
+        }
+        auto c = m_in[m_pos++];
+        if (c == '"')
+        {
+          return buffer;
+        }
+        if (c != '\\')
+        {
+          buffer += c;
+          continue;
+        }
+        if (m_pos >= m_in.size())
+        {
+          throw DecodeError("Unterminated string");
+        }
+        switch (m_in[m_pos++])
+        {
+          case '"':
+            buffer += '"';
+            break;
+          case '\\':
+            buffer += '\\';
+            break;
+          case '/':
+            buffer += '/';
+            break;
+          case 'b':
+            buffer += '\b';
+            break;
+          case 'f':
+            buffer += '\f';
+            break;
+          case 'n':
+            buffer += '\n';
+            break;
+          case 'r':
+            buffer += '\r';
+            break;
+          case 't':
+            buffer += '\t';
+            break;
+          case 'u':
+            unicode(buffer);
+            break;
+          default:
+            throw DecodeError("Invalid escape");
+        }
+      }
+    }
+
+    uint32_t hex4()
+    {
+      if (m_pos + 4 > m_in.size())
+      {
+        throw DecodeError("Invalid unicode escape");
+      }
+      uint32_t code = 0;
+      auto result = std::from_chars(m_in.data() + m_pos, m_in.data() + m_pos + 4, code, 16);
+      if (result.ptr != m_in.data() + m_pos + 4)
+      {
+        throw DecodeError("Invalid unicode escape");
+      }
+      m_pos += 4;
+      return code;
+    }
+
+    // Decode \uXXXX (and its low surrogate) to UTF-8.
+    void unicode(std::string& buffer)
+    {
+      auto code = hex4();
+      if (code >= 0xd800 && code < 0xdc00)
+      {
+        if (m_in.substr(m_pos, 2) != "\\u")
+        {
+          throw DecodeError("Invalid surrogate pair");
+        }
+        m_pos += 2;
+        auto low = hex4();
+        if (low < 0xdc00 || low >= 0xe000)
+        {
+          throw DecodeError("Invalid surrogate pair");
+        }
+        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+      }
+
+      if (code < 0x80)
+      {
+        buffer += static_cast<char>(code);
+      }
+      else if (code < 0x800)
+      {
+        buffer += static_cast<char>(0xc0 | (code >> 6));
+        buffer += static_cast<char>(0x80 | (code & 0x3f));
+      }
+      else if (code < 0x10000)
+      {
+        buffer += static_cast<char>(0xe0 | (code >> 12));
+        buffer += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        buffer += static_cast<char>(0x80 | (code & 0x3f));
+      }
+      else
+      {
+        buffer += static_cast<char>(0xf0 | (code >> 18));
+        buffer += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+        buffer += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+        buffer += static_cast<char>(0x80 | (code & 0x3f));
+      }
+    }
+
+    std::string_view m_in;
+    size_t m_pos = 0;
+    std::string m_key;
+  };
+
+  /// JSON format
+  struct Json
+  {
+    using Writer = JsonWriter;
+    using Reader = JsonReader;
+  };
+
+} // namespace fty::messagebus::dto
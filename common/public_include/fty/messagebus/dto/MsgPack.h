@@ -0,0 +1,546 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/dto/Fields.h>
+
+#include <cstring>
+
+namespace fty::messagebus::dto
+{
+  class MsgPackWriter
+  {
+  public:
+    explicit MsgPackWriter(UserData& out)
+      : m_out(out)
+    {
+    }
+
+    void beginObject(size_t size)
+    {
+      header(size, 0x80, 0xde);
+    }
+
+    void key(std::string_view name)
+    {
+      value(name);
+    }
+
+    void endObject()
+    {
+    }
+
+    void beginArray(size_t size)
+    {
+      header(size, 0x90, 0xdc);
+    }
+
+    void endArray()
+    {
+    }
+
+    void value(bool value)
+    {
+      m_out += static_cast<char>(value ? 0xc3 : 0xc2);
+    }
+
+    void value(int64_t value)
+    {
+      if (value >= 0)
+      {
+        this->value(static_cast<uint64_t>(value));
+      }
+      else if (value >= -32)
+      {
+        m_out += static_cast<char>(value);
+      }
+      else if (value >= INT8_MIN)
+      {
+        big(0xd0, static_cast<uint8_t>(value));
+      }
+      else if (value >= INT16_MIN)
+      {
+        big(0xd1, static_cast<uint16_t>(value));
+      }
+      else if (value >= INT32_MIN)
+      {
+        big(0xd2, static_cast<uint32_t>(value));
+      }
+      else
+      {
+        big(0xd3, static_cast<uint64_t>(value));
+      }
+    }
+
+    void value(uint64_t value)
+    {
+      if (value < 0x80)
+      {
+        m_out += static_cast<char>(value);
+      }
+      else if (value <= UINT8_MAX)
+      {
+        big(0xcc, static_cast<uint8_t>(value));
+      }
+      else if (value <= UINT16_MAX)
+      {
+        big(0xcd, static_cast<uint16_t>(value));
+      }
+      else if (value <= UINT32_MAX)
+      {
+        big(0xce, static_cast<uint32_t>(value));
+      }
+      else
+      {
+        big(0xcf, value);
+      }
+    }
+
+    void value(float value)
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      big(0xca, bits);
+    }
+
+    void value(double value)
+    {
+      uint64_t bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      big(0xcb, bits);
+    }
+
+    void value(std::string_view value)
+    {
+      if (value.size() < 32)
+      {
+        m_out += static_cast<char>(0xa0 | value.size());
+      }
+      else if (value.size() <= UINT8_MAX)
+      {
+        big(0xd9, static_cast<uint8_t>(value.size()));
+      }
+      else
+      {
+        header(value.size(), 0xa0, 0xda);
+      }
+      m_out.append(value);
+    }
+
+  private:
+    // Fix header below 16 (32 for strings), else 16 or 32 bits size after the marker.
+    void header(size_t size, uint8_t fix, uint8_t marker)
+    {
+      if (size < (fix == 0xa0 ? 32u : 16u))
+      {
+        m_out += static_cast<char>(fix | size);
+      }
+      else if (size <= UINT16_MAX)
+      {
+        big(marker, static_cast<uint16_t>(size));
+      }
+      else
+      {
+        big(static_cast<uint8_t>(marker + 1), static_cast<uint32_t>(size));
+      }
+    }
+
+    template <typename U>
+    void big(uint8_t marker, U value)
+    {
+      char buffer[1 + sizeof(U)];
+      buffer[0] = static_cast<char>(marker);
+      for (size_t i = 0; i < sizeof(U); i++)
+      {
+        buffer[sizeof(U) - i] = static_cast<char>(value >> (8 * i));
+      }
+      m_out.append(buffer, sizeof(buffer));
+    }
+
+    UserData& m_out;
+  };
+
+  class MsgPackReader
+  {
+  public:
+    /// Members left in an object or array
+    struct Level
+    {
+      size_t remaining = 0;
+    };
+
+    explicit MsgPackReader(std::string_view in)
+      : m_in(in)
+    {
+    }
+
+    Level beginObject()
+    {
+      auto marker = byte();
+      if ((marker & 0xf0) == 0x80)
+      {
+        return {size_t(marker & 0x0f)};
+      }
+      if (marker == 0xde)
+      {
+        return {big<uint16_t>()};
+      }
+      if (marker == 0xdf)
+      {
+        return {big<uint32_t>()};
+      }
+      throw DecodeError("Map expected");
+    }
+
+    bool nextKey(Level& level, std::string_view& key)
+    {
+      if (level.remaining == 0)
+      {
+        return false;
+      }
+      level.remaining--;
+      key = string();
+      return true;
+    }
+
+    Level beginArray()
+    {
+      auto marker = byte();
+      if ((marker & 0xf0) == 0x90)
+      {
+        return {size_t(marker & 0x0f)};
+      }
+      if (marker == 0xdc)
+      {
+        return {big<uint16_t>()};
+      }
+      if (marker == 0xdd)
+      {
+        return {big<uint32_t>()};
+      }
+      throw DecodeError("Array expected");
+    }
+
+    bool nextItem(Level& level)
+    {
+      if (level.remaining == 0)
+      {
+        return false;
+      }
+      level.remaining--;
+      return true;
+    }
+
+    size_t sizeHint(const Level& level) const
+    {
+      // Each item takes at least one byte, do not trust a size beyond the payload.
+      return std::min(level.remaining, m_in.size() - m_pos);
+    }
+
+    void read(bool& value)
+    {
+      auto marker = byte();
+      if (marker != 0xc2 && marker != 0xc3)
+      {
+        throw DecodeError("Boolean expected");
+      }
+      value = marker == 0xc3;
+    }
+
+    void read(int64_t& value)
+    {
+      bool negative;
+      auto magnitude = integer(negative);
+      if (!negative && magnitude > uint64_t(INT64_MAX))
+      {
+        throw DecodeError("Integer out of range");
+      }
+      value = static_cast<int64_t>(magnitude);
+    }
+
+    void read(uint64_t& value)
+    {
+      bool negative;
+      value = integer(negative);
+      if (negative)
+      {
+        throw DecodeError("Integer out of range");
+      }
+    }
+
+    void read(double& value)
+    {
+      auto marker = peek();
+      if (marker == 0xca)
+      {
+        m_pos++;
+        auto bits = big<uint32_t>();
+        float single;
+        std::memcpy(&single, &bits, sizeof(single));
+        value = single;
+      }
+      else if (marker == 0xcb)
+      {
+        m_pos++;
+        auto bits = big<uint64_t>();
+        std::memcpy(&value, &bits, sizeof(value));
+      }
+      else
+      {
+        bool negative;
+        auto magnitude = integer(negative);
+        value = negative ? static_cast<double>(static_cast<int64_t>(magnitude)) : static_cast<double>(magnitude);
+      }
+    }
+
+    void read(std::string& value)
+    {
+      value.assign(string());
+    }
+
+    void skip()
+    {
+      skip(0);
+    }
+
+    void finish()
+    {
+      if (m_pos != m_in.size())
+      {
+        throw DecodeError("Trailing bytes");
+      }
+    }
+
+  private:
+    void skip(size_t depth)
+    {
+      if (depth > MAX_SKIP_DEPTH)
+      {
+        throw DecodeError("Nesting too deep");
+      }
+      auto marker = byte();
+      if (marker < 0x80 || marker >= 0xe0 || marker == 0xc0 || marker == 0xc2 || marker == 0xc3)
+      {
+        return;
+      }
+      if (marker < 0x90)
+      {
+        skipItems(2 * size_t(marker & 0x0f), depth);
+        return;
+      }
+      if (marker < 0xa0)
+      {
+        skipItems(marker & 0x0f, depth);
+        return;
+      }
+      if (marker < 0xc0)
+      {
+        bytes(marker & 0x1f);
+        return;
+      }
+      switch (marker)
+      {
+        case 0xc4:
+        case 0xd9:
+          bytes(big<uint8_t>());
+          break;
+        case 0xc5:
+        case 0xda:
+          bytes(big<uint16_t>());
+          break;
+        case 0xc6:
+        case 0xdb:
+          bytes(big<uint32_t>());
+          break;
+        case 0xc7:
+          bytes(1 + size_t(big<uint8_t>()));
+          break;
+        case 0xc8:
+          bytes(1 + size_t(big<uint16_t>()));
+          break;
+        case 0xc9:
+          bytes(1 + size_t(big<uint32_t>()));
+          break;
+        case 0xcc:
+        case 0xd0:
+          bytes(1);
+          break;
+        case 0xcd:
+        case 0xd1:
+          bytes(2);
+          break;
+        case 0xca:
+        case 0xce:
+        case 0xd2:
+          bytes(4);
+          break;
+        case 0xcb:
+        case 0xcf:
+        case 0xd3:
+          bytes(8);
+          break;
+        case 0xd4:
+        case 0xd5:
+        case 0xd6:
+        case 0xd7:
+        case 0xd8:
+          bytes(1 + (size_t(1) << (marker - 0xd4)));
+          break;
+        case 0xdc:
+          skipItems(big<uint16_t>(), depth);
+          break;
+        case 0xdd:
+          skipItems(big<uint32_t>(), depth);
+          break;
+        case 0xde:
+          skipItems(2 * size_t(big<uint16_t>()), depth);
+          break;
+        case 0xdf:
+          skipItems(2 * size_t(big<uint32_t>()), depth);
+          break;
+        default:
+          throw DecodeError("Invalid marker");
+      }
+    }
+
+    uint8_t peek()
+    {
+      if (m_pos >= m_in.size())
+      {
+        throw DecodeError("Unexpected end of payload");
+      }
+      return static_cast<uint8_t>(m_in[m_pos]);
+    }
+
+    uint8_t byte()
+    {
+      auto value = peek();
+      m_pos++;
+      return value;
+    }
+
+    std::string_view bytes(size_t size)
+    {
+      if (size > m_in.size() - m_pos)
+      {
+        throw DecodeError("Unexpected end of payload");
+      }
+      auto view = m_in.substr(m_pos, size);
+      m_pos += size;
+      return view;
+    }
+
+    template <typename U>
+    U big()
+    {
+      auto view = bytes(sizeof(U));
+      U value = 0;
+      for (auto c : view)
+      {
+        value = static_cast<U>((uint64_t(value) << 8) | static_cast<uint8_t>(c));
+      }
+      return value;
+    }
+
+    void skipItems(size_t count, size_t depth)
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        skip(depth + 1);
+      }
+    }
+
+    // Integer of any width, as magnitude bits and sign.
+    uint64_t integer(bool& negative)
+    {
+      auto marker = byte();
+      negative = false;
+      if (marker < 0x80)
+      {
+        return marker;
+      }
+      if (marker >= 0xe0)
+      {
+        negative = true;
+        return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(marker)));
+      }
+      switch (marker)
+      {
+        case 0xcc:
+          return big<uint8_t>();
+        case 0xcd:
+          return big<uint16_t>();
+        case 0xce:
+          return big<uint32_t>();
+        case 0xcf:
+          return big<uint64_t>();
+        case 0xd0:
+          return signedInteger<int8_t, uint8_t>(negative);
+        case 0xd1:
+          return signedInteger<int16_t, uint16_t>(negative);
+        case 0xd2:
+          return signedInteger<int32_t, uint32_t>(negative);
+        case 0xd3:
+          return signedInteger<int64_t, uint64_t>(negative);
+        default:
+          throw DecodeError("Integer expected");
+      }
+    }
+
+    template <typename S, typename U>
+    uint64_t signedInteger(bool& negative)
+    {
+      auto value = static_cast<int64_t>(static_cast<S>(big<U>()));
+      negative = value < 0;
+      return static_cast<uint64_t>(value);
+    }
+
+    std::string_view string()
+    {
+      auto marker = byte();
+      if ((marker & 0xe0) == 0xa0)
+      {
+        return bytes(marker & 0x1f);
+      }
+      switch (marker)
+      {
+        case 0xd9:
+          return bytes(big<uint8_t>());
+        case 0xda:
+          return bytes(big<uint16_t>());
+        case 0xdb:
+          return bytes(big<uint32_t>());
+        default:
+          throw DecodeError("String expected");
+      }
+    }
+
+    std::string_view m_in;
+    size_t m_pos = 0;
+  };
+
+  /// MessagePack format
+  struct MsgPack
+  {
+    using Writer = MsgPackWriter;
+    using Reader = MsgPackReader;
+  };
+
+} // namespace fty::messagebus::dto
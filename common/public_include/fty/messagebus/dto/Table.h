@@ -0,0 +1,630 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/dto/Fields.h>
+
+#include <cstring>
+#include <iterator>
+
+// Tables are stored little endian and read with plain loads.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Tables require a little endian host");
+
+namespace fty::messagebus::dto
+{
+  // Offset-table layout, every offset is relative to the start of its table or list:
+  //   table:  u32 field count N, u32 offset[N] of each field (0 when absent), field data
+  //   scalar: its bytes, bool as one byte
+  //   string: u32 size, bytes
+  //   list:   u32 count, then the packed scalars, or u32 offset[count] of each string or table
+  //   map:    u32 count, u32 offset[2 * count] of each key and value, keys sorted
+  // Fields are identified by their rank in fields(): new fields go last, readers ignore the
+  // ones they do not know and read the missing ones as value-initialized.
+
+  template <typename T>
+  class TableView;
+
+  template <typename E>
+  class ListView;
+
+  template <typename V>
+  class MapView;
+
+  template <typename T>
+  struct IsScalar : std::integral_constant<bool, std::is_arithmetic_v<T>>
+  {
+  };
+
+  template <typename T>
+  struct IsScalarVector : std::false_type
+  {
+  };
+
+  template <typename T, typename A>
+  struct IsScalarVector<std::vector<T, A>> : IsScalar<T>
+  {
+  };
+
+  /// Type returned by the view accessors for a field type
+  template <typename M, typename = void>
+  struct View
+  {
+    static_assert(Unsupported<M>::value, "Type not supported by the table views");
+  };
+
+  template <typename M>
+  struct View<M, std::enable_if_t<IsScalar<M>::value>>
+  {
+    using Type = M;
+  };
+
+  template <>
+  struct View<std::string>
+  {
+    using Type = std::string_view;
+  };
+
+  template <typename E, typename A>
+  struct View<std::vector<E, A>>
+  {
+    using Type = ListView<E>;
+  };
+
+  template <typename V, typename C, typename A>
+  struct View<std::map<std::string, V, C, A>>
+  {
+    using Type = MapView<V>;
+  };
+
+  template <typename M>
+  struct View<M, std::enable_if_t<HasFields<M>::value>>
+  {
+    using Type = TableView<M>;
+  };
+
+  template <typename M>
+  using ViewType = typename View<M>::Type;
+
+  template <typename P>
+  struct MemberOf;
+
+  template <typename T, typename M>
+  struct MemberOf<M T::*>
+  {
+    using Class = T;
+    using Type = M;
+  };
+
+  namespace table
+  {
+    inline uint32_t load32(const char* data)
+    {
+      uint32_t value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+
+    inline void store32(UserData& out, size_t position, uint32_t value)
+    {
+      std::memcpy(&out[position], &value, sizeof(value));
+    }
+
+    inline void append32(UserData& out, uint32_t value)
+    {
+      out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename S>
+    constexpr size_t scalarSize()
+    {
+      return std::is_same_v<S, bool> ? 1 : sizeof(S);
+    }
+
+    template <typename M>
+    ViewType<M> read(const char* data);
+
+    template <typename F, typename P>
+    constexpr bool isMember(const F& field, P member)
+    {
+      if constexpr (std::is_same_v<decltype(field.member), P>)
+      {
+        return field.member == member;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    /// Rank of a member in T::fields(), the number of fields if not found
+    template <typename T, auto Member, size_t I = 0>
+    constexpr size_t index()
+    {
+      constexpr auto fields = T::fields();
+      if constexpr (I == std::tuple_size_v<std::decay_t<decltype(fields)>>)
+      {
+        return I;
+      }
+      else if constexpr (isMember(std::get<I>(fields), Member))
+      {
+        return I;
+      }
+      else
+      {
+        return index<T, Member, I + 1>();
+      }
+    }
+
+    template <typename T>
+    void writeTable(UserData& out, const T& value);
+
+    template <typename M>
+    void write(UserData& out, const M& value)
+    {
+      if constexpr (IsScalar<M>::value)
+      {
+        if constexpr (std::is_same_v<M, bool>)
+        {
+          out += static_cast<char>(value ? 1 : 0);
+        }
+        else
+        {
+          out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+      }
+      else if constexpr (std::is_same_v<M, std::string>)
+      {
+        append32(out, static_cast<uint32_t>(value.size()));
+        out.append(value);
+      }
+      else if constexpr (IsScalarVector<M>::value)
+      {
+        append32(out, static_cast<uint32_t>(value.size()));
+        if constexpr (std::is_same_v<typename M::value_type, bool>)
+        {
+          for (bool item : value)
+          {
+            out += static_cast<char>(item ? 1 : 0);
+          }
+        }
+        else
+        {
+          out.append(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(typename M::value_type));
+        }
+      }
+      else if constexpr (IsVector<M>::value)
+      {
+        auto list = out.size();
+        append32(out, static_cast<uint32_t>(value.size()));
+        out.append(value.size() * sizeof(uint32_t), '\0');
+        for (size_t i = 0; i < value.size(); i++)
+        {
+          store32(out, list + sizeof(uint32_t) * (i + 1), static_cast<uint32_t>(out.size() - list));
+          write(out, value[i]);
+        }
+      }
+      else if constexpr (IsStringMap<M>::value)
+      {
+        auto map = out.size();
+        append32(out, static_cast<uint32_t>(value.size()));
+        out.append(2 * value.size() * sizeof(uint32_t), '\0');
+        size_t index = 0;
+        for (const auto& [key, item] : value)
+        {
+          store32(out, map + sizeof(uint32_t) * (++index), static_cast<uint32_t>(out.size() - map));
+          write(out, key);
+          store32(out, map + sizeof(uint32_t) * (++index), static_cast<uint32_t>(out.size() - map));
+          write(out, item);
+        }
+      }
+      else if constexpr (HasFields<M>::value)
+      {
+        writeTable(out, value);
+      }
+      else
+      {
+        static_assert(Unsupported<M>::value, "Type not supported by the table views");
+      }
+    }
+
+    template <typename T>
+    void writeTable(UserData& out, const T& value)
+    {
+      constexpr auto fields = T::fields();
+      constexpr size_t count = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+
+      auto table = out.size();
+      append32(out, count);
+      out.append(count * sizeof(uint32_t), '\0');
+      size_t index = 0;
+      std::apply(
+        [&](const auto&... field) {
+          ((store32(out, table + sizeof(uint32_t) * (++index), static_cast<uint32_t>(out.size() - table)), write(out, value.*(field.member))), ...);
+        },
+        fields);
+    }
+
+    /// Bounds check of a payload against the schema of its root table, in one pass
+    class Verifier
+    {
+    public:
+      explicit Verifier(std::string_view payload)
+        : m_payload(payload)
+        , m_budget(payload.size())
+      {
+      }
+
+      template <typename M>
+      void verify(size_t position, size_t depth)
+      {
+        // Each value of an encoded payload takes at least one byte: the budget bounds the
+        // work on crafted payloads with shared offsets.
+        if (m_budget-- == 0 || depth > MAX_SKIP_DEPTH)
+        {
+          throw DecodeError("Table too complex");
+        }
+
+        if constexpr (IsScalar<M>::value)
+        {
+          need(position, scalarSize<M>());
+        }
+        else if constexpr (std::is_same_v<M, std::string>)
+        {
+          need(position + sizeof(uint32_t), load(position));
+        }
+        else if constexpr (IsScalarVector<M>::value)
+        {
+          auto count = load(position);
+          if (count > (m_payload.size() - position - sizeof(uint32_t)) / scalarSize<typename M::value_type>())
+          {
+            throw DecodeError("List out of bounds");
+          }
+        }
+        else if constexpr (IsVector<M>::value)
+        {
+          auto count = load(position);
+          need(position + sizeof(uint32_t), size_t(count) * sizeof(uint32_t));
+          for (size_t i = 0; i < count; i++)
+          {
+            verify<typename M::value_type>(child(position, position + sizeof(uint32_t) * (i + 1), count), depth + 1);
+          }
+        }
+        else if constexpr (IsStringMap<M>::value)
+        {
+          auto count = load(position);
+          need(position + sizeof(uint32_t), size_t(count) * 2 * sizeof(uint32_t));
+          for (size_t i = 0; i < count; i++)
+          {
+            verify<std::string>(child(position, position + sizeof(uint32_t) * (2 * i + 1), 2 * size_t(count)), depth + 1);
+            verify<typename M::mapped_type>(child(position, position + sizeof(uint32_t) * (2 * i + 2), 2 * size_t(count)), depth + 1);
+          }
+        }
+        else if constexpr (HasFields<M>::value)
+        {
+          constexpr auto fields = M::fields();
+          constexpr size_t known = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+
+          auto count = load(position);
+          need(position + sizeof(uint32_t), size_t(count) * sizeof(uint32_t));
+          verifyFields<M>(position, std::min<size_t>(count, known), count, depth, std::make_index_sequence<known>());
+        }
+      }
+
+    private:
+      template <typename M, size_t... I>
+      void verifyFields(size_t table, size_t present, size_t count, size_t depth, std::index_sequence<I...>)
+      {
+        constexpr auto fields = M::fields();
+        ((I < present && load(table + sizeof(uint32_t) * (I + 1)) != 0
+            ? verify<typename MemberOf<decltype(std::get<I>(fields).member)>::Type>(child(table, table + sizeof(uint32_t) * (I + 1), count), depth + 1)
+            : void()),
+         ...);
+      }
+
+      void need(size_t position, size_t size)
+      {
+        if (position > m_payload.size() || size > m_payload.size() - position)
+        {
+          throw DecodeError("Table out of bounds");
+        }
+      }
+
+      uint32_t load(size_t position)
+      {
+        need(position, sizeof(uint32_t));
+        return load32(m_payload.data() + position);
+      }
+
+      // Position of a child from its offset, which must point after the offsets of its parent.
+      size_t child(size_t parent, size_t offsetPosition, size_t count)
+      {
+        auto offset = load32(m_payload.data() + offsetPosition);
+        if (offset < sizeof(uint32_t) * (count + 1))
+        {
+          throw DecodeError("Invalid table offset");
+        }
+        return parent + offset;
+      }
+
+      std::string_view m_payload;
+      size_t m_budget;
+    };
+  } // namespace table
+
+  /// Encode a DTO as a table
+  template <typename T>
+  UserData encodeTable(const T& value)
+  {
+    static_assert(HasFields<T>::value, "Tables encode DTOs declaring their fields");
+    UserData payload;
+    payload.reserve(256);
+    table::writeTable(payload, value);
+    return payload;
+  }
+
+  /// Read-only view of a list of a table
+  template <typename E>
+  class ListView
+  {
+  public:
+    class Iterator
+    {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = ViewType<E>;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = value_type;
+
+      Iterator(const ListView* list, size_t index)
+        : m_list(list)
+        , m_index(index)
+      {
+      }
+
+      value_type operator*() const
+      {
+        return (*m_list)[m_index];
+      }
+
+      Iterator& operator++()
+      {
+        m_index++;
+        return *this;
+      }
+
+      bool operator==(const Iterator& other) const
+      {
+        return m_index == other.m_index;
+      }
+
+      bool operator!=(const Iterator& other) const
+      {
+        return m_index != other.m_index;
+      }
+
+    private:
+      const ListView* m_list;
+      size_t m_index;
+    };
+
+    ListView() = default;
+
+    explicit ListView(const char* list)
+      : m_list(list)
+    {
+    }
+
+    size_t size() const
+    {
+      return m_list ? table::load32(m_list) : 0;
+    }
+
+    bool empty() const
+    {
+      return size() == 0;
+    }
+
+    ViewType<E> operator[](size_t index) const
+    {
+      if constexpr (IsScalar<E>::value)
+      {
+        return table::read<E>(m_list + sizeof(uint32_t) + index * table::scalarSize<E>());
+      }
+      else
+      {
+        return table::read<E>(m_list + table::load32(m_list + sizeof(uint32_t) * (index + 1)));
+      }
+    }
+
+    Iterator begin() const
+    {
+      return {this, 0};
+    }
+
+    Iterator end() const
+    {
+      return {this, size()};
+    }
+
+  private:
+    const char* m_list = nullptr;
+  };
+
+  /// Read-only view of a map of a table, with its keys in order
+  template <typename V>
+  class MapView
+  {
+  public:
+    MapView() = default;
+
+    explicit MapView(const char* map)
+      : m_map(map)
+    {
+    }
+
+    size_t size() const
+    {
+      return m_map ? table::load32(m_map) : 0;
+    }
+
+    bool empty() const
+    {
+      return size() == 0;
+    }
+
+    std::string_view key(size_t index) const
+    {
+      return table::read<std::string>(m_map + table::load32(m_map + sizeof(uint32_t) * (2 * index + 1)));
+    }
+
+    ViewType<V> value(size_t index) const
+    {
+      return table::read<V>(m_map + table::load32(m_map + sizeof(uint32_t) * (2 * index + 2)));
+    }
+
+    /// Index of a key (binary search), size() if absent
+    size_t find(std::string_view key) const
+    {
+      size_t low = 0;
+      size_t high = size();
+      while (low < high)
+      {
+        auto middle = low + (high - low) / 2;
+        if (this->key(middle) < key)
+        {
+          low = middle + 1;
+        }
+        else
+        {
+          high = middle;
+        }
+      }
+      return low < size() && this->key(low) == key ? low : size();
+    }
+
+  private:
+    const char* m_map = nullptr;
+  };
+
+  /// Read-only view of a DTO encoded as a table, fields are read from the payload on access
+  /// \warning The payload must outlive the view and the views it returns.
+  template <typename T>
+  class TableView
+  {
+  public:
+    /// View of an absent table, every field reads as value-initialized
+    TableView() = default;
+
+    /// Check the payload and view its root table
+    /// @throw DecodeError if the payload does not match the schema of T
+    explicit TableView(std::string_view payload)
+      : m_table(payload.data())
+    {
+      table::Verifier verifier(payload);
+      verifier.verify<T>(0, 0);
+    }
+
+    /// View a payload already checked
+    static TableView unchecked(const char* table)
+    {
+      TableView view;
+      view.m_table = table;
+      return view;
+    }
+
+    /// True if the field is present
+    template <auto Member>
+    bool has() const
+    {
+      return offset<fieldIndex<Member>()>() != 0;
+    }
+
+    /// Value of a field: scalars by value, strings as string_view, lists as ListView and DTOs as TableView
+    template <auto Member>
+    auto get() const -> ViewType<typename MemberOf<decltype(Member)>::Type>
+    {
+      using M = typename MemberOf<decltype(Member)>::Type;
+      auto fieldOffset = offset<fieldIndex<Member>()>();
+      if (fieldOffset == 0)
+      {
+        return ViewType<M>{};
+      }
+      return table::read<M>(m_table + fieldOffset);
+    }
+
+  private:
+    template <auto Member>
+    static constexpr size_t fieldIndex()
+    {
+      static_assert(std::is_same_v<typename MemberOf<decltype(Member)>::Class, T>, "Member of an other DTO");
+      constexpr auto index = table::index<T, Member>();
+      static_assert(index < std::tuple_size_v<std::decay_t<decltype(T::fields())>>, "Member is not a field of the DTO");
+      return index;
+    }
+
+    template <size_t I>
+    uint32_t offset() const
+    {
+      if (!m_table || I >= table::load32(m_table))
+      {
+        return 0;
+      }
+      return table::load32(m_table + sizeof(uint32_t) * (I + 1));
+    }
+
+    const char* m_table = nullptr;
+  };
+
+  namespace table
+  {
+    template <typename M>
+    ViewType<M> read(const char* data)
+    {
+      if constexpr (std::is_same_v<M, bool>)
+      {
+        return *data != 0;
+      }
+      else if constexpr (IsScalar<M>::value)
+      {
+        M value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+      }
+      else if constexpr (std::is_same_v<M, std::string>)
+      {
+        return std::string_view(data + sizeof(uint32_t), load32(data));
+      }
+      else if constexpr (IsVector<M>::value)
+      {
+        return ListView<typename M::value_type>(data);
+      }
+      else if constexpr (IsStringMap<M>::value)
+      {
+        return MapView<typename M::mapped_type>(data);
+      }
+      else
+      {
+        return TableView<M>::unchecked(data);
+      }
+    }
+  } // namespace table
+
+} // namespace fty::messagebus::dto
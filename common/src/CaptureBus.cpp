@@ -0,0 +1,410 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/CaptureBus.h"
+
+#include <fty/messagebus/Latency.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fty::messagebus
+{
+  namespace
+  {
+    static constexpr char MAGIC[8] = {'F', 'T', 'Y', 'C', 'A', 'P', 'T', '1'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+
+    std::string errorString(const std::string& what, int error = errno)
+    {
+      return what + ": " + std::strerror(error);
+    }
+
+    // Size of a record, length prefix included
+    size_t recordSize(const Message& msg)
+    {
+      size_t size = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(int64_t) + sizeof(uint32_t);
+      for (const auto& [key, value] : msg.metaData())
+      {
+        size += 2 * sizeof(uint32_t) + key.size() + value.size();
+      }
+      return size + sizeof(uint32_t) + msg.userData().size();
+    }
+
+    template <typename T>
+    char* put(char* out, T value)
+    {
+      std::memcpy(out, &value, sizeof(value));
+      return out + sizeof(value);
+    }
+
+    char* put(char* out, const std::string& text)
+    {
+      out = put(out, static_cast<uint32_t>(text.size()));
+      std::memcpy(out, text.data(), text.size());
+      return out + text.size();
+    }
+
+    // Bounds checked reading of a record
+    class Cursor
+    {
+    public:
+      Cursor(const char* data, size_t size)
+        : m_data(data)
+        , m_end(data + size)
+      {
+      }
+
+      template <typename T>
+      bool get(T& value)
+      {
+        if (static_cast<size_t>(m_end - m_data) < sizeof(value))
+        {
+          return false;
+        }
+        std::memcpy(&value, m_data, sizeof(value));
+        m_data += sizeof(value);
+        return true;
+      }
+
+      bool get(std::string& text)
+      {
+        uint32_t size;
+        if (!get(size) || static_cast<size_t>(m_end - m_data) < size)
+        {
+          return false;
+        }
+        text.assign(m_data, size);
+        m_data += size;
+        return true;
+      }
+
+      bool done() const
+      {
+        return m_data == m_end;
+      }
+
+    private:
+      const char* m_data;
+      const char* m_end;
+    };
+  } // namespace
+
+  //----------------------------------------------------------------------
+  // CaptureWriter
+  //----------------------------------------------------------------------
+  fty::Expected<std::shared_ptr<CaptureWriter>> CaptureWriter::create(const std::string& path, size_t growth)
+  {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+      return fty::unexpected(errorString("Create " + path));
+    }
+
+    std::shared_ptr<CaptureWriter> writer(new CaptureWriter(fd, std::max<size_t>(growth, 4096)));
+    if (auto reserved = writer->reserve(HEADER_SIZE); !reserved)
+    {
+      return fty::unexpected(reserved.error());
+    }
+    std::memcpy(writer->m_map, MAGIC, sizeof(MAGIC));
+    auto out = put(writer->m_map + sizeof(MAGIC), VERSION);
+    put(out, uint32_t(0));
+    writer->m_size = HEADER_SIZE;
+    return writer;
+  }
+
+  CaptureWriter::CaptureWriter(int fd, size_t growth)
+    : m_fd(fd)
+    , m_growth(growth)
+  {
+  }
+
+  CaptureWriter::~CaptureWriter()
+  {
+    if (m_map)
+    {
+      ::munmap(m_map, m_capacity);
+    }
+    // Drop the zeros of the last chunk, on failure they still end the records.
+    [[maybe_unused]] auto truncated = ::ftruncate(m_fd, static_cast<off_t>(m_size));
+    ::close(m_fd);
+  }
+
+  fty::Expected<void> CaptureWriter::append(CaptureDirection direction, int64_t timestamp, const Message& msg)
+  {
+    auto size = recordSize(msg);
+    if (size - sizeof(uint32_t) > UINT32_MAX)
+    {
+      return fty::unexpected("Message too large to be captured");
+    }
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    if (auto reserved = reserve(m_size + size); !reserved)
+    {
+      return reserved;
+    }
+
+    // Length written last, a record is only seen once complete.
+    auto record = m_map + m_size;
+    auto out = put(record + sizeof(uint32_t), static_cast<uint8_t>(direction));
+    out = put(out, timestamp);
+    out = put(out, static_cast<uint32_t>(msg.metaData().size()));
+    for (const auto& [key, value] : msg.metaData())
+    {
+      out = put(out, key);
+      out = put(out, value);
+    }
+    put(out, msg.userData());
+    put(record, static_cast<uint32_t>(size - sizeof(uint32_t)));
+
+    m_size += size;
+    m_records++;
+    return {};
+  }
+
+  uint64_t CaptureWriter::records() const
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    return m_records;
+  }
+
+  fty::Expected<void> CaptureWriter::reserve(size_t size)
+  {
+    if (size <= m_capacity)
+    {
+      return {};
+    }
+
+    auto capacity = std::max(m_capacity + m_growth, (size + m_growth - 1) / m_growth * m_growth);
+    // Blocks allocated up front: a full file system fails here rather than faulting on write.
+    if (int error = ::posix_fallocate(m_fd, static_cast<off_t>(m_capacity), static_cast<off_t>(capacity - m_capacity)); error != 0)
+    {
+      return fty::unexpected(errorString("Extend capture file", error));
+    }
+
+    void* map = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED)
+    {
+      return fty::unexpected(errorString("Map capture file"));
+    }
+    if (m_map)
+    {
+      ::munmap(m_map, m_capacity);
+    }
+    m_map = static_cast<char*>(map);
+    m_capacity = capacity;
+    return {};
+  }
+
+  //----------------------------------------------------------------------
+  // CaptureReader
+  //----------------------------------------------------------------------
+  fty::Expected<std::unique_ptr<CaptureReader>> CaptureReader::open(const std::string& path)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+      return fty::unexpected(errorString("Open " + path));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE)
+    {
+      ::close(fd);
+      return fty::unexpected("Not a capture file: " + path);
+    }
+
+    auto size = static_cast<size_t>(st.st_size);
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+      return fty::unexpected(errorString("Map " + path));
+    }
+
+    uint32_t version = 0;
+    std::memcpy(&version, static_cast<const char*>(map) + sizeof(MAGIC), sizeof(version));
+    if (std::memcmp(map, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION)
+    {
+      ::munmap(map, size);
+      return fty::unexpected("Not a capture file: " + path);
+    }
+    return std::unique_ptr<CaptureReader>(new CaptureReader(static_cast<const char*>(map), size));
+  }
+
+  CaptureReader::CaptureReader(const char* map, size_t size)
+    : m_map(map)
+    , m_size(size)
+    , m_offset(HEADER_SIZE)
+  {
+  }
+
+  CaptureReader::~CaptureReader()
+  {
+    ::munmap(const_cast<char*>(m_map), m_size);
+  }
+
+  std::optional<CapturedMessage> CaptureReader::next()
+  {
+    uint32_t length = 0;
+    if (m_size - m_offset < sizeof(length))
+    {
+      // Records end with the file or a zero length, a stray byte is the rest of a record.
+      m_truncated = m_truncated || m_offset != m_size;
+      return std::nullopt;
+    }
+    std::memcpy(&length, m_map + m_offset, sizeof(length));
+    if (length == 0)
+    {
+      return std::nullopt;
+    }
+    if (m_size - m_offset - sizeof(length) < length)
+    {
+      m_truncated = true;
+      m_offset = m_size;
+      return std::nullopt;
+    }
+
+    Cursor cursor(m_map + m_offset + sizeof(length), length);
+    CapturedMessage captured;
+    uint8_t direction = 0;
+    uint32_t count = 0;
+    bool valid = cursor.get(direction) && direction <= static_cast<uint8_t>(CaptureDirection::RECEIVED) && cursor.get(captured.timestamp) &&
+                 cursor.get(count);
+    for (uint32_t i = 0; valid && i < count; i++)
+    {
+      std::string key;
+      std::string value;
+      valid = cursor.get(key) && cursor.get(value);
+      captured.message.metaData().emplace(std::move(key), std::move(value));
+    }
+    valid = valid && cursor.get(captured.message.userData()) && cursor.done();
+    if (!valid)
+    {
+      m_truncated = true;
+      m_offset = m_size;
+      return std::nullopt;
+    }
+
+    captured.direction = static_cast<CaptureDirection>(direction);
+    m_offset += sizeof(length) + length;
+    return captured;
+  }
+
+  bool CaptureReader::truncated() const
+  {
+    return m_truncated;
+  }
+
+  //----------------------------------------------------------------------
+  // CaptureBus
+  //----------------------------------------------------------------------
+  struct CaptureBus::State
+  {
+    explicit State(std::shared_ptr<CaptureWriter> captureWriter)
+      : writer(std::move(captureWriter))
+    {
+    }
+
+    void record(CaptureDirection direction, int64_t timestamp, const Message& msg)
+    {
+      if (!writer->append(direction, timestamp, msg))
+      {
+        failed++;
+      }
+    }
+
+    std::shared_ptr<CaptureWriter> writer;
+    std::atomic_uint64_t failed{0};
+  };
+
+  CaptureBus::CaptureBus(MessageBus& bus, std::shared_ptr<CaptureWriter> writer)
+    : m_bus(bus)
+    , m_state(std::make_shared<State>(std::move(writer)))
+  {
+  }
+
+  fty::Expected<void> CaptureBus::connect() noexcept
+  {
+    return m_bus.connect();
+  }
+
+  fty::Expected<void> CaptureBus::send(const Message& msg) noexcept
+  {
+    auto sentAt = latency::now();
+    auto sent = m_bus.send(msg);
+    if (sent)
+    {
+      m_state->record(CaptureDirection::SENT, sentAt, msg);
+    }
+    return sent;
+  }
+
+  fty::Expected<void> CaptureBus::receive(const Address& address, MessageListener&& func, const std::string& filter, DispatchMode mode,
+                                          const std::string& orderingKey) noexcept
+  {
+    return m_bus.receive(
+      address,
+      [state = m_state, func = std::move(func)](const Message& msg) {
+        state->record(CaptureDirection::RECEIVED, latency::now(), msg);
+        func(msg);
+      },
+      filter, mode, orderingKey);
+  }
+
+  fty::Expected<void> CaptureBus::unreceive(const Address& address) noexcept
+  {
+    return m_bus.unreceive(address);
+  }
+
+  fty::Expected<Message> CaptureBus::request(const Message& msg, int timeOut) noexcept
+  {
+    auto sentAt = latency::now();
+    auto reply = m_bus.request(msg, timeOut);
+    if (reply)
+    {
+      m_state->record(CaptureDirection::SENT, sentAt, msg);
+      m_state->record(CaptureDirection::RECEIVED, latency::now(), *reply);
+    }
+    return reply;
+  }
+
+  const ClientName& CaptureBus::clientName() const noexcept
+  {
+    return m_bus.clientName();
+  }
+
+  const Identity& CaptureBus::identity() const noexcept
+  {
+    return m_bus.identity();
+  }
+
+  uint64_t CaptureBus::failed() const
+  {
+    return m_state->failed;
+  }
+
+} // namespace fty::messagebus
@@ -0,0 +1,439 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/ChunkedBus.h"
+
+#include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/utils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace fty::messagebus
+{
+  namespace
+  {
+    using Clock = std::chrono::steady_clock;
+
+    struct Header
+    {
+      std::string key;
+      size_t index = 0;
+      size_t count = 0;
+      size_t offset = 0;
+      size_t totalSize = 0;
+    };
+
+    // Size of the chunks of a message but the last one.
+    size_t chunkStride(size_t totalSize, size_t count)
+    {
+      return (totalSize + count - 1) / count;
+    }
+
+    bool isChunk(const Message& msg)
+    {
+      return msg.metaData().count(CHUNK_ID) != 0;
+    }
+
+    bool parse(const Message& msg, const char* key, size_t& value)
+    {
+      auto it = msg.metaData().find(key);
+      if (it == msg.metaData().end())
+      {
+        return false;
+      }
+      const auto& text = it->second;
+      auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+      return ec == std::errc() && end == text.data() + text.size();
+    }
+
+    // Chunk metadata of a message, nothing if inconsistent.
+    std::optional<Header> parseHeader(const Message& msg)
+    {
+      Header header;
+      if (!parse(msg, CHUNK_INDEX, header.index) || !parse(msg, CHUNK_COUNT, header.count) || !parse(msg, CHUNK_OFFSET, header.offset) ||
+          !parse(msg, CHUNK_TOTAL_SIZE, header.totalSize))
+      {
+        return std::nullopt;
+      }
+      // Chunks all have the size of the first one but the last, which holds the rest.
+      if (header.index >= header.count || header.count > header.totalSize)
+      {
+        return std::nullopt;
+      }
+      auto stride = chunkStride(header.totalSize, header.count);
+      auto size   = header.index + 1 == header.count ? header.totalSize - header.index * stride : stride;
+      if (header.offset != header.index * stride || msg.userData().size() != size)
+      {
+        return std::nullopt;
+      }
+      // Chunks of different senders may share an id.
+      header.key = msg.from() + "/" + msg.getMetaDataValue(CHUNK_ID);
+      return header;
+    }
+  } // namespace
+
+  struct ChunkedBus::State : public std::enable_shared_from_this<State>
+  {
+    struct Partial
+    {
+      Message message;
+      std::vector<bool> seen;
+      size_t chunks = 0;
+      Clock::time_point deadline;
+      uint64_t id = 0;
+      utils::TimerHandle timer;
+    };
+
+    struct Stream
+    {
+      size_t next = 0;
+      Clock::time_point deadline;
+      uint64_t id = 0;
+      utils::TimerHandle timer;
+    };
+
+    explicit State(const Options& opts)
+      : options(opts)
+      , timers(opts.timers ? opts.timers : utils::sharedTimerWheel())
+    {
+    }
+
+    ~State()
+    {
+      for (auto& [key, partial] : partials)
+      {
+        partial.timer.cancel();
+      }
+      for (auto& [key, stream] : streams)
+      {
+        stream.timer.cancel();
+      }
+    }
+
+    // Add a chunk to its message, return the message once complete.
+    std::optional<Message> assemble(const Message& msg)
+    {
+      auto header = parseHeader(msg);
+      if (!header)
+      {
+        dropped++;
+        return std::nullopt;
+      }
+
+      auto now = Clock::now();
+      std::unique_lock<std::mutex> lk(mutex);
+
+      auto it = partials.find(header->key);
+      if (it != partials.end() && it->second.deadline <= now)
+      {
+        // Timed out, its timer is late.
+        drop(it);
+        it = partials.end();
+      }
+      if (it == partials.end())
+      {
+        if (header->totalSize > options.maxReassemblyBytes - buffered)
+        {
+          // Messages timed out may still wait for their timer.
+          expire(now);
+        }
+        if (header->totalSize > options.maxReassemblyBytes - buffered)
+        {
+          dropped++;
+          return std::nullopt;
+        }
+
+        Partial partial;
+        partial.message.metaData(msg.metaData());
+        for (auto key : {CHUNK_ID, CHUNK_INDEX, CHUNK_COUNT, CHUNK_OFFSET, CHUNK_TOTAL_SIZE})
+        {
+          partial.message.metaData().erase(key);
+        }
+        partial.message.userData().resize(header->totalSize);
+        partial.seen.resize(header->count);
+        partial.deadline = now + options.timeout;
+        partial.id = ++lastId;
+        partial.timer = watch(header->key, partial.id, partial.deadline);
+        buffered += header->totalSize;
+        it = partials.emplace(header->key, std::move(partial)).first;
+      }
+
+      auto& partial = it->second;
+      if (partial.seen.size() != header->count || partial.message.userData().size() != header->totalSize || partial.seen[header->index])
+      {
+        dropped++;
+        return std::nullopt;
+      }
+      std::copy(msg.userData().begin(), msg.userData().end(), partial.message.userData().begin() + static_cast<std::ptrdiff_t>(header->offset));
+      partial.seen[header->index] = true;
+      partial.chunks++;
+      partial.deadline = now + options.timeout;
+
+      if (partial.chunks != header->count)
+      {
+        return std::nullopt;
+      }
+
+      // Offsets and sizes checked: every chunk seen covers the whole user data.
+      std::optional<Message> message = std::move(partial.message);
+      buffered -= header->totalSize;
+      partial.timer.cancel();
+      partials.erase(it);
+      return message;
+    }
+
+    // Check that a chunk follows the previous one of its message.
+    std::optional<Header> sequence(const Message& msg)
+    {
+      auto header = parseHeader(msg);
+      if (!header)
+      {
+        dropped++;
+        return std::nullopt;
+      }
+
+      auto now = Clock::now();
+      std::unique_lock<std::mutex> lk(mutex);
+
+      auto it = streams.find(header->key);
+      if (header->index == 0)
+      {
+        if (header->count > 1 && it == streams.end())
+        {
+          auto id = ++lastId;
+          streams[header->key] = {1, now + options.timeout, id, watch(header->key, id, now + options.timeout)};
+        }
+        else if (it != streams.end())
+        {
+          it->second.next = 1;
+          it->second.deadline = now + options.timeout;
+        }
+        return header;
+      }
+      if (it == streams.end() || it->second.next != header->index || it->second.deadline <= now)
+      {
+        // Gap in the sequence or timed out, cut the message short.
+        dropped++;
+        if (it != streams.end())
+        {
+          it->second.timer.cancel();
+          streams.erase(it);
+        }
+        return std::nullopt;
+      }
+      if (header->index + 1 == header->count)
+      {
+        it->second.timer.cancel();
+        streams.erase(it);
+      }
+      else
+      {
+        it->second.next++;
+        it->second.deadline = now + options.timeout;
+      }
+      return header;
+    }
+
+    // Watch the deadline of a message, under lock.
+    utils::TimerHandle watch(const std::string& key, uint64_t id, Clock::time_point deadline)
+    {
+      return timers->scheduleAt(deadline, [state = weak_from_this(), key, id]() {
+        if (auto locked = state.lock())
+        {
+          locked->timeout(key, id);
+        }
+      });
+    }
+
+    // Drop a message without a new chunk before its deadline, or watch its new deadline.
+    // Deadlines move on each chunk, the timer is only set again once it fires.
+    void timeout(const std::string& key, uint64_t id)
+    {
+      auto now = Clock::now();
+      std::unique_lock<std::mutex> lk(mutex);
+      if (auto it = partials.find(key); it != partials.end() && it->second.id == id)
+      {
+        if (it->second.deadline > now)
+        {
+          it->second.timer = watch(key, id, it->second.deadline);
+          return;
+        }
+        drop(it);
+      }
+      else if (auto stream = streams.find(key); stream != streams.end() && stream->second.id == id)
+      {
+        if (stream->second.deadline > now)
+        {
+          stream->second.timer = watch(key, id, stream->second.deadline);
+          return;
+        }
+        streams.erase(stream);
+      }
+    }
+
+    // Drop a partial message, under lock.
+    void drop(std::map<std::string, Partial>::iterator it)
+    {
+      it->second.timer.cancel();
+      dropped += it->second.chunks;
+      buffered -= it->second.message.userData().size();
+      partials.erase(it);
+    }
+
+    // Drop the messages without a new chunk before their deadline, under lock.
+    void expire(Clock::time_point now)
+    {
+      for (auto it = partials.begin(); it != partials.end();)
+      {
+        auto current = it++;
+        if (current->second.deadline <= now)
+        {
+          drop(current);
+        }
+      }
+    }
+
+    const Options options;
+    const std::shared_ptr<utils::TimerWheel> timers;
+    std::mutex mutex;
+    std::map<std::string, Partial> partials;
+    std::map<std::string, Stream> streams;
+    uint64_t lastId = 0;
+    size_t buffered = 0;
+    std::atomic_uint64_t dropped{0};
+  };
+
+  ChunkedBus::ChunkedBus(MessageBus& bus)
+    : ChunkedBus(bus, Options())
+  {
+  }
+
+  ChunkedBus::ChunkedBus(MessageBus& bus, Options options)
+    : m_bus(bus)
+    , m_options(std::move(options))
+    , m_state(std::make_shared<State>(m_options))
+  {
+    m_options.chunkSize = std::max(m_options.chunkSize, size_t(1));
+  }
+
+  fty::Expected<void> ChunkedBus::connect() noexcept
+  {
+    return m_bus.connect();
+  }
+
+  fty::Expected<void> ChunkedBus::send(const Message& msg) noexcept
+  {
+    const auto& data = msg.userData();
+    if (data.size() <= m_options.chunkSize)
+    {
+      return m_bus.send(msg);
+    }
+
+    // Chunks of even size, at most the chunk size, the receiver checks their offsets.
+    auto count  = (data.size() + m_options.chunkSize - 1) / m_options.chunkSize;
+    auto stride = chunkStride(data.size(), count);
+    Message chunk(msg.metaData(), {});
+    chunk.setMetaDataValue(CHUNK_ID, utils::generateUuid());
+    chunk.setMetaDataValue(CHUNK_COUNT, std::to_string(count));
+    chunk.setMetaDataValue(CHUNK_TOTAL_SIZE, std::to_string(data.size()));
+    for (size_t index = 0; index < count; index++)
+    {
+      auto offset = index * stride;
+      chunk.setMetaDataValue(CHUNK_INDEX, std::to_string(index));
+      chunk.setMetaDataValue(CHUNK_OFFSET, std::to_string(offset));
+      chunk.userData().assign(data, offset, stride);
+      auto sent = m_bus.send(chunk);
+      if (!sent)
+      {
+        return fty::unexpected(sent.error());
+      }
+    }
+    return {};
+  }
+
+  fty::Expected<void> ChunkedBus::receive(const Address& address, MessageListener&& func, const std::string& filter, DispatchMode mode,
+                                          const std::string& orderingKey) noexcept
+  {
+    auto listener = [state = m_state, func = std::move(func)](const Message& msg) {
+      if (!isChunk(msg))
+      {
+        func(msg);
+        return;
+      }
+      if (auto message = state->assemble(msg))
+      {
+        func(*message);
+      }
+    };
+    return m_bus.receive(address, std::move(listener), filter, mode, orderingKey);
+  }
+
+  fty::Expected<void> ChunkedBus::receiveStream(const Address& address, ChunkListener&& func, const std::string& filter) noexcept
+  {
+    auto listener = [state = m_state, func = std::move(func)](const Message& msg) {
+      if (!isChunk(msg))
+      {
+        func({msg, 0, 1, 0, msg.userData().size()});
+        return;
+      }
+      if (auto header = state->sequence(msg))
+      {
+        func({msg, header->index, header->count, header->offset, header->totalSize});
+      }
+    };
+    // Chunks of a message dispatched one at a time, in arrival order.
+    return m_bus.receive(address, std::move(listener), filter, DISPATCH_ORDERED, CHUNK_ID);
+  }
+
+  fty::Expected<void> ChunkedBus::unreceive(const Address& address) noexcept
+  {
+    return m_bus.unreceive(address);
+  }
+
+  fty::Expected<Message> ChunkedBus::request(const Message& msg, int timeOut) noexcept
+  {
+    if (msg.userData().size() > m_options.chunkSize)
+    {
+      return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_NOT_SUPPORTED));
+    }
+    return m_bus.request(msg, timeOut);
+  }
+
+  const ClientName& ChunkedBus::clientName() const noexcept
+  {
+    return m_bus.clientName();
+  }
+
+  const Identity& ChunkedBus::identity() const noexcept
+  {
+    return m_bus.identity();
+  }
+
+  uint64_t ChunkedBus::dropped() const
+  {
+    return m_state->dropped.load();
+  }
+
+} // namespace fty::messagebus
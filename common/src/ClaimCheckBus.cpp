@@ -0,0 +1,398 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/ClaimCheckBus.h"
+
+#include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/utils.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fty::messagebus
+{
+  namespace
+  {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto FILE_PREFIX = "fty-messagebus-";
+
+    std::string errorString(const std::string& what)
+    {
+      return what + ": " + std::strerror(errno);
+    }
+
+    // Claim check of a message, empty if sent as is.
+    std::string claimPath(const Message& msg)
+    {
+      return msg.getMetaDataValue(CLAIM_CHECK_PATH);
+    }
+
+    fty::Expected<std::shared_ptr<const ClaimedPayload>> claim(const Message& msg, const std::string& directory, uint32_t owner)
+    {
+      auto path = claimPath(msg);
+      auto name = directory + "/" + FILE_PREFIX;
+      // Only files written by a claim check bus can be mapped.
+      if (path.compare(0, name.size(), name) != 0 || path.find('/', name.size()) != std::string::npos)
+      {
+        return fty::unexpected("Invalid claim check path: " + path);
+      }
+
+      auto sizeText = msg.getMetaDataValue(CLAIM_CHECK_SIZE);
+      size_t size = 0;
+      auto [end, ec] = std::from_chars(sizeText.data(), sizeText.data() + sizeText.size(), size);
+      if (ec != std::errc() || end != sizeText.data() + sizeText.size())
+      {
+        return fty::unexpected("Invalid claim check size: " + sizeText);
+      }
+      return ClaimedPayload::map(path, size, owner);
+    }
+
+    // Message without the claim check metadata.
+    Message claimed(const Message& msg)
+    {
+      Message message(msg);
+      message.metaData().erase(CLAIM_CHECK_PATH);
+      message.metaData().erase(CLAIM_CHECK_SIZE);
+      return message;
+    }
+  } // namespace
+
+  //----------------------------------------------------------------------
+  // ClaimedPayload
+  //----------------------------------------------------------------------
+  fty::Expected<std::shared_ptr<const ClaimedPayload>> ClaimedPayload::map(const std::string& path, size_t size, uint32_t owner)
+  {
+    if (size == 0)
+    {
+      return std::make_shared<const ClaimedPayload>(UserData());
+    }
+
+    // The directory is shared with other users: no symbolic link, no file of someone else.
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW | O_NONBLOCK);
+    if (fd < 0)
+    {
+      return fty::unexpected(errorString("Open " + path));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != (owner == OWNER_SELF ? ::geteuid() : owner))
+    {
+      ::close(fd);
+      return fty::unexpected("Claim check file not trusted: " + path);
+    }
+    // A file shorter than announced would fault on access.
+    if (static_cast<size_t>(st.st_size) < size)
+    {
+      ::close(fd);
+      return fty::unexpected("Claim check file too short: " + path);
+    }
+
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+    {
+      return fty::unexpected(errorString("Map " + path));
+    }
+    return std::shared_ptr<const ClaimedPayload>(new ClaimedPayload(map, size));
+  }
+
+  ClaimedPayload::ClaimedPayload(UserData data)
+    : m_size(data.size())
+    , m_data(std::move(data))
+  {
+  }
+
+  ClaimedPayload::ClaimedPayload(void* map, size_t size)
+    : m_map(map)
+    , m_size(size)
+  {
+  }
+
+  ClaimedPayload::~ClaimedPayload()
+  {
+    if (m_map)
+    {
+      ::munmap(m_map, m_size);
+    }
+  }
+
+  std::string_view ClaimedPayload::data() const
+  {
+    return m_map ? std::string_view(static_cast<const char*>(m_map), m_size) : std::string_view(m_data);
+  }
+
+  //----------------------------------------------------------------------
+  // ClaimCheckBus
+  //----------------------------------------------------------------------
+  struct ClaimCheckBus::State : public std::enable_shared_from_this<State>
+  {
+    struct File
+    {
+      std::string path;
+      Clock::time_point deadline;
+    };
+
+    explicit State(std::weak_ptr<utils::TimerWheel> timerWheel)
+      : timers(timerWheel)
+    {
+    }
+
+    // Keep a file until its deadline.
+    void add(const std::string& path, Clock::time_point deadline)
+    {
+      std::unique_lock<std::mutex> lk(mutex);
+      files.push_back({path, deadline});
+      if (files.size() == 1)
+      {
+        schedule();
+      }
+    }
+
+    // Remove the files past their deadline.
+    void reclaim()
+    {
+      auto now = Clock::now();
+      std::unique_lock<std::mutex> lk(mutex);
+      while (!files.empty() && files.front().deadline <= now)
+      {
+        // Receivers having mapped the file keep their mapping.
+        ::unlink(files.front().path.c_str());
+        files.pop_front();
+      }
+      if (!files.empty())
+      {
+        schedule();
+      }
+    }
+
+    // Hand the files left to the timer wheel, which keeps the state until their deadline.
+    void release()
+    {
+      std::unique_lock<std::mutex> lk(mutex);
+      released = true;
+      if (!files.empty())
+      {
+        timer.cancel();
+        schedule();
+      }
+    }
+
+    // Wake up at the deadline of the oldest file, under lock.
+    // Once released, the timer owns the state: files left when the wheel is destroyed first are
+    // left to the cleanup of stale files.
+    void schedule()
+    {
+      auto wheel = timers.lock();
+      if (!wheel)
+      {
+        return;
+      }
+      if (released)
+      {
+        timer = wheel->scheduleAt(files.front().deadline, [state = shared_from_this()]() {
+          state->reclaim();
+        });
+      }
+      else
+      {
+        timer = wheel->scheduleAt(files.front().deadline, [state = weak_from_this()]() {
+          if (auto locked = state.lock())
+          {
+            locked->reclaim();
+          }
+        });
+      }
+    }
+
+    // Held by the bus, not to keep a wheel alive through its own timers
+    const std::weak_ptr<utils::TimerWheel> timers;
+    std::mutex mutex;
+    // Files sent, by deadline (same time to live for all)
+    std::deque<File> files;
+    utils::TimerHandle timer;
+    bool released = false;
+    std::atomic_uint64_t failed{0};
+  };
+
+  ClaimCheckBus::ClaimCheckBus(MessageBus& bus)
+    : ClaimCheckBus(bus, Options())
+  {
+  }
+
+  ClaimCheckBus::ClaimCheckBus(MessageBus& bus, Options options)
+    : m_bus(bus)
+    , m_options(std::move(options))
+  {
+    if (!m_options.timers)
+    {
+      m_options.timers = utils::sharedTimerWheel();
+    }
+    m_state = std::make_shared<State>(m_options.timers);
+  }
+
+  ClaimCheckBus::~ClaimCheckBus()
+  {
+    m_state->release();
+  }
+
+  fty::Expected<void> ClaimCheckBus::connect() noexcept
+  {
+    return m_bus.connect();
+  }
+
+  fty::Expected<void> ClaimCheckBus::send(const Message& msg) noexcept
+  {
+    if (msg.userData().size() <= m_options.threshold)
+    {
+      return m_bus.send(msg);
+    }
+
+    auto path = store(msg.userData());
+    if (!path)
+    {
+      return fty::unexpected(path.error());
+    }
+
+    Message check(msg.metaData(), {});
+    check.setMetaDataValue(CLAIM_CHECK_PATH, *path);
+    check.setMetaDataValue(CLAIM_CHECK_SIZE, std::to_string(msg.userData().size()));
+    auto sent = m_bus.send(check);
+    if (!sent)
+    {
+      // Nobody will claim it.
+      ::unlink(path->c_str());
+      return fty::unexpected(sent.error());
+    }
+
+    m_state->add(*path, Clock::now() + m_options.ttl);
+    return {};
+  }
+
+  fty::Expected<void> ClaimCheckBus::receive(const Address& address, MessageListener&& func, const std::string& filter, DispatchMode mode,
+                                             const std::string& orderingKey) noexcept
+  {
+    auto listener = [state = m_state, directory = m_options.directory, owner = m_options.owner, func = std::move(func)](const Message& msg) {
+      if (claimPath(msg).empty())
+      {
+        func(msg);
+        return;
+      }
+      auto payload = claim(msg, directory, owner);
+      if (!payload)
+      {
+        state->failed++;
+        return;
+      }
+      auto message = claimed(msg);
+      message.userData().assign((*payload)->data());
+      func(message);
+    };
+    return m_bus.receive(address, std::move(listener), filter, mode, orderingKey);
+  }
+
+  fty::Expected<void> ClaimCheckBus::receiveClaimed(const Address& address, ClaimListener&& func, const std::string& filter, DispatchMode mode,
+                                                    const std::string& orderingKey) noexcept
+  {
+    auto listener = [state = m_state, directory = m_options.directory, owner = m_options.owner, func = std::move(func)](const Message& msg) {
+      if (claimPath(msg).empty())
+      {
+        Message message(msg.metaData(), {});
+        func(message, std::make_shared<const ClaimedPayload>(msg.userData()));
+        return;
+      }
+      auto payload = claim(msg, directory, owner);
+      if (!payload)
+      {
+        state->failed++;
+        return;
+      }
+      func(claimed(msg), std::move(*payload));
+    };
+    return m_bus.receive(address, std::move(listener), filter, mode, orderingKey);
+  }
+
+  fty::Expected<void> ClaimCheckBus::unreceive(const Address& address) noexcept
+  {
+    return m_bus.unreceive(address);
+  }
+
+  fty::Expected<Message> ClaimCheckBus::request(const Message& msg, int timeOut) noexcept
+  {
+    if (msg.userData().size() > m_options.threshold)
+    {
+      return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_NOT_SUPPORTED));
+    }
+    return m_bus.request(msg, timeOut);
+  }
+
+  const ClientName& ClaimCheckBus::clientName() const noexcept
+  {
+    return m_bus.clientName();
+  }
+
+  const Identity& ClaimCheckBus::identity() const noexcept
+  {
+    return m_bus.identity();
+  }
+
+  uint64_t ClaimCheckBus::failed() const
+  {
+    return m_state->failed.load();
+  }
+
+  fty::Expected<std::string> ClaimCheckBus::store(const UserData& data)
+  {
+    auto path = m_options.directory + "/" + FILE_PREFIX + utils::generateUuid();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, static_cast<mode_t>(m_options.permissions));
+    if (fd < 0)
+    {
+      return fty::unexpected(errorString("Create " + path));
+    }
+
+    size_t written = 0;
+    while (written < data.size())
+    {
+      auto count = ::write(fd, data.data() + written, data.size() - written);
+      if (count < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (count <= 0)
+      {
+        auto error = errorString("Write " + path);
+        ::close(fd);
+        ::unlink(path.c_str());
+        return fty::unexpected(error);
+      }
+      written += static_cast<size_t>(count);
+    }
+    ::close(fd);
+    return path;
+  }
+
+} // namespace fty::messagebus
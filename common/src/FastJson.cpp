@@ -0,0 +1,201 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/dto/FastJson.h"
+
+#include <simdjson.h>
+
+#include <limits>
+#include <vector>
+
+namespace fty::messagebus::dto
+{
+  namespace
+  {
+    void check(simdjson::error_code error)
+    {
+      if (error != simdjson::SUCCESS)
+      {
+        throw DecodeError(simdjson::error_message(error));
+      }
+    }
+
+    // Move to the next member of an object or array, the first one on the first call.
+    template <typename Cursor>
+    bool next(Cursor& cursor)
+    {
+      if (cursor.started)
+      {
+        ++cursor.it;
+      }
+      cursor.started = true;
+      return cursor.it != cursor.end;
+    }
+  } // namespace
+
+  struct SimdJsonReader::State
+  {
+    template <typename Iterator>
+    struct Cursor
+    {
+      Iterator it;
+      Iterator end;
+      bool started = false;
+    };
+
+    // Objects and arrays being read, innermost last.
+    struct Nested
+    {
+      Cursor<simdjson::ondemand::object_iterator> object;
+      Cursor<simdjson::ondemand::array_iterator> array;
+    };
+
+    simdjson::ondemand::parser parser;
+    std::string buffer;
+    simdjson::ondemand::document document;
+    simdjson::ondemand::value value;
+    std::vector<Nested> nested;
+
+    // States released by the readers of the thread, with their parser and buffers.
+    static std::vector<std::unique_ptr<State>>& spare()
+    {
+      thread_local std::vector<std::unique_ptr<State>> states;
+      return states;
+    }
+  };
+
+  SimdJsonReader::SimdJsonReader(std::string_view in)
+  {
+    auto& spare = State::spare();
+    if (spare.empty())
+    {
+      m_state = std::make_unique<State>();
+    }
+    else
+    {
+      m_state = std::move(spare.back());
+      spare.pop_back();
+    }
+
+    auto& state = *m_state;
+    state.buffer.assign(in);
+    state.buffer.append(simdjson::SIMDJSON_PADDING, '\0');
+    check(state.parser.iterate(state.buffer.data(), in.size(), state.buffer.size()).get(state.document));
+    check(state.document.get_value().get(state.value));
+  }
+
+  SimdJsonReader::~SimdJsonReader()
+  {
+    m_state->nested.clear();
+    State::spare().push_back(std::move(m_state));
+  }
+
+  SimdJsonReader::Level SimdJsonReader::beginObject()
+  {
+    auto& state = *m_state;
+    simdjson::ondemand::object object;
+    check(state.value.get_object().get(object));
+    auto& nested = state.nested.emplace_back();
+    check(object.begin().get(nested.object.it));
+    check(object.end().get(nested.object.end));
+    return {state.nested.size() - 1};
+  }
+
+  bool SimdJsonReader::nextKey(Level& level, std::string_view& key)
+  {
+    auto& state = *m_state;
+    auto& cursor = state.nested[level.depth].object;
+    if (!next(cursor))
+    {
+      state.nested.resize(level.depth);
+      return false;
+    }
+    simdjson::ondemand::field field;
+    check((*cursor.it).get(field));
+    check(field.unescaped_key().get(key));
+    state.value = field.value();
+    return true;
+  }
+
+  SimdJsonReader::Level SimdJsonReader::beginArray()
+  {
+    auto& state = *m_state;
+    simdjson::ondemand::array array;
+    check(state.value.get_array().get(array));
+    auto& nested = state.nested.emplace_back();
+    check(array.begin().get(nested.array.it));
+    check(array.end().get(nested.array.end));
+    return {state.nested.size() - 1};
+  }
+
+  bool SimdJsonReader::nextItem(Level& level)
+  {
+    auto& state = *m_state;
+    auto& cursor = state.nested[level.depth].array;
+    if (!next(cursor))
+    {
+      state.nested.resize(level.depth);
+      return false;
+    }
+    check((*cursor.it).get(state.value));
+    return true;
+  }
+
+  void SimdJsonReader::read(bool& value)
+  {
+    check(m_state->value.get_bool().get(value));
+  }
+
+  void SimdJsonReader::read(int64_t& value)
+  {
+    check(m_state->value.get_int64().get(value));
+  }
+
+  void SimdJsonReader::read(uint64_t& value)
+  {
+    check(m_state->value.get_uint64().get(value));
+  }
+
+  void SimdJsonReader::read(double& value)
+  {
+    bool null = false;
+    if (m_state->value.is_null().get(null) == simdjson::SUCCESS && null)
+    {
+      value = std::numeric_limits<double>::quiet_NaN();
+      return;
+    }
+    check(m_state->value.get_double().get(value));
+  }
+
+  void SimdJsonReader::read(std::string& value)
+  {
+    std::string_view view;
+    check(m_state->value.get_string().get(view));
+    value.assign(view);
+  }
+
+  void SimdJsonReader::finish()
+  {
+    if (!m_state->document.at_end())
+    {
+      throw DecodeError("Trailing characters");
+    }
+  }
+
+} // namespace fty::messagebus::dto
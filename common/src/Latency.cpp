@@ -0,0 +1,118 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/Latency.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+  using namespace fty::messagebus;
+
+  bool enabledByEnvironment()
+  {
+    auto value = std::getenv("FTY_MESSAGEBUS_LATENCY_STAMPS");
+    return value && std::strcmp(value, "1") == 0;
+  }
+
+  std::atomic_bool g_enabled{enabledByEnvironment()};
+  std::shared_ptr<const latency::Observer> g_observer;
+
+  int64_t stampOf(const MetaData& metaData, const char* key)
+  {
+    auto it = metaData.find(key);
+    return it != metaData.end() ? std::strtoll(it->second.c_str(), nullptr, 10) : 0;
+  }
+} // namespace
+
+namespace fty::messagebus::latency
+{
+  void enable(bool enabled)
+  {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool enabled()
+  {
+    return g_enabled.load(std::memory_order_relaxed);
+  }
+
+  void observe(Observer observer)
+  {
+    std::atomic_store(&g_observer, observer ? std::make_shared<const Observer>(std::move(observer)) : nullptr);
+  }
+
+  int64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  Stamps read(const Message& msg)
+  {
+    const auto& metaData = msg.metaData();
+    Stamps stamps;
+    stamps.send = stampOf(metaData, STAMP_SEND);
+    stamps.wire = stampOf(metaData, STAMP_WIRE);
+    stamps.receive = stampOf(metaData, STAMP_RECEIVE);
+    stamps.listenerStart = stampOf(metaData, STAMP_LISTENER);
+    return stamps;
+  }
+
+  bool stamped(const MetaData& metaData)
+  {
+    return metaData.find(STAMP_SEND) != metaData.end();
+  }
+
+  void stamp(MetaData& metaData, const char* key, int64_t value)
+  {
+    metaData[key] = std::to_string(value);
+  }
+
+  void stampReceive(MetaData& metaData, int64_t receivedAt)
+  {
+    if (stamped(metaData))
+    {
+      stamp(metaData, STAMP_RECEIVE, receivedAt);
+    }
+  }
+
+  void invoke(const MessageListener& listener, const Message& msg)
+  {
+    if (!stamped(msg.metaData()))
+    {
+      listener(msg);
+      return;
+    }
+
+    Message stampedMsg(msg);
+    stamp(stampedMsg.metaData(), STAMP_LISTENER, now());
+    listener(stampedMsg);
+    auto listenerEnd = now();
+    if (auto observer = std::atomic_load(&g_observer))
+    {
+      auto stamps = read(stampedMsg);
+      stamps.listenerEnd = listenerEnd;
+      (*observer)(stamps);
+    }
+  }
+
+} // namespace fty::messagebus::latency
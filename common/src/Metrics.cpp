@@ -0,0 +1,249 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/Metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace fty::messagebus::metrics
+{
+  namespace
+  {
+    std::atomic_uint64_t nextRegistryId{1};
+
+    // Last address looked up by the thread
+    struct CachedAddress
+    {
+      uint64_t registry = 0;
+      Address address;
+      AddressMetrics* metrics = nullptr;
+    };
+
+    thread_local CachedAddress cachedAddress;
+
+    struct Bound
+    {
+      const char* label; // Seconds
+      uint64_t nanoseconds;
+    };
+
+    // Upper bounds of the request latency buckets
+    constexpr std::array<Bound, 12> LATENCY_BOUNDS = {{{"0.0001", 100'000},
+                                                       {"0.00025", 250'000},
+                                                       {"0.0005", 500'000},
+                                                       {"0.001", 1'000'000},
+                                                       {"0.0025", 2'500'000},
+                                                       {"0.005", 5'000'000},
+                                                       {"0.01", 10'000'000},
+                                                       {"0.025", 25'000'000},
+                                                       {"0.05", 50'000'000},
+                                                       {"0.1", 100'000'000},
+                                                       {"1", 1'000'000'000},
+                                                       {"10", 10'000'000'000}}};
+
+    std::string escape(const std::string& value)
+    {
+      std::string escaped;
+      escaped.reserve(value.size());
+      for (auto c : value)
+      {
+        switch (c)
+        {
+          case '\\':
+            escaped += "\\\\";
+            break;
+          case '"':
+            escaped += "\\\"";
+            break;
+          case '\n':
+            escaped += "\\n";
+            break;
+          default:
+            escaped += c;
+        }
+      }
+      return escaped;
+    }
+
+    std::string seconds(uint64_t nanoseconds)
+    {
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(nanoseconds) / 1e9);
+      return buffer;
+    }
+
+    void family(std::ostream& out, const char* name, const char* type, const char* help)
+    {
+      out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    }
+
+    void latency(std::ostream& out, const char* name, const std::string& label, const utils::HistogramSnapshot& snapshot)
+    {
+      uint64_t cumulative = 0;
+      size_t bucket = 0;
+      for (const auto& bound : LATENCY_BOUNDS)
+      {
+        // A bucket is counted under a bound it fully fits in.
+        while (bucket < snapshot.buckets.size() && utils::HistogramBuckets::highest(bucket) <= bound.nanoseconds)
+        {
+          cumulative += snapshot.buckets[bucket++];
+        }
+        out << name << "_bucket{" << label << ",le=\"" << bound.label << "\"} " << cumulative << "\n";
+      }
+      out << name << "_bucket{" << label << ",le=\"+Inf\"} " << snapshot.count << "\n";
+      out << name << "_sum{" << label << "} " << seconds(snapshot.sum) << "\n";
+      out << name << "_count{" << label << "} " << snapshot.count << "\n";
+    }
+
+    // Counters by state, states sharing a name (the undefined ones) are merged.
+    template <typename State, size_t COUNT>
+    void states(std::ostream& out, const char* name, const std::array<Counter, COUNT>& counters)
+    {
+      std::vector<std::pair<std::string, uint64_t>> values;
+      for (size_t state = 0; state < COUNT; state++)
+      {
+        auto value = counters[state].value();
+        if (value == 0)
+        {
+          continue;
+        }
+        auto label = to_string(static_cast<State>(state));
+        auto it = std::find_if(values.begin(), values.end(), [&label](const auto& entry) { return entry.first == label; });
+        if (it != values.end())
+        {
+          it->second += value;
+        }
+        else
+        {
+          values.emplace_back(label, value);
+        }
+      }
+      for (const auto& [label, value] : values)
+      {
+        out << name << "{state=\"" << label << "\"} " << value << "\n";
+      }
+    }
+  } // namespace
+
+  Registry::Registry()
+    : m_id(nextRegistryId++)
+  {
+  }
+
+  AddressMetrics& Registry::address(const Address& address)
+  {
+    auto& cached = cachedAddress;
+    if (cached.registry == m_id && cached.address == address)
+    {
+      return *cached.metrics;
+    }
+
+    AddressMetrics* metrics = nullptr;
+    {
+      std::shared_lock<std::shared_mutex> lk(m_mutex);
+      if (auto it = m_addresses.find(address); it != m_addresses.end())
+      {
+        metrics = it->second.get();
+      }
+    }
+    if (!metrics)
+    {
+      std::unique_lock<std::shared_mutex> lk(m_mutex);
+      auto& entry = m_addresses[address];
+      if (!entry)
+      {
+        entry = std::make_unique<AddressMetrics>();
+      }
+      metrics = entry.get();
+    }
+
+    cached.registry = m_id;
+    cached.address = address;
+    cached.metrics = metrics;
+    return *metrics;
+  }
+
+  std::string Registry::exposition() const
+  {
+    std::vector<std::pair<Address, const AddressMetrics*>> addresses;
+    {
+      std::shared_lock<std::shared_mutex> lk(m_mutex);
+      addresses.reserve(m_addresses.size());
+      for (const auto& [address, metrics] : m_addresses)
+      {
+        addresses.emplace_back(address, metrics.get());
+      }
+    }
+    std::sort(addresses.begin(), addresses.end());
+    for (auto& entry : addresses)
+    {
+      entry.first = "address=\"" + escape(entry.first) + "\"";
+    }
+
+    std::ostringstream out;
+    auto counters = [&out, &addresses](const char* name, const char* help, const Counter AddressMetrics::*counter) {
+      family(out, name, "counter", help);
+      for (const auto& [label, metrics] : addresses)
+      {
+        out << name << "{" << label << "} " << (metrics->*counter).value() << "\n";
+      }
+    };
+    auto gauges = [&out, &addresses](const char* name, const char* help, const Gauge AddressMetrics::*gauge) {
+      family(out, name, "gauge", help);
+      for (const auto& [label, metrics] : addresses)
+      {
+        out << name << "{" << label << "} " << (metrics->*gauge).value() << "\n";
+      }
+    };
+
+    counters("fty_messagebus_sent_messages_total", "Messages sent", &AddressMetrics::sentMessages);
+    counters("fty_messagebus_sent_bytes_total", "User data bytes sent", &AddressMetrics::sentBytes);
+    counters("fty_messagebus_received_messages_total", "Messages received", &AddressMetrics::receivedMessages);
+    counters("fty_messagebus_received_bytes_total", "User data bytes received", &AddressMetrics::receivedBytes);
+    gauges("fty_messagebus_inflight_requests", "Requests waiting for their reply", &AddressMetrics::inflightRequests);
+    gauges("fty_messagebus_inflight_messages", "Listeners running", &AddressMetrics::inflightMessages);
+
+    family(out, "fty_messagebus_request_duration_seconds", "histogram", "Latency of the successful requests");
+    for (const auto& [label, metrics] : addresses)
+    {
+      auto snapshot = metrics->requestLatency.snapshot();
+      if (snapshot.count != 0)
+      {
+        latency(out, "fty_messagebus_request_duration_seconds", label, snapshot);
+      }
+    }
+
+    family(out, "fty_messagebus_delivery_failures_total", "counter", "Failed sends and requests by delivery state");
+    states<DeliveryState>(out, "fty_messagebus_delivery_failures_total", m_deliveryFailures);
+    family(out, "fty_messagebus_connection_states_total", "counter", "Connections, losses and reconnections by state");
+    states<ComState>(out, "fty_messagebus_connection_states_total", m_connectionStates);
+    return out.str();
+  }
+
+  std::shared_ptr<Registry> sharedRegistry()
+  {
+    static auto registry = std::make_shared<Registry>();
+    return registry;
+  }
+
+} // namespace fty::messagebus::metrics
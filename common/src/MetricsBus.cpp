@@ -0,0 +1,243 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/MetricsBus.h"
+
+#include <fty/messagebus/MessageBusStatus.h>
+
+#include <condition_variable>
+#include <mutex>
+
+namespace fty::messagebus
+{
+  namespace
+  {
+    // Decrement a gauge on scope exit, listeners may throw.
+    struct Inflight
+    {
+      explicit Inflight(metrics::Gauge& gauge)
+        : m_gauge(gauge)
+      {
+        m_gauge.add();
+      }
+
+      ~Inflight()
+      {
+        m_gauge.sub();
+      }
+
+      Inflight(const Inflight&) = delete;
+      Inflight& operator=(const Inflight&) = delete;
+
+    private:
+      metrics::Gauge& m_gauge;
+    };
+
+    // Destination of a message, without the copy of Message::to()
+    const Address& destination(const Message& msg)
+    {
+      static const Address none;
+      auto it = msg.metaData().find(TO);
+      return it != msg.metaData().end() ? it->second : none;
+    }
+
+    struct Listener
+    {
+      std::shared_ptr<metrics::Registry> registry;
+      metrics::AddressMetrics& metrics;
+      MessageListener func;
+    };
+  } // namespace
+
+  MetricsBus::MetricsBus(MessageBus& bus, std::shared_ptr<metrics::Registry> registry)
+    : m_bus(bus)
+    , m_registry(registry)
+  {
+  }
+
+  fty::Expected<void> MetricsBus::connect() noexcept
+  {
+    auto connected = m_bus.connect();
+    m_registry->connectionState(connected ? COM_STATE_OK : from_com_state(connected.error()));
+    return connected;
+  }
+
+  fty::Expected<void> MetricsBus::send(const Message& msg) noexcept
+  {
+    auto sent = m_bus.send(msg);
+    if (!sent)
+    {
+      m_registry->deliveryFailure(from_deliveryState(sent.error()));
+      return sent;
+    }
+    auto& metrics = m_registry->address(destination(msg));
+    metrics.sentMessages.add();
+    metrics.sentBytes.add(msg.userData().size());
+    return sent;
+  }
+
+  fty::Expected<void> MetricsBus::receive(const Address& address, MessageListener&& func, const std::string& filter, DispatchMode mode,
+                                          const std::string& orderingKey) noexcept
+  {
+    // Metrics looked up once, kept alive with their registry. Shared by the copies of the listener.
+    auto listener = std::make_shared<const Listener>(Listener{m_registry, m_registry->address(address), std::move(func)});
+    return m_bus.receive(
+      address,
+      [listener](const Message& msg) {
+        auto& metrics = listener->metrics;
+        metrics.receivedMessages.add();
+        metrics.receivedBytes.add(msg.userData().size());
+        Inflight inflight(metrics.inflightMessages);
+        listener->func(msg);
+      },
+      filter, mode, orderingKey);
+  }
+
+  fty::Expected<void> MetricsBus::unreceive(const Address& address) noexcept
+  {
+    return m_bus.unreceive(address);
+  }
+
+  fty::Expected<Message> MetricsBus::request(const Message& msg, int timeOut) noexcept
+  {
+    auto& metrics = m_registry->address(destination(msg));
+    auto started = std::chrono::steady_clock::now();
+    auto reply = [&]() {
+      Inflight inflight(metrics.inflightRequests);
+      return m_bus.request(msg, timeOut);
+    }();
+    if (!reply)
+    {
+      m_registry->deliveryFailure(from_deliveryState(reply.error()));
+      return reply;
+    }
+    metrics.requestLatency.record(std::chrono::steady_clock::now() - started);
+    metrics.sentMessages.add();
+    metrics.sentBytes.add(msg.userData().size());
+    metrics.receivedMessages.add();
+    metrics.receivedBytes.add(reply->userData().size());
+    return reply;
+  }
+
+  const ClientName& MetricsBus::clientName() const noexcept
+  {
+    return m_bus.clientName();
+  }
+
+  const Identity& MetricsBus::identity() const noexcept
+  {
+    return m_bus.identity();
+  }
+
+  metrics::Registry& MetricsBus::registry() const
+  {
+    return *m_registry;
+  }
+
+  /// Schedule of the publications, shared with the timer jobs
+  struct MetricsPublisher::State : public std::enable_shared_from_this<State>
+  {
+    State(MessageBus& messageBus, const Address& publicationAddress, std::chrono::milliseconds publicationPeriod,
+          std::shared_ptr<metrics::Registry> metricsRegistry, std::shared_ptr<utils::TimerWheel> timerWheel)
+      : bus(messageBus)
+      , address(publicationAddress)
+      , period(publicationPeriod)
+      , registry(metricsRegistry)
+      , timers(timerWheel)
+    {
+    }
+
+    fty::Expected<void> publish()
+    {
+      return bus.send(Message::buildMessage(bus.clientName(), address, METRICS_SUBJECT, registry->exposition()));
+    }
+
+    // Schedule the next publication, under lock.
+    void schedule()
+    {
+      timer = timers->scheduleAfter(period, [state = weak_from_this()]() {
+        if (auto locked = state.lock())
+        {
+          locked->tick();
+        }
+      });
+    }
+
+    void tick()
+    {
+      std::unique_lock<std::mutex> lk(mutex);
+      if (stopped)
+      {
+        return;
+      }
+      publishing = true;
+      lk.unlock();
+
+      // A failed publication is retried with the next one.
+      (void)publish();
+
+      lk.lock();
+      publishing = false;
+      if (!stopped)
+      {
+        schedule();
+      }
+      cv.notify_all();
+    }
+
+    void stop()
+    {
+      std::unique_lock<std::mutex> lk(mutex);
+      stopped = true;
+      timer.cancel();
+      cv.wait(lk, [this]() -> bool { return !publishing; });
+    }
+
+    MessageBus& bus;
+    const Address address;
+    const std::chrono::milliseconds period;
+    const std::shared_ptr<metrics::Registry> registry;
+    const std::shared_ptr<utils::TimerWheel> timers;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    utils::TimerHandle timer;
+    bool stopped = false;
+    bool publishing = false;
+  };
+
+  MetricsPublisher::MetricsPublisher(MessageBus& bus, const Address& address, std::chrono::milliseconds period,
+                                     std::shared_ptr<metrics::Registry> registry, std::shared_ptr<utils::TimerWheel> timers)
+    : m_state(std::make_shared<State>(bus, address, period, registry, timers ? timers : utils::sharedTimerWheel()))
+  {
+    std::unique_lock<std::mutex> lk(m_state->mutex);
+    m_state->schedule();
+  }
+
+  MetricsPublisher::~MetricsPublisher()
+  {
+    m_state->stop();
+  }
+
+  fty::Expected<void> MetricsPublisher::publish()
+  {
+    return m_state->publish();
+  }
+
+} // namespace fty::messagebus
@@ -0,0 +1,187 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/RpcClient.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace fty::messagebus
+{
+  /// Calls in progress, shared with the reply listener and the deadline timers
+  struct RpcClient::Calls
+  {
+    struct Pending
+    {
+      ReplyHandler handler;
+      utils::TimerHandle timer;
+    };
+
+    std::shared_ptr<utils::TimerWheel> timers;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Pending> pending;
+    bool started = false;
+
+    /// Remove a call, null if it is already completed
+    ReplyHandler take(const std::string& correlationId)
+    {
+      std::unique_lock<std::mutex> lk(mutex);
+      auto it = pending.find(correlationId);
+      if (it == pending.end())
+      {
+        return {};
+      }
+      it->second.timer.cancel();
+      auto handler = std::move(it->second.handler);
+      pending.erase(it);
+      return handler;
+    }
+
+    void onReply(const Message& reply)
+    {
+      auto handler = take(reply.correlationId());
+      if (!handler)
+      {
+        // Late reply of an expired call.
+        return;
+      }
+      if (reply.status() == STATUS_KO)
+      {
+        handler(nullptr, reply.userData());
+      }
+      else
+      {
+        handler(&reply, {});
+      }
+    }
+
+    void expire(const std::string& correlationId)
+    {
+      std::unique_lock<std::mutex> lk(mutex);
+      auto it = pending.find(correlationId);
+      if (it == pending.end())
+      {
+        return;
+      }
+      auto handler = std::move(it->second.handler);
+      pending.erase(it);
+      lk.unlock();
+
+      handler(nullptr, to_string(DeliveryState::DELIVERY_STATE_TIMEOUT));
+    }
+  };
+
+  RpcClient::RpcClient(MessageBus& bus, const Address& from, const Address& replyTo, std::shared_ptr<utils::TimerWheel> timers)
+    : m_bus(bus)
+    , m_from(from)
+    , m_replyTo(replyTo)
+    , m_calls(std::make_shared<Calls>())
+  {
+    m_calls->timers = timers ? timers : utils::sharedTimerWheel();
+  }
+
+  RpcClient::~RpcClient()
+  {
+    stop();
+  }
+
+  fty::Expected<void> RpcClient::start()
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_calls->mutex);
+      if (m_calls->started)
+      {
+        return {};
+      }
+      m_calls->started = true;
+    }
+
+    // The listener owns the calls, it may still run after the client is destroyed.
+    auto received = m_bus.receive(m_replyTo, [calls = m_calls](const Message& reply) { calls->onReply(reply); });
+    if (!received)
+    {
+      std::unique_lock<std::mutex> lk(m_calls->mutex);
+      m_calls->started = false;
+      return fty::unexpected(received.error());
+    }
+    return {};
+  }
+
+  void RpcClient::stop()
+  {
+    std::unordered_map<std::string, Calls::Pending> pending;
+    {
+      std::unique_lock<std::mutex> lk(m_calls->mutex);
+      if (!m_calls->started)
+      {
+        return;
+      }
+      m_calls->started = false;
+      pending.swap(m_calls->pending);
+    }
+
+    auto unreceived = m_bus.unreceive(m_replyTo);
+    (void)unreceived;
+
+    for (auto& [correlationId, call] : pending)
+    {
+      call.timer.cancel();
+      call.handler(nullptr, to_string(DeliveryState::DELIVERY_STATE_ABORTED));
+    }
+  }
+
+  bool RpcClient::cancel(const std::string& correlationId)
+  {
+    return static_cast<bool>(m_calls->take(correlationId));
+  }
+
+  void RpcClient::send(const Message& request, Clock::time_point deadline, ReplyHandler&& handler)
+  {
+    auto correlationId = request.correlationId();
+    {
+      std::unique_lock<std::mutex> lk(m_calls->mutex);
+      if (!m_calls->started)
+      {
+        lk.unlock();
+        handler(nullptr, to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
+        return;
+      }
+
+      auto& call = m_calls->pending[correlationId];
+      call.handler = std::move(handler);
+      call.timer = m_calls->timers->scheduleAt(deadline, [calls = std::weak_ptr<Calls>(m_calls), correlationId]() {
+        if (auto locked = calls.lock())
+        {
+          locked->expire(correlationId);
+        }
+      });
+    }
+
+    auto sent = m_bus.send(request);
+    if (!sent)
+    {
+      if (auto failed = m_calls->take(correlationId))
+      {
+        failed(nullptr, sent.error());
+      }
+    }
+  }
+
+} // namespace fty::messagebus
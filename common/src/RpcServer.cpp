@@ -0,0 +1,227 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/RpcServer.h"
+
+#include <fty/messagebus/MessageBusStatus.h>
+
+#include <fty_log.h>
+
+namespace fty::messagebus
+{
+  RpcServer::RpcServer(MessageBus& bus, const Address& address)
+    : RpcServer(bus, address, Options())
+  {
+  }
+
+  RpcServer::RpcServer(MessageBus& bus, const Address& address, Options options)
+    : m_bus(bus)
+    , m_address(address)
+    , m_options(std::move(options))
+    , m_executor(m_options.executor ? m_options.executor : utils::sharedPoolWorker())
+  {
+  }
+
+  RpcServer::~RpcServer()
+  {
+    stop();
+  }
+
+  fty::Expected<void> RpcServer::handle(const std::string& subject, RpcHandler handler)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    if (m_started || m_pending != 0)
+    {
+      // The dispatcher holds the handlers of the subjects until the server is stopped.
+      return fty::unexpected("Server started");
+    }
+    m_subjects[subject] = {std::move(handler), std::make_unique<utils::Histogram>()};
+    return {};
+  }
+
+  fty::Expected<void> RpcServer::start()
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      if (m_started)
+      {
+        return {};
+      }
+
+      // Subjects are fixed from now on, build the dispatcher over them.
+      utils::HashedDispatcher<Handle, Missing>::Map handles;
+      for (auto& [subject, entry] : m_subjects)
+      {
+        handles.emplace(subject, [this, &entry = entry](const Message& request, Clock::time_point received) {
+          fty::Expected<UserData> result = fty::unexpected("Unknown error");
+          try
+          {
+            result = entry.handler(request);
+          }
+          catch (const std::exception& e)
+          {
+            result = fty::unexpected(e.what());
+          }
+          catch (...)
+          {
+            result = fty::unexpected("Unknown error");
+          }
+          reply(request, std::move(result));
+          entry.latency->record(Clock::now() - received);
+        });
+      }
+      m_dispatcher = std::make_unique<utils::HashedDispatcher<Handle, Missing>>(
+        handles, [this](const std::string& subject, const Message& request, Clock::time_point) {
+          reply(request, fty::unexpected("Subject not supported: " + subject));
+        });
+      m_started = true;
+    }
+
+    auto received = m_bus.receive(m_address, [this](const Message& request) { onRequest(request); });
+    if (!received)
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_started = false;
+      return fty::unexpected(received.error());
+    }
+    return {};
+  }
+
+  void RpcServer::stop()
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      if (!m_started)
+      {
+        return;
+      }
+      m_started = false;
+    }
+
+    auto unreceived = m_bus.unreceive(m_address);
+    (void)unreceived;
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_cv.wait(lk, [this]() -> bool { return m_pending == 0; });
+  }
+
+  std::map<std::string, utils::HistogramSnapshot> RpcServer::latency() const
+  {
+    std::map<std::string, utils::HistogramSnapshot> latency;
+    std::unique_lock<std::mutex> lk(m_mutex);
+    for (const auto& [subject, entry] : m_subjects)
+    {
+      latency.emplace(subject, entry.latency->snapshot());
+    }
+    return latency;
+  }
+
+  uint64_t RpcServer::rejected() const
+  {
+    return m_rejected.load();
+  }
+
+  void RpcServer::onRequest(const Message& request)
+  {
+    Request queued{request, Clock::now()};
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      if (!m_started || m_pending >= m_options.maxPending)
+      {
+        lk.unlock();
+        m_rejected++;
+        reply(request, fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_BUSY)));
+        return;
+      }
+      m_pending++;
+      if (m_options.maxConcurrency != 0 && m_running >= m_options.maxConcurrency)
+      {
+        // Run by a handler in progress once done.
+        m_queue.push_back(std::move(queued));
+        return;
+      }
+      m_running++;
+    }
+
+    if (m_options.maxConcurrency == 0)
+    {
+      run(std::move(queued));
+      return;
+    }
+    m_executor->offload([this, queued = std::move(queued)]() mutable { run(std::move(queued)); });
+  }
+
+  void RpcServer::run(Request request)
+  {
+    while (true)
+    {
+      dispatch(request);
+
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_pending--;
+      m_cv.notify_all();
+      if (m_queue.empty())
+      {
+        m_running--;
+        return;
+      }
+      request = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+  }
+
+  void RpcServer::dispatch(const Request& request)
+  {
+    try
+    {
+      (*m_dispatcher)(request.message.subject(), request.message, request.received);
+    }
+    catch (const std::exception& e)
+    {
+      logError("Request {} on {} not handled: {}", request.message.correlationId(), m_address, e.what());
+    }
+    catch (...)
+    {
+      logError("Request {} on {} not handled", request.message.correlationId(), m_address);
+    }
+  }
+
+  void RpcServer::reply(const Message& request, fty::Expected<UserData>&& result)
+  {
+    if (!request.needReply())
+    {
+      return;
+    }
+
+    auto response = result ? request.buildReply(*result) : request.buildReply(result.error(), STATUS_KO);
+    if (!response)
+    {
+      return;
+    }
+
+    auto& replyBuses = m_options.replyBuses;
+    auto& bus = replyBuses.empty() ? m_bus : *replyBuses[m_nextReplyBus++ % replyBuses.size()];
+    auto sent = bus.send(*response);
+    if (!sent)
+    {
+      logWarn("Reply to {} on {} not sent: {}", request.from(), response->to(), sent.error());
+    }
+  }
+
+} // namespace fty::messagebus
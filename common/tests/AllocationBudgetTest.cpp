@@ -0,0 +1,55 @@
+#include "AllocationCounter.h"
+#include "LoopbackBus.h"
+
+#include <catch2/catch.hpp>
+#include <fty/messagebus/ChunkedBus.h>
+#include <fty/messagebus/ClaimCheckBus.h>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::allocationsOf;
+  using fty::messagebus::test::LoopbackBus;
+
+  // Allocation budgets of the hot paths, as measured: one per metadata node and per string
+  // not fitting the small string buffer (payload, uuid). Lower them along with the code,
+  // raising one needs a reason in the commit message.
+  constexpr uint64_t BUILD_MESSAGE_BUDGET = 4;  // from, to, subject, payload
+  constexpr uint64_t BUILD_REQUEST_BUDGET = 8;  // + replyTo, correlation id and its uuid
+  constexpr uint64_t BUILD_REPLY_BUDGET = 16;   // + status, getters returning copies
+  constexpr uint64_t COPY_BUDGET = 7;           // nodes, payload and correlation id
+  constexpr uint64_t PASS_THROUGH_BUDGET = 0;   // decorators sending small messages as is
+
+  const UserData PAYLOAD(1024, 'x');
+} // namespace
+
+TEST_CASE("Message build", "[AllocationBudget]")
+{
+  CHECK(allocationsOf([]() { auto msg = Message::buildMessage("client", "Q.BUDGET", "SUBJECT", PAYLOAD); }) <= BUILD_MESSAGE_BUDGET);
+  CHECK(allocationsOf([]() { auto msg = Message::buildRequest("client", "Q.BUDGET", "SUBJECT", "Q.REPLY", PAYLOAD); }) <= BUILD_REQUEST_BUDGET);
+}
+
+TEST_CASE("Message reply and copy", "[AllocationBudget]")
+{
+  auto request = Message::buildRequest("client", "Q.BUDGET", "SUBJECT", "Q.REPLY", PAYLOAD);
+  CHECK(allocationsOf([&request]() { auto reply = request.buildReply(PAYLOAD); }) <= BUILD_REPLY_BUDGET);
+  CHECK(allocationsOf([&request]() { Message copy(request); }) <= COPY_BUDGET);
+}
+
+TEST_CASE("Send and dispatch through decorators", "[AllocationBudget]")
+{
+  LoopbackBus bus;
+  size_t received = 0;
+  REQUIRE(bus.receive("Q.BUDGET", [&received](const Message&) { received++; }));
+  auto msg = Message::buildMessage("client", "Q.BUDGET", "SUBJECT", PAYLOAD);
+
+  // Reference of the loopback send and listener call, the decorators must not add to it.
+  auto loopback = allocationsOf([&]() { REQUIRE(bus.send(msg)); });
+
+  ChunkedBus chunked(bus);
+  CHECK(allocationsOf([&]() { REQUIRE(chunked.send(msg)); }) <= loopback + PASS_THROUGH_BUDGET);
+
+  ClaimCheckBus claimCheck(bus);
+  CHECK(allocationsOf([&]() { REQUIRE(claimCheck.send(msg)); }) <= loopback + PASS_THROUGH_BUDGET);
+  CHECK(received == 3);
+}
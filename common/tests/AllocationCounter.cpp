@@ -0,0 +1,124 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+  // Per thread, the allocations of the other threads (paho, pool workers) do not blur the counts.
+  thread_local uint64_t t_allocations = 0;
+
+  // Left to the sanitizer runtime when built with it: nothing is counted and the budgets trivially hold.
+#if !defined(__SANITIZE_ADDRESS__)
+  void* allocate(std::size_t size)
+  {
+    t_allocations++;
+    if (auto ptr = std::malloc(size ? size : 1))
+    {
+      return ptr;
+    }
+    throw std::bad_alloc();
+  }
+
+  void* allocate(std::size_t size, std::align_val_t alignment)
+  {
+    t_allocations++;
+    auto align = static_cast<std::size_t>(alignment);
+    if (auto ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+    {
+      return ptr;
+    }
+    throw std::bad_alloc();
+  }
+#endif
+} // namespace
+
+namespace fty::messagebus::test
+{
+  uint64_t threadAllocations()
+  {
+    return t_allocations;
+  }
+} // namespace fty::messagebus::test
+
+// Replacement of the global allocation functions of the test executable.
+#if !defined(__SANITIZE_ADDRESS__)
+void* operator new(std::size_t size)
+{
+  return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+  return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+  std::free(ptr);
+}
+#endif
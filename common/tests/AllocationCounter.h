@@ -0,0 +1,40 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+namespace fty::messagebus::test
+{
+  /// Allocations made by operator new on the calling thread, counted by the replaced
+  /// operator new of the test executable (AllocationCounter.cpp linked in, except with AddressSanitizer).
+  uint64_t threadAllocations();
+
+  /// Allocations made by a callable on the calling thread
+  template <typename Function>
+  uint64_t allocationsOf(Function&& fn)
+  {
+    auto before = threadAllocations();
+    std::forward<Function>(fn)();
+    return threadAllocations() - before;
+  }
+
+} // namespace fty::messagebus::test
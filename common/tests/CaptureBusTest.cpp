@@ -0,0 +1,153 @@
+#include <fty/messagebus/CaptureBus.h>
+
+#include "LoopbackBus.h"
+
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::LoopbackBus;
+
+  // Temporary capture file
+  struct CaptureFile
+  {
+    std::string path;
+
+    CaptureFile()
+    {
+      char name[] = "/tmp/fty-messagebus-capture-XXXXXX";
+      int fd = ::mkstemp(name);
+      REQUIRE(fd >= 0);
+      ::close(fd);
+      path = name;
+    }
+
+    ~CaptureFile()
+    {
+      ::unlink(path.c_str());
+    }
+
+    size_t size() const
+    {
+      std::ifstream file(path, std::ios::binary | std::ios::ate);
+      return static_cast<size_t>(file.tellg());
+    }
+  };
+
+  std::string payload(size_t size)
+  {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++)
+    {
+      data[i] = static_cast<char>(i % 256);
+    }
+    return data;
+  }
+
+  Message message(size_t index, const UserData& data)
+  {
+    return Message::buildMessage("client", "Q.IN", "SUBJECT", data, {{"INDEX", std::to_string(index)}, {"EMPTY", ""}});
+  }
+
+  std::vector<CapturedMessage> readAll(const std::string& path, bool& truncated)
+  {
+    auto reader = CaptureReader::open(path);
+    REQUIRE(reader);
+    std::vector<CapturedMessage> records;
+    while (auto record = (*reader)->next())
+    {
+      records.push_back(std::move(*record));
+    }
+    // The end is sticky.
+    REQUIRE_FALSE((*reader)->next());
+    truncated = (*reader)->truncated();
+    return records;
+  }
+} // namespace
+
+TEST_CASE("Capture file", "[CaptureBus]")
+{
+  CaptureFile file;
+  constexpr size_t NB_RECORDS = 100;
+  {
+    // Small chunks, the file is extended and remapped many times, once for a record over the chunk size.
+    auto writer = CaptureWriter::create(file.path, 4096);
+    REQUIRE(writer);
+    for (size_t i = 0; i < NB_RECORDS; i++)
+    {
+      auto direction = i % 2 ? CaptureDirection::RECEIVED : CaptureDirection::SENT;
+      REQUIRE((*writer)->append(direction, static_cast<int64_t>(1000 + i), message(i, payload(i == 50 ? 10000 : i))));
+    }
+    REQUIRE((*writer)->records() == NB_RECORDS);
+  }
+
+  bool truncated = true;
+  auto records = readAll(file.path, truncated);
+  REQUIRE_FALSE(truncated);
+  REQUIRE(records.size() == NB_RECORDS);
+  for (size_t i = 0; i < NB_RECORDS; i++)
+  {
+    CHECK(records[i].direction == (i % 2 ? CaptureDirection::RECEIVED : CaptureDirection::SENT));
+    CHECK(records[i].timestamp == static_cast<int64_t>(1000 + i));
+    CHECK(records[i].message.metaData() == message(i, {}).metaData());
+    CHECK(records[i].message.userData() == payload(i == 50 ? 10000 : i));
+  }
+
+  // Cut in the middle of the last record, as if the writer was killed.
+  auto size = file.size();
+  REQUIRE(::truncate(file.path.c_str(), static_cast<off_t>(size - 10)) == 0);
+  records = readAll(file.path, truncated);
+  REQUIRE(truncated);
+  REQUIRE(records.size() == NB_RECORDS - 1);
+
+  // Not a capture file.
+  {
+    std::ofstream out(file.path, std::ios::trunc);
+    out << "not a capture file at all";
+  }
+  REQUIRE_FALSE(CaptureReader::open(file.path));
+  REQUIRE_FALSE(CaptureReader::open(file.path + ".missing"));
+  REQUIRE_FALSE(CaptureWriter::create("/nonexistent/capture"));
+}
+
+TEST_CASE("Capture bus", "[CaptureBus]")
+{
+  CaptureFile file;
+  LoopbackBus bus;
+  {
+    auto writer = CaptureWriter::create(file.path);
+    REQUIRE(writer);
+    CaptureBus capture(bus, *writer);
+
+    size_t received = 0;
+    REQUIRE(capture.receive("Q.IN", [&received](const Message&) { received++; }));
+    REQUIRE(capture.send(message(0, "first")));
+    REQUIRE(bus.send(message(1, "not captured")));
+    // Failed sends are not recorded.
+    REQUIRE_FALSE(capture.send(Message::buildMessage("client", "Q.NOBODY", "SUBJECT", "lost")));
+    REQUIRE(received == 2);
+    REQUIRE(capture.failed() == 0);
+    REQUIRE((*writer)->records() == 3);
+  }
+
+  bool truncated = true;
+  auto records = readAll(file.path, truncated);
+  REQUIRE_FALSE(truncated);
+  REQUIRE(records.size() == 3);
+
+  // Delivered synchronously by the loopback: received before the send returns.
+  CHECK(records[0].direction == CaptureDirection::RECEIVED);
+  CHECK(records[0].message.userData() == "first");
+  CHECK(records[1].direction == CaptureDirection::SENT);
+  CHECK(records[1].message.userData() == "first");
+  CHECK(records[1].message.to() == "Q.IN");
+  CHECK(records[1].timestamp <= records[0].timestamp);
+  // Sent around the capture bus, only seen by its listener.
+  CHECK(records[2].direction == CaptureDirection::RECEIVED);
+  CHECK(records[2].message.userData() == "not captured");
+}
@@ -0,0 +1,296 @@
+#include <fty/messagebus/ChunkedBus.h>
+
+#include "LoopbackBus.h"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::LoopbackBus;
+
+  std::string payload(size_t size)
+  {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++)
+    {
+      data[i] = static_cast<char>('a' + i % 26);
+    }
+    return data;
+  }
+
+  // Chunks sent by a chunked bus, captured on Q.RAW
+  std::vector<Message> chunksOf(LoopbackBus& bus, ChunkedBus& chunked, const UserData& data)
+  {
+    std::vector<Message> chunks;
+    REQUIRE(bus.receive("Q.RAW", [&chunks](const Message& msg) { chunks.push_back(msg); }));
+    REQUIRE(chunked.send(Message::buildMessage("client", "Q.RAW", "SUBJECT", data, {{"KEY", "value"}})));
+    REQUIRE(bus.unreceive("Q.RAW"));
+    for (auto& chunk : chunks)
+    {
+      chunk.to("Q.IN");
+    }
+    return chunks;
+  }
+
+  //----------------------------------------------------------------------
+  // Test case
+  //----------------------------------------------------------------------
+  TEST_CASE("Chunked bus send", "[ChunkedBus]")
+  {
+    LoopbackBus bus;
+    ChunkedBus::Options options;
+    options.chunkSize = 1000;
+    ChunkedBus chunked(bus, options);
+
+    // Small messages are sent as is.
+    auto small = chunksOf(bus, chunked, payload(1000));
+    REQUIRE(small.size() == 1);
+    REQUIRE(small[0].userData() == payload(1000));
+    REQUIRE(small[0].getMetaDataValue(CHUNK_ID).empty());
+
+    auto chunks = chunksOf(bus, chunked, payload(2500));
+    REQUIRE(chunks.size() == 3);
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+      REQUIRE(chunks[i].getMetaDataValue(CHUNK_ID) == chunks[0].getMetaDataValue(CHUNK_ID));
+      REQUIRE(chunks[i].getMetaDataValue(CHUNK_INDEX) == std::to_string(i));
+      REQUIRE(chunks[i].getMetaDataValue(CHUNK_COUNT) == "3");
+      REQUIRE(chunks[i].getMetaDataValue(CHUNK_OFFSET) == std::to_string(i * 834));
+      REQUIRE(chunks[i].getMetaDataValue(CHUNK_TOTAL_SIZE) == "2500");
+      REQUIRE(chunks[i].getMetaDataValue("KEY") == "value");
+    }
+    // Chunks of even size, the last one holds the rest.
+    REQUIRE(chunks[0].userData().size() == 834);
+    REQUIRE(chunks[2].userData().size() == 832);
+
+    // Requests are not chunked.
+    auto request = Message::buildRequest("client", "Q.IN", "SUBJECT", "Q.REPLY", payload(2500));
+    REQUIRE_FALSE(chunked.request(request, 1));
+  }
+
+  TEST_CASE("Chunked bus reassembly", "[ChunkedBus]")
+  {
+    LoopbackBus bus;
+    ChunkedBus::Options options;
+    options.chunkSize = 1000;
+    options.maxReassemblyBytes = 5000;
+    ChunkedBus chunked(bus, options);
+
+    std::vector<Message> received;
+    REQUIRE(chunked.receive("Q.IN", [&received](const Message& msg) { received.push_back(msg); }));
+
+    // In order, then out of order with a duplicate.
+    auto data = payload(2500);
+    for (const auto& chunk : chunksOf(bus, chunked, data))
+    {
+      REQUIRE(bus.send(chunk));
+    }
+    auto chunks = chunksOf(bus, chunked, data);
+    REQUIRE(bus.send(chunks[2]));
+    REQUIRE(bus.send(chunks[0]));
+    REQUIRE(bus.send(chunks[0]));
+    REQUIRE(received.size() == 1);
+    REQUIRE(bus.send(chunks[1]));
+    REQUIRE(chunked.dropped() == 1);
+
+    REQUIRE(received.size() == 2);
+    for (const auto& msg : received)
+    {
+      REQUIRE(msg.userData() == data);
+      REQUIRE(msg.subject() == "SUBJECT");
+      REQUIRE(msg.getMetaDataValue("KEY") == "value");
+      REQUIRE(msg.getMetaDataValue(CHUNK_ID).empty());
+      REQUIRE(msg.getMetaDataValue(CHUNK_INDEX).empty());
+    }
+
+    // Not chunked.
+    REQUIRE(bus.send(Message::buildMessage("client", "Q.IN", "SUBJECT", "small")));
+    REQUIRE(received.size() == 3);
+    REQUIRE(received[2].userData() == "small");
+
+    // Over the reassembly budget: two messages of 2500 fit, not a third one.
+    received.clear();
+    auto first = chunksOf(bus, chunked, data);
+    auto second = chunksOf(bus, chunked, data);
+    auto third = chunksOf(bus, chunked, data);
+    REQUIRE(bus.send(first[0]));
+    REQUIRE(bus.send(second[0]));
+    REQUIRE(bus.send(third[0]));
+    REQUIRE(chunked.dropped() == 2);
+    for (const auto& chunk : {first[1], first[2], second[1], second[2]})
+    {
+      REQUIRE(bus.send(chunk));
+    }
+    REQUIRE(received.size() == 2);
+
+    // Inconsistent metadata.
+    auto invalid = chunksOf(bus, chunked, data)[0];
+    invalid.setMetaDataValue(CHUNK_OFFSET, "2000");
+    REQUIRE(bus.send(invalid));
+    invalid.setMetaDataValue(CHUNK_OFFSET, "x");
+    REQUIRE(bus.send(invalid));
+    REQUIRE(chunked.dropped() == 4);
+    REQUIRE(received.size() == 2);
+  }
+
+  TEST_CASE("Chunked bus crafted headers", "[ChunkedBus]")
+  {
+    LoopbackBus bus;
+    ChunkedBus::Options options;
+    options.chunkSize = 1000;
+    ChunkedBus chunked(bus, options);
+
+    std::vector<Message> received;
+    REQUIRE(chunked.receive("Q.IN", [&received](const Message& msg) { received.push_back(msg); }));
+
+    auto chunk = [](size_t index, const std::string& count, size_t offset, const UserData& data) {
+      auto msg = Message::buildMessage("client", "Q.IN", "SUBJECT", data);
+      msg.setMetaDataValue(CHUNK_ID, "crafted");
+      msg.setMetaDataValue(CHUNK_INDEX, std::to_string(index));
+      msg.setMetaDataValue(CHUNK_COUNT, count);
+      msg.setMetaDataValue(CHUNK_OFFSET, std::to_string(offset));
+      msg.setMetaDataValue(CHUNK_TOTAL_SIZE, "2000");
+      return msg;
+    };
+
+    // Chunk counts out of the user data, nothing allocated.
+    REQUIRE(bus.send(chunk(0, "1000000000000000", 0, payload(1000))));
+    REQUIRE(bus.send(chunk(0, "2001", 0, payload(1000))));
+    REQUIRE(bus.send(chunk(0, "0", 0, payload(1000))));
+    REQUIRE(chunked.dropped() == 3);
+
+    // Chunks overlapping, or of sizes adding up to the total with holes.
+    REQUIRE(bus.send(chunk(0, "2", 0, payload(1000))));
+    REQUIRE(bus.send(chunk(1, "2", 0, payload(1000))));
+    REQUIRE(chunked.dropped() == 4);
+    REQUIRE(bus.send(chunk(1, "2", 500, payload(1000))));
+    REQUIRE(bus.send(chunk(1, "2", 1000, payload(500))));
+    REQUIRE(chunked.dropped() == 6);
+    REQUIRE(received.empty());
+
+    // The expected chunk still completes the message.
+    REQUIRE(bus.send(chunk(1, "2", 1000, payload(1000))));
+    REQUIRE(received.size() == 1);
+    REQUIRE(received[0].userData() == payload(1000) + payload(1000));
+  }
+
+  TEST_CASE("Chunked bus timeout", "[ChunkedBus]")
+  {
+    LoopbackBus bus;
+    ChunkedBus::Options options;
+    options.chunkSize = 1000;
+    options.maxReassemblyBytes = 3000;
+    options.timeout = std::chrono::milliseconds(10);
+    ChunkedBus chunked(bus, options);
+
+    size_t received = 0;
+    REQUIRE(chunked.receive("Q.IN", [&received](const Message&) { received++; }));
+
+    // A partial message holds its budget until its timeout.
+    auto data = payload(2500);
+    auto lost = chunksOf(bus, chunked, data);
+    auto other = chunksOf(bus, chunked, data);
+    REQUIRE(bus.send(lost[0]));
+    REQUIRE(bus.send(lost[1]));
+    REQUIRE(bus.send(other[0]));
+    REQUIRE(chunked.dropped() == 1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (const auto& chunk : other)
+    {
+      REQUIRE(bus.send(chunk));
+    }
+    REQUIRE(received == 1);
+    REQUIRE(chunked.dropped() == 3);
+  }
+
+  TEST_CASE("Chunked bus timeout without traffic", "[ChunkedBus]")
+  {
+    LoopbackBus bus;
+    ChunkedBus::Options options;
+    options.chunkSize = 1000;
+    options.maxReassemblyBytes = 3000;
+    options.timeout = std::chrono::milliseconds(10);
+    ChunkedBus chunked(bus, options);
+
+    REQUIRE(chunked.receive("Q.IN", [](const Message&) {}));
+    REQUIRE(chunked.receiveStream("Q.STREAM", [](const Chunk&) {}));
+
+    // Senders gone after their first chunks, nothing else arrives.
+    auto lost = chunksOf(bus, chunked, payload(2500));
+    REQUIRE(bus.send(lost[0]));
+    REQUIRE(bus.send(lost[1]));
+    auto stream = chunksOf(bus, chunked, payload(2500));
+    stream[0].to("Q.STREAM");
+    REQUIRE(bus.send(stream[0]));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (chunked.dropped() < 2 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(chunked.dropped() == 2);
+
+    // The budget is released, a stream timed out is cut short.
+    size_t received = 0;
+    REQUIRE(chunked.unreceive("Q.IN"));
+    REQUIRE(chunked.receive("Q.IN", [&received](const Message&) { received++; }));
+    for (const auto& chunk : chunksOf(bus, chunked, payload(3000)))
+    {
+      REQUIRE(bus.send(chunk));
+    }
+    REQUIRE(received == 1);
+    stream[1].to("Q.STREAM");
+    REQUIRE(bus.send(stream[1]));
+    REQUIRE(chunked.dropped() == 3);
+  }
+
+  TEST_CASE("Chunked bus stream", "[ChunkedBus]")
+  {
+    LoopbackBus bus;
+    ChunkedBus::Options options;
+    options.chunkSize = 1000;
+    ChunkedBus chunked(bus, options);
+
+    std::string data;
+    std::vector<size_t> indexes;
+    bool last = false;
+    REQUIRE(chunked.receiveStream("Q.IN", [&](const Chunk& chunk) {
+      REQUIRE(chunk.offset == data.size());
+      data += chunk.message.userData();
+      indexes.push_back(chunk.index);
+      last = chunk.last();
+    }));
+
+    auto expected = payload(2500);
+    for (const auto& chunk : chunksOf(bus, chunked, expected))
+    {
+      REQUIRE(bus.send(chunk));
+    }
+    REQUIRE(data == expected);
+    REQUIRE(indexes == std::vector<size_t>{0, 1, 2});
+    REQUIRE(last);
+
+    // Not chunked, a single chunk.
+    data.clear();
+    indexes.clear();
+    REQUIRE(bus.send(Message::buildMessage("client", "Q.IN", "SUBJECT", "small")));
+    REQUIRE(data == "small");
+    REQUIRE(last);
+
+    // A gap cuts the message short.
+    data.clear();
+    indexes.clear();
+    auto chunks = chunksOf(bus, chunked, expected);
+    REQUIRE(bus.send(chunks[0]));
+    REQUIRE(bus.send(chunks[2]));
+    REQUIRE(bus.send(chunks[1]));
+    REQUIRE(indexes == std::vector<size_t>{0});
+    REQUIRE(chunked.dropped() == 2);
+  }
+
+} // namespace
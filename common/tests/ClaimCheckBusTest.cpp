@@ -0,0 +1,227 @@
+#include <fty/messagebus/ClaimCheckBus.h>
+
+#include "LoopbackBus.h"
+
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::LoopbackBus;
+
+  // Temporary directory of the claim check files
+  struct Directory
+  {
+    std::string path;
+
+    Directory()
+    {
+      char name[] = "/tmp/fty-messagebus-test-XXXXXX";
+      REQUIRE(::mkdtemp(name) != nullptr);
+      path = name;
+    }
+
+    // Including the files left to their time to live
+    ~Directory()
+    {
+      std::error_code ec;
+      std::filesystem::remove_all(path, ec);
+    }
+  };
+
+  std::string payload(size_t size)
+  {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++)
+    {
+      data[i] = static_cast<char>('a' + i % 26);
+    }
+    return data;
+  }
+
+  Message message(const UserData& data)
+  {
+    return Message::buildMessage("client", "Q.IN", "SUBJECT", data, {{"KEY", "value"}});
+  }
+
+  //----------------------------------------------------------------------
+  // Test case
+  //----------------------------------------------------------------------
+  TEST_CASE("Claim check bus", "[ClaimCheckBus]")
+  {
+    Directory directory;
+    LoopbackBus bus;
+    ClaimCheckBus::Options options;
+    options.threshold = 1000;
+    options.directory = directory.path;
+
+    std::vector<Message> raw;
+    REQUIRE(bus.receive("Q.RAW", [&raw](const Message& msg) { raw.push_back(msg); }));
+
+    std::vector<Message> received;
+    std::shared_ptr<const ClaimedPayload> claimed;
+    {
+      ClaimCheckBus checked(bus, options);
+      REQUIRE(checked.receive("Q.IN", [&received](const Message& msg) { received.push_back(msg); }));
+      REQUIRE(checked.receiveClaimed("Q.CLAIMED", [&claimed](const Message& msg, std::shared_ptr<const ClaimedPayload> data) {
+        REQUIRE(msg.userData().empty());
+        REQUIRE(msg.getMetaDataValue(CLAIM_CHECK_PATH).empty());
+        claimed = std::move(data);
+      }));
+
+      // Small messages are sent as is.
+      auto small = message(payload(1000));
+      small.to("Q.RAW");
+      REQUIRE(checked.send(small));
+      REQUIRE(raw.back().userData() == payload(1000));
+
+      // Only the path of large ones goes through the bus.
+      auto large = message(payload(100000));
+      large.to("Q.RAW");
+      REQUIRE(checked.send(large));
+      REQUIRE(raw.back().userData().empty());
+      REQUIRE(raw.back().getMetaDataValue(CLAIM_CHECK_SIZE) == "100000");
+      REQUIRE(raw.back().getMetaDataValue(CLAIM_CHECK_PATH).find(directory.path + "/") == 0);
+      REQUIRE(::access(raw.back().getMetaDataValue(CLAIM_CHECK_PATH).c_str(), R_OK) == 0);
+
+      REQUIRE(checked.send(message(payload(100000))));
+      REQUIRE(received.size() == 1);
+      REQUIRE(received[0].userData() == payload(100000));
+      REQUIRE(received[0].getMetaDataValue("KEY") == "value");
+      REQUIRE(received[0].getMetaDataValue(CLAIM_CHECK_PATH).empty());
+
+      large.to("Q.CLAIMED");
+      REQUIRE(checked.send(large));
+      REQUIRE(claimed);
+      REQUIRE(claimed->data() == payload(100000));
+
+      // Claim checks outside of the directory are refused.
+      auto forged = message("");
+      forged.setMetaDataValue(CLAIM_CHECK_PATH, directory.path + "/../../etc/passwd");
+      forged.setMetaDataValue(CLAIM_CHECK_SIZE, "10");
+      REQUIRE(bus.send(forged));
+      REQUIRE(checked.failed() == 1);
+      REQUIRE(received.size() == 1);
+
+      // Requests are not sent by claim check.
+      REQUIRE_FALSE(checked.request(Message::buildRequest("client", "Q.IN", "SUBJECT", "Q.REPLY", payload(100000)), 1));
+    }
+
+    // Files kept until their time to live, mappings are valid either way.
+    REQUIRE(::access(raw.back().getMetaDataValue(CLAIM_CHECK_PATH).c_str(), F_OK) == 0);
+    REQUIRE(claimed->data() == payload(100000));
+  }
+
+  TEST_CASE("Claim check bus destroyed before the receivers", "[ClaimCheckBus]")
+  {
+    Directory directory;
+    LoopbackBus bus;
+    ClaimCheckBus::Options options;
+    options.threshold = 1000;
+    options.directory = directory.path;
+    options.ttl = std::chrono::milliseconds(200);
+
+    std::vector<Message> raw;
+    REQUIRE(bus.receive("Q.RAW", [&raw](const Message& msg) { raw.push_back(msg); }));
+    {
+      ClaimCheckBus sender(bus, options);
+      auto large = message(payload(2000));
+      large.to("Q.RAW");
+      REQUIRE(sender.send(large));
+    }
+
+    // A receiver still maps the file of a sender gone.
+    ClaimCheckBus checked(bus, options);
+    std::vector<Message> received;
+    REQUIRE(checked.receive("Q.IN", [&received](const Message& msg) { received.push_back(msg); }));
+    auto inFlight = raw[0];
+    inFlight.to("Q.IN");
+    REQUIRE(bus.send(inFlight));
+    REQUIRE(received.size() == 1);
+    REQUIRE(received[0].userData() == payload(2000));
+    REQUIRE(checked.failed() == 0);
+
+    // Then the file is reclaimed at its deadline.
+    auto path = raw[0].getMetaDataValue(CLAIM_CHECK_PATH);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (::access(path.c_str(), F_OK) == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(::access(path.c_str(), F_OK) != 0);
+  }
+
+  TEST_CASE("Claim check bus time to live", "[ClaimCheckBus]")
+  {
+    Directory directory;
+    LoopbackBus bus;
+    ClaimCheckBus::Options options;
+    options.threshold = 1000;
+    options.directory = directory.path;
+    options.ttl = std::chrono::milliseconds(10);
+    ClaimCheckBus checked(bus, options);
+
+    std::vector<Message> raw;
+    REQUIRE(bus.receive("Q.RAW", [&raw](const Message& msg) { raw.push_back(msg); }));
+    size_t received = 0;
+    REQUIRE(checked.receive("Q.IN", [&received](const Message&) { received++; }));
+
+    auto large = message(payload(2000));
+    large.to("Q.RAW");
+    REQUIRE(checked.send(large));
+
+    // Reclaimed by a timer, without sending anything else.
+    auto path = raw[0].getMetaDataValue(CLAIM_CHECK_PATH);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (::access(path.c_str(), F_OK) == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(::access(path.c_str(), F_OK) != 0);
+
+    auto expired = raw[0];
+    expired.to("Q.IN");
+    REQUIRE(bus.send(expired));
+    REQUIRE(received == 0);
+    REQUIRE(checked.failed() == 1);
+  }
+
+  TEST_CASE("Claim check bus untrusted files", "[ClaimCheckBus]")
+  {
+    Directory directory;
+    LoopbackBus bus;
+    ClaimCheckBus::Options options;
+    options.threshold = 1000;
+    options.directory = directory.path;
+    ClaimCheckBus checked(bus, options);
+
+    size_t received = 0;
+    REQUIRE(checked.receive("Q.IN", [&received](const Message&) { received++; }));
+
+    // Symbolic link planted under the prefix of the files
+    auto link = directory.path + "/fty-messagebus-link";
+    REQUIRE(::symlink("/etc/passwd", link.c_str()) == 0);
+    auto forged = message("");
+    forged.setMetaDataValue(CLAIM_CHECK_PATH, link);
+    forged.setMetaDataValue(CLAIM_CHECK_SIZE, "10");
+    REQUIRE(bus.send(forged));
+    REQUIRE(checked.failed() == 1);
+    ::unlink(link.c_str());
+
+    // File of another user
+    options.owner = ::geteuid() + 1;
+    ClaimCheckBus other(bus, options);
+    REQUIRE(other.receive("Q.OTHER", [&received](const Message&) { received++; }));
+    auto large = message(payload(2000));
+    large.to("Q.OTHER");
+    REQUIRE(checked.send(large));
+    REQUIRE(other.failed() == 1);
+    REQUIRE(received == 0);
+  }
+
+} // namespace
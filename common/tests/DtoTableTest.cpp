@@ -0,0 +1,184 @@
+#include <fty/messagebus/dto/Table.h>
+
+#include <catch2/catch.hpp>
+#include <iostream>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using namespace fty::messagebus::dto;
+
+  struct Sample
+  {
+    double value = 0;
+    uint64_t timestamp = 0;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(field("value", &Sample::value), field("timestamp", &Sample::timestamp));
+    }
+  };
+
+  struct Stream
+  {
+    std::string name;
+    bool active = false;
+    int16_t level = 0;
+    std::vector<float> values;
+    std::vector<bool> flags;
+    std::vector<std::string> tags;
+    std::vector<Sample> samples;
+    std::map<std::string, int> counters;
+    Sample last;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(field("name", &Stream::name), field("active", &Stream::active), field("level", &Stream::level),
+                             field("values", &Stream::values), field("flags", &Stream::flags), field("tags", &Stream::tags),
+                             field("samples", &Stream::samples), field("counters", &Stream::counters),
+                             field("last", &Stream::last));
+    }
+  };
+
+  // Older version of Stream, knowing its first fields only.
+  struct StreamV1
+  {
+    std::string name;
+    bool active = false;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(field("name", &StreamV1::name), field("active", &StreamV1::active));
+    }
+  };
+
+  struct Tree
+  {
+    int value = 0;
+    std::vector<Tree> children;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(field("value", &Tree::value), field("children", &Tree::children));
+    }
+  };
+
+  Stream stream()
+  {
+    Stream stream;
+    stream.name = "realpower";
+    stream.active = true;
+    stream.level = -3;
+    stream.values = {1.5f, -2.f, 1e30f};
+    stream.flags = {true, false, true};
+    stream.tags = {"a", "", "long tag"};
+    stream.samples = {{0.25, 1000}, {-1, UINT64_MAX}};
+    stream.counters = {{"b", 2}, {"a", 1}, {"c", -3}};
+    stream.last = {42, 7};
+    return stream;
+  }
+
+  //----------------------------------------------------------------------
+  // Test case
+  //----------------------------------------------------------------------
+  TEST_CASE("Table views", "[DtoTable]")
+  {
+    auto payload = encodeTable(stream());
+    TableView<Stream> view(payload);
+
+    REQUIRE(view.get<&Stream::name>() == "realpower");
+    REQUIRE(view.get<&Stream::active>());
+    REQUIRE(view.get<&Stream::level>() == -3);
+
+    auto values = view.get<&Stream::values>();
+    REQUIRE(values.size() == 3);
+    REQUIRE(values[0] == 1.5f);
+    REQUIRE(values[2] == 1e30f);
+
+    std::vector<bool> flags(view.get<&Stream::flags>().begin(), view.get<&Stream::flags>().end());
+    REQUIRE(flags == std::vector<bool>{true, false, true});
+
+    std::vector<std::string_view> tags;
+    for (auto tag : view.get<&Stream::tags>())
+    {
+      tags.push_back(tag);
+    }
+    REQUIRE(tags == std::vector<std::string_view>{"a", "", "long tag"});
+
+    auto samples = view.get<&Stream::samples>();
+    REQUIRE(samples.size() == 2);
+    REQUIRE(samples[0].get<&Sample::value>() == 0.25);
+    REQUIRE(samples[1].get<&Sample::timestamp>() == UINT64_MAX);
+    REQUIRE(view.get<&Stream::last>().get<&Sample::value>() == 42);
+
+    auto counters = view.get<&Stream::counters>();
+    REQUIRE(counters.size() == 3);
+    REQUIRE(counters.key(0) == "a");
+    REQUIRE(counters.value(counters.find("c")) == -3);
+    REQUIRE(counters.value(counters.find("b")) == 2);
+    REQUIRE(counters.find("d") == counters.size());
+
+    // Views read in place from the payload.
+    REQUIRE(view.get<&Stream::name>().data() >= payload.data());
+    REQUIRE(view.get<&Stream::name>().data() < payload.data() + payload.size());
+  }
+
+  TEST_CASE("Table versions", "[DtoTable]")
+  {
+    // A newer payload read by an older schema, and the other way around.
+    auto olderPayload = encodeTable(stream());
+    TableView<StreamV1> olderView(olderPayload);
+    REQUIRE(olderView.get<&StreamV1::name>() == "realpower");
+
+    auto newerPayload = encodeTable(StreamV1{"v1", true});
+    TableView<Stream> newer(newerPayload);
+    REQUIRE(newer.get<&Stream::name>() == "v1");
+    REQUIRE(newer.has<&Stream::active>());
+    REQUIRE(!newer.has<&Stream::samples>());
+    REQUIRE(newer.get<&Stream::level>() == 0);
+    REQUIRE(newer.get<&Stream::samples>().empty());
+    REQUIRE(newer.get<&Stream::last>().get<&Sample::timestamp>() == 0);
+  }
+
+  TEST_CASE("Table verification", "[DtoTable]")
+  {
+    auto payload = encodeTable(stream());
+
+    // Every truncation is detected.
+    for (size_t size = 0; size < payload.size(); size++)
+    {
+      REQUIRE_THROWS_AS(TableView<Stream>(std::string_view(payload).substr(0, size)), DecodeError);
+    }
+
+    // Offsets out of the payload or into the offsets of the table.
+    auto corrupted = payload;
+    uint32_t offset = 0xffff;
+    std::memcpy(&corrupted[4], &offset, sizeof(offset));
+    REQUIRE_THROWS_AS(TableView<Stream>(corrupted), DecodeError);
+    offset = 4;
+    std::memcpy(&corrupted[4], &offset, sizeof(offset));
+    REQUIRE_THROWS_AS(TableView<Stream>(corrupted), DecodeError);
+
+    // A list whose items all point to the same subtree, nested deeper and deeper.
+    Tree tree{1, {}};
+    auto deep = encodeTable(tree);
+    REQUIRE(TableView<Tree>(deep).get<&Tree::value>() == 1);
+    std::string shared;
+    auto append = [&shared](uint32_t value) { shared.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    for (uint32_t level = 0; level < 64; level++)
+    {
+      // Table of 2 fields, the list has 16 items pointing to the next table.
+      append(2);
+      append(12);
+      append(16);
+      append(0);
+      append(16);
+      for (uint32_t i = 0; i < 16; i++)
+      {
+        append(4 * 17);
+      }
+    }
+    append(0);
+    REQUIRE_THROWS_AS(TableView<Tree>(shared), DecodeError);
+  }
+} // namespace
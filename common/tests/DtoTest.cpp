@@ -0,0 +1,161 @@
+#include <fty/messagebus/Codec.h>
+#include <fty/messagebus/dto/Cbor.h>
+#include <fty/messagebus/dto/FastJson.h>
+#include <fty/messagebus/dto/Json.h>
+#include <fty/messagebus/dto/MsgPack.h>
+
+#include <catch2/catch.hpp>
+#include <iostream>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using namespace fty::messagebus::dto;
+
+  struct Point
+  {
+    double x = 0;
+    float y = 0;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(field("x", &Point::x), field("y", &Point::y));
+    }
+  };
+
+  struct Shape
+  {
+    std::string name;
+    bool closed = false;
+    int8_t small = 0;
+    int64_t big = 0;
+    uint64_t unsignedBig = 0;
+    std::vector<Point> points;
+    std::vector<bool> flags;
+    std::map<std::string, int> counters;
+    Point center;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(field("name", &Shape::name), field("closed", &Shape::closed), field("small", &Shape::small),
+                             field("big", &Shape::big), field("unsigned_big", &Shape::unsignedBig), field("points", &Shape::points),
+                             field("flags", &Shape::flags), field("counters", &Shape::counters), field("center", &Shape::center));
+    }
+  };
+
+  struct Small
+  {
+    int a = 0;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(field("a", &Small::a));
+    }
+  };
+
+  Shape shape()
+  {
+    Shape shape;
+    shape.name = "tri\"angle\\\n\x01 é";
+    shape.closed = true;
+    shape.small = -100;
+    shape.big = INT64_MIN;
+    shape.unsignedBig = UINT64_MAX;
+    shape.points = {{0.5, -1.25f}, {1e300, 3.f}, {-2, 0}};
+    shape.flags = {true, false, true};
+    shape.counters = {{"one", 1}, {"minus", -70000}, {"", 0}};
+    shape.center = {0.1, 0.2f};
+    return shape;
+  }
+
+  void check(const Shape& decoded, const Shape& expected)
+  {
+    REQUIRE(decoded.name == expected.name);
+    REQUIRE(decoded.closed == expected.closed);
+    REQUIRE(decoded.small == expected.small);
+    REQUIRE(decoded.big == expected.big);
+    REQUIRE(decoded.unsignedBig == expected.unsignedBig);
+    REQUIRE(decoded.points.size() == expected.points.size());
+    for (size_t i = 0; i < expected.points.size(); i++)
+    {
+      REQUIRE(decoded.points[i].x == expected.points[i].x);
+      REQUIRE(decoded.points[i].y == expected.points[i].y);
+    }
+    REQUIRE(decoded.flags == expected.flags);
+    REQUIRE(decoded.counters == expected.counters);
+    REQUIRE(decoded.center.x == expected.center.x);
+    REQUIRE(decoded.center.y == expected.center.y);
+  }
+
+  template <typename Format>
+  void roundTrip()
+  {
+    auto expected = shape();
+    auto payload = encode<Format>(expected);
+    check(decode<Format, Shape>(payload), expected);
+
+    // Unknown fields are skipped, missing ones keep their default value.
+    auto small = decode<Format, Small>(payload);
+    REQUIRE(small.a == 0);
+    REQUIRE(decode<Format, Shape>(encode<Format>(Small{42})).name.empty());
+
+    // Truncated payloads are rejected.
+    for (size_t size = 0; size < payload.size(); size++)
+    {
+      REQUIRE_THROWS_AS((decode<Format, Shape>(std::string_view(payload).substr(0, size))), DecodeError);
+    }
+    REQUIRE_THROWS_AS((decode<Format, Shape>(payload + payload)), DecodeError);
+  }
+
+  //----------------------------------------------------------------------
+  // Test case
+  //----------------------------------------------------------------------
+  TEST_CASE("Dto round trip", "[Dto]")
+  {
+    roundTrip<Json>();
+    roundTrip<MsgPack>();
+    roundTrip<Cbor>();
+    roundTrip<FastJson>();
+  }
+
+  TEST_CASE("Dto wire format", "[Dto]")
+  {
+    REQUIRE(encode<Json>(Small{1}) == R"({"a":1})");
+    REQUIRE(encode<MsgPack>(Small{1}) == "\x81\xa1" "a\x01");
+    REQUIRE(encode<Cbor>(Small{1}) == "\xa1\x61" "a\x01");
+
+    REQUIRE(encode<Json>(Point{0.5, 2}) == R"({"x":0.5,"y":2})");
+    REQUIRE(encode<MsgPack>(Small{-33}) == "\x81\xa1" "a\xd0\xdf");
+    REQUIRE(encode<Cbor>(Small{-500}) == std::string("\xa1\x61" "a\x39\x01\xf3", 6));
+
+    // Foreign encodings: spaces and escapes in JSON, CBOR indefinite map and half float.
+    REQUIRE(decode<Json, Shape>(R"( { "name" : "é😀\/" , "unknown" : [ {"a" : null}, true, -1.5e3 ] } )").name == "é😀/");
+    REQUIRE(decode<FastJson, Shape>(R"( { "name" : "é😀\/" , "unknown" : [ {"a" : null}, true, -1.5e3 ] } )").name == "é😀/");
+    auto point = decode<Cbor, Point>(std::string("\xbf\x61x\xf9\x3c\x00\xff", 7));
+    REQUIRE(point.x == 1.0);
+
+    // Integer range is checked against the field type.
+    REQUIRE_THROWS_AS((decode<Json, Shape>(R"({"small":128})")), DecodeError);
+    REQUIRE_THROWS_AS((decode<MsgPack, Shape>("\x81\xac" "unsigned_big\xff")), DecodeError);
+    REQUIRE(decode<MsgPack, Small>(encode<MsgPack>(Small{-1})).a == -1);
+    REQUIRE_THROWS_AS((decode<Json, Shape>(R"({"unsigned_big":-1})")), DecodeError);
+
+    // Deep nesting of unknown values is rejected.
+    REQUIRE_THROWS_AS((decode<Json, Small>(R"({"b":)" + std::string(1000, '[') + std::string(1000, ']') + "}")), DecodeError);
+  }
+} // namespace
+
+template <>
+struct fty::messagebus::Codec<Shape> : dto::FieldCodec<Shape, dto::MsgPack>
+{
+};
+
+namespace
+{
+  TEST_CASE("Dto codec", "[Dto]")
+  {
+    static_assert(HasCodec<Shape>::value);
+    auto expected = shape();
+    check(Codec<Shape>::decode(Codec<Shape>::encode(expected)), expected);
+  }
+} // namespace
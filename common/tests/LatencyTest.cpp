@@ -0,0 +1,85 @@
+#include <fty/messagebus/Latency.h>
+
+#include "AllocationCounter.h"
+
+#include <catch2/catch.hpp>
+#include <optional>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::allocationsOf;
+
+  // Message as sent and received by a backend, stamped on each side.
+  Message sentStamped()
+  {
+    auto msg = Message::buildMessage("client", "Q.LATENCY", "SUBJECT", "data");
+    latency::stamp(msg.metaData(), latency::STAMP_SEND, latency::now());
+    latency::stamp(msg.metaData(), latency::STAMP_WIRE, latency::now());
+    latency::stampReceive(msg.metaData(), latency::now());
+    return msg;
+  }
+} // namespace
+
+TEST_CASE("Latency stamping enabled", "[Latency]")
+{
+  auto enabled = latency::enabled();
+  latency::enable(true);
+  CHECK(latency::enabled());
+  latency::enable(false);
+  CHECK_FALSE(latency::enabled());
+  latency::enable(enabled);
+}
+
+TEST_CASE("Latency stamps of a message", "[Latency]")
+{
+  auto msg = sentStamped();
+  REQUIRE(latency::stamped(msg.metaData()));
+
+  std::optional<latency::Stamps> inListener;
+  std::optional<latency::Stamps> observed;
+  latency::observe([&observed](const latency::Stamps& stamps) { observed = stamps; });
+  latency::invoke([&inListener](const Message& received) { inListener = latency::read(received); }, msg);
+  latency::observe({});
+
+  REQUIRE(inListener);
+  CHECK(inListener->send != 0);
+  CHECK(inListener->wire >= inListener->send);
+  CHECK(inListener->receive >= inListener->wire);
+  CHECK(inListener->listenerStart >= inListener->receive);
+  CHECK(inListener->listenerEnd == 0);
+  CHECK(inListener->listener().count() == 0);
+
+  REQUIRE(observed);
+  CHECK(observed->listenerStart == inListener->listenerStart);
+  CHECK(observed->listenerEnd >= observed->listenerStart);
+  CHECK(observed->sendToWire().count() >= 0);
+  CHECK(observed->wireToReceive().count() >= 0);
+  CHECK(observed->receiveToListener().count() >= 0);
+  CHECK(observed->total() == observed->sendToWire() + observed->wireToReceive() + observed->receiveToListener() + observed->listener());
+
+  // The message of the backend is left as received.
+  CHECK(msg.metaData().count(latency::STAMP_LISTENER) == 0);
+}
+
+TEST_CASE("Latency of messages sent without stamps", "[Latency]")
+{
+  auto msg = Message::buildMessage("client", "Q.LATENCY", "SUBJECT", "data");
+  latency::stampReceive(msg.metaData(), latency::now());
+  CHECK_FALSE(latency::stamped(msg.metaData()));
+  CHECK(msg.metaData().count(latency::STAMP_RECEIVE) == 0);
+
+  bool observed = false;
+  latency::observe([&observed](const latency::Stamps&) { observed = true; });
+  size_t received = 0;
+  MessageListener listener = [&received](const Message& in) {
+    received++;
+    CHECK(latency::read(in).send == 0);
+  };
+  // Dispatch of unstamped messages costs nothing.
+  CHECK(allocationsOf([&]() { latency::invoke(listener, msg); }) == 0);
+  latency::observe({});
+
+  CHECK(received == 1);
+  CHECK_FALSE(observed);
+}
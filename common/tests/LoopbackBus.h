@@ -0,0 +1,81 @@
+#pragma once
+
+#include <fty/messagebus/MessageBus.h>
+
+#include <map>
+#include <mutex>
+
+namespace fty::messagebus::test
+{
+  //----------------------------------------------------------------------
+  // Loopback bus: messages sent are delivered synchronously to the listener of their address
+  //----------------------------------------------------------------------
+  class LoopbackBus : public MessageBus
+  {
+  public:
+    fty::Expected<void> connect() noexcept override
+    {
+      return {};
+    }
+
+    fty::Expected<void> send(const Message& msg) noexcept override
+    {
+      MessageListener listener;
+      {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_sent++;
+        auto it = m_listeners.find(msg.to());
+        if (it == m_listeners.end())
+        {
+          return fty::unexpected("No listener");
+        }
+        listener = it->second;
+      }
+      listener(msg);
+      return {};
+    }
+
+    fty::Expected<void> receive(const Address& address, MessageListener&& func, const std::string& = {}, DispatchMode = DISPATCH_UNORDERED,
+                                const std::string& = {}) noexcept override
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_listeners[address] = std::move(func);
+      return {};
+    }
+
+    fty::Expected<void> unreceive(const Address& address) noexcept override
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_listeners.erase(address);
+      return {};
+    }
+
+    fty::Expected<Message> request(const Message&, int) noexcept override
+    {
+      return fty::unexpected("Not implemented");
+    }
+
+    const ClientName& clientName() const noexcept override
+    {
+      return m_name;
+    }
+
+    const Identity& identity() const noexcept override
+    {
+      return m_name;
+    }
+
+    size_t sent()
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      return m_sent;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::map<Address, MessageListener> m_listeners;
+    size_t m_sent = 0;
+    ClientName m_name = "loopback";
+  };
+
+} // namespace fty::messagebus::test
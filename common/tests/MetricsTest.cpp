@@ -0,0 +1,201 @@
+#include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/Metrics.h>
+#include <fty/messagebus/MetricsBus.h>
+
+#include "AllocationCounter.h"
+#include "LoopbackBus.h"
+
+#include <catch2/catch.hpp>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::allocationsOf;
+  using fty::messagebus::test::LoopbackBus;
+
+  // Loopback bus replying to requests, or failing them with an error
+  class ReplyingBus : public LoopbackBus
+  {
+  public:
+    fty::Expected<Message> request(const Message& msg, int) noexcept override
+    {
+      if (!error.empty())
+      {
+        return fty::unexpected(error);
+      }
+      return msg.buildReply(UserData(10, 'r'));
+    }
+
+    std::string error;
+  };
+
+  bool contains(const std::string& text, const std::string& line)
+  {
+    return text.find(line + "\n") != std::string::npos;
+  }
+} // namespace
+
+TEST_CASE("Metrics counter", "[Metrics]")
+{
+  metrics::Counter counter;
+  REQUIRE(counter.value() == 0);
+
+  constexpr size_t NB_THREADS = 32;
+  constexpr uint64_t NB_ADDS = 10000;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < NB_THREADS; i++)
+  {
+    threads.emplace_back([&counter]() {
+      for (uint64_t n = 0; n < NB_ADDS; n++)
+      {
+        counter.add();
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  REQUIRE(counter.value() == NB_THREADS * NB_ADDS);
+
+  counter.add(5);
+  REQUIRE(counter.value() == NB_THREADS * NB_ADDS + 5);
+}
+
+TEST_CASE("Metrics registry", "[Metrics]")
+{
+  metrics::Registry registry;
+  auto& metrics = registry.address("Q.ONE");
+  REQUIRE(&registry.address("Q.ONE") == &metrics);
+  REQUIRE(&registry.address("Q.TWO") != &metrics);
+  REQUIRE(&registry.address("Q.ONE") == &metrics);
+
+  // Another registry does not hit the cache of the thread.
+  metrics::Registry other;
+  REQUIRE(&other.address("Q.ONE") != &metrics);
+
+  // Repeated lookups do not allocate.
+  REQUIRE(allocationsOf([&registry]() { registry.address("Q.ONE").sentMessages.add(); }) == 0);
+
+  registry.deliveryFailure(DELIVERY_STATE_TIMEOUT);
+  registry.deliveryFailure(DELIVERY_STATE_TIMEOUT);
+  registry.deliveryFailure(static_cast<DeliveryState>(200));
+  registry.connectionState(COM_STATE_LOST);
+  REQUIRE(registry.deliveryFailures(DELIVERY_STATE_TIMEOUT) == 2);
+  REQUIRE(registry.deliveryFailures(DELIVERY_STATE_UNDEFINED) == 1);
+  REQUIRE(registry.connectionStates(COM_STATE_LOST) == 1);
+  REQUIRE(registry.connectionStates(COM_STATE_OK) == 0);
+}
+
+TEST_CASE("Metrics bus", "[Metrics]")
+{
+  ReplyingBus bus;
+  auto registry = std::make_shared<metrics::Registry>();
+  MetricsBus metricsBus(bus, registry);
+
+  REQUIRE(metricsBus.connect());
+  REQUIRE(registry->connectionStates(COM_STATE_OK) == 1);
+
+  int64_t inflight = -1;
+  REQUIRE(metricsBus.receive("Q.IN", [&registry, &inflight](const Message&) {
+    inflight = registry->address("Q.IN").inflightMessages.value();
+  }));
+  REQUIRE(metricsBus.send(Message::buildMessage("client", "Q.IN", "SUBJECT", "12345")));
+  REQUIRE(metricsBus.send(Message::buildMessage("client", "Q.IN", "SUBJECT", "123")));
+  REQUIRE(inflight == 1);
+
+  auto& metrics = registry->address("Q.IN");
+  REQUIRE(metrics.sentMessages.value() == 2);
+  REQUIRE(metrics.sentBytes.value() == 8);
+  REQUIRE(metrics.receivedMessages.value() == 2);
+  REQUIRE(metrics.receivedBytes.value() == 8);
+  REQUIRE(metrics.inflightMessages.value() == 0);
+
+  // Failed sends are only counted as failures.
+  REQUIRE_FALSE(metricsBus.send(Message::buildMessage("client", "Q.NOBODY", "SUBJECT", "data")));
+  REQUIRE(registry->address("Q.NOBODY").sentMessages.value() == 0);
+  REQUIRE(registry->deliveryFailures(DELIVERY_STATE_UNDEFINED) == 1);
+
+  // Requests and their replies are counted on the request address.
+  auto request = Message::buildRequest("client", "Q.REQUEST", "SUBJECT", "Q.REPLY", "data");
+  REQUIRE(metricsBus.request(request, 1));
+  auto& requests = registry->address("Q.REQUEST");
+  REQUIRE(requests.sentMessages.value() == 1);
+  REQUIRE(requests.sentBytes.value() == 4);
+  REQUIRE(requests.receivedMessages.value() == 1);
+  REQUIRE(requests.receivedBytes.value() == 10);
+  REQUIRE(requests.inflightRequests.value() == 0);
+  REQUIRE(requests.requestLatency.snapshot().count == 1);
+
+  bus.error = to_string(DELIVERY_STATE_TIMEOUT);
+  REQUIRE_FALSE(metricsBus.request(request, 1));
+  REQUIRE(registry->deliveryFailures(DELIVERY_STATE_TIMEOUT) == 1);
+  REQUIRE(requests.requestLatency.snapshot().count == 1);
+  REQUIRE(requests.inflightRequests.value() == 0);
+}
+
+TEST_CASE("Metrics exposition", "[Metrics]")
+{
+  metrics::Registry registry;
+  auto& metrics = registry.address("Q.\"QUOTED\"");
+  metrics.sentMessages.add(3);
+  metrics.inflightRequests.add(2);
+  metrics.requestLatency.record(std::chrono::microseconds(300));
+  metrics.requestLatency.record(std::chrono::seconds(30));
+  registry.deliveryFailure(DELIVERY_STATE_REJECTED);
+  // Both undefined, merged in one line.
+  registry.deliveryFailure(static_cast<DeliveryState>(8));
+  registry.deliveryFailure(DELIVERY_STATE_UNDEFINED);
+  registry.connectionState(COM_STATE_LOST);
+
+  auto text = registry.exposition();
+  CHECK(contains(text, "# TYPE fty_messagebus_sent_messages_total counter"));
+  CHECK(contains(text, "fty_messagebus_sent_messages_total{address=\"Q.\\\"QUOTED\\\"\"} 3"));
+  CHECK(contains(text, "fty_messagebus_received_messages_total{address=\"Q.\\\"QUOTED\\\"\"} 0"));
+  CHECK(contains(text, "# TYPE fty_messagebus_inflight_requests gauge"));
+  CHECK(contains(text, "fty_messagebus_inflight_requests{address=\"Q.\\\"QUOTED\\\"\"} 2"));
+  CHECK(contains(text, "# TYPE fty_messagebus_request_duration_seconds histogram"));
+  CHECK(contains(text, "fty_messagebus_request_duration_seconds_bucket{address=\"Q.\\\"QUOTED\\\"\",le=\"0.00025\"} 0"));
+  CHECK(contains(text, "fty_messagebus_request_duration_seconds_bucket{address=\"Q.\\\"QUOTED\\\"\",le=\"0.0005\"} 1"));
+  CHECK(contains(text, "fty_messagebus_request_duration_seconds_bucket{address=\"Q.\\\"QUOTED\\\"\",le=\"10\"} 1"));
+  CHECK(contains(text, "fty_messagebus_request_duration_seconds_bucket{address=\"Q.\\\"QUOTED\\\"\",le=\"+Inf\"} 2"));
+  CHECK(contains(text, "fty_messagebus_request_duration_seconds_count{address=\"Q.\\\"QUOTED\\\"\"} 2"));
+  CHECK(contains(text, "fty_messagebus_delivery_failures_total{state=\"REJECTED\"} 1"));
+  CHECK(contains(text, "fty_messagebus_delivery_failures_total{state=\"UNDEFINED\"} 2"));
+  CHECK(contains(text, "fty_messagebus_connection_states_total{state=\"LOST\"} 1"));
+  CHECK(text.find("state=\"OK\"") == std::string::npos);
+}
+
+TEST_CASE("Metrics publisher", "[Metrics]")
+{
+  LoopbackBus bus;
+  auto registry = std::make_shared<metrics::Registry>();
+  registry->address("Q.TRAFFIC").sentMessages.add(7);
+
+  std::promise<Message> published;
+  auto future = published.get_future();
+  bool first = true;
+  REQUIRE(bus.receive("Q.METRICS", [&published, &first](const Message& msg) {
+    if (first)
+    {
+      first = false;
+      published.set_value(msg);
+    }
+  }));
+
+  {
+    MetricsPublisher publisher(bus, "Q.METRICS", std::chrono::milliseconds(10), registry);
+    REQUIRE(future.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+  }
+  auto msg = future.get();
+  CHECK(msg.subject() == METRICS_SUBJECT);
+  CHECK(contains(msg.userData(), "fty_messagebus_sent_messages_total{address=\"Q.TRAFFIC\"} 7"));
+
+  // No publication after the publisher is gone.
+  auto sent = bus.sent();
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  CHECK(bus.sent() == sent);
+}
@@ -0,0 +1,170 @@
+#include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/RpcClient.h>
+#include <fty/messagebus/RpcServer.h>
+
+#include "LoopbackBus.h"
+
+#include <catch2/catch.hpp>
+#include <future>
+#include <iostream>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::LoopbackBus;
+
+  // Dto following the serialize() / constructor convention
+  struct Operation
+  {
+    int param_1 = 0;
+    int param_2 = 0;
+
+    Operation(int _param_1, int _param_2)
+      : param_1(_param_1)
+      , param_2(_param_2)
+    {
+    }
+    Operation(const std::string& input)
+    {
+      auto separator = input.find(' ');
+      param_1 = std::stoi(input.substr(0, separator));
+      param_2 = std::stoi(input.substr(separator + 1));
+    }
+
+    std::string serialize() const
+    {
+      return std::to_string(param_1) + " " + std::to_string(param_2);
+    }
+  };
+
+  // Dto with a dedicated codec
+  struct Result
+  {
+    int value = 0;
+  };
+} // namespace
+
+template <>
+struct fty::messagebus::Codec<Result>
+{
+  static UserData encode(const Result& result)
+  {
+    return std::to_string(result.value);
+  }
+
+  static Result decode(const UserData& payload)
+  {
+    return {std::stoi(payload)};
+  }
+};
+
+namespace
+{
+  static_assert(HasCodec<UserData>::value);
+  static_assert(HasCodec<Operation>::value);
+  static_assert(HasCodec<Result>::value);
+  static_assert(!HasCodec<int>::value);
+
+  auto deadline(int ms = 5000)
+  {
+    return RpcClient::Clock::now() + std::chrono::milliseconds(ms);
+  }
+
+  //----------------------------------------------------------------------
+  // Test case
+  //----------------------------------------------------------------------
+  TEST_CASE("Rpc client call", "[RpcClient]")
+  {
+    LoopbackBus bus;
+    RpcServer server(bus, "Q.SERVER", {1, 16, {}});
+    REQUIRE(server.handle("SUM", [](const Message& request) -> fty::Expected<UserData> {
+      auto operation = Codec<Operation>::decode(request.userData());
+      return Codec<Result>::encode({operation.param_1 + operation.param_2});
+    }));
+    REQUIRE(server.handle("ECHO", [](const Message& request) -> fty::Expected<UserData> { return request.userData(); }));
+    REQUIRE(server.start());
+
+    RpcClient client(bus, "client", "Q.CLIENT");
+    REQUIRE(client.start());
+
+    // Synchronous calls
+    auto sum = client.call<Operation, Result>("Q.SERVER", "SUM", Operation(40, 2), deadline());
+    REQUIRE(sum);
+    REQUIRE(sum->value == 42);
+
+    auto echo = client.call<UserData, UserData>("Q.SERVER", "ECHO", "data", deadline());
+    REQUIRE(echo);
+    REQUIRE(*echo == "data");
+
+    // Errors of the server, of the decoding and of the bus
+    auto unknown = client.call<UserData, UserData>("Q.SERVER", "UNKNOWN", "data", deadline());
+    REQUIRE(!unknown);
+    REQUIRE(unknown.error() == "Subject not supported: UNKNOWN");
+
+    auto invalid = client.call<UserData, Result>("Q.SERVER", "ECHO", "not a number", deadline());
+    REQUIRE(!invalid);
+
+    auto unavailable = client.call<UserData, UserData>("Q.NOBODY", "ECHO", "data", deadline());
+    REQUIRE(!unavailable);
+    REQUIRE(unavailable.error() == "No listener");
+
+    // Asynchronous call
+    std::promise<fty::Expected<Result>> promise;
+    client.callAsync<Operation, Result>("Q.SERVER", "SUM", Operation(1, 2), deadline(), [&promise](fty::Expected<Result>&& reply) {
+      promise.set_value(std::move(reply));
+    });
+    auto asyncSum = promise.get_future().get();
+    REQUIRE(asyncSum);
+    REQUIRE(asyncSum->value == 3);
+  }
+
+  TEST_CASE("Rpc client deadline", "[RpcClient]")
+  {
+    LoopbackBus bus;
+    // Requests are dropped.
+    REQUIRE(bus.receive("Q.SERVER", [](const Message&) {}));
+
+    RpcClient client(bus, "client", "Q.CLIENT");
+
+    auto notStarted = client.call<UserData, UserData>("Q.SERVER", "ECHO", "data", deadline());
+    REQUIRE(!notStarted);
+    REQUIRE(notStarted.error() == to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
+
+    REQUIRE(client.start());
+    auto start = RpcClient::Clock::now();
+    auto timeout = client.call<UserData, UserData>("Q.SERVER", "ECHO", "data", deadline(20));
+    REQUIRE(!timeout);
+    REQUIRE(timeout.error() == to_string(DeliveryState::DELIVERY_STATE_TIMEOUT));
+    REQUIRE(RpcClient::Clock::now() - start >= std::chrono::milliseconds(20));
+
+    // Stopping the client aborts the calls in progress.
+    std::promise<fty::Expected<UserData>> promise;
+    client.callAsync<UserData, UserData>("Q.SERVER", "ECHO", "data", deadline(), [&promise](fty::Expected<UserData>&& reply) {
+      promise.set_value(std::move(reply));
+    });
+    client.stop();
+    auto aborted = promise.get_future().get();
+    REQUIRE(!aborted);
+    REQUIRE(aborted.error() == to_string(DeliveryState::DELIVERY_STATE_ABORTED));
+  }
+
+  TEST_CASE("Rpc client deadline with a saturated pool", "[RpcClient]")
+  {
+    LoopbackBus bus;
+    REQUIRE(bus.receive("Q.SERVER", [](const Message&) {}));
+
+    // The only worker running the deadline timers is busy.
+    auto pool = std::make_shared<fty::messagebus::utils::PoolWorker>(1);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    pool->offload([released]() { released.wait(); });
+
+    RpcClient client(bus, "client", "Q.CLIENT", std::make_shared<fty::messagebus::utils::TimerWheel>(pool));
+    REQUIRE(client.start());
+    auto timeout = client.call<UserData, UserData>("Q.SERVER", "ECHO", "data", deadline(20));
+    REQUIRE(!timeout);
+    REQUIRE(timeout.error() == to_string(DeliveryState::DELIVERY_STATE_TIMEOUT));
+
+    release.set_value();
+  }
+} // namespace
@@ -0,0 +1,168 @@
+#include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/RpcServer.h>
+
+#include "LoopbackBus.h"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace fty::messagebus;
+  using fty::messagebus::test::LoopbackBus;
+
+  // Collect the replies sent to Q.REPLY
+  struct Replies
+  {
+    std::mutex mutex;
+    std::map<std::string, Message> byId;
+
+    void operator()(const Message& msg)
+    {
+      std::unique_lock<std::mutex> lk(mutex);
+      byId[msg.correlationId()] = msg;
+    }
+  };
+
+  Message request(const std::string& subject, const std::string& data)
+  {
+    return Message::buildRequest("client", "Q.SERVER", subject, "Q.REPLY", data);
+  }
+
+  //----------------------------------------------------------------------
+  // Test case
+  //----------------------------------------------------------------------
+  TEST_CASE("Rpc server dispatch", "[RpcServer]")
+  {
+    LoopbackBus bus;
+    Replies replies;
+    REQUIRE(bus.receive("Q.REPLY", [&replies](const Message& msg) { replies(msg); }));
+
+    RpcServer server(bus, "Q.SERVER", {0, 16, {}});
+    REQUIRE(server.handle("ECHO", [](const Message& msg) -> fty::Expected<UserData> { return msg.userData(); }));
+    REQUIRE(server.handle("FAIL", [](const Message&) -> fty::Expected<UserData> { return fty::unexpected("Failed"); }));
+    REQUIRE(server.handle("THROW", [](const Message&) -> fty::Expected<UserData> { throw std::runtime_error("Thrown"); }));
+    REQUIRE(server.handle("THROW_INT", [](const Message&) -> fty::Expected<UserData> { throw 42; }));
+    REQUIRE(server.start());
+    // Subjects are fixed once started.
+    REQUIRE_FALSE(server.handle("ECHO", [](const Message&) -> fty::Expected<UserData> { return UserData(); }));
+
+    auto echo = request("ECHO", "data");
+    auto fail = request("FAIL", "data");
+    auto thrown = request("THROW", "data");
+    auto thrownInt = request("THROW_INT", "data");
+    auto unknown = request("UNKNOWN", "data");
+    for (const auto& msg : {echo, fail, thrown, thrownInt, unknown})
+    {
+      REQUIRE(bus.send(msg));
+    }
+
+    REQUIRE(replies.byId.size() == 5);
+    REQUIRE(replies.byId[echo.correlationId()].status() == STATUS_OK);
+    REQUIRE(replies.byId[echo.correlationId()].userData() == "data");
+    REQUIRE(replies.byId[fail.correlationId()].status() == STATUS_KO);
+    REQUIRE(replies.byId[fail.correlationId()].userData() == "Failed");
+    REQUIRE(replies.byId[thrown.correlationId()].status() == STATUS_KO);
+    REQUIRE(replies.byId[thrown.correlationId()].userData() == "Thrown");
+    REQUIRE(replies.byId[thrownInt.correlationId()].status() == STATUS_KO);
+    REQUIRE(replies.byId[thrownInt.correlationId()].userData() == "Unknown error");
+    REQUIRE(replies.byId[unknown.correlationId()].status() == STATUS_KO);
+    REQUIRE(replies.byId[unknown.correlationId()].userData() == "Subject not supported: UNKNOWN");
+
+    auto latency = server.latency();
+    REQUIRE(latency.size() == 4);
+    REQUIRE(latency["ECHO"].count == 1);
+    REQUIRE(latency["FAIL"].count == 1);
+    REQUIRE(latency["THROW"].count == 1);
+
+    // Once stopped, requests are not received anymore.
+    server.stop();
+    REQUIRE(!bus.send(echo));
+  }
+
+  TEST_CASE("Rpc server bounded executor", "[RpcServer]")
+  {
+    LoopbackBus bus;
+    Replies replies;
+    REQUIRE(bus.receive("Q.REPLY", [&replies](const Message& msg) { replies(msg); }));
+
+    // Replies go through an other connected bus.
+    auto replyBus = std::make_shared<LoopbackBus>();
+    REQUIRE(replyBus->receive("Q.REPLY", [&replies](const Message& msg) { replies(msg); }));
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    RpcServer server(bus, "Q.SERVER", {2, 2, {replyBus}});
+    REQUIRE(server.handle("WAIT", [released](const Message& msg) -> fty::Expected<UserData> {
+      released.wait();
+      return msg.userData();
+    }));
+    REQUIRE(server.start());
+
+    // Two requests fill the server, the third is rejected at once.
+    auto first = request("WAIT", "1");
+    auto second = request("WAIT", "2");
+    auto third = request("WAIT", "3");
+    REQUIRE(bus.send(first));
+    REQUIRE(bus.send(second));
+    REQUIRE(bus.send(third));
+    REQUIRE(server.rejected() == 1);
+
+    release.set_value();
+    server.stop();
+
+    REQUIRE(replies.byId.size() == 3);
+    REQUIRE(replies.byId[first.correlationId()].userData() == "1");
+    REQUIRE(replies.byId[second.correlationId()].userData() == "2");
+    REQUIRE(replies.byId[third.correlationId()].status() == STATUS_KO);
+    REQUIRE(replies.byId[third.correlationId()].userData() == to_string(DeliveryState::DELIVERY_STATE_BUSY));
+    REQUIRE(replyBus->sent() == 3);
+    REQUIRE(server.latency()["WAIT"].count == 2);
+  }
+
+  TEST_CASE("Rpc server concurrency over an executor", "[RpcServer]")
+  {
+    LoopbackBus bus;
+    Replies replies;
+    REQUIRE(bus.receive("Q.REPLY", [&replies](const Message& msg) { replies(msg); }));
+
+    // Requests beyond the concurrency wait for a handler, without taking more workers.
+    auto executor = std::make_shared<fty::messagebus::utils::PoolWorker>(4);
+    std::atomic_int running{0};
+    std::atomic_int maxRunning{0};
+    RpcServer server(bus, "Q.SERVER", {2, 16, {}, executor});
+    REQUIRE(server.handle("WAIT", [&running, &maxRunning](const Message& msg) -> fty::Expected<UserData> {
+      auto current = ++running;
+      auto seen = maxRunning.load();
+      while (current > seen && !maxRunning.compare_exchange_weak(seen, current))
+      {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      running--;
+      return msg.userData();
+    }));
+    REQUIRE(server.start());
+
+    std::vector<Message> requests;
+    for (int i = 0; i < 8; i++)
+    {
+      requests.push_back(request("WAIT", std::to_string(i)));
+      REQUIRE(bus.send(requests.back()));
+    }
+    server.stop();
+
+    REQUIRE(server.rejected() == 0);
+    REQUIRE(maxRunning.load() == 2);
+    REQUIRE(replies.byId.size() == 8);
+    for (const auto& msg : requests)
+    {
+      REQUIRE(replies.byId[msg.correlationId()].userData() == msg.userData());
+    }
+  }
+} // namespace
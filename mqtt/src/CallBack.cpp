@@ -27,88 +27,65 @@
 */
 
 #include "CallBack.h"
+#include "MsgBusMqttUtils.h"
 #include <fty/messagebus/Message.h>
+#include <fty/messagebus/Metrics.h>
+#include <fty/messagebus/utils/MsgBusTrace.hpp>
 
 #include <fty_log.h>
 
 #include <mqtt/async_client.h>
 #include <mqtt/properties.h>
-
-namespace
-{
-
-  using namespace fty::messagebus;
-
-  static auto getMetaDataFromMqttProperties(const ::mqtt::properties& props) -> const MetaData
-  {
-
-    logDebug("getMetaDataFromMqttProperties...");
-    auto metaData = MetaData{};
-
-    // User properties
-    if (props.contains(::mqtt::property::USER_PROPERTY))
-    {
-      std::string key, value;
-      for (size_t i = 0; i < props.count(::mqtt::property::USER_PROPERTY); i++)
-      {
-        std::tie(key, value) = ::mqtt::get<::mqtt::string_pair>(props, ::mqtt::property::USER_PROPERTY, i);
-        metaData.emplace(key, value);
-      }
-    }
-    // Req/Rep pattern properties
-    if (props.contains(::mqtt::property::CORRELATION_DATA))
-    {
-      metaData.emplace(CORRELATION_ID, ::mqtt::get<std::string>(props, ::mqtt::property::CORRELATION_DATA));
-    }
-
-    if (props.contains(::mqtt::property::RESPONSE_TOPIC))
-    {
-      metaData.emplace(REPLY_TO, ::mqtt::get<std::string>(props, ::mqtt::property::RESPONSE_TOPIC));
-    }
-
-    logDebug("Done.");
-    return metaData;
-  }
-
-} // namespace
+#include <optional>
 
 namespace fty::messagebus::mqtt
 {
-  size_t NB_WORKERS = 16;
-
-  CallBack::CallBack()
+  CallBack::CallBack(PoolWorkerPointer poolWorkers)
     : ::mqtt::callback()
   {
-    m_poolWorkers = std::make_shared<utils::PoolWorker>(NB_WORKERS);
+    // The pool may be shared between bus instances, strands only wait for the jobs of this callback.
+    m_strands = std::make_shared<utils::Strands>(poolWorkers);
   }
 
   // Callback called when connection lost.
   void CallBack::connection_lost(const std::string& cause)
   {
+    utils::adoptThread(utils::ThreadRole::IO);
     std::string what = "?";
     if (!cause.empty())
     {
       what = cause;
     }
     logError("Connection lost: {}", what);
+    metrics::sharedRegistry()->connectionState(ComState::COM_STATE_LOST);
+    m_connectionLost = true;
+  }
+
+  bool CallBack::reconnected()
+  {
+    return m_connectionLost.exchange(false);
   }
 
   SubScriptionListener CallBack::subscriptions()
   {
+    std::unique_lock<std::mutex> lk(m_subscriptionsMutex);
     return m_subscriptions;
   }
 
-  void CallBack::subscriptions(const std::string& topic, const MessageListener& messageListener)
+  void CallBack::subscriptions(const std::string& topic, const Subscription& subscription)
   {
+    std::unique_lock<std::mutex> lk(m_subscriptionsMutex);
     if (auto it{m_subscriptions.find(topic)}; it == m_subscriptions.end())
     {
-      m_subscriptions.emplace(topic, messageListener);
+      auto& subscribed = m_subscriptions.emplace(topic, subscription).first->second;
+      subscribed.listenerTime = std::make_shared<utils::LazyHistogram>();
     }
   }
 
   auto CallBack::subscribed(const std::string& topic) -> bool
   {
     bool isSubscript = false;
+    std::unique_lock<std::mutex> lk(m_subscriptionsMutex);
     if (auto iter{m_subscriptions.find(topic)}; iter != m_subscriptions.end())
     {
       isSubscript = true;
@@ -118,27 +95,65 @@ namespace fty::messagebus::mqtt
 
   void CallBack::eraseSubscriptions(const std::string& topic)
   {
+    std::unique_lock<std::mutex> lk(m_subscriptionsMutex);
     m_subscriptions.erase(topic);
   }
 
+  std::map<std::string, utils::HistogramSnapshot> CallBack::listenerMetrics()
+  {
+    std::map<std::string, utils::HistogramSnapshot> metrics;
+    std::unique_lock<std::mutex> lk(m_subscriptionsMutex);
+    for (const auto& [topic, subscription] : m_subscriptions)
+    {
+      metrics.emplace(topic, subscription.listenerTime->snapshot());
+    }
+    return metrics;
+  }
+
   // Callback called when a mqtt message arrives.
   void CallBack::onMessageArrived(::mqtt::const_message_ptr msg, AsynClientPointer clientPointer)
   {
+    auto receivedAt = latency::now();
+    // Paho creates its threads, configure them on their first callback.
+    utils::adoptThread(utils::ThreadRole::IO);
     auto topic = msg->get_topic();
     logTrace("Message received from topic: '{}'", topic);
     // build metaData message from mqtt properties
     auto metaData = getMetaDataFromMqttProperties(msg->get_properties());
-    if (auto it{m_subscriptions.find(topic)}; it != m_subscriptions.end())
+    latency::stampReceive(metaData, receivedAt);
+    if (FTY_TRACE_ENABLED(receive))
+    {
+      auto correlationId = metaData.find(CORRELATION_ID);
+      FTY_TRACE(receive, topic.c_str(), msg->get_payload().size(),
+                utils::traceHash(correlationId != metaData.end() ? correlationId->second : std::string{}));
+    }
+    // The subscription is copied, it may be erased while its listener runs.
+    std::optional<Subscription> found;
+    {
+      std::unique_lock<std::mutex> lk(m_subscriptionsMutex);
+      if (auto it{m_subscriptions.find(topic)}; it != m_subscriptions.end())
+      {
+        found = it->second;
+      }
+    }
+    if (found)
     {
       try
       {
-        // Delegate to the pool worker
-        logTrace("Notify received from topic: '{}'", topic);
-        m_poolWorkers->offload([this, clientPointer, topic](MessageListener listener, const Message& mqttMsg) {
+        auto dispatch = [this, clientPointer, topic, receivedAt](MessageListener listener, std::shared_ptr<utils::LazyHistogram> listenerTime,
+                                                                 const Message& mqttMsg) {
           if (listener)
           {
             logTrace("Trigger callback...");
-            listener(mqttMsg);
+            auto started = std::chrono::steady_clock::now();
+            auto queued = FTY_TRACE_ENABLED(listener_done) ? latency::now() - receivedAt : 0;
+            latency::invoke(listener, mqttMsg);
+            auto duration = std::chrono::steady_clock::now() - started;
+            listenerTime->record(duration);
+            if (FTY_TRACE_ENABLED(listener_done))
+            {
+              FTY_TRACE(listener_done, topic.c_str(), utils::traceHash(mqttMsg.correlationId()), queued, std::chrono::nanoseconds(duration).count());
+            }
             logTrace("Trigger callback... Done.");
           }
           else
@@ -153,15 +168,35 @@ namespace fty::messagebus::mqtt
             clientPointer->unsubscribe(topic);
             this->eraseSubscriptions(topic);
           }
-        },(it->second), Message{metaData, msg->get_payload_str()});
+        };
+
+        auto& subscription = *found;
+        if (subscription.mode == DISPATCH_ORDERED)
+        {
+          // Delegate to the strand of the ordering key
+          auto key = topic;
+          if (!subscription.orderingKey.empty())
+          {
+            auto value = metaData.find(subscription.orderingKey);
+            key += ":" + (value != metaData.end() ? value->second : std::string{});
+          }
+          logTrace("Notify received from topic: '{}' on strand '{}'", topic, key);
+          m_strands->offload(key, dispatch, std::move(subscription.listener), subscription.listenerTime, Message{metaData, msg->get_payload_str()});
+        }
+        else
+        {
+          // Delegate to the pool worker
+          logTrace("Notify received from topic: '{}'", topic);
+          m_strands->offloadUnordered(dispatch, std::move(subscription.listener), subscription.listenerTime, Message{metaData, msg->get_payload_str()});
+        }
       }
       catch (const std::exception& e)
       {
-        logError("Error in listener of queue '{}': '{}'", it->first, e.what());
+        logError("Error in listener of queue '{}': '{}'", topic, e.what());
       }
       catch (...)
       {
-        logError("Error in listener of queue '{}': 'unknown error'", it->first);
+        logError("Error in listener of queue '{}': 'unknown error'", topic);
       }
     }
     else
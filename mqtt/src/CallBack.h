@@ -23,11 +23,16 @@
 
 #include <fty/messagebus/Message.h>
 #include <fty/messagebus/MessageBus.h>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
 #include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+#include <fty/messagebus/utils/MsgBusStrand.hpp>
+#include <fty/messagebus/utils/MsgBusThread.hpp>
 
+#include <atomic>
 #include <map>
 #include <mqtt/async_client.h>
 #include <mqtt/client.h>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -37,26 +42,43 @@ namespace fty::messagebus::mqtt
   using AsynClientPointer = std::shared_ptr<::mqtt::async_client>;
   using SynClientPointer = std::shared_ptr<::mqtt::client>;
   using MessageListener = fty::messagebus::MessageListener;
-  using SubScriptionListener = std::map<std::string, MessageListener>;
+
+  struct Subscription
+  {
+    MessageListener listener;
+    DispatchMode mode = DISPATCH_UNORDERED;
+    std::string orderingKey;
+    // Execution time of the listener, set once subscribed
+    std::shared_ptr<utils::LazyHistogram> listenerTime;
+  };
+
+  using SubScriptionListener = std::map<std::string, Subscription>;
 
   using PoolWorkerPointer = std::shared_ptr<utils::PoolWorker>;
+  using StrandsPointer = std::shared_ptr<utils::Strands>;
 
   class CallBack : public ::mqtt::callback
   {
   public:
-    CallBack();
+    CallBack(PoolWorkerPointer poolWorkers);
     ~CallBack() = default;
     void connection_lost(const std::string& cause) override;
+    // True once per connection following a connection lost
+    bool reconnected();
     void onMessageArrived(::mqtt::const_message_ptr msg, AsynClientPointer clientPointer = nullptr);
 
     SubScriptionListener subscriptions();
-    void subscriptions(const std::string& topic, const MessageListener& messageListener);
+    void subscriptions(const std::string& topic, const Subscription& subscription);
     bool subscribed(const std::string& topic);
     void eraseSubscriptions(const std::string& topic);
+    std::map<std::string, utils::HistogramSnapshot> listenerMetrics();
 
   private:
+    // Subscriptions are updated by the bus and read by the paho and dispatch threads.
+    std::mutex m_subscriptionsMutex;
     SubScriptionListener m_subscriptions;
-    PoolWorkerPointer m_poolWorkers;
+    StrandsPointer m_strands;
+    std::atomic_bool m_connectionLost{false};
   };
 
 } // namespace fty::messagebus::mqtt
@@ -37,10 +37,11 @@ namespace fty::messagebus::mqtt
 {
   MessageBusMqtt::MessageBusMqtt(const ClientName& clientName,
                                  const Endpoint& endpoint,
-                                 const Message& will)
+                                 const Message& will,
+                                 std::shared_ptr<utils::PoolWorker> executor)
     : MessageBus()
   {
-    m_busMqtt = std::make_shared<MsgBusMqtt>(clientName, endpoint, will);
+    m_busMqtt = std::make_shared<MsgBusMqtt>(clientName, endpoint, will, executor ? executor : utils::sharedPoolWorker());
   }
 
   fty::Expected<void> MessageBusMqtt::connect() noexcept
@@ -57,9 +58,10 @@ namespace fty::messagebus::mqtt
     return m_busMqtt->send(msg);
   }
 
-  fty::Expected<void> MessageBusMqtt::receive(const Address& address, MessageListener&& func, const std::string& /*filter*/) noexcept
+  fty::Expected<void> MessageBusMqtt::receive(const Address& address, MessageListener&& func, const std::string& /*filter*/,
+                                              DispatchMode mode, const std::string& orderingKey) noexcept
   {
-    return m_busMqtt->receive(address, func);
+    return m_busMqtt->receive(address, func, mode, orderingKey);
   }
 
   fty::Expected<void> MessageBusMqtt::unreceive(const Address& address) noexcept
@@ -84,6 +86,11 @@ namespace fty::messagebus::mqtt
     return m_busMqtt->clientName();
   }
 
+  std::map<std::string, utils::HistogramSnapshot> MessageBusMqtt::listenerMetrics() const
+  {
+    return m_busMqtt->listenerMetrics();
+  }
+
   static const std::string g_identity(BUS_IDENTITY);
 
   const std::string& MessageBusMqtt::identity() const noexcept
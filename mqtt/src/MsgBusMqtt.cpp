@@ -18,10 +18,13 @@
 */
 
 #include "MsgBusMqtt.h"
+#include "MsgBusMqttUtils.h"
 
 #include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/Metrics.h>
 #include <fty/messagebus/mqtt/MessageBusMqtt.h>
 #include <fty/messagebus/utils.h>
+#include <fty/messagebus/utils/MsgBusTrace.hpp>
 #include <fty_log.h>
 
 #include <mqtt/async_client.h>
@@ -39,80 +42,6 @@ namespace fty::messagebus::mqtt
   auto constexpr TIMEOUT = std::chrono::seconds(5);
   auto constexpr DOUBLE_TIMEOUT = std::chrono::seconds(10);
 
-  static const MetaData getMetaDataFromMqttProperties(const ::mqtt::properties& props)
-  {
-    Message message;
-
-    // User properties
-    if (props.contains(::mqtt::property::USER_PROPERTY))
-    {
-      std::string key, value;
-      for (size_t i = 0; i < props.count(::mqtt::property::USER_PROPERTY); ++i)
-      {
-        std::tie(key, value) = ::mqtt::get<::mqtt::string_pair>(props, ::mqtt::property::USER_PROPERTY, i);
-        message.setMetaDataValue(key, value);
-      }
-    }
-    // Req/Rep pattern properties
-    if (props.contains(::mqtt::property::CORRELATION_DATA))
-    {
-      message.correlationId(::mqtt::get<std::string>(props, ::mqtt::property::CORRELATION_DATA));
-    }
-
-    if (props.contains(::mqtt::property::RESPONSE_TOPIC))
-    {
-      message.replyTo(::mqtt::get<std::string>(props, ::mqtt::property::RESPONSE_TOPIC));
-    }
-    return message.metaData();
-  }
-
-  static const ::mqtt::properties getMqttProperties(const Message& message)
-  {
-    auto props = ::mqtt::properties{};
-    for (const auto& [key, value] : message.metaData())
-    {
-      if (key == REPLY_TO)
-      {
-        props.add({::mqtt::property::CORRELATION_DATA, message.correlationId()});
-        props.add({::mqtt::property::RESPONSE_TOPIC, message.replyTo()});
-      }
-      else if (key != CORRELATION_ID)
-      {
-        props.add({::mqtt::property::USER_PROPERTY, key, value});
-      }
-    }
-    return props;
-  }
-
-  static ::mqtt::message_ptr buildMessageForMqtt(const Message& message)
-  {
-    // Adding all meta data inside mqtt properties
-    auto props = getMqttProperties(message);
-
-    //get retain
-    bool retain = (message.getMetaDataValue(mqtt::RETAIN) == "true");
-
-    //get QoS
-    ::mqtt::ReasonCode QoS = ::mqtt::ReasonCode::GRANTED_QOS_2;
-    if (message.getMetaDataValue(mqtt::QOS) == "1")
-    {
-      QoS = ::mqtt::ReasonCode::GRANTED_QOS_1;
-    }
-    else if (message.getMetaDataValue(mqtt::QOS) == "0")
-    {
-      QoS = ::mqtt::ReasonCode::GRANTED_QOS_0;
-    }
-
-    auto msgToSend = ::mqtt::message_ptr_builder()
-                       .topic(message.to())
-                       .payload(message.userData())
-                       .qos(QoS)
-                       .properties(props)
-                       .retained(retain)
-                       .finalize();
-    return msgToSend;
-  }
-
   MsgBusMqtt::~MsgBusMqtt()
   {
     // Cleaning all async/sync mqtt clients
@@ -162,12 +91,17 @@ namespace fty::messagebus::mqtt
 
       // Called after a reconnection
       m_asynClient->set_connected_handler([this](const std::string& cause) {
-
+        utils::adoptThread(utils::ThreadRole::IO);
         (cause.empty()) ? logDebug("Connected") : logDebug("{}", cause);
+        // Only connections following a loss are counted, the first one is counted by the caller (as with AMQP).
+        if (m_cb.reconnected())
+        {
+          metrics::sharedRegistry()->connectionState(ComState::COM_STATE_OK);
+        }
         // Refresh all recieved
-        for (auto [address, listener] : m_cb.subscriptions())
+        for (auto [address, subscription] : m_cb.subscriptions())
         {
-          auto received = receive(address, listener);
+          auto received = receive(address, subscription.listener, subscription.mode, subscription.orderingKey);
           if (!received)
           {
             logWarn("Address '{}' rejected after reconnection", address);
@@ -203,7 +137,7 @@ namespace fty::messagebus::mqtt
     return {};
   }
 
-  fty::Expected<void> MsgBusMqtt::receive(const Address& address, MessageListener messageListener)
+  fty::Expected<void> MsgBusMqtt::receive(const Address& address, MessageListener messageListener, DispatchMode mode, const std::string& orderingKey)
   {
     if (!isServiceAvailable())
     {
@@ -213,7 +147,7 @@ namespace fty::messagebus::mqtt
 
     if (!m_cb.subscribed(address))
     {
-      m_cb.subscriptions(address, messageListener);
+      m_cb.subscriptions(address, {messageListener, mode, orderingKey});
       m_asynClient->set_message_callback([this](::mqtt::const_message_ptr msg) {
         // Wrapper from mqtt msg to Message
         m_cb.onMessageArrived(msg);
@@ -263,11 +197,27 @@ namespace fty::messagebus::mqtt
       return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
     }
 
+    auto sentAt = latency::enabled() ? latency::now() : 0;
+    auto started = utils::traceStart(FTY_TRACE_ENABLED(send_done));
+    if (FTY_TRACE_ENABLED(send))
+    {
+      FTY_TRACE(send, message.to().c_str(), message.userData().size(), utils::traceHash(message.correlationId()));
+    }
     logDebug("Sending message {}", message.toString());
 
     auto msgToSend = buildMessageForMqtt(message);
+    if (sentAt)
+    {
+      addLatencyStamps(msgToSend, sentAt);
+    }
 
-    if (!m_asynClient->publish(msgToSend)->wait_for(TIMEOUT))
+    auto delivered = m_asynClient->publish(msgToSend)->wait_for(TIMEOUT);
+    if (FTY_TRACE_ENABLED(send_done))
+    {
+      FTY_TRACE(send_done, message.to().c_str(), message.userData().size(), utils::traceHash(message.correlationId()), utils::traceElapsed(started),
+                delivered);
+    }
+    if (!delivered)
     {
       logError("Message sent (Rejected)");
       return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_REJECTED));
@@ -285,16 +235,31 @@ namespace fty::messagebus::mqtt
       return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_UNAVAILABLE));
     }
 
+    auto started = utils::traceStart(FTY_TRACE_ENABLED(request_done));
+    if (FTY_TRACE_ENABLED(request))
+    {
+      FTY_TRACE(request, message.to().c_str(), message.userData().size(), utils::traceHash(message.correlationId()), receiveTimeOut);
+    }
+
+    auto traceDone = [&message, started](bool replied) {
+      if (FTY_TRACE_ENABLED(request_done))
+      {
+        FTY_TRACE(request_done, message.to().c_str(), utils::traceHash(message.correlationId()), utils::traceElapsed(started), replied);
+      }
+    };
+
     ::mqtt::const_message_ptr msg;
     m_asynClient->subscribe(message.replyTo(), _QOS);
     auto msgSent = send(message);
     if (!msgSent)
     {
+      traceDone(false);
       return fty::unexpected(to_string(DeliveryState::DELIVERY_STATE_REJECTED));
     }
 
     auto messageArrived = m_asynClient->try_consume_message_for(&msg, std::chrono::seconds(receiveTimeOut));
     m_asynClient->unsubscribe(message.replyTo());
+    traceDone(messageArrived);
     if (!messageArrived)
     {
       logError("No message arrive in time!");
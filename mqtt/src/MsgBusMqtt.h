@@ -27,10 +27,11 @@ namespace fty::messagebus::mqtt
   {
   public:
 
-    MsgBusMqtt(const std::string& clientName, const Endpoint& endpoint, const Message& will = Message())
+    MsgBusMqtt(const std::string& clientName, const Endpoint& endpoint, const Message& will = Message(), PoolWorkerPointer poolWorkers = utils::sharedPoolWorker())
       : m_clientName(clientName)
       , m_endpoint(endpoint)
-      , m_will(will) {};
+      , m_will(will)
+      , m_cb(poolWorkers) {};
 
     MsgBusMqtt() = delete;
     ~MsgBusMqtt();
@@ -42,7 +43,7 @@ namespace fty::messagebus::mqtt
 
     [[nodiscard]] fty::Expected<void> connect();
 
-    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener messageListener);
+    [[nodiscard]] fty::Expected<void> receive(const Address& address, MessageListener messageListener, DispatchMode mode = DISPATCH_UNORDERED, const std::string& orderingKey = {});
     [[nodiscard]] fty::Expected<void> unreceive(const Address& address);
     [[nodiscard]] fty::Expected<void> send(const Message& message);
 
@@ -56,6 +57,12 @@ namespace fty::messagebus::mqtt
 
     bool isServiceAvailable();
 
+    // Execution time of the listeners per topic
+    std::map<std::string, utils::HistogramSnapshot> listenerMetrics()
+    {
+      return m_cb.listenerMetrics();
+    }
+
   private:
     std::string m_clientName;
     Endpoint m_endpoint;
@@ -0,0 +1,114 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "fty/messagebus/Latency.h"
+#include "fty/messagebus/Message.h"
+#include "fty/messagebus/mqtt/MessageBusMqtt.h"
+
+#include <mqtt/message.h>
+#include <mqtt/properties.h>
+
+namespace fty::messagebus::mqtt
+{
+  inline const MetaData getMetaDataFromMqttProperties(const ::mqtt::properties& props)
+  {
+    auto metaData = MetaData{};
+
+    // User properties
+    if (props.contains(::mqtt::property::USER_PROPERTY))
+    {
+      std::string key, value;
+      for (size_t i = 0; i < props.count(::mqtt::property::USER_PROPERTY); ++i)
+      {
+        std::tie(key, value) = ::mqtt::get<::mqtt::string_pair>(props, ::mqtt::property::USER_PROPERTY, i);
+        metaData[key] = value;
+      }
+    }
+    // Req/Rep pattern properties
+    if (props.contains(::mqtt::property::CORRELATION_DATA))
+    {
+      metaData[CORRELATION_ID] = ::mqtt::get<std::string>(props, ::mqtt::property::CORRELATION_DATA);
+    }
+
+    if (props.contains(::mqtt::property::RESPONSE_TOPIC))
+    {
+      metaData[REPLY_TO] = ::mqtt::get<std::string>(props, ::mqtt::property::RESPONSE_TOPIC);
+    }
+    return metaData;
+  }
+
+  inline const ::mqtt::properties getMqttProperties(const Message& message)
+  {
+    auto props = ::mqtt::properties{};
+    for (const auto& [key, value] : message.metaData())
+    {
+      if (key == REPLY_TO)
+      {
+        props.add({::mqtt::property::CORRELATION_DATA, message.correlationId()});
+        props.add({::mqtt::property::RESPONSE_TOPIC, message.replyTo()});
+      }
+      else if (key != CORRELATION_ID)
+      {
+        props.add({::mqtt::property::USER_PROPERTY, key, value});
+      }
+    }
+    return props;
+  }
+
+  inline ::mqtt::message_ptr buildMessageForMqtt(const Message& message)
+  {
+    // Adding all meta data inside mqtt properties
+    auto props = getMqttProperties(message);
+
+    //get retain
+    bool retain = (message.getMetaDataValue(mqtt::RETAIN) == "true");
+
+    //get QoS
+    ::mqtt::ReasonCode QoS = ::mqtt::ReasonCode::GRANTED_QOS_2;
+    if (message.getMetaDataValue(mqtt::QOS) == "1")
+    {
+      QoS = ::mqtt::ReasonCode::GRANTED_QOS_1;
+    }
+    else if (message.getMetaDataValue(mqtt::QOS) == "0")
+    {
+      QoS = ::mqtt::ReasonCode::GRANTED_QOS_0;
+    }
+
+    auto msgToSend = ::mqtt::message_ptr_builder()
+                       .topic(message.to())
+                       .payload(message.userData())
+                       .qos(QoS)
+                       .properties(props)
+                       .retained(retain)
+                       .finalize();
+    return msgToSend;
+  }
+
+  // Stamp the send and the hand-off to paho of a message built for mqtt.
+  inline void addLatencyStamps(::mqtt::message_ptr& msg, int64_t sentAt)
+  {
+    auto props = msg->get_properties();
+    props.add({::mqtt::property::USER_PROPERTY, latency::STAMP_SEND, std::to_string(sentAt)});
+    props.add({::mqtt::property::USER_PROPERTY, latency::STAMP_WIRE, std::to_string(latency::now())});
+    msg->set_properties(props);
+  }
+
+} // namespace fty::messagebus::mqtt
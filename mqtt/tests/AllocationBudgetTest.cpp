@@ -0,0 +1,90 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "AllocationCounter.h"
+#include "FakeBroker.h"
+#include "src/CallBack.h"
+#include "src/MsgBusMqtt.h"
+#include "src/MsgBusMqttUtils.h"
+
+#include <catch2/catch.hpp>
+
+namespace
+{
+#if defined(EXTERNAL_SERVER_FOR_TEST)
+  static constexpr auto MQTT_SERVER_URI{"tcp://mqtt.eclipse.org:1883"};
+#else
+  // In-process broker unless FTY_MQTT_TEST_ENDPOINT is set
+  static const std::string MQTT_SERVER_URI{fty::messagebus::mqtt::test::testEndpoint()};
+#endif
+
+  using namespace fty::messagebus;
+  using namespace fty::messagebus::mqtt;
+  using fty::messagebus::test::allocationsOf;
+
+  // Allocation budgets of the hot paths, paho C++ wrappers included (property and topic
+  // references, message and token objects), for a message with from, to and subject.
+  // Lower them along with the code, raising one needs a reason in the commit message.
+  constexpr uint64_t CONVERSION_BUDGET = 16; // Message to paho message
+  constexpr uint64_t PUBLISH_BUDGET = 12;    // Delivery token and its tracking
+  constexpr uint64_t DISPATCH_BUDGET = 16;   // Metadata, message copy and the jobs of the strands
+
+  const std::string TOPIC = "/etn/t/budget";
+  const UserData PAYLOAD(1024, 'x');
+} // namespace
+
+TEST_CASE("Mqtt conversion budget", "[AllocationBudget]")
+{
+  auto msg = Message::buildMessage("client", TOPIC, "SUBJECT", PAYLOAD);
+  auto allocations = allocationsOf([&msg]() { auto mqttMsg = buildMessageForMqtt(msg); });
+  CAPTURE(allocations);
+  CHECK(allocations <= CONVERSION_BUDGET);
+}
+
+TEST_CASE("Mqtt dispatch budget", "[AllocationBudget]")
+{
+  // Synchronous pool: the listener runs on the arrival thread, where allocations are counted.
+  CallBack callBack(std::make_shared<utils::PoolWorker>(0));
+  size_t received = 0;
+  Subscription subscription;
+  subscription.listener = [&received](const Message&) { received++; };
+  callBack.subscriptions(TOPIC, subscription);
+
+  ::mqtt::const_message_ptr mqttMsg = buildMessageForMqtt(Message::buildMessage("client", TOPIC, "SUBJECT", PAYLOAD));
+  // First arrival configures the thread.
+  callBack.onMessageArrived(mqttMsg);
+
+  auto allocations = allocationsOf([&]() { callBack.onMessageArrived(mqttMsg); });
+  CAPTURE(allocations);
+  CHECK(allocations <= DISPATCH_BUDGET);
+  CHECK(received == 2);
+}
+
+TEST_CASE("Mqtt send budget", "[AllocationBudget]")
+{
+  auto msgBus = MsgBusMqtt("MqttSendBudgetTestCase", MQTT_SERVER_URI);
+  REQUIRE(msgBus.connect());
+
+  auto msg = Message::buildMessage("client", TOPIC, "SUBJECT", PAYLOAD);
+  REQUIRE(msgBus.send(msg));
+
+  auto allocations = allocationsOf([&]() { REQUIRE(msgBus.send(msg)); });
+  CAPTURE(allocations);
+  CHECK(allocations <= CONVERSION_BUDGET + PUBLISH_BUDGET);
+}
@@ -0,0 +1,973 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "FakeBroker.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <optional>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fty::messagebus::mqtt::test
+{
+  namespace
+  {
+    enum PacketType : uint8_t
+    {
+      CONNECT = 1,
+      CONNACK = 2,
+      PUBLISH = 3,
+      PUBACK = 4,
+      PUBREC = 5,
+      PUBREL = 6,
+      PUBCOMP = 7,
+      SUBSCRIBE = 8,
+      SUBACK = 9,
+      UNSUBSCRIBE = 10,
+      UNSUBACK = 11,
+      PINGREQ = 12,
+      PINGRESP = 13,
+      DISCONNECT = 14,
+    };
+
+    // Reason codes
+    static constexpr uint8_t SUCCESS = 0x00;
+    static constexpr uint8_t DISCONNECT_WITH_WILL = 0x04;
+    static constexpr uint8_t NO_SUBSCRIPTION_EXISTED = 0x11;
+    static constexpr uint8_t MALFORMED_PACKET = 0x81;
+    static constexpr uint8_t PROTOCOL_ERROR = 0x82;
+    static constexpr uint8_t UNSUPPORTED_PROTOCOL_VERSION = 0x84;
+    static constexpr uint8_t SESSION_TAKEN_OVER = 0x8E;
+    static constexpr uint8_t TOPIC_FILTER_INVALID = 0x8F;
+    static constexpr uint8_t TOPIC_NAME_INVALID = 0x90;
+    static constexpr uint8_t TOPIC_ALIAS_INVALID = 0x94;
+    static constexpr uint8_t SHARED_SUBSCRIPTIONS_NOT_SUPPORTED = 0x9E;
+
+    // Properties
+    static constexpr uint8_t SUBSCRIPTION_IDENTIFIER = 0x0B;
+    static constexpr uint8_t ASSIGNED_CLIENT_IDENTIFIER = 0x12;
+    static constexpr uint8_t WILL_DELAY_INTERVAL = 0x18;
+    static constexpr uint8_t TOPIC_ALIAS = 0x23;
+    static constexpr uint8_t SUBSCRIPTION_IDENTIFIER_AVAILABLE = 0x29;
+    static constexpr uint8_t SHARED_SUBSCRIPTION_AVAILABLE = 0x2A;
+
+    // Subscription options
+    static constexpr uint8_t QOS_MASK = 0x03;
+    static constexpr uint8_t NO_LOCAL = 0x04;
+    static constexpr uint8_t RETAIN_AS_PUBLISHED = 0x08;
+
+    static constexpr size_t MAX_PACKET_SIZE = 256 * 1024 * 1024;
+
+    class Encoder
+    {
+    public:
+      Encoder& byte(uint8_t value)
+      {
+        m_data += static_cast<char>(value);
+        return *this;
+      }
+
+      Encoder& u16(uint16_t value)
+      {
+        return byte(static_cast<uint8_t>(value >> 8)).byte(static_cast<uint8_t>(value));
+      }
+
+      Encoder& varint(size_t value)
+      {
+        do
+        {
+          auto digit = static_cast<uint8_t>(value & 0x7F);
+          value >>= 7;
+          byte(value ? digit | 0x80 : digit);
+        } while (value);
+        return *this;
+      }
+
+      Encoder& string(std::string_view value)
+      {
+        return u16(static_cast<uint16_t>(value.size())).raw(value);
+      }
+
+      Encoder& raw(std::string_view value)
+      {
+        m_data.append(value);
+        return *this;
+      }
+
+      const std::string& data() const
+      {
+        return m_data;
+      }
+
+    private:
+      std::string m_data;
+    };
+
+    // Packet of a fixed header and its body
+    std::string packet(uint8_t header, const std::string& body)
+    {
+      return Encoder().byte(header).varint(body.size()).raw(body).data();
+    }
+
+    // Bounds checked reading, every read past the end fails the decoder.
+    class Decoder
+    {
+    public:
+      explicit Decoder(std::string_view data)
+        : m_data(data)
+      {
+      }
+
+      uint8_t byte()
+      {
+        auto bytes = raw(1);
+        return bytes.empty() ? 0 : static_cast<uint8_t>(bytes[0]);
+      }
+
+      uint16_t u16()
+      {
+        auto bytes = raw(2);
+        return bytes.empty() ? 0 : static_cast<uint16_t>(static_cast<uint8_t>(bytes[0]) << 8 | static_cast<uint8_t>(bytes[1]));
+      }
+
+      uint32_t u32()
+      {
+        return static_cast<uint32_t>(u16()) << 16 | u16();
+      }
+
+      size_t varint()
+      {
+        size_t value = 0;
+        for (unsigned shift = 0; shift < 28; shift += 7)
+        {
+          auto digit = byte();
+          value |= static_cast<size_t>(digit & 0x7F) << shift;
+          if ((digit & 0x80) == 0)
+          {
+            return value;
+          }
+        }
+        m_ok = false;
+        return 0;
+      }
+
+      std::string_view string()
+      {
+        return raw(u16());
+      }
+
+      std::string_view raw(size_t size)
+      {
+        if (!m_ok || m_data.size() - m_position < size)
+        {
+          m_ok = false;
+          return {};
+        }
+        auto value = m_data.substr(m_position, size);
+        m_position += size;
+        return value;
+      }
+
+      std::string_view rest()
+      {
+        return raw(m_data.size() - m_position);
+      }
+
+      size_t position() const
+      {
+        return m_position;
+      }
+
+      bool done() const
+      {
+        return m_position == m_data.size();
+      }
+
+      bool ok() const
+      {
+        return m_ok;
+      }
+
+    private:
+      std::string_view m_data;
+      size_t m_position = 0;
+      bool m_ok = true;
+    };
+
+    // Properties without the dropped ones, nothing if malformed or holding a refused one.
+    std::optional<std::string> filterProperties(std::string_view properties, std::initializer_list<uint8_t> dropped,
+                                                std::initializer_list<uint8_t> refused = {})
+    {
+      std::string kept;
+      Decoder decoder(properties);
+      while (decoder.ok() && !decoder.done())
+      {
+        auto start = decoder.position();
+        auto id = decoder.byte();
+        switch (id)
+        {
+          case 0x01: case 0x17: case 0x19: case 0x24: case 0x25: case 0x28: case 0x29: case 0x2A:
+            decoder.byte();
+            break;
+          case 0x13: case 0x21: case 0x22: case 0x23:
+            decoder.u16();
+            break;
+          case 0x02: case 0x11: case 0x18: case 0x27:
+            decoder.u32();
+            break;
+          case 0x0B:
+            decoder.varint();
+            break;
+          case 0x03: case 0x08: case 0x09: case 0x12: case 0x15: case 0x16: case 0x1A: case 0x1C: case 0x1F:
+            decoder.string();
+            break;
+          case 0x26:
+            decoder.string();
+            decoder.string();
+            break;
+          default:
+            return std::nullopt;
+        }
+        if (std::find(refused.begin(), refused.end(), id) != refused.end())
+        {
+          return std::nullopt;
+        }
+        if (decoder.ok() && std::find(dropped.begin(), dropped.end(), id) == dropped.end())
+        {
+          kept.append(properties.substr(start, decoder.position() - start));
+        }
+      }
+      return decoder.ok() ? std::optional(kept) : std::nullopt;
+    }
+
+    bool validTopic(std::string_view topic)
+    {
+      return !topic.empty() && topic.find_first_of(std::string_view("+#\0", 3)) == std::string_view::npos;
+    }
+
+    bool validFilter(std::string_view filter)
+    {
+      if (filter.empty() || filter.find('\0') != std::string_view::npos)
+      {
+        return false;
+      }
+      for (size_t start = 0; start <= filter.size();)
+      {
+        auto end = std::min(filter.find('/', start), filter.size());
+        auto level = filter.substr(start, end - start);
+        if (level.find_first_of("+#") != std::string_view::npos && level.size() != 1)
+        {
+          return false;
+        }
+        // # only as the last level
+        if (level == "#" && end != filter.size())
+        {
+          return false;
+        }
+        start = end + 1;
+      }
+      return true;
+    }
+
+    void setNoDelay(int fd)
+    {
+      int one = 1;
+      ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    // Buffered reading of the packets of a client
+    class Input
+    {
+    public:
+      explicit Input(int fd)
+        : m_fd(fd)
+        , m_buffer(64 * 1024)
+      {
+      }
+
+      bool packet(uint8_t& header, std::string& body)
+      {
+        if (!read(reinterpret_cast<char*>(&header), 1))
+        {
+          return false;
+        }
+        size_t size = 0;
+        for (unsigned shift = 0;; shift += 7)
+        {
+          char digit;
+          if (shift >= 28 || !read(&digit, 1))
+          {
+            return false;
+          }
+          size |= static_cast<size_t>(digit & 0x7F) << shift;
+          if ((digit & 0x80) == 0)
+          {
+            break;
+          }
+        }
+        if (size > MAX_PACKET_SIZE)
+        {
+          return false;
+        }
+        body.resize(size);
+        return read(body.data(), size);
+      }
+
+    private:
+      bool read(char* out, size_t size)
+      {
+        while (size != 0)
+        {
+          if (m_begin == m_end)
+          {
+            auto received = ::recv(m_fd, m_buffer.data(), m_buffer.size(), 0);
+            if (received <= 0)
+            {
+              if (received < 0 && errno == EINTR)
+              {
+                continue;
+              }
+              // Closed, shut down or keep alive expired.
+              return false;
+            }
+            m_begin = 0;
+            m_end = static_cast<size_t>(received);
+          }
+          auto chunk = std::min(size, m_end - m_begin);
+          std::memcpy(out, m_buffer.data() + m_begin, chunk);
+          m_begin += chunk;
+          out += chunk;
+          size -= chunk;
+        }
+        return true;
+      }
+
+      int m_fd;
+      std::vector<char> m_buffer;
+      size_t m_begin = 0;
+      size_t m_end = 0;
+    };
+  } // namespace
+
+  bool topicMatches(std::string_view filter, std::string_view topic)
+  {
+    // Topics starting with $ are not matched by a leading wildcard.
+    if (!topic.empty() && topic.front() == '$' && !filter.empty() && (filter.front() == '+' || filter.front() == '#'))
+    {
+      return false;
+    }
+
+    size_t f = 0;
+    size_t t = 0;
+    while (true)
+    {
+      auto fEnd = std::min(filter.find('/', f), filter.size());
+      auto level = filter.substr(f, fEnd - f);
+      if (level == "#")
+      {
+        return true;
+      }
+      auto tEnd = std::min(topic.find('/', t), topic.size());
+      if (level != "+" && level != topic.substr(t, tEnd - t))
+      {
+        return false;
+      }
+
+      auto lastFilterLevel = fEnd == filter.size();
+      auto lastTopicLevel = tEnd == topic.size();
+      if (lastTopicLevel)
+      {
+        // "a/#" matches "a" as well.
+        return lastFilterLevel || filter.substr(fEnd + 1) == "#";
+      }
+      if (lastFilterLevel)
+      {
+        return false;
+      }
+      f = fEnd + 1;
+      t = tEnd + 1;
+    }
+  }
+
+  //----------------------------------------------------------------------
+  // Session of a client
+  //----------------------------------------------------------------------
+  struct FakeBroker::Session
+  {
+    struct Will
+    {
+      std::string topic;
+      Publication publication;
+      bool retain = false;
+    };
+
+    explicit Session(int socket)
+      : fd(socket)
+    {
+    }
+
+    ~Session()
+    {
+      ::close(fd);
+    }
+
+    // Write a whole packet, false on a dead connection.
+    bool write(const std::string& data)
+    {
+      std::unique_lock<std::mutex> lk(writeMutex);
+      size_t written = 0;
+      while (written < data.size())
+      {
+        auto sent = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          return false;
+        }
+        written += static_cast<size_t>(sent);
+      }
+      return true;
+    }
+
+    void disconnect(uint8_t reason)
+    {
+      write(packet(DISCONNECT << 4, Encoder().byte(reason).varint(0).data()));
+      ::shutdown(fd, SHUT_RDWR);
+    }
+
+    void deliver(const std::string& topic, const Publication& publication, uint8_t qos, bool retain)
+    {
+      Encoder body;
+      body.string(topic);
+      if (qos != 0)
+      {
+        // Identifiers are not tracked: nothing is retransmitted.
+        auto id = static_cast<uint16_t>(nextPacketId++ % 0xFFFF + 1);
+        body.u16(id);
+      }
+      body.varint(publication.properties.size()).raw(publication.properties).raw(publication.payload);
+      write(packet(static_cast<uint8_t>(PUBLISH << 4 | qos << 1 | (retain ? 1 : 0)), body.data()));
+    }
+
+    const int fd;
+    std::string clientId;
+    std::optional<Will> will;
+    std::vector<uint16_t> receivingQos2; // Received in QoS 2, waiting for their PUBREL
+
+    std::mutex writeMutex;
+    std::atomic_uint32_t nextPacketId{0};
+
+    // Filter and options, under the mutex of the broker
+    std::map<std::string, uint8_t> subscriptions;
+  };
+
+  //----------------------------------------------------------------------
+  // Broker
+  //----------------------------------------------------------------------
+  fty::Expected<std::unique_ptr<FakeBroker>> FakeBroker::start(uint16_t port)
+  {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+      return fty::unexpected(std::string("Socket: ") + std::strerror(errno));
+    }
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    socklen_t length = sizeof(address);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 64) != 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+    {
+      auto error = std::string("Listen on port ") + std::to_string(port) + ": " + std::strerror(errno);
+      ::close(fd);
+      return fty::unexpected(error);
+    }
+    return std::unique_ptr<FakeBroker>(new FakeBroker(fd, ntohs(address.sin_port)));
+  }
+
+  FakeBroker* FakeBroker::shared()
+  {
+    static auto broker = start();
+    return broker ? broker->get() : nullptr;
+  }
+
+  FakeBroker::FakeBroker(int fd, uint16_t port)
+    : m_fd(fd)
+    , m_port(port)
+  {
+    m_acceptThread = std::thread([this]() { acceptLoop(); });
+  }
+
+  FakeBroker::~FakeBroker()
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_stopping = true;
+    }
+    // Wakes up accept().
+    ::shutdown(m_fd, SHUT_RDWR);
+    m_acceptThread.join();
+    ::close(m_fd);
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    for (auto& session : m_connections)
+    {
+      ::shutdown(session->fd, SHUT_RDWR);
+    }
+    m_cv.wait(lk, [this]() -> bool { return m_running == 0; });
+  }
+
+  uint16_t FakeBroker::port() const
+  {
+    return m_port;
+  }
+
+  std::string FakeBroker::endpoint() const
+  {
+    return "tcp://127.0.0.1:" + std::to_string(m_port);
+  }
+
+  size_t FakeBroker::clients() const
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    return m_sessions.size();
+  }
+
+  size_t FakeBroker::retained() const
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    return m_retained.size();
+  }
+
+  void FakeBroker::acceptLoop()
+  {
+    while (true)
+    {
+      int fd = ::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      std::unique_lock<std::mutex> lk(m_mutex);
+      if (m_stopping)
+      {
+        if (fd >= 0)
+        {
+          ::close(fd);
+        }
+        return;
+      }
+      if (fd < 0)
+      {
+        // Aborted connection or out of descriptors, try again.
+        lk.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(errno == ECONNABORTED || errno == EINTR ? 0 : 10));
+        continue;
+      }
+
+      setNoDelay(fd);
+      auto session = std::make_shared<Session>(fd);
+      m_connections.push_back(session);
+      m_running++;
+      std::thread([this, session]() { run(session); }).detach();
+    }
+  }
+
+  void FakeBroker::run(std::shared_ptr<Session> session)
+  {
+    Input input(session->fd);
+    uint8_t header = 0;
+    std::string body;
+    bool clean = false;
+
+    if (input.packet(header, body) && header == CONNECT << 4 && connect(session, body))
+    {
+      bool alive = true;
+      while (alive && input.packet(header, body))
+      {
+        Decoder decoder(body);
+        switch (header >> 4)
+        {
+          case PUBLISH:
+            alive = publish(*session, header & 0x0F, body);
+            break;
+          case PUBACK:
+          case PUBCOMP:
+            // Deliveries are not tracked.
+            break;
+          case PUBREC:
+            alive = session->write(packet(PUBREL << 4 | 0x02, Encoder().u16(decoder.u16()).data()));
+            break;
+          case PUBREL:
+          {
+            auto id = decoder.u16();
+            auto& pending = session->receivingQos2;
+            pending.erase(std::remove(pending.begin(), pending.end(), id), pending.end());
+            alive = session->write(packet(PUBCOMP << 4, Encoder().u16(id).data()));
+            break;
+          }
+          case SUBSCRIBE:
+            alive = header == (SUBSCRIBE << 4 | 0x02) && subscribe(*session, body);
+            break;
+          case UNSUBSCRIBE:
+            alive = header == (UNSUBSCRIBE << 4 | 0x02) && unsubscribe(*session, body);
+            break;
+          case PINGREQ:
+            alive = session->write(packet(PINGRESP << 4, {}));
+            break;
+          case DISCONNECT:
+            clean = decoder.done() || decoder.byte() != DISCONNECT_WITH_WILL;
+            alive = false;
+            break;
+          default:
+            session->disconnect(PROTOCOL_ERROR);
+            alive = false;
+        }
+      }
+    }
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    // A session taken over is already replaced.
+    if (auto it = m_sessions.find(session->clientId); it != m_sessions.end() && it->second == session)
+    {
+      m_sessions.erase(it);
+    }
+    m_connections.remove(session);
+    auto stopping = m_stopping;
+    lk.unlock();
+
+    ::shutdown(session->fd, SHUT_RDWR);
+    if (!clean && session->will && !stopping)
+    {
+      route(nullptr, session->will->topic, session->will->publication, session->will->retain);
+    }
+    session.reset();
+
+    lk.lock();
+    m_running--;
+    m_cv.notify_all();
+  }
+
+  bool FakeBroker::connect(const std::shared_ptr<Session>& session, std::string_view body)
+  {
+    Decoder decoder(body);
+    auto protocol = decoder.string();
+    auto level = decoder.byte();
+    if (!decoder.ok() || protocol != "MQTT" || level != 5)
+    {
+      if (decoder.ok() && (level == 3 || level == 4))
+      {
+        // Refused in the CONNACK format of the client.
+        session->write(packet(CONNACK << 4, Encoder().byte(0).byte(0x01).data()));
+      }
+      else
+      {
+        session->write(packet(CONNACK << 4, Encoder().byte(0).byte(UNSUPPORTED_PROTOCOL_VERSION).varint(0).data()));
+      }
+      return false;
+    }
+
+    auto flags = decoder.byte();
+    auto keepAlive = decoder.u16();
+    decoder.raw(decoder.varint());
+    std::string clientId(decoder.string());
+    if (flags & 0x04)
+    {
+      Session::Will will;
+      auto properties = filterProperties(decoder.raw(decoder.varint()), {WILL_DELAY_INTERVAL});
+      will.topic = decoder.string();
+      will.publication.payload = decoder.string();
+      will.publication.qos = static_cast<uint8_t>((flags >> 3) & QOS_MASK);
+      will.retain = flags & 0x20;
+      if (!properties || !validTopic(will.topic) || will.publication.qos > 2)
+      {
+        session->write(packet(CONNACK << 4, Encoder().byte(0).byte(MALFORMED_PACKET).varint(0).data()));
+        return false;
+      }
+      will.publication.properties = std::move(*properties);
+      session->will = std::move(will);
+    }
+    if (flags & 0x80)
+    {
+      decoder.string();
+    }
+    if (flags & 0x40)
+    {
+      decoder.string();
+    }
+    if (!decoder.ok() || !decoder.done() || (flags & 0x01))
+    {
+      session->write(packet(CONNACK << 4, Encoder().byte(0).byte(MALFORMED_PACKET).varint(0).data()));
+      return false;
+    }
+
+    if (keepAlive != 0)
+    {
+      // The client is dropped after one and a half keep alive without a packet.
+      timeval timeout{};
+      timeout.tv_sec = keepAlive + keepAlive / 2;
+      ::setsockopt(session->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    Encoder properties;
+    properties.byte(SUBSCRIPTION_IDENTIFIER_AVAILABLE).byte(0).byte(SHARED_SUBSCRIPTION_AVAILABLE).byte(0);
+    std::shared_ptr<Session> previous;
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      if (clientId.empty())
+      {
+        clientId = "fake-broker-" + std::to_string(++m_assignedIds);
+        properties.byte(ASSIGNED_CLIENT_IDENTIFIER).string(clientId);
+      }
+      session->clientId = clientId;
+      auto& current = m_sessions[clientId];
+      previous = current;
+      current = session;
+    }
+    if (previous)
+    {
+      previous->disconnect(SESSION_TAKEN_OVER);
+    }
+    return session->write(packet(CONNACK << 4, Encoder().byte(0).byte(SUCCESS).varint(properties.data().size()).raw(properties.data()).data()));
+  }
+
+  bool FakeBroker::publish(Session& session, uint8_t flags, std::string_view body)
+  {
+    Decoder decoder(body);
+    std::string topic(decoder.string());
+    auto qos = static_cast<uint8_t>((flags >> 1) & QOS_MASK);
+    uint16_t id = qos ? decoder.u16() : 0;
+    auto properties = filterProperties(decoder.raw(decoder.varint()), {SUBSCRIPTION_IDENTIFIER}, {TOPIC_ALIAS});
+    auto payload = decoder.rest();
+    if (!decoder.ok() || qos > 2 || (qos != 0 && id == 0))
+    {
+      session.disconnect(MALFORMED_PACKET);
+      return false;
+    }
+    if (!properties)
+    {
+      // No topic alias maximum announced, an alias is an error.
+      session.disconnect(TOPIC_ALIAS_INVALID);
+      return false;
+    }
+    if (!validTopic(topic))
+    {
+      session.disconnect(TOPIC_NAME_INVALID);
+      return false;
+    }
+
+    // A QoS 2 message sent again before its PUBREL is delivered once.
+    auto duplicate = false;
+    if (qos == 2)
+    {
+      auto& pending = session.receivingQos2;
+      duplicate = std::find(pending.begin(), pending.end(), id) != pending.end();
+      if (!duplicate)
+      {
+        pending.push_back(id);
+      }
+    }
+    if (!duplicate)
+    {
+      route(&session, topic, Publication{std::move(*properties), std::string(payload), qos}, flags & 0x01);
+    }
+
+    if (qos == 1)
+    {
+      return session.write(packet(PUBACK << 4, Encoder().u16(id).data()));
+    }
+    if (qos == 2)
+    {
+      return session.write(packet(PUBREC << 4, Encoder().u16(id).data()));
+    }
+    return true;
+  }
+
+  bool FakeBroker::subscribe(Session& session, std::string_view body)
+  {
+    Decoder decoder(body);
+    auto id = decoder.u16();
+    decoder.raw(decoder.varint());
+    std::vector<std::pair<std::string, uint8_t>> filters;
+    while (decoder.ok() && !decoder.done())
+    {
+      std::string filter(decoder.string());
+      filters.emplace_back(std::move(filter), decoder.byte());
+    }
+    if (!decoder.ok() || filters.empty())
+    {
+      session.disconnect(MALFORMED_PACKET);
+      return false;
+    }
+
+    Encoder reasons;
+    std::vector<std::pair<std::string, Publication>> retained;
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      for (const auto& [filter, options] : filters)
+      {
+        auto qos = static_cast<uint8_t>(options & QOS_MASK);
+        auto retainHandling = (options >> 4) & 0x03;
+        if (qos > 2 || retainHandling > 2 || (options & 0xC0))
+        {
+          lk.unlock();
+          session.disconnect(MALFORMED_PACKET);
+          return false;
+        }
+        if (filter.rfind("$share/", 0) == 0)
+        {
+          reasons.byte(SHARED_SUBSCRIPTIONS_NOT_SUPPORTED);
+          continue;
+        }
+        if (!validFilter(filter))
+        {
+          reasons.byte(TOPIC_FILTER_INVALID);
+          continue;
+        }
+
+        auto existed = session.subscriptions.count(filter) != 0;
+        session.subscriptions[filter] = options;
+        reasons.byte(qos);
+        if (retainHandling == 0 || (retainHandling == 1 && !existed))
+        {
+          for (const auto& [topic, publication] : m_retained)
+          {
+            if (topicMatches(filter, topic))
+            {
+              retained.emplace_back(topic, publication);
+              retained.back().second.qos = std::min(publication.qos, qos);
+            }
+          }
+        }
+      }
+    }
+
+    if (!session.write(packet(SUBACK << 4, Encoder().u16(id).varint(0).raw(reasons.data()).data())))
+    {
+      return false;
+    }
+    for (const auto& [topic, publication] : retained)
+    {
+      session.deliver(topic, publication, publication.qos, true);
+    }
+    return true;
+  }
+
+  bool FakeBroker::unsubscribe(Session& session, std::string_view body)
+  {
+    Decoder decoder(body);
+    auto id = decoder.u16();
+    decoder.raw(decoder.varint());
+    std::vector<std::string> filters;
+    while (decoder.ok() && !decoder.done())
+    {
+      filters.emplace_back(decoder.string());
+    }
+    if (!decoder.ok() || filters.empty())
+    {
+      session.disconnect(MALFORMED_PACKET);
+      return false;
+    }
+
+    Encoder reasons;
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      for (const auto& filter : filters)
+      {
+        reasons.byte(session.subscriptions.erase(filter) ? SUCCESS : NO_SUBSCRIPTION_EXISTED);
+      }
+    }
+    return session.write(packet(UNSUBACK << 4, Encoder().u16(id).varint(0).raw(reasons.data()).data()));
+  }
+
+  void FakeBroker::route(const Session* publisher, const std::string& topic, const Publication& publication, bool retain)
+  {
+    struct Delivery
+    {
+      std::shared_ptr<Session> session;
+      uint8_t qos;
+      bool retain;
+    };
+
+    std::vector<Delivery> deliveries;
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      if (retain)
+      {
+        if (publication.payload.empty())
+        {
+          m_retained.erase(topic);
+        }
+        else
+        {
+          m_retained[topic] = publication;
+        }
+      }
+
+      // One delivery per session, with the highest QoS of its matching subscriptions.
+      for (const auto& [clientId, session] : m_sessions)
+      {
+        int qos = -1;
+        bool retainAsPublished = false;
+        for (const auto& [filter, options] : session->subscriptions)
+        {
+          if (((options & NO_LOCAL) && session.get() == publisher) || !topicMatches(filter, topic))
+          {
+            continue;
+          }
+          qos = std::max(qos, static_cast<int>(std::min<uint8_t>(options & QOS_MASK, publication.qos)));
+          retainAsPublished = retainAsPublished || (options & RETAIN_AS_PUBLISHED);
+        }
+        if (qos >= 0)
+        {
+          deliveries.push_back({session, static_cast<uint8_t>(qos), retain && retainAsPublished});
+        }
+      }
+    }
+
+    // Written out of the lock, a slow subscriber only blocks its publishers.
+    for (const auto& delivery : deliveries)
+    {
+      delivery.session->deliver(topic, publication, delivery.qos, delivery.retain);
+    }
+  }
+
+  std::string testEndpoint()
+  {
+    if (auto endpoint = std::getenv("FTY_MQTT_TEST_ENDPOINT"); endpoint && *endpoint)
+    {
+      return endpoint;
+    }
+    auto broker = FakeBroker::shared();
+    return broker ? broker->endpoint() : "tcp://localhost:1883";
+  }
+
+} // namespace fty::messagebus::mqtt::test
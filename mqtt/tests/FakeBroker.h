@@ -0,0 +1,114 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/expected.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace fty::messagebus::mqtt::test
+{
+  /// True if a topic matches a subscription filter, with the + and # wildcards
+  bool topicMatches(std::string_view filter, std::string_view topic);
+
+  //----------------------------------------------------------------------
+  // In-process MQTT v5 broker of the tests and benchmarks
+  //
+  // Enough of the protocol for the paho clients of the backend: CONNECT with a will, PUBLISH in
+  // QoS 0, 1 and 2, retained messages, SUBSCRIBE with wildcards and subscription options,
+  // UNSUBSCRIBE, PINGREQ and DISCONNECT. Publish properties (user properties, correlation data,
+  // response topic, ...) are forwarded as sent. Sessions are not persisted and nothing is
+  // retransmitted; topic aliases, shared subscriptions and AUTH are refused.
+  // One thread per client, a message is delivered by the thread of its publisher.
+  //----------------------------------------------------------------------
+  class FakeBroker
+  {
+  public:
+    /// Start a broker on the loopback interface
+    /// @param port port to listen on, an ephemeral one when 0
+    /// @return Broker or error
+    static fty::Expected<std::unique_ptr<FakeBroker>> start(uint16_t port = 0);
+
+    /// Broker shared by the tests of the process, started on first use (nullptr if it failed)
+    static FakeBroker* shared();
+
+    /// Disconnect the clients and stop
+    ~FakeBroker();
+
+    FakeBroker(const FakeBroker&) = delete;
+    FakeBroker& operator=(const FakeBroker&) = delete;
+
+    uint16_t port() const;
+
+    /// Endpoint of the broker for the clients, tcp://127.0.0.1:<port>
+    std::string endpoint() const;
+
+    /// Clients connected
+    size_t clients() const;
+
+    /// Messages retained
+    size_t retained() const;
+
+  private:
+    struct Session;
+
+    struct Publication
+    {
+      std::string properties;
+      std::string payload;
+      uint8_t qos = 0;
+    };
+
+    FakeBroker(int fd, uint16_t port);
+
+    void acceptLoop();
+    void run(std::shared_ptr<Session> session);
+    bool connect(const std::shared_ptr<Session>& session, std::string_view body);
+    bool publish(Session& session, uint8_t flags, std::string_view body);
+    bool subscribe(Session& session, std::string_view body);
+    bool unsubscribe(Session& session, std::string_view body);
+    void route(const Session* publisher, const std::string& topic, const Publication& publication, bool retain);
+
+    int m_fd;
+    uint16_t m_port;
+    std::thread m_acceptThread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+    size_t m_running = 0;
+    std::list<std::shared_ptr<Session>> m_connections;
+    std::map<std::string, std::shared_ptr<Session>> m_sessions; // Connected, by client id
+    std::map<std::string, Publication> m_retained;              // By topic
+    uint64_t m_assignedIds = 0;
+  };
+
+  /// Endpoint of the MQTT tests: FTY_MQTT_TEST_ENDPOINT when set, else the shared fake broker
+  std::string testEndpoint();
+
+} // namespace fty::messagebus::mqtt::test
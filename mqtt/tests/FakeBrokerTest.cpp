@@ -0,0 +1,445 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "FakeBroker.h"
+
+#include <catch2/catch.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace
+{
+  using namespace fty::messagebus::mqtt::test;
+
+  std::string varint(size_t value)
+  {
+    std::string out;
+    do
+    {
+      auto digit = static_cast<char>(value & 0x7F);
+      value >>= 7;
+      out += value ? static_cast<char>(digit | 0x80) : digit;
+    } while (value);
+    return out;
+  }
+
+  std::string u16(uint16_t value)
+  {
+    return {static_cast<char>(value >> 8), static_cast<char>(value & 0xFF)};
+  }
+
+  std::string str(const std::string& value)
+  {
+    return u16(static_cast<uint16_t>(value.size())) + value;
+  }
+
+  std::string packet(uint8_t header, const std::string& body)
+  {
+    return static_cast<char>(header) + varint(body.size()) + body;
+  }
+
+  // Raw MQTT v5 client, enough to check the bytes of the broker
+  class Client
+  {
+  public:
+    explicit Client(uint16_t port)
+    {
+      m_fd = ::socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in address{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.sin_port = htons(port);
+      REQUIRE(::connect(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+      timeval timeout{2, 0};
+      ::setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~Client()
+    {
+      ::close(m_fd);
+    }
+
+    // CONNACK of the CONNECT
+    std::pair<uint8_t, std::string> connect(const std::string& clientId, const std::string& will = {})
+    {
+      uint8_t flags = 0x02 | (will.empty() ? 0 : 0x04 | 0x08); // Clean start, will in QoS 1
+      auto body = str("MQTT") + '\5' + static_cast<char>(flags) + u16(0) + varint(0) + str(clientId);
+      if (!will.empty())
+      {
+        body += varint(0) + str("will/" + clientId) + str(will);
+      }
+      write(packet(0x10, body));
+      return read();
+    }
+
+    void subscribe(uint16_t id, const std::string& filter, uint8_t options, uint8_t expected)
+    {
+      write(packet(0x82, u16(id) + varint(0) + str(filter) + static_cast<char>(options)));
+      auto [header, body] = read();
+      REQUIRE(header == 0x90);
+      CHECK(body == u16(id) + varint(0) + static_cast<char>(expected));
+    }
+
+    void publish(const std::string& topic, const std::string& properties, const std::string& payload, uint8_t qos = 0,
+                 bool retain = false, uint16_t id = 1)
+    {
+      auto body = str(topic) + (qos ? u16(id) : "") + varint(properties.size()) + properties + payload;
+      write(packet(static_cast<uint8_t>(0x30 | qos << 1 | (retain ? 1 : 0)), body));
+    }
+
+    void write(const std::string& data)
+    {
+      REQUIRE(::send(m_fd, data.data(), data.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(data.size()));
+    }
+
+    // Header and body of the next packet, header 0 on a closed connection
+    std::pair<uint8_t, std::string> read()
+    {
+      uint8_t header = 0;
+      if (!readExactly(reinterpret_cast<char*>(&header), 1))
+      {
+        return {0, {}};
+      }
+      size_t size = 0;
+      for (unsigned shift = 0;; shift += 7)
+      {
+        char digit = 0;
+        REQUIRE(readExactly(&digit, 1));
+        size |= static_cast<size_t>(digit & 0x7F) << shift;
+        if ((digit & 0x80) == 0)
+        {
+          break;
+        }
+      }
+      std::string body(size, '\0');
+      REQUIRE(readExactly(body.data(), size));
+      return {header, body};
+    }
+
+  private:
+    bool readExactly(char* out, size_t size)
+    {
+      while (size != 0)
+      {
+        auto received = ::recv(m_fd, out, size, 0);
+        if (received <= 0)
+        {
+          return false;
+        }
+        out += received;
+        size -= static_cast<size_t>(received);
+      }
+      return true;
+    }
+
+    int m_fd = -1;
+  };
+
+  std::unique_ptr<FakeBroker> startBroker()
+  {
+    auto broker = FakeBroker::start();
+    REQUIRE(broker);
+    return std::move(*broker);
+  }
+
+  // PUBLISH received: topic, properties and payload
+  struct Received
+  {
+    uint8_t header = 0;
+    std::string topic;
+    uint16_t id = 0;
+    std::string properties;
+    std::string payload;
+  };
+
+  Received receive(Client& client)
+  {
+    auto [header, body] = client.read();
+    REQUIRE((header & 0xF0) == 0x30);
+    Received received;
+    received.header = header;
+    size_t position = 2 + ((uint8_t(body[0]) << 8) | uint8_t(body[1]));
+    received.topic = body.substr(2, position - 2);
+    if (header & 0x06)
+    {
+      received.id = static_cast<uint16_t>((uint8_t(body[position]) << 8) | uint8_t(body[position + 1]));
+      position += 2;
+    }
+    // Properties shorter than 128 bytes in the tests
+    size_t length = uint8_t(body[position++]);
+    received.properties = body.substr(position, length);
+    received.payload = body.substr(position + length);
+    return received;
+  }
+
+} // namespace
+
+TEST_CASE("Fake broker topic matching", "[FakeBroker]")
+{
+  CHECK(topicMatches("a/b/c", "a/b/c"));
+  CHECK_FALSE(topicMatches("a/b/c", "a/b"));
+  CHECK_FALSE(topicMatches("a/b", "a/b/c"));
+  CHECK(topicMatches("a/+/c", "a/b/c"));
+  CHECK(topicMatches("a/+/c", "a//c"));
+  CHECK_FALSE(topicMatches("a/+", "a/b/c"));
+  CHECK(topicMatches("+/+", "/b"));
+  CHECK(topicMatches("a/#", "a/b/c"));
+  CHECK(topicMatches("a/#", "a"));
+  CHECK(topicMatches("#", "a/b"));
+  CHECK_FALSE(topicMatches("#", "$SYS/broker"));
+  CHECK_FALSE(topicMatches("+/broker", "$SYS/broker"));
+  CHECK(topicMatches("$SYS/#", "$SYS/broker"));
+  CHECK_FALSE(topicMatches("a/b/#", "a/c"));
+}
+
+TEST_CASE("Fake broker connection", "[FakeBroker]")
+{
+  auto broker = startBroker();
+  REQUIRE(broker->port() != 0);
+  REQUIRE(broker->endpoint() == "tcp://127.0.0.1:" + std::to_string(broker->port()));
+
+  SECTION("Client identifier")
+  {
+    Client client(broker->port());
+    auto [header, body] = client.connect("named");
+    REQUIRE(header == 0x20);
+    CHECK(body.substr(0, 2) == std::string("\0\0", 2));
+    CHECK(body.find('\x12') == std::string::npos);
+    CHECK(broker->clients() == 1);
+
+    Client anonymous(broker->port());
+    std::tie(header, body) = anonymous.connect("");
+    REQUIRE(header == 0x20);
+    CHECK(body.find(std::string("\x12") + str("fake-broker-1")) != std::string::npos);
+    CHECK(broker->clients() == 2);
+
+    // Ping
+    client.write(packet(0xC0, {}));
+    std::tie(header, body) = client.read();
+    CHECK(header == 0xD0);
+    CHECK(body.empty());
+  }
+
+  SECTION("Session taken over")
+  {
+    Client first(broker->port());
+    REQUIRE(first.connect("same").first == 0x20);
+    Client second(broker->port());
+    REQUIRE(second.connect("same").first == 0x20);
+
+    auto [header, body] = first.read();
+    CHECK(header == 0xE0);
+    CHECK(uint8_t(body[0]) == 0x8E);
+    CHECK(first.read().first == 0);
+    CHECK(broker->clients() == 1);
+  }
+
+  SECTION("Unsupported protocol")
+  {
+    Client client(broker->port());
+    client.write(packet(0x10, str("MQTT") + '\4' + '\2' + u16(0) + str("v311")));
+    auto [header, body] = client.read();
+    CHECK(header == 0x20);
+    CHECK(body == std::string("\0\1", 2));
+    CHECK(client.read().first == 0);
+  }
+}
+
+TEST_CASE("Fake broker publish and subscribe", "[FakeBroker]")
+{
+  auto broker = startBroker();
+  Client subscriber(broker->port());
+  REQUIRE(subscriber.connect("subscriber").first == 0x20);
+  Client publisher(broker->port());
+  REQUIRE(publisher.connect("publisher").first == 0x20);
+
+  subscriber.subscribe(1, "test/+/data", 0x02, 0x02);
+
+  // Correlation data, response topic and a user property
+  std::string properties = std::string("\x09") + str("corr-1") + '\x08' + str("reply/topic") + '\x26' + str("key") + str("value");
+
+  SECTION("QoS 0")
+  {
+    publisher.publish("test/x/data", properties, "hello");
+    publisher.publish("test/x/other", {}, "ignored");
+    publisher.publish("test/y/data", {}, "world");
+
+    auto received = receive(subscriber);
+    CHECK(received.header == 0x30);
+    CHECK(received.topic == "test/x/data");
+    CHECK(received.properties == properties);
+    CHECK(received.payload == "hello");
+
+    received = receive(subscriber);
+    CHECK(received.topic == "test/y/data");
+    CHECK(received.properties.empty());
+    CHECK(received.payload == "world");
+  }
+
+  SECTION("QoS 1")
+  {
+    publisher.publish("test/x/data", properties, "hello", 1, false, 7);
+    auto [header, body] = publisher.read();
+    CHECK(header == 0x40);
+    CHECK(body == u16(7));
+
+    auto received = receive(subscriber);
+    CHECK(received.header == 0x32);
+    CHECK(received.id != 0);
+    CHECK(received.properties == properties);
+    CHECK(received.payload == "hello");
+    subscriber.write(packet(0x40, u16(received.id)));
+  }
+
+  SECTION("QoS 2")
+  {
+    publisher.publish("test/x/data", {}, "once", 2, false, 9);
+    auto [header, body] = publisher.read();
+    CHECK(header == 0x50);
+    CHECK(body == u16(9));
+    // Sent again before the PUBREL, not delivered again
+    publisher.publish("test/x/data", {}, "once", 2, false, 9);
+    CHECK(publisher.read().first == 0x50);
+    publisher.write(packet(0x62, u16(9)));
+    std::tie(header, body) = publisher.read();
+    CHECK(header == 0x70);
+    CHECK(body == u16(9));
+
+    auto received = receive(subscriber);
+    CHECK(received.header == 0x34);
+    CHECK(received.payload == "once");
+    subscriber.write(packet(0x50, u16(received.id)));
+    std::tie(header, body) = subscriber.read();
+    CHECK(header == 0x62);
+    CHECK(body == u16(received.id));
+    subscriber.write(packet(0x70, u16(received.id)));
+
+    publisher.publish("test/x/data", {}, "next");
+    CHECK(receive(subscriber).payload == "next");
+  }
+
+  SECTION("QoS downgraded to the subscription")
+  {
+    Client qos0(broker->port());
+    REQUIRE(qos0.connect("qos0").first == 0x20);
+    qos0.subscribe(1, "test/#", 0x00, 0x00);
+
+    publisher.publish("test/x/data", {}, "hello", 1);
+    CHECK(publisher.read().first == 0x40);
+    CHECK(receive(qos0).header == 0x30);
+    CHECK(receive(subscriber).header == 0x32);
+  }
+
+  SECTION("No local")
+  {
+    subscriber.subscribe(2, "test/#", 0x04, 0x00);
+    subscriber.publish("test/self", {}, "own");
+    publisher.publish("test/x/data", {}, "other");
+    // Only the message of the publisher comes back
+    CHECK(receive(subscriber).payload == "other");
+  }
+
+  SECTION("Unsubscribe")
+  {
+    subscriber.write(packet(0xA2, u16(3) + varint(0) + str("test/+/data") + str("unknown")));
+    auto [header, body] = subscriber.read();
+    CHECK(header == 0xB0);
+    CHECK(body == u16(3) + varint(0) + '\x00' + '\x11');
+
+    subscriber.subscribe(4, "last", 0x00, 0x00);
+    publisher.publish("test/x/data", {}, "dropped");
+    publisher.publish("last", {}, "kept");
+    CHECK(receive(subscriber).payload == "kept");
+  }
+
+  SECTION("Invalid filters")
+  {
+    subscriber.subscribe(5, "a/b#", 0x00, 0x8F);
+    subscriber.subscribe(6, "$share/group/a", 0x00, 0x9E);
+  }
+}
+
+TEST_CASE("Fake broker retained messages", "[FakeBroker]")
+{
+  auto broker = startBroker();
+  Client publisher(broker->port());
+  REQUIRE(publisher.connect("publisher").first == 0x20);
+
+  publisher.publish("status/a", {}, "up", 1, true, 1);
+  REQUIRE(publisher.read().first == 0x40);
+  CHECK(broker->retained() == 1);
+
+  Client subscriber(broker->port());
+  REQUIRE(subscriber.connect("subscriber").first == 0x20);
+  subscriber.subscribe(1, "status/#", 0x01, 0x01);
+  auto received = receive(subscriber);
+  CHECK(received.header == 0x33);
+  CHECK(received.topic == "status/a");
+  CHECK(received.payload == "up");
+
+  // Retain handling 2: not sent on subscription
+  Client late(broker->port());
+  REQUIRE(late.connect("late").first == 0x20);
+  late.subscribe(1, "status/#", 0x20, 0x00);
+
+  // Live messages have the retain flag cleared, unless retain as published
+  Client asPublished(broker->port());
+  REQUIRE(asPublished.connect("asPublished").first == 0x20);
+  asPublished.subscribe(1, "status/#", 0x28, 0x00);
+  publisher.publish("status/b", {}, "down", 0, true);
+  CHECK(receive(subscriber).header == 0x30);
+  CHECK(receive(late).payload == "down");
+  CHECK(receive(asPublished).header == 0x31);
+  CHECK(broker->retained() == 2);
+
+  // Empty payload clears
+  publisher.publish("status/a", {}, "", 0, true);
+  publisher.publish("status/b", {}, "", 0, true);
+  receive(subscriber);
+  receive(subscriber);
+  CHECK(broker->retained() == 0);
+}
+
+TEST_CASE("Fake broker will", "[FakeBroker]")
+{
+  auto broker = startBroker();
+  Client watcher(broker->port());
+  REQUIRE(watcher.connect("watcher").first == 0x20);
+  watcher.subscribe(1, "will/#", 0x01, 0x01);
+
+  {
+    Client clean(broker->port());
+    REQUIRE(clean.connect("clean", "gone").first == 0x20);
+    clean.write(packet(0xE0, {}));
+  }
+  {
+    // Closed without DISCONNECT
+    Client lost(broker->port());
+    REQUIRE(lost.connect("lost", "lost").first == 0x20);
+  }
+
+  auto received = receive(watcher);
+  CHECK(received.topic == "will/lost");
+  CHECK(received.payload == "lost");
+  CHECK(received.header == 0x32);
+}
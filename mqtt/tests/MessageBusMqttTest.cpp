@@ -17,6 +17,7 @@
     =========================================================================
 */
 
+#include "FakeBroker.h"
 #include <fty/messagebus/Message.h>
 #include <fty/messagebus/MessageBusStatus.h>
 #include <fty/messagebus/mqtt/MessageBusMqtt.h>
@@ -26,6 +27,7 @@
 
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace
 {
@@ -34,7 +36,8 @@ namespace
 #if defined(EXTERNAL_SERVER_FOR_TEST)
   static constexpr auto MQTT_SERVER_URI{"tcp://mqtt.eclipse.org:1883"};
 #else
-  static constexpr auto MQTT_SERVER_URI{"tcp://localhost:1883"};
+  // In-process broker unless FTY_MQTT_TEST_ENDPOINT is set
+  static const std::string MQTT_SERVER_URI{fty::messagebus::mqtt::test::testEndpoint()};
 #endif
 
   using namespace fty::messagebus;
@@ -271,6 +274,40 @@ namespace
       CHECK(g_msgRecieved.isRecieved(1));
     }
 
+    SECTION("Ordered dispatch")
+    {
+      auto topic = "/etn/test/message/ordered";
+      auto msgBusSender = mqtt::MessageBusMqtt("OrderedPubTestCase", MQTT_SERVER_URI);
+      REQUIRE(msgBusSender.connect());
+
+      auto msgBusReceiver = mqtt::MessageBusMqtt("OrderedPubTestCaseReceiver", MQTT_SERVER_URI);
+      REQUIRE(msgBusReceiver.connect());
+
+      std::vector<std::string> received;
+      REQUIRE(msgBusReceiver.receive(topic, [&received](const Message& message) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        received.push_back(message.userData());
+      }, {}, DISPATCH_ORDERED));
+
+      int nbMessageToSend = 20;
+      for (int i = 0; i < nbMessageToSend; i++)
+      {
+        REQUIRE(msgBusSender.send(Message::buildMessage("OrderedPubTestCase", topic, "TEST", std::to_string(i))));
+      }
+      std::this_thread::sleep_for(TIMEOUT);
+
+      std::lock_guard<std::mutex> lock(m_lock);
+      REQUIRE(received.size() == static_cast<size_t>(nbMessageToSend));
+      for (int i = 0; i < nbMessageToSend; i++)
+      {
+        CHECK(received[static_cast<size_t>(i)] == std::to_string(i));
+      }
+
+      auto metrics = msgBusReceiver.listenerMetrics();
+      REQUIRE(metrics.count(topic) == 1);
+      CHECK(metrics[topic].count == static_cast<uint64_t>(nbMessageToSend));
+    }
+
     SECTION("Pub sub with same object")
     {
       auto topic = "/etn/test/message/pubsub";
@@ -17,6 +17,7 @@
     =========================================================================
 */
 
+#include "FakeBroker.h"
 #include "src/MsgBusMqtt.h"
 #include <fty/messagebus/Message.h>
 #include <fty/messagebus/MessageBusStatus.h>
@@ -31,7 +32,8 @@ namespace
 #if defined(EXTERNAL_SERVER_FOR_TEST)
   static constexpr auto MQTT_SERVER_URI{"tcp://mqtt.eclipse.org:1883"};
 #else
-  static constexpr auto MQTT_SERVER_URI{"tcp://localhost:1883"};
+  // In-process broker unless FTY_MQTT_TEST_ENDPOINT is set
+  static const std::string MQTT_SERVER_URI{fty::messagebus::mqtt::test::testEndpoint()};
 #endif
 
   using namespace fty::messagebus;
@@ -18,6 +18,7 @@
 */
 
 #include <fty/sample/dto/FtyCommonMathDto.h>
+#include <fty/messagebus/RpcClient.h>
 #include <fty/messagebus/amqp/MessageBusAmqp.h>
 
 #include <csignal>
@@ -85,20 +86,24 @@ int main(int argc, char** argv)
   {
     _continue = false;
 
-    fty::Expected<Message> reply = bus.request(request, SYNC_REQUEST_TIMEOUT);
-    if (!reply)
+    // Replies are decoded to MathResult by the client, a KO reply is returned as an error.
+    RpcClient client(bus, "MathsOperationsRequester", replyQueue);
+    fty::Expected<void> startRet = client.start();
+    if (!startRet)
     {
-      std::cerr << "Error while requesting " << reply.error() << std::endl;
+      logError("Error while subscribing {}", startRet.error());
       return EXIT_FAILURE;
     }
 
-    if (reply.value().status() != STATUS_OK)
+    auto deadline = RpcClient::Clock::now() + std::chrono::seconds(SYNC_REQUEST_TIMEOUT);
+    fty::Expected<MathResult> mathresult = client.call<MathOperation, MathResult>(requestQueue, "MathsOperations", operationQuery, deadline);
+    if (!mathresult)
     {
-      std::cerr << "An error occured, message status is not OK!" << std::endl;
+      std::cerr << "Error while requesting " << mathresult.error() << std::endl;
       return EXIT_FAILURE;
     }
 
-    responseMessageListener(reply.value());
+    logInfo("  * status: '{}', result: {}, error: '{}'", mathresult->status, mathresult->result, mathresult->error);
   }
   else
   {
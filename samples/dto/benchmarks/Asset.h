@@ -0,0 +1,110 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/dto/Fields.h>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+  using namespace fty::messagebus;
+
+  // Nested telemetry DTO, mostly numeric.
+  struct Metric
+  {
+    std::string name;
+    double value = 0;
+    uint64_t timestamp = 0;
+    std::string unit;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(dto::field("name", &Metric::name), dto::field("value", &Metric::value), dto::field("timestamp", &Metric::timestamp),
+                             dto::field("unit", &Metric::unit));
+    }
+  };
+
+  struct Asset
+  {
+    std::string id;
+    std::string type;
+    std::map<std::string, std::string> ext;
+    std::vector<Metric> metrics;
+    std::vector<int64_t> samples;
+
+    static constexpr auto fields()
+    {
+      return std::make_tuple(dto::field("id", &Asset::id), dto::field("type", &Asset::type), dto::field("ext", &Asset::ext),
+                             dto::field("metrics", &Asset::metrics), dto::field("samples", &Asset::samples));
+    }
+  };
+
+  inline void to_json(nlohmann::json& json, const Metric& metric)
+  {
+    json = {{"name", metric.name}, {"value", metric.value}, {"timestamp", metric.timestamp}, {"unit", metric.unit}};
+  }
+
+  inline void from_json(const nlohmann::json& json, Metric& metric)
+  {
+    json.at("name").get_to(metric.name);
+    json.at("value").get_to(metric.value);
+    json.at("timestamp").get_to(metric.timestamp);
+    json.at("unit").get_to(metric.unit);
+  }
+
+  inline void to_json(nlohmann::json& json, const Asset& asset)
+  {
+    json = {{"id", asset.id}, {"type", asset.type}, {"ext", asset.ext}, {"metrics", asset.metrics}, {"samples", asset.samples}};
+  }
+
+  inline void from_json(const nlohmann::json& json, Asset& asset)
+  {
+    json.at("id").get_to(asset.id);
+    json.at("type").get_to(asset.type);
+    json.at("ext").get_to(asset.ext);
+    json.at("metrics").get_to(asset.metrics);
+    json.at("samples").get_to(asset.samples);
+  }
+
+  /// Asset with a given number of metrics and four samples per metric, about 150 bytes of JSON per metric.
+  inline Asset makeAsset(size_t nbMetrics)
+  {
+    Asset asset;
+    asset.id = "ups-42";
+    asset.type = "device";
+    for (int i = 0; i < 8; i++)
+    {
+      asset.ext["property." + std::to_string(i)] = "value " + std::to_string(i);
+    }
+    for (size_t i = 0; i < nbMetrics; i++)
+    {
+      asset.metrics.push_back({"realpower.output.L" + std::to_string(i % 3 + 1), 1234.5 + double(i) * 0.25, 1650000000000ull + i * 1000, "W"});
+    }
+    for (size_t i = 0; i < nbMetrics * 4; i++)
+    {
+      asset.samples.push_back(int64_t(i * 7919 % 100000) - 50000);
+    }
+    return asset;
+  }
+
+} // namespace bench
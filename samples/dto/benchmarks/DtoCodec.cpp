@@ -0,0 +1,225 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+#include "Asset.h"
+#include "fty/sample/dto/FtyCommonMathDto.h"
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/dto/Cbor.h>
+#include <fty/messagebus/dto/Json.h>
+#include <fty/messagebus/dto/MsgPack.h>
+#include <fty/messagebus/dto/Table.h>
+#include <nlohmann/json.hpp>
+
+using namespace fty::messagebus;
+using namespace fty::sample::dto;
+using namespace bench;
+
+namespace
+{
+  // nlohmann path: hand-written for the samples, generic for Asset.
+  struct Nlohmann
+  {
+  };
+
+  template <typename T>
+  UserData encode(const T& value)
+  {
+    if constexpr (std::is_same_v<T, Asset>)
+    {
+      return nlohmann::json(value).dump();
+    }
+    else
+    {
+      return value.serialize();
+    }
+  }
+
+  template <typename T>
+  T decode(const UserData& payload)
+  {
+    // Parsed with nlohmann whatever the parser used by deserialize() in this build.
+    auto json = nlohmann::json::parse(payload);
+    if constexpr (std::is_same_v<T, Asset>)
+    {
+      return json.get<Asset>();
+    }
+    else if constexpr (std::is_same_v<T, MathOperation>)
+    {
+      return {json.at("operation").get<std::string>(), json.at("param_1").get<int>(), json.at("param_2").get<int>()};
+    }
+    else
+    {
+      return {json.at("status").get<std::string>(), json.at("result").get<int>(), json.at("error").get<std::string>()};
+    }
+  }
+
+  // Offset table read through views.
+  struct Table
+  {
+  };
+
+  template <typename Format, typename T>
+  UserData encodeWith(const T& value)
+  {
+    if constexpr (std::is_same_v<Format, Nlohmann>)
+    {
+      return encode(value);
+    }
+    else if constexpr (std::is_same_v<Format, Table>)
+    {
+      return dto::encodeTable(value);
+    }
+    else
+    {
+      return dto::encode<Format>(value);
+    }
+  }
+
+  template <typename Format, typename T>
+  T decodeWith(const UserData& payload)
+  {
+    if constexpr (std::is_same_v<Format, Nlohmann>)
+    {
+      return decode<T>(payload);
+    }
+    else
+    {
+      return dto::decode<Format, T>(payload);
+    }
+  }
+
+  template <typename T>
+  T sample();
+
+  template <>
+  MathOperation sample()
+  {
+    return {"add", 123456, -42};
+  }
+
+  template <>
+  MathResult sample()
+  {
+    return {MathResult::STATUS_OK, 123414, ""};
+  }
+
+  template <>
+  Asset sample()
+  {
+    return makeAsset(64);
+  }
+} // namespace
+
+template <typename Format, typename T>
+static void BM_Encode(benchmark::State& state)
+{
+  auto value = sample<T>();
+  size_t size = 0;
+  for (auto _ : state)
+  {
+    auto payload = encodeWith<Format>(value);
+    size = payload.size();
+    benchmark::DoNotOptimize(payload);
+  }
+  state.counters["bytes"] = static_cast<double>(size);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * size));
+}
+
+template <typename Format, typename T>
+static void BM_Decode(benchmark::State& state)
+{
+  auto payload = encodeWith<Format>(sample<T>());
+  for (auto _ : state)
+  {
+    auto value = decodeWith<Format, T>(payload);
+    benchmark::DoNotOptimize(value);
+  }
+  state.counters["bytes"] = static_cast<double>(payload.size());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+}
+
+// Sum of the metric values and samples of an Asset: decoded, or read through a view.
+template <typename Format>
+static void BM_ReadAsset(benchmark::State& state)
+{
+  auto payload = encodeWith<Format>(sample<Asset>());
+  for (auto _ : state)
+  {
+    double sum = 0;
+    if constexpr (std::is_same_v<Format, Table>)
+    {
+      dto::TableView<Asset> asset(payload);
+      for (auto metric : asset.get<&Asset::metrics>())
+      {
+        sum += metric.get<&Metric::value>();
+      }
+      for (auto value : asset.get<&Asset::samples>())
+      {
+        sum += static_cast<double>(value);
+      }
+    }
+    else
+    {
+      auto asset = decodeWith<Format, Asset>(payload);
+      for (const auto& metric : asset.metrics)
+      {
+        sum += metric.value;
+      }
+      for (auto value : asset.samples)
+      {
+        sum += static_cast<double>(value);
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.counters["bytes"] = static_cast<double>(payload.size());
+}
+BENCHMARK_TEMPLATE(BM_ReadAsset, Nlohmann);
+BENCHMARK_TEMPLATE(BM_ReadAsset, dto::Json);
+BENCHMARK_TEMPLATE(BM_ReadAsset, dto::MsgPack);
+BENCHMARK_TEMPLATE(BM_ReadAsset, Table);
+
+// Single field of an Asset, the view still checks the whole payload.
+static void BM_ReadAssetIdTable(benchmark::State& state)
+{
+  auto payload = dto::encodeTable(sample<Asset>());
+  for (auto _ : state)
+  {
+    dto::TableView<Asset> asset(payload);
+    benchmark::DoNotOptimize(asset.get<&Asset::id>());
+  }
+}
+BENCHMARK(BM_ReadAssetIdTable);
+
+#define DTO_BENCHMARKS(T)                                      \
+  BENCHMARK_TEMPLATE(BM_Encode, Nlohmann, T);                  \
+  BENCHMARK_TEMPLATE(BM_Encode, dto::Json, T);                 \
+  BENCHMARK_TEMPLATE(BM_Encode, dto::MsgPack, T);              \
+  BENCHMARK_TEMPLATE(BM_Encode, dto::Cbor, T);                 \
+  BENCHMARK_TEMPLATE(BM_Encode, Table, T);                     \
+  BENCHMARK_TEMPLATE(BM_Decode, Nlohmann, T);                  \
+  BENCHMARK_TEMPLATE(BM_Decode, dto::Json, T);                 \
+  BENCHMARK_TEMPLATE(BM_Decode, dto::MsgPack, T);              \
+  BENCHMARK_TEMPLATE(BM_Decode, dto::Cbor, T)
+
+DTO_BENCHMARKS(MathOperation);
+DTO_BENCHMARKS(MathResult);
+DTO_BENCHMARKS(Asset);
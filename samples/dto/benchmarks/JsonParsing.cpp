@@ -0,0 +1,86 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "Asset.h"
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/dto/FastJson.h>
+#include <nlohmann/json.hpp>
+
+using namespace fty::messagebus;
+using namespace bench;
+
+namespace
+{
+  // JSON payload of an Asset of about the requested size.
+  std::string payloadOfSize(size_t bytes)
+  {
+    size_t nbMetrics = 1;
+    auto payload = dto::encode<dto::Json>(makeAsset(nbMetrics));
+    while (payload.size() < bytes)
+    {
+      nbMetrics = std::max(nbMetrics + 1, nbMetrics * bytes / payload.size());
+      payload = dto::encode<dto::Json>(makeAsset(nbMetrics));
+    }
+    return payload;
+  }
+
+  // Realistic payload sizes, from a single asset to a bulk export.
+  void jsonSizes(benchmark::internal::Benchmark* benchmark)
+  {
+    for (int64_t size : {1 << 10, 16 << 10, 256 << 10, 1 << 20})
+    {
+      benchmark->Arg(size);
+    }
+  }
+
+  struct Nlohmann
+  {
+  };
+
+  template <typename Format>
+  Asset parse(const std::string& payload)
+  {
+    if constexpr (std::is_same_v<Format, Nlohmann>)
+    {
+      return nlohmann::json::parse(payload).get<Asset>();
+    }
+    else
+    {
+      return dto::decode<Format, Asset>(payload);
+    }
+  }
+} // namespace
+
+template <typename Format>
+static void BM_ParseJson(benchmark::State& state)
+{
+  auto payload = payloadOfSize(static_cast<size_t>(state.range(0)));
+  for (auto _ : state)
+  {
+    auto asset = parse<Format>(payload);
+    benchmark::DoNotOptimize(asset);
+  }
+  state.counters["bytes"] = static_cast<double>(payload.size());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+}
+
+BENCHMARK_TEMPLATE(BM_ParseJson, Nlohmann)->Apply(jsonSizes);
+BENCHMARK_TEMPLATE(BM_ParseJson, dto::Json)->Apply(jsonSizes);
+BENCHMARK_TEMPLATE(BM_ParseJson, dto::SimdJson)->Apply(jsonSizes);
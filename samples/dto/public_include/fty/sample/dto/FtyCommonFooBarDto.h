@@ -45,7 +45,7 @@ namespace fty::sample::dto
       deserialize(input);
     }
 
-    const std::string serialize() const;
+    std::string serialize() const;
     void deserialize(const std::string& input);
   };
 
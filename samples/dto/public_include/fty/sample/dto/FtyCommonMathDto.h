@@ -21,6 +21,7 @@
 
 #pragma once
 
+#include <fty/messagebus/dto/Fields.h>
 
 #include <list>
 #include <string>
@@ -30,8 +31,8 @@ namespace fty::sample::dto
   struct MathOperation
   {
     std::string operation;
-    int param_1;
-    int param_2;
+    int param_1 = 0;
+    int param_2 = 0;
     MathOperation() = default;
     MathOperation(const std::string& _operation, int _param_1, int _param_2)
       : operation(_operation)
@@ -44,8 +45,17 @@ namespace fty::sample::dto
       deserialize(input);
     }
 
-    auto serialize() -> const std::string;
+    auto serialize() const -> std::string;
+    // Fields missing from the input keep their value, unknown ones are ignored
     void deserialize(const std::string& input);
+
+    // Fields for the fty::messagebus::dto codecs
+    static constexpr auto fields()
+    {
+      using fty::messagebus::dto::field;
+      return std::make_tuple(field("operation", &MathOperation::operation), field("param_1", &MathOperation::param_1),
+                             field("param_2", &MathOperation::param_2));
+    }
   };
 
   struct MathResult
@@ -69,8 +79,16 @@ namespace fty::sample::dto
       deserialize(input);
     }
 
-    auto serialize() -> const std::string;
+    auto serialize() const -> std::string;
+    // Fields missing from the input keep their value, unknown ones are ignored
     void deserialize(const std::string& input);
+
+    // Fields for the fty::messagebus::dto codecs
+    static constexpr auto fields()
+    {
+      using fty::messagebus::dto::field;
+      return std::make_tuple(field("status", &MathResult::status), field("result", &MathResult::result), field("error", &MathResult::error));
+    }
   };
 
 } // namespace fty::messagebus::test
@@ -36,7 +36,7 @@ using json = nlohmann::json;
 
 namespace fty::sample::dto
 {
-  const std::string FooBar::serialize() const
+  std::string FooBar::serialize() const
   {
     json op;
     op["foo"] = foo;
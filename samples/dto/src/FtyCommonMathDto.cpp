@@ -28,6 +28,7 @@
 
 #include "fty/sample/dto/FtyCommonMathDto.h"
 
+#include <fty/messagebus/dto/FastJson.h>
 #include <nlohmann/json.hpp>
 #include <ostream>
 
@@ -35,7 +36,7 @@ namespace fty::sample::dto
 {
   using json = nlohmann::json;
 
-  auto MathOperation::serialize() -> const std::string
+  auto MathOperation::serialize() const -> std::string
   {
     json op;
     op["operation"] = operation;
@@ -47,10 +48,7 @@ namespace fty::sample::dto
 
   void MathOperation::deserialize(const std::string& input)
   {
-    auto jsonInput = json::parse(input);
-    operation = jsonInput["operation"];
-    param_1 = jsonInput["param_1"];
-    param_2 = jsonInput["param_2"];
+    fty::messagebus::dto::decode<fty::messagebus::dto::FastJson>(input, *this);
   }
 
   std::ostream& operator<<(std::ostream& os, const MathOperation& mathOperation)
@@ -63,7 +61,7 @@ namespace fty::sample::dto
     return os;
   }
 
-  auto MathResult::serialize() -> const std::string
+  auto MathResult::serialize() const -> std::string
   {
     json op;
     op["status"] = status;
@@ -75,10 +73,7 @@ namespace fty::sample::dto
 
   void MathResult::deserialize(const std::string& input)
   {
-    auto jsonInput = json::parse(input);
-    status = jsonInput["status"];
-    result = jsonInput["result"];
-    error = jsonInput["error"];
+    fty::messagebus::dto::decode<fty::messagebus::dto::FastJson>(input, *this);
   }
 
   std::ostream& operator<<(std::ostream& os, const MathResult& mathResult)
@@ -0,0 +1,130 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <string>
+
+namespace loadgen
+{
+  // Metadata set by the load generator
+  static constexpr auto SENT_AT   = "LOADGEN_SENT_AT";   // Send time, ns since epoch
+  static constexpr auto PUBLISHER = "LOADGEN_PUBLISHER"; // Publisher id
+  static constexpr auto SEQUENCE  = "LOADGEN_SEQUENCE";  // Sequence number of the publisher
+
+  static constexpr auto DEFAULT_TOPIC = "/etn/loadgen";
+
+  inline int64_t wallClockNs()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+
+  inline std::string topic(const std::string& prefix, size_t index)
+  {
+    return prefix + "/" + std::to_string(index);
+  }
+
+  /// Payload size distribution: "<bytes>", "<min>-<max>" (uniform) or "exp:<mean>" (exponential)
+  class SizeDistribution
+  {
+  public:
+    static std::optional<SizeDistribution> parse(const std::string& text)
+    {
+      try
+      {
+        SizeDistribution sizes;
+        if (text.rfind("exp:", 0) == 0)
+        {
+          sizes.m_mean = std::stod(text.substr(4));
+          sizes.m_max = static_cast<size_t>(sizes.m_mean * 20);
+          return sizes.m_mean > 0 ? std::optional(sizes) : std::nullopt;
+        }
+        auto dash = text.find('-');
+        sizes.m_min = std::stoul(text.substr(0, dash));
+        sizes.m_max = dash == std::string::npos ? sizes.m_min : std::stoul(text.substr(dash + 1));
+        return sizes.m_min <= sizes.m_max ? std::optional(sizes) : std::nullopt;
+      }
+      catch (const std::exception&)
+      {
+        return std::nullopt;
+      }
+    }
+
+    template <typename Random>
+    size_t operator()(Random& random) const
+    {
+      if (m_mean > 0)
+      {
+        // Capped to keep a bounded payload buffer.
+        auto size = std::exponential_distribution<double>(1. / m_mean)(random);
+        return std::min(static_cast<size_t>(size), m_max);
+      }
+      return m_min == m_max ? m_min : std::uniform_int_distribution<size_t>(m_min, m_max)(random);
+    }
+
+    size_t max() const
+    {
+      return m_max;
+    }
+
+  private:
+    size_t m_min = 0;
+    size_t m_max = 0;
+    double m_mean = 0;
+  };
+
+  /// Values recorded between two snapshots of a histogram
+  inline fty::messagebus::utils::HistogramSnapshot since(const fty::messagebus::utils::HistogramSnapshot& now,
+                                                         const fty::messagebus::utils::HistogramSnapshot& before)
+  {
+    auto delta = now;
+    delta.count -= before.count;
+    delta.sum -= before.sum;
+    delta.max = 0;
+    for (size_t bucket = 0; bucket < delta.buckets.size(); bucket++)
+    {
+      delta.buckets[bucket] -= bucket < before.buckets.size() ? before.buckets[bucket] : 0;
+      if (delta.buckets[bucket] != 0)
+      {
+        // Max of the interval bounded by its highest bucket.
+        delta.max = std::min(fty::messagebus::utils::HistogramBuckets::highest(bucket), now.max);
+      }
+    }
+    return delta;
+  }
+
+  /// Print the percentiles of latencies recorded in ns
+  inline void printPercentiles(const char* title, const fty::messagebus::utils::HistogramSnapshot& latency)
+  {
+    auto us = [&latency](double ratio) { return static_cast<double>(latency.percentile(ratio)) / 1000.; };
+    std::printf("%s: count=%llu mean=%.1fus p50=%.1fus p90=%.1fus p99=%.1fus p99.9=%.1fus p99.99=%.1fus max=%.1fus\n", title,
+                static_cast<unsigned long long>(latency.count), latency.mean() / 1000., us(0.5), us(0.9), us(0.99), us(0.999), us(0.9999),
+                static_cast<double>(latency.max) / 1000.);
+    std::fflush(stdout);
+  }
+
+} // namespace loadgen
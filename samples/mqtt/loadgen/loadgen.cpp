@@ -0,0 +1,251 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "LoadGen.h"
+
+#include <fty/messagebus/mqtt/MessageBusMqtt.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <fty_log.h>
+#include <getopt.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace fty::messagebus;
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::atomic_bool g_stop{false};
+
+  struct Options
+  {
+    std::string endpoint = mqtt::DEFAULT_ENDPOINT;
+    std::string topic = loadgen::DEFAULT_TOPIC;
+    size_t topics = 1;
+    size_t threads = 1;
+    double rate = 1000;
+    bool poisson = false;
+    loadgen::SizeDistribution sizes = *loadgen::SizeDistribution::parse("1024");
+    std::string qos = "0";
+    std::chrono::seconds duration = std::chrono::seconds(10);
+  };
+
+  struct Counters
+  {
+    std::atomic_uint64_t sent{0};
+    std::atomic_uint64_t bytes{0};
+    std::atomic_uint64_t failed{0};
+    // Sum of the delays behind schedule, ns
+    std::atomic_uint64_t late{0};
+  };
+
+  void usage(const char* name)
+  {
+    std::cout << "USAGE: " << name
+              << " [--endpoint <uri>] [--topic <prefix>] [--topics <count>] [--threads <count>] [--rate <msg/s>] [--arrival fixed|poisson]"
+                 " [--size <bytes>|<min>-<max>|exp:<mean>] [--qos 0|1|2] [--duration <s>]"
+              << std::endl;
+  }
+
+  std::optional<Options> parseOptions(int argc, char** argv)
+  {
+    static const option longOptions[] = {
+      {"endpoint", required_argument, nullptr, 'e'}, {"topic", required_argument, nullptr, 't'},   {"topics", required_argument, nullptr, 'n'},
+      {"threads", required_argument, nullptr, 'j'},  {"rate", required_argument, nullptr, 'r'},    {"arrival", required_argument, nullptr, 'a'},
+      {"size", required_argument, nullptr, 's'},     {"qos", required_argument, nullptr, 'q'},     {"duration", required_argument, nullptr, 'd'},
+      {"help", no_argument, nullptr, 'h'},           {nullptr, 0, nullptr, 0}};
+
+    Options options;
+    try
+    {
+      int opt;
+      while ((opt = getopt_long(argc, argv, "e:t:n:j:r:a:s:q:d:h", longOptions, nullptr)) != -1)
+      {
+        switch (opt)
+        {
+          case 'e':
+            options.endpoint = optarg;
+            break;
+          case 't':
+            options.topic = optarg;
+            break;
+          case 'n':
+            options.topics = std::max(std::stoul(optarg), 1ul);
+            break;
+          case 'j':
+            options.threads = std::max(std::stoul(optarg), 1ul);
+            break;
+          case 'r':
+            options.rate = std::stod(optarg);
+            break;
+          case 'a':
+            if (std::string(optarg) != "fixed" && std::string(optarg) != "poisson")
+            {
+              return std::nullopt;
+            }
+            options.poisson = std::string(optarg) == "poisson";
+            break;
+          case 's':
+          {
+            auto sizes = loadgen::SizeDistribution::parse(optarg);
+            if (!sizes)
+            {
+              return std::nullopt;
+            }
+            options.sizes = *sizes;
+            break;
+          }
+          case 'q':
+            options.qos = optarg;
+            if (options.qos != "0" && options.qos != "1" && options.qos != "2")
+            {
+              return std::nullopt;
+            }
+            break;
+          case 'd':
+            options.duration = std::chrono::seconds(std::stoul(optarg));
+            break;
+          default:
+            return std::nullopt;
+        }
+      }
+    }
+    catch (const std::exception&)
+    {
+      return std::nullopt;
+    }
+    return optind == argc ? std::optional(options) : std::nullopt;
+  }
+
+  void publish(const Options& options, size_t index, mqtt::MessageBusMqtt& bus, Counters& counters, Clock::time_point end)
+  {
+    std::mt19937_64 random(std::random_device{}() + index);
+    const UserData payload(options.sizes.max(), 'x');
+    auto publisher = bus.clientName();
+
+    // Schedule of the thread, in steady time, stamped in wall clock time.
+    auto wallOffset = loadgen::wallClockNs() - std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    auto rate = options.rate / static_cast<double>(options.threads);
+    std::exponential_distribution<double> poisson(rate > 0 ? rate : 1);
+    auto next = Clock::now();
+
+    for (uint64_t sequence = 0; !g_stop; sequence++)
+    {
+      auto scheduled = Clock::now();
+      if (rate > 0)
+      {
+        auto interval = options.poisson ? poisson(random) : 1. / rate;
+        next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(interval));
+        std::this_thread::sleep_until(next);
+        scheduled = next;
+        auto late = Clock::now() - next;
+        counters.late += static_cast<uint64_t>(std::max<Clock::rep>(std::chrono::duration_cast<std::chrono::nanoseconds>(late).count(), 0));
+      }
+      if (scheduled >= end)
+      {
+        break;
+      }
+
+      auto size = options.sizes(random);
+      auto stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(scheduled.time_since_epoch()).count() + wallOffset;
+      auto msg = Message::buildMessage(publisher, loadgen::topic(options.topic, sequence % options.topics), "LOAD", payload.substr(0, size),
+                                       {{mqtt::QOS, options.qos},
+                                        {loadgen::SENT_AT, std::to_string(stamp)},
+                                        {loadgen::PUBLISHER, publisher},
+                                        {loadgen::SEQUENCE, std::to_string(sequence)}});
+      if (bus.send(msg))
+      {
+        counters.sent++;
+        counters.bytes += size;
+      }
+      else
+      {
+        counters.failed++;
+      }
+    }
+  }
+
+  void signalHandler(int)
+  {
+    g_stop = true;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  auto options = parseOptions(argc, argv);
+  if (!options)
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::signal(SIGINT, signalHandler);
+  std::signal(SIGTERM, signalHandler);
+
+  // One connection per publishing thread.
+  std::vector<std::unique_ptr<mqtt::MessageBusMqtt>> buses;
+  for (size_t i = 0; i < options->threads; i++)
+  {
+    buses.emplace_back(std::make_unique<mqtt::MessageBusMqtt>(utils::getClientId("loadgen"), options->endpoint));
+    auto connected = buses.back()->connect();
+    if (!connected)
+    {
+      logError("Error while connecting {}", connected.error());
+      return EXIT_FAILURE;
+    }
+  }
+
+  Counters counters;
+  auto start = Clock::now();
+  auto end = start + options->duration;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < options->threads; i++)
+  {
+    threads.emplace_back(publish, std::cref(*options), i, std::ref(*buses[i]), std::ref(counters), end);
+  }
+
+  // Report every second.
+  uint64_t lastSent = 0;
+  while (!g_stop && Clock::now() < end)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    auto sent = counters.sent.load();
+    std::printf("sent=%llu rate=%llu/s failed=%llu\n", static_cast<unsigned long long>(sent), static_cast<unsigned long long>(sent - lastSent),
+                static_cast<unsigned long long>(counters.failed.load()));
+    std::fflush(stdout);
+    lastSent = sent;
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  auto sent = counters.sent.load();
+  std::printf("total: sent=%llu failed=%llu rate=%.0f/s throughput=%.1fMB/s mean_lateness=%.1fus\n", static_cast<unsigned long long>(sent),
+              static_cast<unsigned long long>(counters.failed.load()), static_cast<double>(sent) / elapsed,
+              static_cast<double>(counters.bytes.load()) / elapsed / 1e6, sent ? static_cast<double>(counters.late.load()) / static_cast<double>(sent) / 1000. : 0.);
+  return EXIT_SUCCESS;
+}
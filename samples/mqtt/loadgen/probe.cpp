@@ -0,0 +1,229 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "LoadGen.h"
+
+#include <fty/messagebus/mqtt/MessageBusMqtt.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <fty_log.h>
+#include <getopt.h>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace fty::messagebus;
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::atomic_bool g_stop{false};
+
+  struct Options
+  {
+    std::string endpoint = mqtt::DEFAULT_ENDPOINT;
+    std::string topic = loadgen::DEFAULT_TOPIC;
+    size_t topics = 1;
+    std::chrono::seconds interval = std::chrono::seconds(1);
+    std::chrono::seconds duration = std::chrono::seconds(0);
+  };
+
+  // Sequence tracking of a publisher
+  struct Publisher
+  {
+    uint64_t received = 0;
+    uint64_t highest = 0;
+    uint64_t reordered = 0;
+  };
+
+  class Probe
+  {
+  public:
+    void onMessage(const Message& msg)
+    {
+      auto now = loadgen::wallClockNs();
+      int64_t sentAt = 0;
+      uint64_t sequence = 0;
+      try
+      {
+        sentAt = std::stoll(msg.getMetaDataValue(loadgen::SENT_AT));
+        sequence = std::stoull(msg.getMetaDataValue(loadgen::SEQUENCE));
+      }
+      catch (const std::exception&)
+      {
+        m_invalid++;
+        return;
+      }
+
+      if (now < sentAt)
+      {
+        // Clocks of the hosts drifting apart.
+        m_skewed++;
+      }
+      m_latency.record(static_cast<uint64_t>(std::max<int64_t>(now - sentAt, 0)));
+
+      std::unique_lock<std::mutex> lk(m_mutex);
+      auto& publisher = m_publishers[msg.getMetaDataValue(loadgen::PUBLISHER)];
+      if (publisher.received != 0 && sequence < publisher.highest)
+      {
+        publisher.reordered++;
+      }
+      publisher.highest = std::max(publisher.highest, sequence);
+      publisher.received++;
+    }
+
+    void report(const char* title, const utils::HistogramSnapshot& latency)
+    {
+      uint64_t lost = 0;
+      uint64_t reordered = 0;
+      {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        for (const auto& [name, publisher] : m_publishers)
+        {
+          // Sequences start at 0, messages still in flight are counted as lost.
+          lost += publisher.highest + 1 - std::min(publisher.received, publisher.highest + 1);
+          reordered += publisher.reordered;
+        }
+      }
+      loadgen::printPercentiles(title, latency);
+      std::printf("  lost=%llu reordered=%llu invalid=%llu skewed=%llu\n", static_cast<unsigned long long>(lost),
+                  static_cast<unsigned long long>(reordered), static_cast<unsigned long long>(m_invalid.load()),
+                  static_cast<unsigned long long>(m_skewed.load()));
+      std::fflush(stdout);
+    }
+
+    utils::HistogramSnapshot latency() const
+    {
+      return m_latency.snapshot();
+    }
+
+  private:
+    utils::Histogram m_latency;
+    std::atomic_uint64_t m_invalid{0};
+    std::atomic_uint64_t m_skewed{0};
+    std::mutex m_mutex;
+    std::map<std::string, Publisher> m_publishers;
+  };
+
+  void usage(const char* name)
+  {
+    std::cout << "USAGE: " << name << " [--endpoint <uri>] [--topic <prefix>] [--topics <count>] [--interval <s>] [--duration <s>]" << std::endl;
+  }
+
+  std::optional<Options> parseOptions(int argc, char** argv)
+  {
+    static const option longOptions[] = {{"endpoint", required_argument, nullptr, 'e'}, {"topic", required_argument, nullptr, 't'},
+                                         {"topics", required_argument, nullptr, 'n'},   {"interval", required_argument, nullptr, 'i'},
+                                         {"duration", required_argument, nullptr, 'd'}, {"help", no_argument, nullptr, 'h'},
+                                         {nullptr, 0, nullptr, 0}};
+
+    Options options;
+    try
+    {
+      int opt;
+      while ((opt = getopt_long(argc, argv, "e:t:n:i:d:h", longOptions, nullptr)) != -1)
+      {
+        switch (opt)
+        {
+          case 'e':
+            options.endpoint = optarg;
+            break;
+          case 't':
+            options.topic = optarg;
+            break;
+          case 'n':
+            options.topics = std::max(std::stoul(optarg), 1ul);
+            break;
+          case 'i':
+            options.interval = std::chrono::seconds(std::max(std::stoul(optarg), 1ul));
+            break;
+          case 'd':
+            options.duration = std::chrono::seconds(std::stoul(optarg));
+            break;
+          default:
+            return std::nullopt;
+        }
+      }
+    }
+    catch (const std::exception&)
+    {
+      return std::nullopt;
+    }
+    return optind == argc ? std::optional(options) : std::nullopt;
+  }
+
+  void signalHandler(int)
+  {
+    g_stop = true;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  auto options = parseOptions(argc, argv);
+  if (!options)
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::signal(SIGINT, signalHandler);
+  std::signal(SIGTERM, signalHandler);
+
+  auto bus = mqtt::MessageBusMqtt(utils::getClientId("loadgen-probe"), options->endpoint);
+  auto connected = bus.connect();
+  if (!connected)
+  {
+    logError("Error while connecting {}", connected.error());
+    return EXIT_FAILURE;
+  }
+
+  Probe probe;
+  for (size_t i = 0; i < options->topics; i++)
+  {
+    auto subscribed = bus.receive(loadgen::topic(options->topic, i), [&probe](const Message& msg) { probe.onMessage(msg); });
+    if (!subscribed)
+    {
+      logError("Error while subscribing {}", subscribed.error());
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Until interrupted when no duration is given.
+  auto end = options->duration.count() ? Clock::now() + options->duration : Clock::time_point::max();
+  auto next = Clock::now();
+  utils::HistogramSnapshot last;
+  while (!g_stop && next < end)
+  {
+    next += options->interval;
+    while (!g_stop && Clock::now() < next)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    auto latency = probe.latency();
+    probe.report("interval", loadgen::since(latency, last));
+    last = std::move(latency);
+  }
+  probe.report("total", probe.latency());
+  return EXIT_SUCCESS;
+}
@@ -22,6 +22,7 @@
 #include "fty/sample/dto/FtyCommonMathDto.h"
 #include <fty/messagebus/MessageBus.h>
 #include <fty/messagebus/MessageBusStatus.h>
+#include <fty/messagebus/RpcClient.h>
 #include <fty/messagebus/mqtt/MessageBusMqtt.h>
 
 #include <csignal>
@@ -103,14 +104,24 @@ int main(int argc, char** argv)
   {
     _continue = false;
 
-    auto replyMsg = msgBus.request(msg, SYNC_REQUEST_TIMEOUT);
-    if (replyMsg)
+    // Replies are decoded to MathResult by the client, a KO reply is returned as an error.
+    RpcClient client(msgBus, argv[0], MATHS_OPERATOR_REPLY_QUEUE);
+    fty::Expected<void> startRet = client.start();
+    if (!startRet)
     {
-      responseMessageListener(replyMsg.value());
+      logError("Error while subscribing {}", startRet.error());
+      return EXIT_FAILURE;
+    }
+
+    auto deadline = RpcClient::Clock::now() + std::chrono::seconds(SYNC_REQUEST_TIMEOUT);
+    auto mathresult = client.call<MathOperation, MathResult>(requestQueue, "mathQuery", query, deadline);
+    if (mathresult)
+    {
+      logInfo("  * status: '{}', result: {}, error: '{}'", mathresult->status, mathresult->result, mathresult->error);
     }
     else
     {
-      logError("Time out reached: (%ds)", SYNC_REQUEST_TIMEOUT);
+      logError("Request failed: {}", mathresult.error());
     }
   }
 
@@ -0,0 +1,273 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <fty/messagebus/CaptureBus.h>
+#include <fty/messagebus/Latency.h>
+#include <fty/messagebus/utils.h>
+
+#ifdef FTY_REPLAY_MQTT
+#include <fty/messagebus/mqtt/MessageBusMqtt.h>
+#endif
+#ifdef FTY_REPLAY_AMQP
+#include <fty/messagebus/amqp/MessageBusAmqp.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fty_log.h>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <thread>
+
+using namespace fty::messagebus;
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::atomic_bool g_stop{false};
+
+  struct Options
+  {
+    std::string path;
+#ifdef FTY_REPLAY_MQTT
+    std::string backend = "mqtt";
+#else
+    std::string backend = "amqp";
+#endif
+    std::string endpoint;
+    double speed = 1; // 0 for max speed
+    bool sent = true;
+    bool received = false;
+    size_t loops = 1;
+  };
+
+  struct Counters
+  {
+    uint64_t sent = 0;
+    uint64_t failed = 0;
+    uint64_t skipped = 0;
+    // Delays behind schedule, ns
+    uint64_t late = 0;
+    uint64_t maxLate = 0;
+  };
+
+  void usage(const char* name)
+  {
+    std::cout << "USAGE: " << name
+              << " <capture file> [--backend mqtt|amqp] [--endpoint <uri>] [--speed <factor>|max] [--direction sent|received|all] [--loop <count>]"
+              << std::endl;
+  }
+
+  std::optional<Options> parseOptions(int argc, char** argv)
+  {
+    static const option longOptions[] = {
+      {"backend", required_argument, nullptr, 'b'}, {"endpoint", required_argument, nullptr, 'e'}, {"speed", required_argument, nullptr, 's'},
+      {"direction", required_argument, nullptr, 'd'}, {"loop", required_argument, nullptr, 'l'},   {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+    Options options;
+    try
+    {
+      int opt;
+      while ((opt = getopt_long(argc, argv, "b:e:s:d:l:h", longOptions, nullptr)) != -1)
+      {
+        switch (opt)
+        {
+          case 'b':
+            options.backend = optarg;
+            break;
+          case 'e':
+            options.endpoint = optarg;
+            break;
+          case 's':
+            options.speed = std::string(optarg) == "max" ? 0 : std::stod(optarg);
+            if (options.speed < 0)
+            {
+              return std::nullopt;
+            }
+            break;
+          case 'd':
+          {
+            std::string direction = optarg;
+            if (direction != "sent" && direction != "received" && direction != "all")
+            {
+              return std::nullopt;
+            }
+            options.sent = direction != "received";
+            options.received = direction != "sent";
+            break;
+          }
+          case 'l':
+            options.loops = std::max(std::stoul(optarg), 1ul);
+            break;
+          default:
+            return std::nullopt;
+        }
+      }
+    }
+    catch (const std::exception&)
+    {
+      return std::nullopt;
+    }
+    if (optind + 1 != argc)
+    {
+      return std::nullopt;
+    }
+    options.path = argv[optind];
+    return options;
+  }
+
+  fty::Expected<std::unique_ptr<MessageBus>> makeBus(const Options& options)
+  {
+    std::unique_ptr<MessageBus> bus;
+#ifdef FTY_REPLAY_MQTT
+    if (options.backend == "mqtt")
+    {
+      bus = std::make_unique<mqtt::MessageBusMqtt>(utils::getClientId("replay"), options.endpoint.empty() ? mqtt::DEFAULT_ENDPOINT : options.endpoint);
+    }
+#endif
+#ifdef FTY_REPLAY_AMQP
+    if (options.backend == "amqp")
+    {
+      bus = std::make_unique<amqp::MessageBusAmqp>(utils::getClientId("replay"), options.endpoint.empty() ? amqp::DEFAULT_ENDPOINT : options.endpoint);
+    }
+#endif
+    if (!bus)
+    {
+      return fty::unexpected("Backend not built: " + options.backend);
+    }
+    if (auto connected = bus->connect(); !connected)
+    {
+      return fty::unexpected(connected.error());
+    }
+    return bus;
+  }
+
+  // Replay the capture once, return false on a capture error.
+  bool replay(const Options& options, MessageBus& bus, Counters& counters)
+  {
+    auto reader = CaptureReader::open(options.path);
+    if (!reader)
+    {
+      logError("{}", reader.error());
+      return false;
+    }
+
+    std::optional<int64_t> first;
+    auto start = Clock::now();
+    while (!g_stop)
+    {
+      auto record = (*reader)->next();
+      if (!record)
+      {
+        break;
+      }
+      if (!(record->direction == CaptureDirection::SENT ? options.sent : options.received))
+      {
+        counters.skipped++;
+        continue;
+      }
+
+      // Pace of the capture, records of concurrent threads may be slightly out of order.
+      if (!first)
+      {
+        first = record->timestamp;
+      }
+      if (options.speed > 0)
+      {
+        auto offset = static_cast<double>(std::max<int64_t>(record->timestamp - *first, 0)) / options.speed;
+        auto scheduled = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::nano>(offset));
+        std::this_thread::sleep_until(scheduled);
+        auto late = static_cast<uint64_t>(std::max<Clock::rep>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - scheduled).count(), 0));
+        counters.late += late;
+        counters.maxLate = std::max(counters.maxLate, late);
+      }
+
+      auto& msg = record->message;
+      for (auto key : {latency::STAMP_SEND, latency::STAMP_WIRE, latency::STAMP_RECEIVE, latency::STAMP_LISTENER})
+      {
+        msg.metaData().erase(key);
+      }
+      if (bus.send(msg))
+      {
+        counters.sent++;
+      }
+      else
+      {
+        counters.failed++;
+      }
+    }
+
+    if ((*reader)->truncated())
+    {
+      logWarn("Capture {} ends on a truncated record", options.path);
+    }
+    return true;
+  }
+
+  void signalHandler(int)
+  {
+    g_stop = true;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  auto options = parseOptions(argc, argv);
+  if (!options)
+  {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::signal(SIGINT, signalHandler);
+  std::signal(SIGTERM, signalHandler);
+
+  auto bus = makeBus(*options);
+  if (!bus)
+  {
+    logError("Error while connecting {}", bus.error());
+    return EXIT_FAILURE;
+  }
+
+  Counters counters;
+  auto start = Clock::now();
+  for (size_t loop = 0; loop < options->loops && !g_stop; loop++)
+  {
+    if (!replay(*options, **bus, counters))
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  std::printf("total: sent=%llu failed=%llu skipped=%llu rate=%.0f/s mean_lateness=%.1fus max_lateness=%.1fus\n",
+              static_cast<unsigned long long>(counters.sent), static_cast<unsigned long long>(counters.failed),
+              static_cast<unsigned long long>(counters.skipped), static_cast<double>(counters.sent) / elapsed,
+              counters.sent ? static_cast<double>(counters.late) / static_cast<double>(counters.sent) / 1000. : 0.,
+              static_cast<double>(counters.maxLate) / 1000.);
+  return counters.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
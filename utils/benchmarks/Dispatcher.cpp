@@ -0,0 +1,120 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/utils/MsgBusDispatcher.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace fty::messagebus::utils;
+
+namespace
+{
+  constexpr size_t NB_SUBJECTS = 256;
+
+  using WorkFunction = std::function<size_t(size_t)>;
+  using MissingFunction = std::function<size_t(const std::string&, size_t)>;
+
+  // Subjects looking like the ones of the services, with a shared prefix.
+  std::vector<std::string> subjects(size_t count)
+  {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; i++)
+    {
+      names.push_back("GET_ASSET_PROPERTY_" + std::to_string(i * 7919 % 100000));
+    }
+    return names;
+  }
+
+  std::map<std::string, WorkFunction> functionMap(const std::vector<std::string>& names)
+  {
+    std::map<std::string, WorkFunction> map;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+      map.emplace(names[i], [i](size_t arg) { return arg + i; });
+    }
+    return map;
+  }
+} // namespace
+
+// Dispatch of a message subject over std::map, O(log n) string compares.
+static void BM_DispatchMap(benchmark::State& state)
+{
+  auto names = subjects(static_cast<size_t>(state.range(0)));
+  Dispatcher<std::string, WorkFunction, MissingFunction> dispatcher(functionMap(names));
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dispatcher(names[i], i));
+    i = (i + 1 == names.size()) ? 0 : i + 1;
+  }
+}
+BENCHMARK(BM_DispatchMap)->RangeMultiplier(4)->Range(4, NB_SUBJECTS);
+
+// Dispatch of a message subject over a hash table, looked up with a std::string_view.
+static void BM_DispatchHashed(benchmark::State& state)
+{
+  auto names = subjects(static_cast<size_t>(state.range(0)));
+  HashedDispatcher<WorkFunction, MissingFunction> dispatcher(functionMap(names));
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dispatcher(names[i], i));
+    i = (i + 1 == names.size()) ? 0 : i + 1;
+  }
+}
+BENCHMARK(BM_DispatchHashed)->RangeMultiplier(4)->Range(4, NB_SUBJECTS);
+
+// Dispatch of a message subject with a perfect hash.
+template <size_t N>
+static void BM_DispatchStatic(benchmark::State& state)
+{
+  auto names = subjects(N);
+  std::array<std::string_view, N> keys;
+  typename StaticDispatcher<N, WorkFunction, MissingFunction>::Functions functions;
+  for (size_t i = 0; i < N; i++)
+  {
+    keys[i] = names[i];
+    functions[i] = [i](size_t arg) { return arg + i; };
+  }
+  StaticDispatcher<N, WorkFunction, MissingFunction> dispatcher(PerfectHash<N>(keys), functions);
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dispatcher(names[i], i));
+    i = (i + 1 == N) ? 0 : i + 1;
+  }
+}
+BENCHMARK_TEMPLATE(BM_DispatchStatic, 4);
+BENCHMARK_TEMPLATE(BM_DispatchStatic, 16);
+BENCHMARK_TEMPLATE(BM_DispatchStatic, 64);
+BENCHMARK_TEMPLATE(BM_DispatchStatic, NB_SUBJECTS);
+
+// Dispatch of an unknown subject, handled by the default handler.
+static void BM_DispatchHashedMissing(benchmark::State& state)
+{
+  auto names = subjects(NB_SUBJECTS);
+  HashedDispatcher<WorkFunction, MissingFunction> dispatcher(functionMap(names), [](const std::string&, size_t arg) { return arg; });
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(dispatcher("GET_ASSET_PROPERTY_UNKNOWN", 0));
+  }
+}
+BENCHMARK(BM_DispatchHashedMissing);
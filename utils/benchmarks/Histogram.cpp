@@ -0,0 +1,83 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+
+#include <chrono>
+
+using namespace fty::messagebus::utils;
+
+// Recording of a value, uncontended.
+static void BM_HistogramRecord(benchmark::State& state)
+{
+  Histogram histogram;
+  uint64_t value = 0;
+  for (auto _ : state)
+  {
+    histogram.record(value);
+    value = (value * 7 + 13) & 0xFFFFF;
+  }
+}
+BENCHMARK(BM_HistogramRecord);
+
+// Recording of a value by several threads.
+static void BM_HistogramRecordShared(benchmark::State& state)
+{
+  static Histogram histogram;
+  uint64_t value = static_cast<uint64_t>(state.thread_index());
+  for (auto _ : state)
+  {
+    histogram.record(value);
+    value = (value * 7 + 13) & 0xFFFFF;
+  }
+}
+BENCHMARK(BM_HistogramRecordShared)->ThreadRange(1, 4);
+
+// Recording of a value already serialized by a lock.
+static void BM_HistogramRecordExclusive(benchmark::State& state)
+{
+  Histogram histogram;
+  uint64_t value = 0;
+  for (auto _ : state)
+  {
+    histogram.recordExclusive(value);
+    value = (value * 7 + 13) & 0xFFFFF;
+  }
+}
+BENCHMARK(BM_HistogramRecordExclusive);
+
+// Instrumentation of a job in PoolWorker: the queueing time stamp, the end time
+// stamp (the start of the next job) and two recordings under the pool lock.
+static void BM_JobInstrumentation(benchmark::State& state)
+{
+  using Clock = std::chrono::steady_clock;
+  Histogram queueWait;
+  Histogram runTime;
+  auto started = Clock::now();
+  for (auto _ : state)
+  {
+    auto queued = Clock::now();
+    queueWait.recordExclusive(started - queued);
+    auto finished = Clock::now();
+    runTime.recordExclusive(finished - started);
+    started = finished;
+  }
+}
+BENCHMARK(BM_JobInstrumentation);
@@ -0,0 +1,95 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace fty::messagebus::utils;
+
+namespace
+{
+  constexpr size_t NB_WORKERS = 4;
+
+  void waitFor(const std::atomic_size_t& counter, size_t expected)
+  {
+    while (counter.load() != expected)
+    {
+      std::this_thread::yield();
+    }
+  }
+} // namespace
+
+// N jobs offloaded one by one: one lock and one wake up per job.
+static void BM_OffloadLoop(benchmark::State& state)
+{
+  PoolWorker pool(NB_WORKERS);
+  auto nbJobs = static_cast<size_t>(state.range(0));
+  std::atomic_size_t done{0};
+
+  for (auto _ : state)
+  {
+    done = 0;
+    for (size_t i = 0; i < nbJobs; i++)
+    {
+      pool.offload([&done]() { done++; });
+    }
+    waitFor(done, nbJobs);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * nbJobs));
+}
+BENCHMARK(BM_OffloadLoop)->RangeMultiplier(8)->Range(8, 8 * 1024)->UseRealTime();
+
+// N jobs offloaded at once: one lock and at most one wake up per worker.
+static void BM_OffloadBulk(benchmark::State& state)
+{
+  PoolWorker pool(NB_WORKERS);
+  auto nbJobs = static_cast<size_t>(state.range(0));
+  std::atomic_size_t done{0};
+  std::vector<std::function<void()>> jobs(nbJobs, [&done]() { done++; });
+
+  for (auto _ : state)
+  {
+    done = 0;
+    pool.offloadBulk(jobs.begin(), jobs.end());
+    waitFor(done, nbJobs);
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * nbJobs));
+}
+BENCHMARK(BM_OffloadBulk)->RangeMultiplier(8)->Range(8, 8 * 1024)->UseRealTime();
+
+// N indexes processed in chunks by the workers and the calling thread.
+static void BM_ParallelFor(benchmark::State& state)
+{
+  PoolWorker pool(NB_WORKERS);
+  auto nbJobs = static_cast<size_t>(state.range(0));
+  std::atomic_size_t done{0};
+
+  for (auto _ : state)
+  {
+    done = 0;
+    pool.parallelFor(0, nbJobs, [&done](size_t) { done++; });
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * nbJobs));
+}
+BENCHMARK(BM_ParallelFor)->RangeMultiplier(8)->Range(8, 8 * 1024)->UseRealTime();
@@ -0,0 +1,121 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <benchmark/benchmark.h>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+#include <fty/messagebus/utils/MsgBusThread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+using namespace fty::messagebus::utils;
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<unsigned> allowedCpus()
+  {
+    std::vector<unsigned> cpus;
+    cpu_set_t cpuSet;
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+    {
+      for (unsigned cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      {
+        if (CPU_ISSET(cpu, &cpuSet))
+        {
+          cpus.push_back(cpu);
+        }
+      }
+    }
+    return cpus;
+  }
+
+  double percentile(std::vector<double>& values, double ratio)
+  {
+    auto index = static_cast<size_t>(ratio * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<long>(index), values.end());
+    return values[index];
+  }
+} // namespace
+
+// Latency between offloading a job and its start on a worker, while busy threads
+// (standing for the monitoring threads of the appliance) load every CPU.
+// Unpinned: worker and busy threads float freely.
+// Pinned: the worker owns the first CPU, busy threads are pinned to the others.
+static void BM_DispatchLatency(benchmark::State& state)
+{
+  auto pinned = state.range(0) != 0;
+  auto cpus = allowedCpus();
+  if (pinned && cpus.size() < 2)
+  {
+    state.SkipWithError("Pinning needs at least 2 CPUs");
+    return;
+  }
+
+  std::atomic_bool stop{false};
+  std::vector<std::thread> busyThreads;
+  for (size_t i = 0; i < cpus.size(); i++)
+  {
+    ThreadConfig config{"bench-busy", {}};
+    if (pinned)
+    {
+      config.cpus.assign(cpus.begin() + 1, cpus.end());
+    }
+    busyThreads.emplace_back([&stop, config, i]() {
+      applyThreadConfig(config, std::to_string(i));
+      while (!stop.load(std::memory_order_relaxed))
+      {
+      }
+    });
+  }
+
+  std::vector<double> latencies;
+  {
+    ThreadConfig config{"bench-worker", {}};
+    if (pinned)
+    {
+      config.cpus = {cpus.front()};
+    }
+    PoolWorker pool(1, config);
+
+    for (auto _ : state)
+    {
+      auto offloaded = Clock::now();
+      auto started = pool.queue([]() { return Clock::now(); }).get();
+      latencies.push_back(std::chrono::duration<double, std::micro>(started - offloaded).count());
+    }
+  }
+
+  stop = true;
+  for (auto& th : busyThreads)
+  {
+    th.join();
+  }
+
+  state.counters["p50_us"] = percentile(latencies, 0.50);
+  state.counters["p99_us"] = percentile(latencies, 0.99);
+  state.counters["p999_us"] = percentile(latencies, 0.999);
+  state.SetLabel(pinned ? "pinned" : "unpinned");
+}
+BENCHMARK(BM_DispatchLatency)->ArgName("pinned")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMicrosecond)->MinTime(2.0);
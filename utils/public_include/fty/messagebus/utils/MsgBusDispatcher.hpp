@@ -19,8 +19,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <functional>
 #include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace fty::messagebus::utils
 {
@@ -78,4 +86,350 @@ namespace fty::messagebus::utils
     MissingFunctionType m_defaultHandler;
   };
 
+  /**
+   * @brief Hash functions of the string dispatchers, usable at compile time.
+   */
+  struct DispatcherHash
+  {
+    /// @brief Hash of a string, 8 bytes at a time.
+    static constexpr uint64_t hash(std::string_view key)
+    {
+      uint64_t hash = 0xcbf29ce484222325 ^ key.size();
+      size_t i = 0;
+      for (; i + 8 <= key.size(); i += 8)
+      {
+        hash = step(hash, load(key, i, 8));
+      }
+      if (i < key.size())
+      {
+        hash = step(hash, load(key, i, key.size() - i));
+      }
+      hash = (hash ^ (hash >> 29)) * 0xbf58476d1ce4e5b9;
+      return hash ^ (hash >> 32);
+    }
+
+  private:
+    /// @brief Little endian word of up to 8 bytes (byte per byte to stay usable at compile time, merged in one load by compilers).
+    static constexpr uint64_t load(std::string_view key, size_t offset, size_t size)
+    {
+      if (size == 8)
+      {
+        return uint64_t(static_cast<uint8_t>(key[offset])) | uint64_t(static_cast<uint8_t>(key[offset + 1])) << 8 |
+               uint64_t(static_cast<uint8_t>(key[offset + 2])) << 16 | uint64_t(static_cast<uint8_t>(key[offset + 3])) << 24 |
+               uint64_t(static_cast<uint8_t>(key[offset + 4])) << 32 | uint64_t(static_cast<uint8_t>(key[offset + 5])) << 40 |
+               uint64_t(static_cast<uint8_t>(key[offset + 6])) << 48 | uint64_t(static_cast<uint8_t>(key[offset + 7])) << 56;
+      }
+      uint64_t word = 0;
+      for (size_t byte = 0; byte < size; byte++)
+      {
+        word |= uint64_t(static_cast<uint8_t>(key[offset + byte])) << (8 * byte);
+      }
+      return word;
+    }
+
+    static constexpr uint64_t step(uint64_t hash, uint64_t word)
+    {
+      hash = (hash ^ word) * 0x9e3779b97f4a7c15;
+      return hash ^ (hash >> 32);
+    }
+  };
+
+  /**
+  * @brief Callable dispatcher based on a hash table of strings.
+  *
+  * Same semantics as Dispatcher with std::string keys, looked up with a std::string_view
+  * (without building a key) in an open addressing table.
+  */
+  template <typename WorkFunctionType, typename MissingFunctionType>
+  class HashedDispatcher
+  {
+  public:
+    /// @brief Map of (key -> callable).
+    using Map = std::map<std::string, WorkFunctionType>;
+
+    /**
+     * @brief Constructor without default handler.
+     * \param map Function map.
+     */
+    HashedDispatcher(const Map& map)
+      : HashedDispatcher(map, MissingFunctionType())
+    {
+    }
+
+    /**
+     * @brief Constructor with default handler.
+     * \param map Function map.
+     * \param defaultHandler Default handler callable.
+     */
+    HashedDispatcher(const Map& map, MissingFunctionType defaultHandler)
+      : m_defaultHandler(defaultHandler)
+    {
+      // Power of two table, at most half full to keep probing sequences short.
+      size_t tableSize = 2;
+      while (tableSize < 2 * map.size())
+      {
+        tableSize *= 2;
+      }
+      m_mask = tableSize - 1;
+      m_slots.assign(tableSize, EMPTY);
+
+      m_entries.reserve(map.size());
+      for (const auto& [key, function] : map)
+      {
+        auto hash = DispatcherHash::hash(key);
+        auto slot = hash & m_mask;
+        while (m_slots[slot] != EMPTY)
+        {
+          slot = (slot + 1) & m_mask;
+        }
+        m_slots[slot] = static_cast<uint32_t>(m_entries.size());
+        m_entries.push_back({hash, key, function});
+      }
+    }
+
+    /**
+     * @brief Dispatch a callable based on a key.
+     * \param key Value to dispatch with.
+     * \param args Arguments to pass to the callable.
+     * \return Result of callable.
+     * \warning Dispatching an unknown key without a default handler will throw an std::bad_function_call.
+     */
+    template <typename... ArgsType>
+    typename WorkFunctionType::result_type operator()(std::string_view key, ArgsType&&... args)
+    {
+      auto hash = DispatcherHash::hash(key);
+      for (auto slot = hash & m_mask; m_slots[slot] != EMPTY; slot = (slot + 1) & m_mask)
+      {
+        auto& entry = m_entries[m_slots[slot]];
+        if (entry.hash == hash && entry.key == key)
+        {
+          return entry.function(std::forward<ArgsType>(args)...);
+        }
+      }
+      return m_defaultHandler(std::string(key), std::forward<ArgsType>(args)...);
+    }
+
+  private:
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+
+    struct Entry
+    {
+      uint64_t hash;
+      std::string key;
+      WorkFunctionType function;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_slots;
+    uint64_t m_mask = 0;
+    MissingFunctionType m_defaultHandler;
+  };
+
+  /**
+  * @brief Perfect hash of a set of strings, built at compile time (hash and displace).
+  *
+  * Keys are spread in buckets by the high bits of their hash, each bucket gets the first
+  * seed sending its keys to free slots of the table. A lookup is one hash of the key,
+  * one multiplication and one string compare.
+  */
+  template <size_t N>
+  class PerfectHash
+  {
+  public:
+    /**
+     * @brief Build the perfect hash.
+     * \param keys Set of distinct keys, indexes are kept.
+     * \throw std::invalid_argument on duplicate keys (a compilation error in a constant expression).
+     */
+    constexpr explicit PerfectHash(const std::array<std::string_view, N>& keys)
+      : m_keys(keys)
+    {
+      // Group the keys per bucket.
+      std::array<uint64_t, N> hashes{};
+      std::array<size_t, BUCKETS + 1> starts{};
+      size_t largest = 0;
+      for (size_t i = 0; i < N; i++)
+      {
+        hashes[i] = DispatcherHash::hash(keys[i]);
+        largest = std::max(largest, ++starts[bucket(hashes[i]) + 1]);
+      }
+      for (size_t i = 0; i < BUCKETS; i++)
+      {
+        starts[i + 1] += starts[i];
+      }
+      std::array<size_t, N> byBucket{};
+      std::array<size_t, BUCKETS> filled{};
+      for (size_t i = 0; i < N; i++)
+      {
+        auto current = bucket(hashes[i]);
+        byBucket[starts[current] + filled[current]++] = i;
+      }
+
+      for (auto& index : m_slots)
+      {
+        index = N;
+      }
+
+      // Place the largest buckets first, while the table is mostly free.
+      for (auto size = largest; size > 0; size--)
+      {
+        for (size_t current = 0; current < BUCKETS; current++)
+        {
+          if (starts[current + 1] - starts[current] != size)
+          {
+            continue;
+          }
+          auto first = starts[current];
+          for (auto i = first; i < first + size; i++)
+          {
+            for (auto j = first; j < i; j++)
+            {
+              if (keys[byBucket[i]] == keys[byBucket[j]])
+              {
+                throw std::invalid_argument("Duplicate key in perfect hash");
+              }
+            }
+          }
+
+          for (uint64_t seed = 1;; seed++)
+          {
+            bool fits = true;
+            for (auto i = first; i < first + size && fits; i++)
+            {
+              auto keySlot = slot(hashes[byBucket[i]], seed);
+              fits = m_slots[keySlot] == N;
+              for (auto j = first; j < i && fits; j++)
+              {
+                fits = slot(hashes[byBucket[j]], seed) != keySlot;
+              }
+            }
+            if (fits)
+            {
+              m_seeds[current] = seed;
+              for (auto i = first; i < first + size; i++)
+              {
+                m_slots[slot(hashes[byBucket[i]], seed)] = byBucket[i];
+              }
+              break;
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Index of a key.
+     * \param key Key to look for.
+     * \return Index of the key in the set, N if not in the set.
+     */
+    constexpr size_t find(std::string_view key) const
+    {
+      if constexpr (N == 0)
+      {
+        return N;
+      }
+      else
+      {
+        auto hash = DispatcherHash::hash(key);
+        auto index = m_slots[slot(hash, m_seeds[bucket(hash)])];
+        return (index != N && m_keys[index] == key) ? index : N;
+      }
+    }
+
+    /// @brief Keys of the set.
+    constexpr const std::array<std::string_view, N>& keys() const
+    {
+      return m_keys;
+    }
+
+  private:
+    static constexpr unsigned log2Ceil(size_t value)
+    {
+      unsigned bits = 0;
+      while ((size_t(1) << bits) < value)
+      {
+        bits++;
+      }
+      return bits;
+    }
+
+    // At most one key per bucket on average, the table is at most half full.
+    static constexpr unsigned BUCKET_BITS = log2Ceil(N);
+    static constexpr unsigned TABLE_BITS = log2Ceil(2 * N);
+    static constexpr size_t BUCKETS = size_t(1) << BUCKET_BITS;
+
+    static constexpr size_t bucket(uint64_t hash)
+    {
+      return BUCKET_BITS ? static_cast<size_t>(hash >> (64 - BUCKET_BITS)) : 0;
+    }
+
+    static constexpr size_t slot(uint64_t hash, uint64_t seed)
+    {
+      return TABLE_BITS ? static_cast<size_t>(((hash ^ (seed * 0x9e3779b97f4a7c15)) * 0xbf58476d1ce4e5b9) >> (64 - TABLE_BITS)) : 0;
+    }
+
+    std::array<std::string_view, N> m_keys{};
+    std::array<uint64_t, BUCKETS> m_seeds{};
+    std::array<size_t, size_t(1) << TABLE_BITS> m_slots{};
+  };
+
+  /**
+  * @brief Callable dispatcher over a set of string keys known at compile time.
+  *
+  * Same semantics as Dispatcher, callables are given in the order of the keys of the perfect hash.
+  */
+  template <size_t N, typename WorkFunctionType, typename MissingFunctionType>
+  class StaticDispatcher
+  {
+  public:
+    /// @brief Callables, in the order of the keys.
+    using Functions = std::array<WorkFunctionType, N>;
+
+    /**
+     * @brief Constructor without default handler.
+     * \param hash Perfect hash of the keys.
+     * \param functions Callables of the keys.
+     */
+    StaticDispatcher(const PerfectHash<N>& hash, const Functions& functions)
+      : StaticDispatcher(hash, functions, MissingFunctionType())
+    {
+    }
+
+    /**
+     * @brief Constructor with default handler.
+     * \param hash Perfect hash of the keys.
+     * \param functions Callables of the keys.
+     * \param defaultHandler Default handler callable.
+     */
+    StaticDispatcher(const PerfectHash<N>& hash, const Functions& functions, MissingFunctionType defaultHandler)
+      : m_hash(hash)
+      , m_functions(functions)
+      , m_defaultHandler(defaultHandler)
+    {
+    }
+
+    /**
+     * @brief Dispatch a callable based on a key.
+     * \param key Value to dispatch with.
+     * \param args Arguments to pass to the callable.
+     * \return Result of callable.
+     * \warning Dispatching an unknown key without a default handler will throw an std::bad_function_call.
+     */
+    template <typename... ArgsType>
+    typename WorkFunctionType::result_type operator()(std::string_view key, ArgsType&&... args)
+    {
+      auto index = m_hash.find(key);
+      if (index != N)
+      {
+        return m_functions[index](std::forward<ArgsType>(args)...);
+      }
+      return m_defaultHandler(std::string(key), std::forward<ArgsType>(args)...);
+    }
+
+  private:
+    PerfectHash<N> m_hash;
+    Functions m_functions;
+    MissingFunctionType m_defaultHandler;
+  };
+
 } // namespace fty::messagebus::utils
@@ -0,0 +1,240 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace fty::messagebus::utils
+{
+  /**
+   * @brief Log-linear bucketing shared by Histogram and HistogramSnapshot.
+   *
+   * Values below 16 have their own bucket, above each power of two is split in
+   * 16 linear buckets: a bucket is at most 1/16 (6.25%) of its values wide.
+   */
+  struct HistogramBuckets
+  {
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BITS;
+    static constexpr size_t COUNT = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    /// @brief Bucket of a value.
+    static constexpr size_t index(uint64_t value)
+    {
+      if (value < SUB_BUCKETS)
+      {
+        return static_cast<size_t>(value);
+      }
+      auto msb = static_cast<unsigned>(63 - __builtin_clzll(value));
+      return static_cast<size_t>(((msb - SUB_BITS + 1) << SUB_BITS) + ((value >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1)));
+    }
+
+    /// @brief Lowest value of a bucket.
+    static constexpr uint64_t lowest(size_t bucket)
+    {
+      if (bucket < SUB_BUCKETS)
+      {
+        return bucket;
+      }
+      auto magnitude = bucket >> SUB_BITS;
+      return (SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << (magnitude - 1);
+    }
+
+    /// @brief Highest value of a bucket.
+    static constexpr uint64_t highest(size_t bucket)
+    {
+      return bucket + 1 < COUNT ? lowest(bucket + 1) - 1 : UINT64_MAX;
+    }
+  };
+
+  /**
+   * @brief Copy of the content of a Histogram at a point in time.
+   */
+  struct HistogramSnapshot
+  {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> buckets; // Counts per bucket, see HistogramBuckets
+
+    /// @brief Mean of the recorded values.
+    double mean() const
+    {
+      return count ? static_cast<double>(sum) / static_cast<double>(count) : 0.;
+    }
+
+    /**
+     * @brief Value under which a ratio of the recorded values are.
+     * \param ratio Between 0 and 1 (0.99 for the 99th percentile).
+     * \return Highest value of the bucket holding the percentile, 0 if empty.
+     */
+    uint64_t percentile(double ratio) const
+    {
+      if (count == 0)
+      {
+        return 0;
+      }
+      auto rank = static_cast<uint64_t>(std::clamp(ratio, 0., 1.) * static_cast<double>(count - 1)) + 1;
+      uint64_t seen = 0;
+      for (size_t bucket = 0; bucket < buckets.size(); bucket++)
+      {
+        seen += buckets[bucket];
+        if (seen >= rank)
+        {
+          return std::min(HistogramBuckets::highest(bucket), max);
+        }
+      }
+      return max;
+    }
+  };
+
+  /**
+   * @brief Lock-free HDR-style histogram of 64 bits values.
+   *
+   * Recording is a few relaxed atomic operations, meant for hot paths.
+   * Durations are recorded in nanoseconds.
+   */
+  class Histogram
+  {
+  public:
+    Histogram() = default;
+
+    // Histogram can't be copied, assigned or moved.
+    Histogram(const Histogram&) = delete;
+    Histogram(Histogram&&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+    void operator=(Histogram&&) = delete;
+
+    /**
+     * @brief Record a value.
+     * \param value Value to record.
+     */
+    void record(uint64_t value)
+    {
+      m_buckets[HistogramBuckets::index(value)].fetch_add(1, std::memory_order_relaxed);
+      m_sum.fetch_add(value, std::memory_order_relaxed);
+      auto max = m_max.load(std::memory_order_relaxed);
+      while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+      {
+      }
+    }
+
+    /**
+     * @brief Record a duration, in nanoseconds.
+     * \param duration Duration to record (0 if negative).
+     */
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> duration)
+    {
+      record(toNanoseconds(duration));
+    }
+
+    /**
+     * @brief Record a value, cheaper when recordings are already serialized.
+     * \warning Only one thread may record at a time (under a lock or from a single thread).
+     * \param value Value to record.
+     */
+    void recordExclusive(uint64_t value)
+    {
+      auto& bucket = m_buckets[HistogramBuckets::index(value)];
+      bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      m_sum.store(m_sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+      if (value > m_max.load(std::memory_order_relaxed))
+      {
+        m_max.store(value, std::memory_order_relaxed);
+      }
+    }
+
+    /**
+     * @brief Record a duration in nanoseconds, cheaper when recordings are already serialized.
+     * \warning Only one thread may record at a time (under a lock or from a single thread).
+     * \param duration Duration to record (0 if negative).
+     */
+    template <typename Rep, typename Period>
+    void recordExclusive(std::chrono::duration<Rep, Period> duration)
+    {
+      recordExclusive(toNanoseconds(duration));
+    }
+
+    /**
+     * @brief Copy the content of the histogram.
+     *
+     * Values recorded during the copy may be partially accounted.
+     */
+    HistogramSnapshot snapshot() const;
+
+  private:
+    template <typename Rep, typename Period>
+    static uint64_t toNanoseconds(std::chrono::duration<Rep, Period> duration)
+    {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+      return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    }
+
+    std::array<std::atomic_uint64_t, HistogramBuckets::COUNT> m_buckets{};
+    std::atomic_uint64_t m_sum{0};
+    std::atomic_uint64_t m_max{0};
+  };
+
+  /**
+   * @brief Histogram allocated on its first recording.
+   *
+   * Meant for the many histograms rarely or never recorded, one per listener for instance:
+   * until then, it is a pointer instead of the buckets.
+   */
+  class LazyHistogram
+  {
+  public:
+    LazyHistogram() = default;
+    ~LazyHistogram();
+
+    // LazyHistogram can't be copied, assigned or moved.
+    LazyHistogram(const LazyHistogram&) = delete;
+    LazyHistogram(LazyHistogram&&) = delete;
+    LazyHistogram& operator=(const LazyHistogram&) = delete;
+    void operator=(LazyHistogram&&) = delete;
+
+    /**
+     * @brief Record a duration, in nanoseconds.
+     * \param duration Duration to record (0 if negative).
+     */
+    template <typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> duration)
+    {
+      histogram().record(duration);
+    }
+
+    /**
+     * @brief Copy the content of the histogram, empty if nothing recorded.
+     */
+    HistogramSnapshot snapshot() const;
+
+  private:
+    Histogram& histogram();
+
+    std::atomic<Histogram*> m_histogram{nullptr};
+  };
+
+} // namespace fty::messagebus::utils
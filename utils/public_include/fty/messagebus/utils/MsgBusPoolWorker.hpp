@@ -19,11 +19,21 @@
 
 #pragma once
 
+#include "fty/messagebus/utils/MsgBusHistogram.hpp"
+#include "fty/messagebus/utils/MsgBusThread.hpp"
+
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
+#include <exception>
 #include <future>
+#include <iterator>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <thread>
 #include <type_traits>
@@ -37,11 +47,59 @@ namespace fty::messagebus::utils
   class PoolWorker
   {
   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Elastic sizing of a pool of worker threads.
+     *
+     * A worker is added when the oldest queued job has waited more than growThreshold,
+     * a worker above minWorkers exits after being idle for keepAlive. The wait is checked on
+     * offload and dequeue, and by a supervisor thread while jobs are queued (all workers blocked).
+     */
+    struct Elastic
+    {
+      size_t minWorkers = 1;
+      size_t maxWorkers = 2 * std::thread::hardware_concurrency() + 1;
+      std::chrono::milliseconds growThreshold = std::chrono::milliseconds(10);
+      std::chrono::milliseconds keepAlive = std::chrono::seconds(30);
+    };
+
+    /**
+     * @brief Sizing metrics of a pool of worker threads.
+     */
+    struct SizeMetrics
+    {
+      size_t workers = 0;       // Current number of workers
+      size_t idleWorkers = 0;   // Workers waiting for a job
+      size_t peakWorkers = 0;   // Highest number of workers
+      uint64_t growEvents = 0;  // Workers added because of queue wait
+      uint64_t shrinkEvents = 0; // Workers removed because of idleness
+    };
+
+    /**
+     * @brief Job metrics of a pool of worker threads.
+     */
+    struct JobMetrics
+    {
+      HistogramSnapshot queueWait; // Time spent by the jobs in the queue (ns)
+      HistogramSnapshot runTime;   // Execution time of the jobs (ns)
+      size_t queueDepth = 0;       // Current number of queued jobs
+      size_t peakQueueDepth = 0;   // Highest number of queued jobs
+    };
+
     /**
      * @brief Create a pool of worker threads.
      * \param workers Number of workers (work will be processed synchronously if 0).
+     * \param config Name and CPU affinity of the workers.
+     */
+    PoolWorker(size_t workers = std::thread::hardware_concurrency() + 1, const ThreadConfig& config = threadConfig(ThreadRole::DISPATCH));
+
+    /**
+     * @brief Create an elastic pool of worker threads.
+     * \param elastic Bounds and thresholds of the pool size (a worker is started on demand if minWorkers is 0).
+     * \param config Name and CPU affinity of the workers.
      */
-    PoolWorker(size_t workers = std::thread::hardware_concurrency() + 1);
+    PoolWorker(const Elastic& elastic, const ThreadConfig& config = threadConfig(ThreadRole::DISPATCH));
 
     // PoolWorker can't be copied, assigned or moved.
     PoolWorker() = delete;
@@ -95,6 +153,133 @@ namespace fty::messagebus::utils
       return packagedJob->get_future();
     }
 
+    /**
+     * @brief Offload a range of jobs at once (do not keep std::future for the results).
+     *
+     * Jobs are queued under a single lock and only the workers needed are woken up.
+     * \param first Iterator to the first callable (without argument) of the range.
+     * \param last Iterator past the last callable of the range.
+     */
+    template <typename InputIt>
+    auto offloadBulk(InputIt first, InputIt last) -> void
+    {
+      std::vector<Job> jobs;
+      reserve(jobs, first, last);
+      for (; first != last; ++first)
+      {
+        jobs.emplace_back([job = *first]() mutable -> bool { job(); return false; });
+      }
+      addJobs(std::move(jobs));
+    }
+
+    /**
+     * @brief Queue a range of jobs at once (keep std::future for the results).
+     *
+     * Jobs are queued under a single lock and only the workers needed are woken up.
+     * \param first Iterator to the first callable (without argument) of the range.
+     * \param last Iterator past the last callable of the range.
+     * \return The futures of the return values of the callables, in the order of the range.
+     */
+    template <
+      typename InputIt,
+      typename ReturnType = decltype(std::declval<typename std::iterator_traits<InputIt>::value_type&>()())>
+    auto queueBulk(InputIt first, InputIt last) -> std::vector<std::future<ReturnType>>
+    {
+      std::vector<Job> jobs;
+      std::vector<std::future<ReturnType>> futures;
+      reserve(jobs, first, last);
+      futures.reserve(jobs.capacity());
+      for (; first != last; ++first)
+      {
+        auto packagedJob = std::make_shared<std::packaged_task<ReturnType()>>(*first);
+        futures.emplace_back(packagedJob->get_future());
+        jobs.emplace_back([packagedJob]() -> bool { (*packagedJob)(); return false; });
+      }
+      addJobs(std::move(jobs));
+      return futures;
+    }
+
+    /**
+     * @brief Call a function for each index of a range, in parallel on the workers.
+     *
+     * The range is split in chunks picked up by the calling thread and by helper jobs,
+     * the call returns once every index was processed. As the calling thread can process
+     * all the chunks by itself, parallelFor may be called from a job of the same pool.
+     * \param first First index.
+     * \param last Index past the last one.
+     * \param fn Callable taking an index (size_t).
+     * \param grain Minimum number of indexes per chunk.
+     * \throw The first exception thrown by the callable, once the range is processed.
+     */
+    template <typename Function>
+    auto parallelFor(size_t first, size_t last, Function&& fn, size_t grain = 1) -> void
+    {
+      if (first >= last)
+      {
+        return;
+      }
+
+      // Around 4 chunks per thread to balance uneven indexes.
+      auto threads = concurrency() + 1;
+      auto count = last - first;
+      auto chunkSize = std::max(std::max(grain, size_t(1)), (count + 4 * threads - 1) / (4 * threads));
+      auto nbChunks = (count + chunkSize - 1) / chunkSize;
+
+      // Shared with the helpers, which may start after the end of the call.
+      struct ForState
+      {
+        std::function<void(size_t)> fn;
+        std::atomic_size_t nextChunk{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t doneChunks = 0;
+        std::exception_ptr error;
+      };
+      auto state = std::make_shared<ForState>();
+      state->fn = std::forward<Function>(fn);
+
+      auto work = [state, first, last, chunkSize, nbChunks]() {
+        for (auto chunk = state->nextChunk++; chunk < nbChunks; chunk = state->nextChunk++)
+        {
+          auto begin = first + chunk * chunkSize;
+          auto end = std::min(begin + chunkSize, last);
+          std::exception_ptr error;
+          try
+          {
+            for (auto index = begin; index < end; index++)
+            {
+              state->fn(index);
+            }
+          }
+          catch (...)
+          {
+            error = std::current_exception();
+          }
+
+          std::unique_lock<std::mutex> lk(state->mutex);
+          if (error && !state->error)
+          {
+            state->error = error;
+          }
+          if (++state->doneChunks == nbChunks)
+          {
+            state->cv.notify_all();
+          }
+        }
+      };
+
+      std::vector<std::function<void()>> helpers(std::min(threads - 1, nbChunks - 1), work);
+      offloadBulk(helpers.begin(), helpers.end());
+      work();
+
+      std::unique_lock<std::mutex> lk(state->mutex);
+      state->cv.wait(lk, [&]() -> bool { return state->doneChunks == nbChunks; });
+      if (state->error)
+      {
+        std::rethrow_exception(state->error);
+      }
+    }
+
     /**
      * @brief Schedule job (queue when the std::future is ready).
      * \warning Jobs cannot be scheduled with a PoolWorker of 0 threads!
@@ -145,22 +330,115 @@ namespace fty::messagebus::utils
       });
     }
 
+    /**
+     * @brief Get the sizing metrics of the pool.
+     * \return Snapshot of the metrics.
+     */
+    SizeMetrics sizeMetrics();
+
+    /**
+     * @brief Get the job metrics of the pool.
+     * \return Snapshot of the metrics.
+     */
+    JobMetrics jobMetrics();
+
   private:
     /// @brief Unit of scheduled job for pool worker.
     using Job = std::function<bool()>;
 
+    /// @brief Job waiting in the queue.
+    struct QueuedJob
+    {
+      Job job;
+      Clock::time_point queued;
+    };
+
     /**
      * @brief Add a Job to the queue of jobs to process.
      * \param Job Job to queue.
      */
     void addJob(Job&& Job);
 
+    /**
+     * @brief Add Jobs to the queue of jobs to process, under a single lock.
+     * \param jobs Jobs to queue.
+     */
+    void addJobs(std::vector<Job>&& jobs);
+
+    /**
+     * @brief Number of workers able to run jobs in parallel (0 if synchronous).
+     */
+    size_t concurrency();
+
+    /**
+     * @brief Reserve room for a range of jobs, if its size is known.
+     */
+    template <typename InputIt>
+    static void reserve(std::vector<Job>& jobs, InputIt first, InputIt last)
+    {
+      if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>)
+      {
+        jobs.reserve(static_cast<size_t>(std::distance(first, last)));
+      }
+    }
+
+    /**
+     * @brief Process jobs until termination (or idleness above the minimum size in elastic mode).
+     * \param id Worker identifier.
+     */
+    void workerMainloop(size_t id);
+
+    /**
+     * @brief Start a new worker thread (mutex must be held).
+     */
+    void addWorker();
+
+    /**
+     * @brief Add a worker if the oldest job waits for too long (mutex must be held).
+     */
+    void growIfLate();
+
+    /**
+     * @brief Check the queue wait periodically while jobs are queued (elastic mode).
+     */
+    void supervisorMainloop();
+
+    /**
+     * @brief Wake up the supervisor if the queue was empty before the jobs just queued (mutex must be held).
+     * \param queued Number of jobs just queued.
+     */
+    void notifySupervisor(size_t queued);
+
     std::atomic_bool m_terminated;
-    std::vector<std::thread> m_workers;
+    bool m_synchronous = false;
+    std::optional<Elastic> m_elastic;
+    ThreadConfig m_threadConfig;
 
     std::mutex m_mutex;
-    std::queue<Job> m_jobs;
+    std::map<size_t, std::thread> m_workers;
+    std::vector<std::thread> m_retiredWorkers;
+    size_t m_nextWorkerId = 0;
+    SizeMetrics m_sizeMetrics;
+
+    std::queue<QueuedJob> m_jobs;
     std::condition_variable m_cv;
+
+    // Elastic mode only
+    std::thread m_supervisor;
+    std::condition_variable m_supervisorCv;
+
+    // Job metrics
+    Histogram m_queueWait;
+    Histogram m_runTime;
+    size_t m_peakQueueDepth = 0;
   };
 
+  /**
+   * @brief Process-wide pool of workers shared by the bus instances.
+   *
+   * Created on first use with one worker per hardware thread.
+   * \return The shared pool of workers.
+   */
+  std::shared_ptr<PoolWorker> sharedPoolWorker();
+
 } // namespace fty::messagebus::utils
@@ -0,0 +1,152 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "fty/messagebus/utils/MsgBusPoolWorker.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+
+namespace fty::messagebus::utils
+{
+  /**
+   * @brief Per-key serial executors (strands) on top of a PoolWorker.
+   *
+   * Jobs offloaded with the same key run one at a time, in the order they were
+   * offloaded. Jobs with different keys run in parallel on the pool threads.
+   * The pool may be shared with other users: Strands only waits for its own jobs.
+   * A job throwing an exception is logged, the next jobs of its key still run.
+   */
+  class Strands
+  {
+  public:
+    /**
+     * @brief Create strands running on a pool of workers.
+     * \param pool Pool of workers executing the jobs.
+     */
+    Strands(std::shared_ptr<PoolWorker> pool);
+
+    // Strands can't be copied, assigned or moved.
+    Strands() = delete;
+    Strands(const Strands&) = delete;
+    Strands(Strands&&) = delete;
+    Strands& operator=(const Strands&) = delete;
+    void operator=(Strands&&) = delete;
+
+    /**
+     * @brief Destroy the strands.
+     *
+     * Once the destructor is called, Strands will wait until all offloaded jobs
+     * are completed before returning.
+     */
+    ~Strands();
+
+    /**
+     * @brief Offload job on the strand of a key.
+     * \param key Ordering key, jobs with the same key are processed in FIFO order.
+     * \param fn Callable of the job to do.
+     * \param args Arguments to pass to the callable.
+     */
+    template <
+      typename Function,
+      typename... Args>
+    auto offload(const std::string& key, Function&& fn, Args&&... args) -> void
+    {
+      // Package the job into a storable form.
+      std::function<void()> packagedJob = std::bind(std::forward<Function&&>(fn), std::forward<Args&&>(args)...);
+      addJob(key, std::move(packagedJob));
+    }
+
+    /**
+     * @brief Offload job without ordering constraint.
+     * \param fn Callable of the job to do.
+     * \param args Arguments to pass to the callable.
+     */
+    template <
+      typename Function,
+      typename... Args>
+    auto offloadUnordered(Function&& fn, Args&&... args) -> void
+    {
+      // Package the job into a storable form.
+      std::function<void()> packagedJob = std::bind(std::forward<Function&&>(fn), std::forward<Args&&>(args)...);
+      addJob(std::move(packagedJob));
+    }
+
+    /**
+     * @brief Number of keys having pending or running jobs.
+     */
+    size_t activeKeys();
+
+  private:
+    /// @brief Unit of job for a strand.
+    using Job = std::function<void()>;
+
+    /// @brief Pending jobs of a key, running is set while a drain is scheduled on the pool.
+    struct Strand
+    {
+      std::queue<Job> jobs;
+      bool running = false;
+    };
+
+    /**
+     * @brief Add a Job to the strand of a key.
+     * \param key Ordering key.
+     * \param job Job to queue.
+     */
+    void addJob(const std::string& key, Job&& job);
+
+    /**
+     * @brief Add a Job without ordering constraint.
+     * \param job Job to queue.
+     */
+    void addJob(Job&& job);
+
+    /**
+     * @brief Run a job, logging its exception if any.
+     * \param job Job to run.
+     * \param key Ordering key, empty for an unordered job.
+     */
+    void run(const Job& job, const std::string& key);
+
+    /**
+     * @brief Account the end of a job scheduled on the pool.
+     */
+    void jobDone();
+
+    /**
+     * @brief Process all pending jobs of a key, one at a time.
+     * \param key Ordering key.
+     */
+    void drain(const std::string& key);
+
+    std::shared_ptr<PoolWorker> m_pool;
+
+    std::mutex m_mutex;
+    std::map<std::string, Strand> m_strands;
+    size_t m_runningJobs = 0;
+    std::condition_variable m_cv;
+  };
+
+} // namespace fty::messagebus::utils
@@ -0,0 +1,90 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fty::messagebus::utils
+{
+  /**
+   * @brief Kind of threads running the bus.
+   */
+  enum class ThreadRole : uint8_t
+  {
+    IO = 0,   // Threads of the broker clients (paho callback, proton containers)
+    DISPATCH, // Workers running the listeners
+    TIMER     // Timer wheels
+  };
+
+  /**
+   * @brief Name and CPU affinity applied to a thread when it starts.
+   */
+  struct ThreadConfig
+  {
+    std::string name;           // Thread name, truncated to 15 characters with its suffix
+    std::vector<unsigned> cpus; // Allowed CPUs, the thread floats freely if empty
+  };
+
+  /**
+   * @brief Set the configuration of a kind of threads.
+   *
+   * Threads float freely by default, unless pinned at process start by the CPU lists of
+   * FTY_MESSAGEBUS_CPUS_IO, FTY_MESSAGEBUS_CPUS_DISPATCH or FTY_MESSAGEBUS_CPUS_TIMER.
+   *
+   * Only threads started afterwards are affected: call it before creating the bus
+   * instances (the shared pool of workers is created with the first one).
+   * \param role Kind of threads.
+   * \param config Name and CPU affinity.
+   */
+  void setThreadConfig(ThreadRole role, const ThreadConfig& config);
+
+  /**
+   * @brief Get the configuration of a kind of threads.
+   * \param role Kind of threads.
+   * \return Name and CPU affinity.
+   */
+  ThreadConfig threadConfig(ThreadRole role);
+
+  /**
+   * @brief Apply a configuration to the calling thread.
+   * \param config Name and CPU affinity.
+   * \param suffix Appended to the name to tell threads of a pool apart.
+   * \return True if name and affinity were applied.
+   */
+  bool applyThreadConfig(const ThreadConfig& config, const std::string& suffix = {});
+
+  /**
+   * @brief Apply the configuration of a role to the calling thread, once per thread.
+   *
+   * Meant for threads created by third-party libraries, from their callbacks.
+   * \param role Kind of threads.
+   */
+  void adoptThread(ThreadRole role);
+
+  /**
+   * @brief Parse a list of CPUs ("0,2-3"), as in the FTY_MESSAGEBUS_CPUS_* variables.
+   * \param list Comma separated CPUs or ranges of CPUs.
+   * \return CPUs of the list, empty if invalid.
+   */
+  std::vector<unsigned> parseCpuList(const std::string& list);
+
+} // namespace fty::messagebus::utils
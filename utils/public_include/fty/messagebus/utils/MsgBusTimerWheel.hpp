@@ -0,0 +1,208 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#pragma once
+
+#include "fty/messagebus/utils/MsgBusPoolWorker.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fty::messagebus::utils
+{
+  class TimerWheel;
+
+  /**
+   * @brief Handle of a timer scheduled on a TimerWheel.
+   * \warning A handle must not be used after the destruction of its wheel.
+   */
+  class TimerHandle
+  {
+  public:
+    TimerHandle() = default;
+
+    /**
+     * @brief Cancel the timer.
+     * \return True if the timer was pending, false if already fired or cancelled.
+     */
+    bool cancel();
+
+  private:
+    friend class TimerWheel;
+
+    TimerHandle(TimerWheel* wheel, uint32_t index, uint32_t generation)
+      : m_wheel(wheel)
+      , m_index(index)
+      , m_generation(generation)
+    {
+    }
+
+    TimerWheel* m_wheel = nullptr;
+    uint32_t m_index = 0;
+    uint32_t m_generation = 0;
+  };
+
+  /**
+   * @brief Hierarchical timer wheel.
+   *
+   * Timers are kept in 4 levels of 256 slots, insertion and cancellation are O(1).
+   * A dedicated thread sleeps until the next tick with timers to fire or to cascade,
+   * and offloads the expired jobs to a PoolWorker, so waiting for a deadline does
+   * not park any thread.
+   */
+  class TimerWheel
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Create a timer wheel.
+     * \param pool Pool of workers running the expired jobs.
+     * \param tick Resolution of the wheel, timers are rounded up to the next tick.
+     * \param config Name and CPU affinity of the wheel thread.
+     */
+    TimerWheel(std::shared_ptr<PoolWorker> pool = sharedPoolWorker(), std::chrono::microseconds tick = std::chrono::milliseconds(1),
+               const ThreadConfig& config = threadConfig(ThreadRole::TIMER));
+
+    // TimerWheel can't be copied, assigned or moved.
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    void operator=(TimerWheel&&) = delete;
+
+    /**
+     * @brief Destroy the timer wheel.
+     *
+     * Pending timers are dropped without being fired.
+     */
+    ~TimerWheel();
+
+    /**
+     * @brief Schedule job after a delay.
+     * \param delay Delay before offloading the job.
+     * \param fn Callable of the job to do.
+     * \param args Arguments to pass to the callable.
+     * \return Handle to cancel the timer.
+     */
+    template <
+      typename Rep,
+      typename Period,
+      typename Function,
+      typename... Args>
+    auto scheduleAfter(std::chrono::duration<Rep, Period> delay, Function&& fn, Args&&... args) -> TimerHandle
+    {
+      return scheduleAt(Clock::now() + std::chrono::duration_cast<Clock::duration>(delay), std::forward<Function>(fn), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Schedule job at a point in time.
+     * \param deadline When to offload the job.
+     * \param fn Callable of the job to do.
+     * \param args Arguments to pass to the callable.
+     * \return Handle to cancel the timer.
+     */
+    template <
+      typename Function,
+      typename... Args>
+    auto scheduleAt(Clock::time_point deadline, Function&& fn, Args&&... args) -> TimerHandle
+    {
+      // Package the job into a storable form.
+      std::function<void()> packagedJob = std::bind(std::forward<Function&&>(fn), std::forward<Args&&>(args)...);
+      return addTimer(deadline, std::move(packagedJob));
+    }
+
+    /**
+     * @brief Cancel a timer.
+     * \param handle Handle returned when the timer was scheduled.
+     * \return True if the timer was pending, false if already fired or cancelled.
+     */
+    bool cancel(const TimerHandle& handle);
+
+    /**
+     * @brief Number of pending timers.
+     */
+    size_t pending();
+
+  private:
+    /// @brief Unit of job for a timer.
+    using Job = std::function<void()>;
+
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOTS = 1 << SLOT_BITS;
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+
+    /// @brief Timer storage, linked in the list of its slot (or in the free list).
+    struct Node
+    {
+      Job job;
+      uint64_t expiry = 0;
+      uint32_t prev = NIL;
+      uint32_t next = NIL;
+      uint32_t slot = NIL;
+      uint32_t generation = 0;
+    };
+
+    TimerHandle addTimer(Clock::time_point deadline, Job&& job);
+
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    uint64_t nextTick() const;
+    void advance(uint64_t target, std::vector<Job>& expired);
+    void mainloop();
+
+    std::shared_ptr<PoolWorker> m_pool;
+    Clock::duration m_tick;
+    Clock::time_point m_start;
+    ThreadConfig m_threadConfig;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_terminated = false;
+
+    // Current tick of the wheel
+    uint64_t m_now = 0;
+    // Tick the wheel thread sleeps until
+    uint64_t m_wakeup = UINT64_MAX;
+    size_t m_pending = 0;
+    std::vector<Node> m_nodes;
+    uint32_t m_free = NIL;
+    std::array<std::array<uint32_t, SLOTS>, LEVELS> m_slots;
+
+    std::thread m_thread;
+  };
+
+  /**
+   * @brief Process-wide timer wheel shared by the bus helpers.
+   *
+   * Created on first use, its jobs run on the shared pool of workers.
+   * \return The shared timer wheel.
+   */
+  std::shared_ptr<TimerWheel> sharedTimerWheel();
+
+} // namespace fty::messagebus::utils
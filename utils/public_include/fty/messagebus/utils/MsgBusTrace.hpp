@@ -0,0 +1,106 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * Static tracepoints (USDT) of the message bus, provider fty_messagebus.
+ *
+ * Built in when sys/sdt.h is available (FTY_MESSAGEBUS_USDT), a disabled probe is a nop and
+ * its arguments are only computed while a tracer (bpftrace, perf, systemtap) is attached:
+ *   bpftrace -e 'usdt:/usr/lib/libfty-common-messagebus2-mqtt.so:fty_messagebus:send_done { @[str(arg0)] = hist(arg3); }'
+ *
+ * Probes and arguments (addresses as strings, durations in ns, correlation ids hashed):
+ *   send(address, size, correlation)
+ *   send_done(address, size, correlation, duration, delivered)
+ *   request(address, size, correlation, timeout in s)
+ *   request_done(address, correlation, duration, replied)
+ *   receive(address, size, correlation)                       receive callback of the client library
+ *   listener_done(address, correlation, queued, duration)     queued from the receive callback
+ *   pool_job(queued, duration)                                job of a PoolWorker
+ */
+#define FTY_MESSAGEBUS_PROBES(X) \
+  X(send)                        \
+  X(send_done)                   \
+  X(request)                     \
+  X(request_done)                \
+  X(receive)                     \
+  X(listener_done)               \
+  X(pool_job)
+
+#if defined(FTY_MESSAGEBUS_USDT)
+// Probes guarded by semaphores, raised by the tracers attaching to them.
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define FTY_TRACE_SEMAPHORE(probe) fty_messagebus_##probe##_semaphore
+// One semaphore per shared object, the tracers raise the one referenced by the probe they attach to.
+#define FTY_TRACE_DECLARE_SEMAPHORE(probe) extern "C" __attribute__((visibility("hidden"))) unsigned short FTY_TRACE_SEMAPHORE(probe);
+FTY_MESSAGEBUS_PROBES(FTY_TRACE_DECLARE_SEMAPHORE)
+
+#define FTY_TRACE_ENABLED(probe) __builtin_expect(FTY_TRACE_SEMAPHORE(probe) != 0, 0)
+#define FTY_TRACE(probe, ...) STAP_PROBEV(fty_messagebus, probe, __VA_ARGS__)
+#else
+#define FTY_TRACE_ENABLED(probe) false
+// Arguments never evaluated, still checked and used.
+#define FTY_TRACE(probe, ...)               \
+  do                                        \
+  {                                         \
+    if (false)                              \
+    {                                       \
+      [](const auto&...) {}(__VA_ARGS__);   \
+    }                                       \
+  } while (0)
+#endif
+
+namespace fty::messagebus::utils
+{
+  /**
+   * @brief Hash of a correlation id carried by the probes, 0 without one.
+   */
+  inline uint64_t traceHash(const std::string& correlationId)
+  {
+    return correlationId.empty() ? 0 : std::hash<std::string>{}(correlationId);
+  }
+
+  /**
+   * @brief Start time of a traced operation (ns).
+   * \param enabled True if the probe ending the operation is enabled, 0 is returned otherwise.
+   */
+  inline int64_t traceStart(bool enabled)
+  {
+    return enabled ? std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() : 0;
+  }
+
+  /**
+   * @brief Duration of a traced operation (ns), 0 if the probe was enabled after its start.
+   * \param started Start time of the operation.
+   */
+  inline int64_t traceElapsed(int64_t started)
+  {
+    return started ? traceStart(true) - started : 0;
+  }
+
+} // namespace fty::messagebus::utils
@@ -0,0 +1,78 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/utils/MsgBusHistogram.hpp"
+
+namespace fty::messagebus::utils
+{
+  HistogramSnapshot Histogram::snapshot() const
+  {
+    HistogramSnapshot snapshot;
+    snapshot.buckets.reserve(HistogramBuckets::COUNT);
+    for (const auto& bucket : m_buckets)
+    {
+      snapshot.buckets.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+    snapshot.max = m_max.load(std::memory_order_relaxed);
+
+    // Keep the count consistent with the copied buckets.
+    for (auto count : snapshot.buckets)
+    {
+      snapshot.count += count;
+    }
+
+    // Trailing empty buckets are not worth keeping.
+    while (!snapshot.buckets.empty() && snapshot.buckets.back() == 0)
+    {
+      snapshot.buckets.pop_back();
+    }
+    return snapshot;
+  }
+
+  LazyHistogram::~LazyHistogram()
+  {
+    delete m_histogram.load(std::memory_order_acquire);
+  }
+
+  HistogramSnapshot LazyHistogram::snapshot() const
+  {
+    auto histogram = m_histogram.load(std::memory_order_acquire);
+    return histogram ? histogram->snapshot() : HistogramSnapshot{};
+  }
+
+  Histogram& LazyHistogram::histogram()
+  {
+    auto histogram = m_histogram.load(std::memory_order_acquire);
+    if (histogram)
+    {
+      return *histogram;
+    }
+
+    // First recordings racing, the histogram of the first one is kept.
+    auto created = new Histogram();
+    if (m_histogram.compare_exchange_strong(histogram, created, std::memory_order_acq_rel))
+    {
+      return *created;
+    }
+    delete created;
+    return *histogram;
+  }
+
+} // namespace fty::messagebus::utils
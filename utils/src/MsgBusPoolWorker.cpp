@@ -18,80 +18,311 @@
 */
 
 #include "fty/messagebus/utils/MsgBusPoolWorker.hpp"
+#include "fty/messagebus/utils/MsgBusTrace.hpp"
+
+#include <algorithm>
 
 namespace fty::messagebus::utils
 {
-  PoolWorker::PoolWorker(size_t workers)
+  PoolWorker::PoolWorker(size_t workers, const ThreadConfig& config)
+    : m_terminated(false)
+    , m_synchronous(workers == 0)
+    , m_threadConfig(config)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    for (size_t cpt = 0; cpt < workers; cpt++)
+    {
+      addWorker();
+    }
+  }
+
+  PoolWorker::PoolWorker(const Elastic& elastic, const ThreadConfig& config)
     : m_terminated(false)
+    , m_elastic(elastic)
+    , m_threadConfig(config)
   {
-    auto workerMainloop = [this]() {
-      while (true)
+    m_elastic->maxWorkers = std::max({m_elastic->maxWorkers, m_elastic->minWorkers, size_t(1)});
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    for (size_t cpt = 0; cpt < m_elastic->minWorkers; cpt++)
+    {
+      addWorker();
+    }
+    m_supervisor = std::thread([this]() { supervisorMainloop(); });
+  }
+
+  PoolWorker::~PoolWorker()
+  {
+    std::map<size_t, std::thread> workers;
+    std::vector<std::thread> retiredWorkers;
+    {
+      // No worker can be added or retired once terminated.
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_terminated.store(true);
+      m_cv.notify_all();
+      m_supervisorCv.notify_all();
+      workers.swap(m_workers);
+      retiredWorkers.swap(m_retiredWorkers);
+    }
+
+    for (auto& [id, th] : workers)
+    {
+      th.join();
+    }
+    for (auto& th : retiredWorkers)
+    {
+      th.join();
+    }
+    if (m_supervisor.joinable())
+    {
+      m_supervisor.join();
+    }
+  }
+
+  void PoolWorker::supervisorMainloop()
+  {
+    applyThreadConfig(m_threadConfig, "supervisor");
+
+    // Workers all blocked don't dequeue and offloads may have stopped: the wait of the
+    // oldest job is also checked periodically while the queue is not empty.
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (!m_terminated.load())
+    {
+      if (m_jobs.empty())
+      {
+        m_supervisorCv.wait(lk, [this]() -> bool { return m_terminated.load() || !m_jobs.empty(); });
+      }
+      else
+      {
+        m_supervisorCv.wait_for(lk, m_elastic->growThreshold);
+      }
+      growIfLate();
+    }
+  }
+
+  void PoolWorker::workerMainloop(size_t id)
+  {
+    applyThreadConfig(m_threadConfig, std::to_string(id));
+
+    auto ready = [this]() -> bool { return m_terminated.load() || !m_jobs.empty(); };
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (true)
+    {
+      m_sizeMetrics.idleWorkers++;
+      bool awoken = true;
+      if (m_elastic && m_sizeMetrics.workers > m_elastic->minWorkers)
+      {
+        awoken = m_cv.wait_for(lk, m_elastic->keepAlive, ready);
+      }
+      else
       {
-        std::unique_lock<std::mutex> lk(m_mutex);
-        m_cv.wait(lk, [this]() -> bool { return m_terminated.load() || !m_jobs.empty(); });
+        m_cv.wait(lk, ready);
+      }
+      m_sizeMetrics.idleWorkers--;
 
-        while (!m_jobs.empty())
+      if (!awoken)
+      {
+        if (m_sizeMetrics.workers > m_elastic->minWorkers)
         {
-          auto job = std::move(m_jobs.front());
-          m_jobs.pop();
-          lk.unlock();
-
-          auto shouldReschedule = job();
-
-          lk.lock();
-          if (shouldReschedule)
-          {
-            m_jobs.emplace(std::move(job));
-            m_cv.notify_one();
-          }
+          // Idle for too long above the minimum size, retire (joined later).
+          auto worker = m_workers.find(id);
+          m_retiredWorkers.emplace_back(std::move(worker->second));
+          m_workers.erase(worker);
+          m_sizeMetrics.workers--;
+          m_sizeMetrics.shrinkEvents++;
+          return;
         }
+        continue;
+      }
+
+      // Jobs processed back to back start when the previous one finished,
+      // one clock read per job (metrics are recorded under the lock).
+      auto started = Clock::now();
+      while (!m_jobs.empty())
+      {
+        auto queuedJob = std::move(m_jobs.front());
+        m_jobs.pop();
+        m_queueWait.recordExclusive(started - queuedJob.queued);
+        growIfLate();
+        lk.unlock();
+
+        auto shouldReschedule = queuedJob.job();
+        auto finished = Clock::now();
 
-        if (m_terminated.load())
+        lk.lock();
+        m_runTime.recordExclusive(finished - started);
+        if (FTY_TRACE_ENABLED(pool_job))
+        {
+          FTY_TRACE(pool_job, std::chrono::nanoseconds(started - queuedJob.queued).count(), std::chrono::nanoseconds(finished - started).count());
+        }
+        started = finished;
+        if (shouldReschedule)
         {
-          break;
+          m_jobs.push({std::move(queuedJob.job), finished});
+          m_peakQueueDepth = std::max(m_peakQueueDepth, m_jobs.size());
+          notifySupervisor(1);
+          m_cv.notify_one();
         }
       }
-    };
 
-    m_workers.reserve(workers);
-    for (size_t cpt = 0; cpt < workers; cpt++)
+      if (m_terminated.load())
+      {
+        break;
+      }
+    }
+  }
+
+  void PoolWorker::addWorker()
+  {
+    if (m_terminated.load())
     {
-      m_workers.emplace_back(std::thread(workerMainloop));
+      return;
     }
+
+    // Threads retired in the meantime are over or about to be.
+    for (auto& th : m_retiredWorkers)
+    {
+      th.join();
+    }
+    m_retiredWorkers.clear();
+
+    auto id = m_nextWorkerId++;
+    m_workers.emplace(id, std::thread([this, id]() { workerMainloop(id); }));
+    m_sizeMetrics.workers++;
+    m_sizeMetrics.peakWorkers = std::max(m_sizeMetrics.peakWorkers, m_sizeMetrics.workers);
   }
 
-  PoolWorker::~PoolWorker()
+  void PoolWorker::growIfLate()
   {
-    if (!m_workers.empty())
+    if (!m_elastic || m_jobs.empty() || m_sizeMetrics.idleWorkers != 0 || m_sizeMetrics.workers >= m_elastic->maxWorkers)
     {
-      {
-        std::unique_lock<std::mutex> lk(m_mutex);
-        m_terminated.store(true);
-        m_cv.notify_all();
-      }
+      return;
+    }
 
-      for (auto& th : m_workers)
-      {
-        th.join();
-      }
+    if (Clock::now() - m_jobs.front().queued > m_elastic->growThreshold)
+    {
+      addWorker();
+      m_sizeMetrics.growEvents++;
+    }
+  }
+
+  void PoolWorker::notifySupervisor(size_t queued)
+  {
+    // Only when the queue was empty, the supervisor is then waiting without a timeout.
+    if (m_elastic && m_jobs.size() == queued)
+    {
+      m_supervisorCv.notify_one();
     }
   }
 
+  PoolWorker::SizeMetrics PoolWorker::sizeMetrics()
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    return m_sizeMetrics;
+  }
+
   void PoolWorker::addJob(Job&& work)
   {
     std::unique_lock<std::mutex> lk(m_mutex);
 
-    if (m_workers.empty())
+    if (m_synchronous)
     {
       // No workers, run work unit synchronously.
+      auto started = Clock::now();
       work();
+      m_runTime.recordExclusive(Clock::now() - started);
     }
     else
     {
       // Got workers, schedule.
-      m_jobs.emplace(work);
+      m_jobs.push({std::move(work), Clock::now()});
+      m_peakQueueDepth = std::max(m_peakQueueDepth, m_jobs.size());
+      notifySupervisor(1);
+      if (m_elastic && m_sizeMetrics.workers == 0)
+      {
+        // Elastic pool shrunk to nothing, start a worker right away.
+        addWorker();
+      }
+      growIfLate();
       m_cv.notify_one();
     }
   }
 
+  void PoolWorker::addJobs(std::vector<Job>&& jobs)
+  {
+    if (jobs.empty())
+    {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+
+    if (m_synchronous)
+    {
+      // No workers, run work units synchronously.
+      for (auto& work : jobs)
+      {
+        auto started = Clock::now();
+        work();
+        m_runTime.recordExclusive(Clock::now() - started);
+      }
+      return;
+    }
+
+    auto queued = Clock::now();
+    for (auto& work : jobs)
+    {
+      m_jobs.push({std::move(work), queued});
+    }
+    m_peakQueueDepth = std::max(m_peakQueueDepth, m_jobs.size());
+    notifySupervisor(jobs.size());
+    if (m_elastic && m_sizeMetrics.workers == 0)
+    {
+      addWorker();
+    }
+    growIfLate();
+
+    // Wake up one idle worker per job, busy workers pick up the rest when done.
+    if (jobs.size() >= m_sizeMetrics.idleWorkers)
+    {
+      m_cv.notify_all();
+    }
+    else
+    {
+      for (size_t i = 0; i < jobs.size(); i++)
+      {
+        m_cv.notify_one();
+      }
+    }
+  }
+
+  PoolWorker::JobMetrics PoolWorker::jobMetrics()
+  {
+    JobMetrics metrics;
+    metrics.queueWait = m_queueWait.snapshot();
+    metrics.runTime = m_runTime.snapshot();
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    metrics.queueDepth = m_jobs.size();
+    metrics.peakQueueDepth = m_peakQueueDepth;
+    return metrics;
+  }
+
+  size_t PoolWorker::concurrency()
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    if (m_synchronous)
+    {
+      return 0;
+    }
+    return m_elastic ? m_elastic->maxWorkers : m_sizeMetrics.workers;
+  }
+
+  std::shared_ptr<PoolWorker> sharedPoolWorker()
+  {
+    static auto sharedPool = std::make_shared<PoolWorker>(std::max(std::thread::hardware_concurrency(), 1u));
+    return sharedPool;
+  }
+
 } // namespace fty::messagebus::utils
@@ -0,0 +1,125 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/utils/MsgBusStrand.hpp"
+
+#include <fty_log.h>
+
+namespace fty::messagebus::utils
+{
+  Strands::Strands(std::shared_ptr<PoolWorker> pool)
+    : m_pool(pool)
+  {
+  }
+
+  Strands::~Strands()
+  {
+    // Jobs running on the pool reference this object, wait for all of them.
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_cv.wait(lk, [this]() -> bool { return m_runningJobs == 0; });
+  }
+
+  size_t Strands::activeKeys()
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    return m_strands.size();
+  }
+
+  void Strands::addJob(const std::string& key, Job&& job)
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      auto& strand = m_strands[key];
+      strand.jobs.emplace(std::move(job));
+      if (strand.running)
+      {
+        // A drain is already scheduled for this key, it will pick up the job.
+        return;
+      }
+      strand.running = true;
+      m_runningJobs++;
+    }
+
+    // Lock released, the pool may run the drain synchronously.
+    m_pool->offload([this, key]() { drain(key); });
+  }
+
+  void Strands::addJob(Job&& job)
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_runningJobs++;
+    }
+
+    m_pool->offload([this, job = std::move(job)]() {
+      run(job, {});
+      jobDone();
+    });
+  }
+
+  void Strands::run(const Job& job, const std::string& key)
+  {
+    // An exception would end the pool thread, the job is lost but not the next ones.
+    try
+    {
+      job();
+    }
+    catch (const std::exception& e)
+    {
+      logError("Job of strand '{}' failed: {}", key, e.what());
+    }
+    catch (...)
+    {
+      logError("Job of strand '{}' failed", key);
+    }
+  }
+
+  void Strands::jobDone()
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    m_runningJobs--;
+    m_cv.notify_all();
+  }
+
+  void Strands::drain(const std::string& key)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (true)
+    {
+      auto it = m_strands.find(key);
+      if (it->second.jobs.empty())
+      {
+        // Nothing left for this key, forget it until its next job.
+        m_strands.erase(it);
+        m_runningJobs--;
+        m_cv.notify_all();
+        return;
+      }
+
+      auto job = std::move(it->second.jobs.front());
+      it->second.jobs.pop();
+      lk.unlock();
+
+      run(job, key);
+
+      lk.lock();
+    }
+  }
+
+} // namespace fty::messagebus::utils
@@ -0,0 +1,161 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/utils/MsgBusThread.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+
+namespace fty::messagebus::utils
+{
+  namespace
+  {
+    // Linux thread names are limited to 16 bytes with the terminating null.
+    constexpr size_t MAX_THREAD_NAME = 15;
+
+    // Default configuration of a role, pinned to the CPUs of its environment variable if set.
+    ThreadConfig defaultConfig(const char* name, const char* variable)
+    {
+      auto value = std::getenv(variable);
+      return {name, value ? parseCpuList(value) : std::vector<unsigned>{}};
+    }
+
+    std::mutex g_mutex;
+    std::array<ThreadConfig, 3> g_configs{{
+      defaultConfig("mb-io", "FTY_MESSAGEBUS_CPUS_IO"),
+      defaultConfig("mb-worker", "FTY_MESSAGEBUS_CPUS_DISPATCH"),
+      defaultConfig("mb-timer", "FTY_MESSAGEBUS_CPUS_TIMER"),
+    }};
+  } // namespace
+
+  void setThreadConfig(ThreadRole role, const ThreadConfig& config)
+  {
+    std::unique_lock<std::mutex> lk(g_mutex);
+    g_configs.at(static_cast<size_t>(role)) = config;
+  }
+
+  ThreadConfig threadConfig(ThreadRole role)
+  {
+    std::unique_lock<std::mutex> lk(g_mutex);
+    return g_configs.at(static_cast<size_t>(role));
+  }
+
+  bool applyThreadConfig(const ThreadConfig& config, const std::string& suffix)
+  {
+    bool applied = true;
+
+    if (!config.name.empty())
+    {
+      // Keep the suffix when truncating, it identifies the thread in its pool.
+      auto name = suffix.empty() ? config.name : config.name + "-" + suffix;
+      if (name.size() > MAX_THREAD_NAME)
+      {
+        auto suffixSize = std::min(name.size() - config.name.size(), MAX_THREAD_NAME);
+        name = name.substr(0, MAX_THREAD_NAME - suffixSize) + name.substr(name.size() - suffixSize);
+      }
+      applied = pthread_setname_np(pthread_self(), name.c_str()) == 0;
+    }
+
+    if (!config.cpus.empty())
+    {
+      cpu_set_t cpuSet;
+      CPU_ZERO(&cpuSet);
+      for (auto cpu : config.cpus)
+      {
+        if (cpu < CPU_SETSIZE)
+        {
+          CPU_SET(cpu, &cpuSet);
+        }
+      }
+      applied = (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0) && applied;
+    }
+
+    return applied;
+  }
+
+  void adoptThread(ThreadRole role)
+  {
+    thread_local bool adopted = false;
+    if (!adopted)
+    {
+      adopted = true;
+      applyThreadConfig(threadConfig(role));
+    }
+  }
+
+  std::vector<unsigned> parseCpuList(const std::string& list)
+  {
+    std::vector<unsigned> cpus;
+    size_t pos = 0;
+    while (pos < list.size())
+    {
+      auto end = list.find(',', pos);
+      if (end == std::string::npos)
+      {
+        end = list.size();
+      }
+      auto item = list.substr(pos, end - pos);
+      pos = end + 1;
+
+      if (item.empty() || !std::isdigit(static_cast<unsigned char>(item[0])))
+      {
+        return {};
+      }
+
+      try
+      {
+        size_t parsed = 0;
+        auto first = std::stoul(item, &parsed);
+        auto last = first;
+        if (parsed < item.size())
+        {
+          if (item[parsed] != '-')
+          {
+            return {};
+          }
+          auto range = item.substr(parsed + 1);
+          last = std::stoul(range, &parsed);
+          if (range.empty() || !std::isdigit(static_cast<unsigned char>(range[0])) || parsed != range.size() || last < first)
+          {
+            return {};
+          }
+        }
+        if (last >= CPU_SETSIZE)
+        {
+          return {};
+        }
+        for (auto cpu = first; cpu <= last; cpu++)
+        {
+          cpus.push_back(static_cast<unsigned>(cpu));
+        }
+      }
+      catch (const std::exception&)
+      {
+        return {};
+      }
+    }
+    return cpus;
+  }
+
+} // namespace fty::messagebus::utils
@@ -0,0 +1,292 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include "fty/messagebus/utils/MsgBusTimerWheel.hpp"
+
+#include <algorithm>
+
+namespace fty::messagebus::utils
+{
+  bool TimerHandle::cancel()
+  {
+    return m_wheel && m_wheel->cancel(*this);
+  }
+
+  TimerWheel::TimerWheel(std::shared_ptr<PoolWorker> pool, std::chrono::microseconds tick, const ThreadConfig& config)
+    : m_pool(pool)
+    , m_tick(std::max(std::chrono::duration_cast<Clock::duration>(tick), Clock::duration(1)))
+    , m_start(Clock::now())
+    , m_threadConfig(config)
+  {
+    for (auto& level : m_slots)
+    {
+      level.fill(NIL);
+    }
+    m_thread = std::thread([this]() { mainloop(); });
+  }
+
+  TimerWheel::~TimerWheel()
+  {
+    {
+      std::unique_lock<std::mutex> lk(m_mutex);
+      m_terminated = true;
+      m_cv.notify_all();
+    }
+    m_thread.join();
+  }
+
+  TimerHandle TimerWheel::addTimer(Clock::time_point deadline, Job&& job)
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+
+    auto now = static_cast<uint64_t>((Clock::now() - m_start) / m_tick);
+    if (m_pending == 0)
+    {
+      // Idle wheel, catch up with the clock at once.
+      m_now = std::max(m_now, now);
+    }
+
+    // Round up to the next tick, a timer never fires in the current one.
+    auto expiry = deadline > m_start ? static_cast<uint64_t>((deadline - m_start + m_tick - Clock::duration(1)) / m_tick) : 0;
+    expiry = std::max(expiry, m_now + 1);
+
+    uint32_t index;
+    if (m_free != NIL)
+    {
+      index = m_free;
+      m_free = m_nodes[index].next;
+    }
+    else
+    {
+      index = static_cast<uint32_t>(m_nodes.size());
+      m_nodes.emplace_back();
+    }
+
+    auto& node = m_nodes[index];
+    node.job = std::move(job);
+    node.expiry = expiry;
+    link(index);
+    m_pending++;
+
+    if (expiry < m_wakeup)
+    {
+      // Wake up the wheel thread sleeping past the new timer.
+      m_wakeup = expiry;
+      m_cv.notify_one();
+    }
+    return TimerHandle(this, index, node.generation);
+  }
+
+  bool TimerWheel::cancel(const TimerHandle& handle)
+  {
+    if (handle.m_wheel != this)
+    {
+      return false;
+    }
+
+    std::unique_lock<std::mutex> lk(m_mutex);
+    if (handle.m_index >= m_nodes.size())
+    {
+      return false;
+    }
+
+    auto& node = m_nodes[handle.m_index];
+    if (node.generation != handle.m_generation || node.slot == NIL)
+    {
+      return false;
+    }
+    unlink(handle.m_index);
+    release(handle.m_index);
+    return true;
+  }
+
+  size_t TimerWheel::pending()
+  {
+    std::unique_lock<std::mutex> lk(m_mutex);
+    return m_pending;
+  }
+
+  void TimerWheel::link(uint32_t index)
+  {
+    auto& node = m_nodes[index];
+    auto delta = node.expiry - m_now;
+
+    // Pick the lowest level able to hold the delay, beyond the last one the timer is
+    // parked in the farthest slot and cascaded again until it reaches its expiry.
+    size_t level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1))))
+    {
+      level++;
+    }
+    auto expiry = node.expiry;
+    if (delta >= (uint64_t(1) << (SLOT_BITS * LEVELS)))
+    {
+      expiry = m_now + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+    }
+    auto slot = static_cast<uint32_t>(level * SLOTS + ((expiry >> (SLOT_BITS * level)) & SLOT_MASK));
+
+    auto& head = m_slots[level][slot % SLOTS];
+    node.slot = slot;
+    node.prev = NIL;
+    node.next = head;
+    if (head != NIL)
+    {
+      m_nodes[head].prev = index;
+    }
+    head = index;
+  }
+
+  void TimerWheel::unlink(uint32_t index)
+  {
+    auto& node = m_nodes[index];
+    if (node.prev != NIL)
+    {
+      m_nodes[node.prev].next = node.next;
+    }
+    else
+    {
+      m_slots[node.slot / SLOTS][node.slot % SLOTS] = node.next;
+    }
+    if (node.next != NIL)
+    {
+      m_nodes[node.next].prev = node.prev;
+    }
+    node.prev = NIL;
+    node.next = NIL;
+    node.slot = NIL;
+  }
+
+  void TimerWheel::release(uint32_t index)
+  {
+    auto& node = m_nodes[index];
+    node.job = nullptr;
+    node.generation++;
+    node.next = m_free;
+    m_free = index;
+    m_pending--;
+  }
+
+  uint64_t TimerWheel::nextTick() const
+  {
+    // First occupied slot of each level after the current tick: a timer to fire on the
+    // first level, a cascade on its boundary on the upper ones.
+    uint64_t next = UINT64_MAX;
+    for (size_t level = 0; level < LEVELS; level++)
+    {
+      auto shift = SLOT_BITS * level;
+      auto base = m_now >> shift;
+      for (uint64_t offset = 1; offset <= SLOTS; offset++)
+      {
+        if (m_slots[level][(base + offset) & SLOT_MASK] != NIL)
+        {
+          next = std::min(next, (base + offset) << shift);
+          break;
+        }
+      }
+    }
+    return next;
+  }
+
+  void TimerWheel::advance(uint64_t target, std::vector<Job>& expired)
+  {
+    while (m_now < target)
+    {
+      if (m_pending == 0)
+      {
+        m_now = target;
+        break;
+      }
+      // Jump over the ticks without anything to do.
+      m_now = std::min(target, nextTick());
+
+      // Cascade the slots of the upper levels reached by this tick, farthest level first.
+      for (size_t level = LEVELS - 1; level > 0; level--)
+      {
+        if ((m_now & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) != 0)
+        {
+          continue;
+        }
+        auto& head = m_slots[level][(m_now >> (SLOT_BITS * level)) & SLOT_MASK];
+        auto index = head;
+        head = NIL;
+        while (index != NIL)
+        {
+          auto next = m_nodes[index].next;
+          link(index);
+          index = next;
+        }
+      }
+
+      // Fire the timers of the current slot.
+      auto& head = m_slots[0][m_now & SLOT_MASK];
+      auto index = head;
+      head = NIL;
+      while (index != NIL)
+      {
+        auto next = m_nodes[index].next;
+        expired.emplace_back(std::move(m_nodes[index].job));
+        m_nodes[index].slot = NIL;
+        release(index);
+        index = next;
+      }
+    }
+  }
+
+  void TimerWheel::mainloop()
+  {
+    applyThreadConfig(m_threadConfig);
+
+    std::vector<Job> expired;
+    std::unique_lock<std::mutex> lk(m_mutex);
+    while (!m_terminated)
+    {
+      advance(static_cast<uint64_t>((Clock::now() - m_start) / m_tick), expired);
+      if (!expired.empty())
+      {
+        lk.unlock();
+        for (auto& job : expired)
+        {
+          m_pool->offload(std::move(job));
+        }
+        expired.clear();
+        lk.lock();
+        continue;
+      }
+
+      // Any wake up computes the next tick again, a timer added then cancelled
+      // meanwhile must not leave a stale one.
+      m_wakeup = m_pending == 0 ? UINT64_MAX : nextTick();
+      if (m_wakeup == UINT64_MAX)
+      {
+        m_cv.wait(lk);
+      }
+      else
+      {
+        m_cv.wait_until(lk, m_start + m_tick * static_cast<Clock::rep>(m_wakeup));
+      }
+    }
+  }
+
+  std::shared_ptr<TimerWheel> sharedTimerWheel()
+  {
+    static auto sharedWheel = std::make_shared<TimerWheel>();
+    return sharedWheel;
+  }
+
+} // namespace fty::messagebus::utils
@@ -77,4 +77,88 @@ TEST_CASE("Dispatcher")
 
         std::cerr << "OK" << std::endl;
     }
+
+    {
+        // Hashed translator test.
+        std::cerr << "  - hashed translator: ";
+
+        using TranslatorDispatcher = HashedDispatcher<std::function<std::string()>, std::function<std::string(const std::string&)>>;
+        TranslatorDispatcher::Map translatorMap;
+        for (int i = 0; i < 500; i++) {
+            translatorMap.emplace("subject-" + std::to_string(i), [i]() -> std::string { return std::to_string(i); });
+        }
+
+        TranslatorDispatcher translator(translatorMap,
+            [](const std::string& word) { return "unknown word " + word; }
+        );
+
+        for (int i = 0; i < 500; i++) {
+            auto subject = "subject-" + std::to_string(i);
+            REQUIRE(translator(std::string_view(subject)) == std::to_string(i));
+        }
+        REQUIRE(translator("candy") == "unknown word candy");
+
+        TranslatorDispatcher empty({});
+        REQUIRE_THROWS_AS(empty("candy"), std::bad_function_call);
+
+        std::cerr << "OK" << std::endl;
+    }
+
+    {
+        // Static calculator test.
+        std::cerr << "  - static calculator: ";
+
+        static constexpr PerfectHash<4> operators({"+", "-", "*", "/"});
+        static_assert(operators.find("*") == 2);
+        static_assert(operators.find("A") == 4);
+
+        using CalculatorDispatcher = StaticDispatcher<4, std::function<int(int, int)>, std::function<int(const std::string&, int, int)>>;
+        CalculatorDispatcher calculator(operators, {
+            [](int a, int b) -> int { return a + b; },
+            [](int a, int b) -> int { return a - b; },
+            [](int a, int b) -> int { return a * b; },
+            [](int a, int b) -> int { return a / b; },
+        });
+
+        for (int b = 1; b < 10; b++) {
+            for (int a = 1; a < 10; a++) {
+                REQUIRE(calculator("+", a, b) == (a+b));
+                REQUIRE(calculator("-", a, b) == (a-b));
+                REQUIRE(calculator("*", a, b) == (a*b));
+                REQUIRE(calculator("/", a, b) == (a/b));
+            }
+        }
+
+        // Check what happens on unknown operator.
+        REQUIRE_THROWS_AS((calculator("A", 2, 3) == 'A'), std::bad_function_call);
+
+        std::cerr << "OK" << std::endl;
+    }
+
+    {
+        // Perfect hash of many keys test.
+        std::cerr << "  - perfect hash: ";
+
+        constexpr size_t NB_KEYS = 300;
+        std::vector<std::string> names;
+        std::array<std::string_view, NB_KEYS> keys;
+        for (size_t i = 0; i < NB_KEYS; i++) {
+            names.push_back("/etn/q/subject/" + std::to_string(i));
+        }
+        for (size_t i = 0; i < NB_KEYS; i++) {
+            keys[i] = names[i];
+        }
+
+        PerfectHash<NB_KEYS> hash(keys);
+        for (size_t i = 0; i < NB_KEYS; i++) {
+            REQUIRE(hash.find(names[i]) == i);
+        }
+        REQUIRE(hash.find("/etn/q/subject/300") == NB_KEYS);
+        REQUIRE(hash.find("") == NB_KEYS);
+
+        keys[1] = keys[0];
+        REQUIRE_THROWS_AS(PerfectHash<NB_KEYS>(keys), std::invalid_argument);
+
+        std::cerr << "OK" << std::endl;
+    }
 }
@@ -0,0 +1,169 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <catch2/catch.hpp>
+#include <fty/messagebus/utils/MsgBusHistogram.hpp>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace fty::messagebus::utils;
+
+TEST_CASE("Histogram")
+{
+  std::cerr << " * MsgBusHistogram: " << std::endl;
+
+  // Buckets.
+  {
+    std::cerr << "  - Buckets: ";
+
+    for (uint64_t value : {uint64_t(0), uint64_t(15), uint64_t(16), uint64_t(31), uint64_t(32), uint64_t(1000), uint64_t(123456789), UINT64_MAX})
+    {
+      auto bucket = HistogramBuckets::index(value);
+      REQUIRE(bucket < HistogramBuckets::COUNT);
+      REQUIRE(HistogramBuckets::lowest(bucket) <= value);
+      REQUIRE(HistogramBuckets::highest(bucket) >= value);
+    }
+    for (size_t bucket = 1; bucket < HistogramBuckets::COUNT; bucket++)
+    {
+      REQUIRE(HistogramBuckets::lowest(bucket) == HistogramBuckets::highest(bucket - 1) + 1);
+      REQUIRE(HistogramBuckets::index(HistogramBuckets::lowest(bucket)) == bucket);
+    }
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Percentiles.
+  {
+    std::cerr << "  - Percentiles: ";
+
+    Histogram histogram;
+    REQUIRE(histogram.snapshot().percentile(0.99) == 0);
+
+    std::mt19937_64 generator(42);
+    std::lognormal_distribution<double> distribution(10., 2.);
+    std::vector<uint64_t> values;
+    for (size_t i = 0; i < 100000; i++)
+    {
+      values.push_back(static_cast<uint64_t>(distribution(generator)));
+      histogram.record(values.back());
+    }
+    std::sort(values.begin(), values.end());
+
+    auto snapshot = histogram.snapshot();
+    REQUIRE(snapshot.count == values.size());
+    REQUIRE(snapshot.max == values.back());
+    for (double ratio : {0., 0.5, 0.9, 0.99, 0.999, 1.})
+    {
+      auto expected = static_cast<double>(values[static_cast<size_t>(ratio * static_cast<double>(values.size() - 1))]);
+      auto actual = static_cast<double>(snapshot.percentile(ratio));
+      REQUIRE(actual >= expected);
+      REQUIRE(actual <= expected * 1.0625 + 1);
+    }
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Concurrent recording.
+  {
+    std::cerr << "  - Concurrent recording: ";
+
+    constexpr size_t NB_THREADS = 4;
+    constexpr size_t NB_VALUES = 100000;
+    Histogram histogram;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < NB_THREADS; i++)
+    {
+      threads.emplace_back([&histogram]() {
+        for (uint64_t value = 0; value < NB_VALUES; value++)
+        {
+          histogram.record(std::chrono::nanoseconds(value));
+        }
+      });
+    }
+    for (auto& th : threads)
+    {
+      th.join();
+    }
+
+    auto snapshot = histogram.snapshot();
+    REQUIRE(snapshot.count == NB_THREADS * NB_VALUES);
+    REQUIRE(snapshot.sum == NB_THREADS * (NB_VALUES * (NB_VALUES - 1) / 2));
+    REQUIRE(snapshot.max == NB_VALUES - 1);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Lazy histogram.
+  {
+    std::cerr << "  - Lazy histogram: ";
+
+    constexpr size_t NB_THREADS = 4;
+    LazyHistogram histogram;
+    REQUIRE(histogram.snapshot().count == 0);
+    REQUIRE(histogram.snapshot().buckets.empty());
+
+    // Threads racing on the allocation record in the same histogram.
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < NB_THREADS; i++)
+    {
+      threads.emplace_back([&histogram]() { histogram.record(std::chrono::nanoseconds(1000)); });
+    }
+    for (auto& th : threads)
+    {
+      th.join();
+    }
+    REQUIRE(histogram.snapshot().count == NB_THREADS);
+    REQUIRE(histogram.snapshot().max == 1000);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Pool worker job metrics.
+  {
+    std::cerr << "  - PoolWorker job metrics: ";
+
+    constexpr size_t NB_JOBS = 64;
+    PoolWorker pool(1);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    pool.offload([released]() { released.wait(); });
+    for (size_t i = 0; i < NB_JOBS; i++)
+    {
+      pool.offload([]() { std::this_thread::sleep_for(std::chrono::microseconds(100)); });
+    }
+    REQUIRE(pool.jobMetrics().queueDepth >= NB_JOBS);
+    release.set_value();
+    pool.queue([]() {}).get();
+
+    auto metrics = pool.jobMetrics();
+    REQUIRE(metrics.queueDepth == 0);
+    REQUIRE(metrics.peakQueueDepth >= NB_JOBS);
+    REQUIRE(metrics.runTime.count == NB_JOBS + 2);
+    REQUIRE(metrics.runTime.percentile(0.5) >= 100000);
+    REQUIRE(metrics.queueWait.count == NB_JOBS + 2);
+    REQUIRE(metrics.queueWait.max >= NB_JOBS * 100000);
+
+    std::cerr << "OK" << std::endl;
+  }
+}
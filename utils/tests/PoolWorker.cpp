@@ -172,4 +172,205 @@ TEST_CASE("Pool worker")
 
     std::cerr << "OK" << std::endl;
   }
+
+  // Shared pool test.
+  {
+    std::cerr << "  - Shared PoolWorker: ";
+
+    auto pool = sharedPoolWorker();
+    REQUIRE(pool);
+    REQUIRE(pool == sharedPoolWorker());
+    REQUIRE(pool->queue([]() { return 42; }).get() == 42);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Elastic pool test.
+  {
+    std::cerr << "  - Elastic PoolWorker: ";
+
+    PoolWorker::Elastic elastic;
+    elastic.minWorkers = 1;
+    elastic.maxWorkers = 4;
+    elastic.growThreshold = std::chrono::milliseconds(1);
+    elastic.keepAlive = std::chrono::milliseconds(50);
+    PoolWorker pool(elastic);
+    REQUIRE(pool.sizeMetrics().workers == 1);
+
+    // Blocked jobs make the queue wait, the pool grows up to its maximum.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic_size_t done{0};
+    constexpr size_t NB_BLOCKED = 8;
+    for (size_t i = 0; i < NB_BLOCKED; i++)
+    {
+      pool.offload([released, &done]() { released.wait(); done++; });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pool.sizeMetrics().workers < elastic.maxWorkers && std::chrono::steady_clock::now() < deadline)
+    {
+      // Each offload checks the wait of the oldest queued job.
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      pool.offload([&done]() { done++; });
+    }
+    auto metrics = pool.sizeMetrics();
+    REQUIRE(metrics.workers == elastic.maxWorkers);
+    REQUIRE(metrics.peakWorkers == elastic.maxWorkers);
+    REQUIRE(metrics.growEvents == elastic.maxWorkers - 1);
+
+    // Idle workers above the minimum exit after keepAlive.
+    release.set_value();
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pool.sizeMetrics().workers > elastic.minWorkers && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    metrics = pool.sizeMetrics();
+    REQUIRE(metrics.workers == elastic.minWorkers);
+    REQUIRE(metrics.shrinkEvents == elastic.maxWorkers - elastic.minWorkers);
+    REQUIRE(pool.queue([]() { return 42; }).get() == 42);
+    REQUIRE(done.load() >= NB_BLOCKED);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Elastic pool with all workers blocked test.
+  {
+    std::cerr << "  - Elastic PoolWorker with all workers blocked: ";
+
+    PoolWorker::Elastic elastic;
+    elastic.minWorkers = 1;
+    elastic.maxWorkers = 3;
+    elastic.growThreshold = std::chrono::milliseconds(5);
+    PoolWorker pool(elastic);
+
+    // Jobs queued once, nothing is offloaded while waiting for the pool to grow.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic_size_t started{0};
+    for (size_t i = 0; i < elastic.maxWorkers; i++)
+    {
+      pool.offload([released, &started]() { started++; released.wait(); });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (started.load() < elastic.maxWorkers && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    auto metrics = pool.sizeMetrics();
+    REQUIRE(started.load() == elastic.maxWorkers);
+    REQUIRE(metrics.workers == elastic.maxWorkers);
+    REQUIRE(metrics.growEvents == elastic.maxWorkers - 1);
+    release.set_value();
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Elastic pool without minimum test.
+  {
+    std::cerr << "  - Elastic PoolWorker without minimum: ";
+
+    PoolWorker::Elastic elastic;
+    elastic.minWorkers = 0;
+    elastic.keepAlive = std::chrono::milliseconds(10);
+    PoolWorker pool(elastic);
+    REQUIRE(pool.sizeMetrics().workers == 0);
+    REQUIRE(pool.queue([]() { return 42; }).get() == 42);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pool.sizeMetrics().workers != 0 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(pool.sizeMetrics().workers == 0);
+    REQUIRE(pool.queue([]() { return 43; }).get() == 43);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Bulk offloading test.
+  {
+    for (size_t nWorkers = 0; nWorkers < NB_WORKERS; nWorkers = nWorkers * 2 + 1)
+    {
+      std::cerr << "  - Bulk offload with PoolWorker(" << nWorkers << "): ";
+
+      std::vector<std::atomic_uint_fast32_t> results(NB_JOBS);
+      {
+        PoolWorker pool(nWorkers);
+        std::vector<std::function<void()>> jobs;
+        for (size_t i = 0; i < NB_JOBS; i++)
+        {
+          jobs.emplace_back([&results, i]() { results[i].store(i); });
+        }
+        pool.offloadBulk(jobs.begin(), jobs.end());
+      }
+
+      for (size_t i = 0; i < NB_JOBS; i++)
+      {
+        REQUIRE(results[i].load() == i);
+      }
+
+      std::cerr << "OK" << std::endl;
+    }
+  }
+
+  // Bulk queueing test.
+  {
+    std::cerr << "  - Bulk queue: ";
+
+    PoolWorker pool(4);
+    std::vector<std::function<uint64_t()>> jobs;
+    for (uint64_t i = 0; i < NB_JOBS; i++)
+    {
+      jobs.emplace_back([i]() { return collatz(i); });
+    }
+    auto futures = pool.queueBulk(jobs.begin(), jobs.end());
+
+    REQUIRE(futures.size() == NB_JOBS);
+    for (size_t i = 0; i < NB_JOBS; i++)
+    {
+      REQUIRE(futures[i].get() == collatz(i));
+    }
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Parallel for test.
+  {
+    for (size_t nWorkers = 0; nWorkers < NB_WORKERS; nWorkers = nWorkers * 2 + 1)
+    {
+      std::cerr << "  - Parallel for with PoolWorker(" << nWorkers << "): ";
+
+      PoolWorker pool(nWorkers);
+      std::vector<std::atomic_uint_fast32_t> results(NB_JOBS);
+      pool.parallelFor(0, NB_JOBS, [&results](size_t index) { results[index]++; });
+      for (size_t i = 0; i < NB_JOBS; i++)
+      {
+        REQUIRE(results[i].load() == 1);
+      }
+
+      // Nested in a job of the same pool.
+      if (nWorkers != 0)
+      {
+        auto nested = pool.queue([&pool]() {
+          std::atomic_size_t count{0};
+          pool.parallelFor(0, NB_JOBS, [&count](size_t) { count++; }, 64);
+          return count.load();
+        });
+        REQUIRE(nested.get() == NB_JOBS);
+      }
+
+      // First exception rethrown once the range is processed.
+      std::atomic_size_t processed{0};
+      REQUIRE_THROWS_AS(pool.parallelFor(0, NB_JOBS, [&processed](size_t index) {
+        processed++;
+        if (index == NB_JOBS / 2)
+        {
+          throw std::runtime_error("failure");
+        }
+      }), std::runtime_error);
+
+      std::cerr << "OK" << std::endl;
+    }
+  }
 }
@@ -0,0 +1,172 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <catch2/catch.hpp>
+#include <fty/messagebus/utils/MsgBusStrand.hpp>
+
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+using namespace fty::messagebus::utils;
+
+TEST_CASE("Strands")
+{
+  std::cerr << " * MsgBusStrand: " << std::endl;
+  constexpr size_t NB_WORKERS = 16;
+  constexpr size_t NB_KEYS = 8;
+  constexpr size_t NB_JOBS = 1024;
+
+  // FIFO order per key.
+  {
+    for (size_t nWorkers = 0; nWorkers < NB_WORKERS; nWorkers = nWorkers * 2 + 1)
+    {
+      std::cerr << "  - FIFO per key with PoolWorker(" << nWorkers << "): ";
+
+      std::array<std::vector<size_t>, NB_KEYS> results;
+      std::array<std::atomic_int, NB_KEYS> inFlight{};
+      std::atomic_bool overlap{false};
+      {
+        auto pool = std::make_shared<PoolWorker>(nWorkers);
+        Strands strands(pool);
+        for (size_t i = 0; i < NB_JOBS; i++)
+        {
+          for (size_t key = 0; key < NB_KEYS; key++)
+          {
+            strands.offload(std::to_string(key), [&results, &inFlight, &overlap](size_t k, size_t index) {
+              if (inFlight[k]++ != 0)
+              {
+                overlap = true;
+              }
+              results[k].push_back(index);
+              inFlight[k]--;
+            }, key, i);
+          }
+        }
+      }
+
+      REQUIRE_FALSE(overlap.load());
+      for (const auto& result : results)
+      {
+        REQUIRE(result.size() == NB_JOBS);
+        for (size_t i = 0; i < NB_JOBS; i++)
+        {
+          REQUIRE(result[i] == i);
+        }
+      }
+
+      std::cerr << "OK" << std::endl;
+    }
+  }
+
+  // Different keys run in parallel.
+  {
+    std::cerr << "  - Parallel keys: ";
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t started = 0;
+    bool allStarted = false;
+    {
+      auto pool = std::make_shared<PoolWorker>(NB_KEYS);
+      Strands strands(pool);
+      for (size_t key = 0; key < NB_KEYS; key++)
+      {
+        // Each job blocks until every key has started one: only possible if keys are not serialized.
+        strands.offload(std::to_string(key), [&]() {
+          std::unique_lock<std::mutex> lk(mutex);
+          started++;
+          cv.notify_all();
+          allStarted = cv.wait_for(lk, std::chrono::seconds(5), [&]() { return started == NB_KEYS; });
+        });
+      }
+    }
+    REQUIRE(allStarted);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Idle keys are forgotten.
+  {
+    std::cerr << "  - Idle keys: ";
+
+    auto pool = std::make_shared<PoolWorker>(2);
+    Strands strands(pool);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    strands.offload("busy", [released]() { released.wait(); });
+    REQUIRE(strands.activeKeys() == 1);
+    release.set_value();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (strands.activeKeys() != 0 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(strands.activeKeys() == 0);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Throwing jobs.
+  {
+    std::cerr << "  - Throwing jobs: ";
+
+    auto pool = std::make_shared<PoolWorker>(2);
+    std::atomic_size_t done{0};
+    {
+      Strands strands(pool);
+      strands.offload("key", []() { throw std::runtime_error("Thrown"); });
+      strands.offload("key", [&done]() { done++; });
+      strands.offloadUnordered([]() { throw 42; });
+      strands.offloadUnordered([&done]() { done++; });
+    }
+    // The jobs after the ones throwing ran, on the same pool threads.
+    REQUIRE(done.load() == 2);
+    std::atomic_bool alive{false};
+    pool->queue([&alive]() { alive = true; }).wait();
+    REQUIRE(alive.load());
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Unordered jobs on a shared pool.
+  {
+    std::cerr << "  - Unordered jobs on a shared pool: ";
+
+    auto pool = std::make_shared<PoolWorker>(4);
+    std::atomic_size_t first{0};
+    std::atomic_size_t second{0};
+    Strands otherStrands(pool);
+    {
+      Strands strands(pool);
+      for (size_t i = 0; i < NB_JOBS; i++)
+      {
+        strands.offloadUnordered([&first]() { first++; });
+        otherStrands.offloadUnordered([&second]() { second++; });
+      }
+    }
+    // Destroying strands only waits for its own jobs.
+    REQUIRE(first.load() == NB_JOBS);
+
+    std::cerr << "OK" << std::endl;
+  }
+}
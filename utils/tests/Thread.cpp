@@ -0,0 +1,115 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <fty/messagebus/utils/MsgBusPoolWorker.hpp>
+#include <fty/messagebus/utils/MsgBusThread.hpp>
+
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+
+using namespace fty::messagebus::utils;
+
+namespace
+{
+  std::string currentThreadName()
+  {
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    return name;
+  }
+} // namespace
+
+TEST_CASE("Thread config")
+{
+  std::cerr << " * MsgBusThread: " << std::endl;
+
+  // CPU list parsing.
+  {
+    std::cerr << "  - CPU list: ";
+
+    REQUIRE(parseCpuList("0") == std::vector<unsigned>{0});
+    REQUIRE(parseCpuList("0,2-4,7") == std::vector<unsigned>{0, 2, 3, 4, 7});
+    REQUIRE(parseCpuList("").empty());
+    REQUIRE(parseCpuList("a").empty());
+    REQUIRE(parseCpuList("3-1").empty());
+    REQUIRE(parseCpuList("-1").empty());
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Default affinity, from the environment of the process.
+  {
+    std::cerr << "  - Environment: ";
+
+    auto cpus = std::getenv("FTY_MESSAGEBUS_CPUS_TIMER");
+    REQUIRE(threadConfig(ThreadRole::TIMER).cpus == (cpus ? parseCpuList(cpus) : std::vector<unsigned>{}));
+    REQUIRE(threadConfig(ThreadRole::TIMER).name == "mb-timer");
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Name and affinity of a thread.
+  {
+    std::cerr << "  - Apply config: ";
+
+    cpu_set_t allowed;
+    REQUIRE(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    unsigned cpu = 0;
+    while (!CPU_ISSET(cpu, &allowed))
+    {
+      cpu++;
+    }
+
+    bool done = false;
+    std::string name;
+    cpu_set_t applied;
+    std::thread([&]() {
+      done = applyThreadConfig({"a-very-long-thread-name", {cpu}}, "12");
+      name = currentThreadName();
+      sched_getaffinity(0, sizeof(applied), &applied);
+    }).join();
+    REQUIRE(done);
+    // Truncated, the suffix is kept.
+    REQUIRE(name == "a-very-long--12");
+    REQUIRE(CPU_COUNT(&applied) == 1);
+    REQUIRE(CPU_ISSET(cpu, &applied));
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Threads of a pool worker.
+  {
+    std::cerr << "  - PoolWorker threads: ";
+
+    auto config = threadConfig(ThreadRole::DISPATCH);
+    REQUIRE(config.name == "mb-worker");
+    config.name = "test-pool";
+    setThreadConfig(ThreadRole::DISPATCH, config);
+
+    PoolWorker pool(1);
+    REQUIRE(pool.queue(currentThreadName).get() == "test-pool-0");
+
+    setThreadConfig(ThreadRole::DISPATCH, {"mb-worker", {}});
+
+    std::cerr << "OK" << std::endl;
+  }
+}
@@ -0,0 +1,184 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#include <catch2/catch.hpp>
+#include <fty/messagebus/utils/MsgBusTimerWheel.hpp>
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using namespace fty::messagebus::utils;
+using namespace std::chrono_literals;
+
+TEST_CASE("Timer wheel")
+{
+  std::cerr << " * MsgBusTimerWheel: " << std::endl;
+
+  // Timers fire in deadline order, never early.
+  {
+    std::cerr << "  - Deadline order: ";
+
+    auto pool = std::make_shared<PoolWorker>(0);
+    std::vector<int> fired;
+    std::vector<TimerWheel::Clock::duration> lateness;
+    {
+      TimerWheel wheel(pool);
+      auto start = TimerWheel::Clock::now();
+      for (int i : {5, 1, 4, 2, 3})
+      {
+        auto deadline = start + std::chrono::milliseconds(20 * i);
+        wheel.scheduleAt(deadline, [&fired, &lateness, deadline](int value) {
+          fired.push_back(value);
+          lateness.push_back(TimerWheel::Clock::now() - deadline);
+        }, i);
+      }
+      std::this_thread::sleep_for(200ms);
+      REQUIRE(wheel.pending() == 0);
+    }
+
+    REQUIRE(fired == std::vector<int>{1, 2, 3, 4, 5});
+    for (const auto& late : lateness)
+    {
+      REQUIRE(late >= 0ms);
+    }
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Cancellation.
+  {
+    std::cerr << "  - Cancel: ";
+
+    auto pool = std::make_shared<PoolWorker>(1);
+    std::atomic_int fired{0};
+    TimerWheel wheel(pool);
+    auto cancelled = wheel.scheduleAfter(30ms, [&fired]() { fired += 10; });
+    auto kept = wheel.scheduleAfter(30ms, [&fired]() { fired += 1; });
+    REQUIRE(wheel.pending() == 2);
+    REQUIRE(cancelled.cancel());
+    REQUIRE_FALSE(cancelled.cancel());
+    REQUIRE(wheel.pending() == 1);
+
+    std::this_thread::sleep_for(100ms);
+    REQUIRE(fired.load() == 1);
+    // Already fired.
+    REQUIRE_FALSE(kept.cancel());
+    REQUIRE_FALSE(TimerHandle().cancel());
+
+    // Cancelled before the idle wheel thread wakes up, a later timer still fires.
+    for (int i = 0; i < 100; i++)
+    {
+      REQUIRE(wheel.scheduleAfter(10ms, [&fired]() { fired += 10; }).cancel());
+      std::this_thread::sleep_for(100us);
+    }
+    wheel.scheduleAfter(20ms, [&fired]() { fired += 1; });
+    std::this_thread::sleep_for(100ms);
+    REQUIRE(fired.load() == 2);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Cascading through the upper levels (fine tick to cross several levels quickly).
+  {
+    std::cerr << "  - Cascade: ";
+
+    auto pool = std::make_shared<PoolWorker>(1);
+    std::mutex mutex;
+    std::vector<int> fired;
+    TimerWheel wheel(pool, 10us);
+    // 10us ticks: 1ms crosses level 0, 100ms crosses level 1 (65536 ticks ~ 655ms is level 2).
+    for (int i : {700, 3, 100, 1})
+    {
+      wheel.scheduleAfter(std::chrono::milliseconds(i), [&mutex, &fired, i]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        fired.push_back(i);
+      });
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (wheel.pending() != 0 && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(10ms);
+    }
+    std::this_thread::sleep_for(10ms);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    REQUIRE(fired == std::vector<int>{1, 3, 100, 700});
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // A timer added while the wheel sleeps until a far one.
+  {
+    std::cerr << "  - Sparse timers: ";
+
+    auto pool = std::make_shared<PoolWorker>(1);
+    std::atomic_int fired{0};
+    TimerWheel wheel(pool);
+    wheel.scheduleAfter(60s, [&fired]() { fired += 10; });
+    std::this_thread::sleep_for(10ms);
+
+    auto start = TimerWheel::Clock::now();
+    std::atomic<TimerWheel::Clock::time_point> firedAt{start};
+    wheel.scheduleAfter(20ms, [&fired, &firedAt]() {
+      firedAt = TimerWheel::Clock::now();
+      fired += 1;
+    });
+    auto deadline = start + 5s;
+    while (fired.load() == 0 && TimerWheel::Clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(5ms);
+    }
+    REQUIRE(fired.load() == 1);
+    REQUIRE(firedAt.load() - start >= 20ms);
+    REQUIRE(firedAt.load() - start < 1s);
+    REQUIRE(wheel.pending() == 1);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Massive insertion and cancellation.
+  {
+    std::cerr << "  - One million timers: ";
+
+    constexpr size_t NB_TIMERS = 1000 * 1000;
+    auto pool = std::make_shared<PoolWorker>(1);
+    std::atomic_size_t fired{0};
+    TimerWheel wheel(pool);
+
+    std::vector<TimerHandle> handles;
+    handles.reserve(NB_TIMERS);
+    for (size_t i = 0; i < NB_TIMERS; i++)
+    {
+      // Spread over all levels, far enough to never fire during the test.
+      handles.push_back(wheel.scheduleAfter(std::chrono::seconds(60) + std::chrono::milliseconds(i * 4099 % (1 << 30)), [&fired]() { fired++; }));
+    }
+    REQUIRE(wheel.pending() == NB_TIMERS);
+
+    for (auto& handle : handles)
+    {
+      REQUIRE(handle.cancel());
+    }
+    REQUIRE(wheel.pending() == 0);
+    REQUIRE(fired.load() == 0);
+
+    std::cerr << "OK" << std::endl;
+  }
+}
@@ -0,0 +1,69 @@
+/*  =========================================================================
+    Copyright (C) 2014 - 2021 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+#include <catch2/catch.hpp>
+#include <fty/messagebus/utils/MsgBusTrace.hpp>
+
+#include <iostream>
+#include <thread>
+
+using namespace fty::messagebus::utils;
+
+TEST_CASE("Trace")
+{
+  std::cerr << " * MsgBusTrace: " << std::endl;
+
+  // Probe arguments.
+  {
+    std::cerr << "  - Arguments: ";
+
+    CHECK(traceHash("") == 0);
+    CHECK(traceHash("b5a2ca5c-7ab1-4a5f-b5e3-3e1a36b0a5f6") == traceHash("b5a2ca5c-7ab1-4a5f-b5e3-3e1a36b0a5f6"));
+    CHECK(traceHash("b5a2ca5c-7ab1-4a5f-b5e3-3e1a36b0a5f6") != traceHash("0e3b6a4e-2d3c-4f7a-9b1e-8c5d4a3b2c1d"));
+
+    // Probe disabled at the start of the operation.
+    CHECK(traceStart(false) == 0);
+    CHECK(traceElapsed(traceStart(false)) == 0);
+
+    auto started = traceStart(true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    CHECK(traceElapsed(started) >= 1000000);
+
+    std::cerr << "OK" << std::endl;
+  }
+
+  // Probes are nops without a tracer attached.
+  {
+    std::cerr << "  - Probes: ";
+
+    size_t computed = 0;
+    auto size = [&computed]() -> size_t {
+      computed++;
+      return 0;
+    };
+    if (FTY_TRACE_ENABLED(send))
+    {
+      FTY_TRACE(send, "address", size(), traceHash("id"));
+    }
+    CHECK(computed == 0);
+
+    std::cerr << "OK" << std::endl;
+  }
+}